@@ -11,6 +11,15 @@
 #define MIN(A, B) ((A) < (B) ? (A) : (B))
 #define MAX(A, B) ((A) > (B) ? (A) : (B))
 
+/* Bytes per canvas pixel (LV_IMG_CF_TRUE_COLOR_ALPHA) */
+#if LV_COLOR_DEPTH == 32
+#define CANVAS_PX_SIZE 4
+#elif LV_COLOR_DEPTH == 16
+#define CANVAS_PX_SIZE 3
+#else
+#define CANVAS_PX_SIZE 2
+#endif
+
 typedef struct Entry {
     uint16_t length;
     uint16_t prefix;
@@ -29,6 +38,23 @@ static void f_gif_read(gd_GIF * gif, void * buf, size_t len);
 static int f_gif_seek(gd_GIF * gif, size_t pos, int k);
 static void f_gif_close(gd_GIF * gif);
 
+/* Write the i-th pixel of a canvas. */
+static inline void
+put_pixel(uint8_t *buffer, int i, lv_color_t c, uint8_t opa)
+{
+#if LV_COLOR_DEPTH == 32
+    c.ch.alpha = opa;
+    ((lv_color_t *) buffer)[i] = c;
+#elif LV_COLOR_DEPTH == 16
+    buffer[i*3 + 0] = c.full & 0xff;
+    buffer[i*3 + 1] = (c.full >> 8) & 0xff;
+    buffer[i*3 + 2] = opa;
+#elif LV_COLOR_DEPTH == 8 || LV_COLOR_DEPTH == 1
+    buffer[i*2 + 0] = c.full;
+    buffer[i*2 + 1] = opa;
+#endif
+}
+
 static uint16_t
 read_num(gd_GIF * gif)
 {
@@ -65,6 +91,9 @@ gd_open_gif_data(const void *data)
     return gif_open(&gif_base);
 }
 
+/* Palette LUT lives in the same allocation as canvas/frame so gd_GIF stays small on the stack */
+#define GD_LUT_SIZE (0x100 * sizeof(lv_color_t))
+
 static gd_GIF * gif_open(gd_GIF * gif_base)
 {
     uint8_t sigver[3];
@@ -108,11 +137,11 @@ static gd_GIF * gif_open(gd_GIF * gif_base)
     f_gif_read(gif_base, &aspect, 1);
     /* Create gd_GIF Structure. */
 #if LV_COLOR_DEPTH == 32
-    gif = lv_mem_alloc(sizeof(gd_GIF) + 5 * width * height);
+    gif = lv_mem_alloc(sizeof(gd_GIF) + GD_LUT_SIZE + 5 * width * height);
 #elif LV_COLOR_DEPTH == 16
-    gif = lv_mem_alloc(sizeof(gd_GIF) + 4 * width * height);
+    gif = lv_mem_alloc(sizeof(gd_GIF) + GD_LUT_SIZE + 4 * width * height);
 #elif LV_COLOR_DEPTH == 8 || LV_COLOR_DEPTH == 1
-    gif = lv_mem_alloc(sizeof(gd_GIF) + 3 * width * height);
+    gif = lv_mem_alloc(sizeof(gd_GIF) + GD_LUT_SIZE + 3 * width * height);
 #endif
 
     if (!gif) goto fail;
@@ -125,7 +154,8 @@ static gd_GIF * gif_open(gd_GIF * gif_base)
     f_gif_read(gif, gif->gct.colors, 3 * gif->gct.size);
     gif->palette = &gif->gct;
     gif->bgindex = bgidx;
-    gif->canvas = (uint8_t *) &gif[1];
+    gif->lut = (lv_color_t *) &gif[1];
+    gif->canvas = (uint8_t *) &gif->lut[0x100];
 #if LV_COLOR_DEPTH == 32
     gif->frame = &gif->canvas[4 * width * height];
 #elif LV_COLOR_DEPTH == 16
@@ -137,24 +167,11 @@ static gd_GIF * gif_open(gd_GIF * gif_base)
         memset(gif->frame, gif->bgindex, gif->width * gif->height);
     bgcolor = &gif->palette->colors[gif->bgindex*3];
 
-    if (bgcolor[0] || bgcolor[1] || bgcolor [2])
-        for (i = 0; i < gif->width * gif->height; i++) {
-#if LV_COLOR_DEPTH == 32
-            gif->canvas[i*4 + 0] = *(bgcolor + 2);
-            gif->canvas[i*4 + 1] = *(bgcolor + 1);
-            gif->canvas[i*4 + 2] = *(bgcolor + 0);
-            gif->canvas[i*4 + 3] = 0xff;
-#elif LV_COLOR_DEPTH == 16
-            lv_color_t c = lv_color_make(*(bgcolor + 0), *(bgcolor + 1), *(bgcolor + 2));
-            gif->canvas[i*3 + 0] = c.full & 0xff;
-            gif->canvas[i*3 + 1] = (c.full >> 8) & 0xff;
-            gif->canvas[i*3 + 2] = 0xff;
-#elif LV_COLOR_DEPTH == 8
-            lv_color_t c = lv_color_make(*(bgcolor + 0), *(bgcolor + 1), *(bgcolor + 2));
-            gif->canvas[i*2 + 0] = c.full;
-            gif->canvas[i*2 + 1] = 0xff;
-#endif
-        }
+    if (bgcolor[0] || bgcolor[1] || bgcolor [2]) {
+        lv_color_t c = lv_color_make(*(bgcolor + 0), *(bgcolor + 1), *(bgcolor + 2));
+        for (i = 0; i < gif->width * gif->height; i++)
+            put_pixel(gif->canvas, i, c, 0xff);
+    }
     gif->anim_start = f_gif_seek(gif, 0, LV_FS_SEEK_CUR);
     goto ok;
 fail:
@@ -373,8 +390,10 @@ interlaced_line_index(int h, int y)
 
 /* Decompress image pixels.
  * Return 0 on success or -1 on out-of-memory (w.r.t. LZW code table). */
+/* fw, fh: the declared frame size, which lays out the LZW pixel stream.
+ * Pixels outside the clamped rectangle (gif->fw x gif->fh) are decoded and dropped. */
 static int
-read_image_data(gd_GIF *gif, int interlace)
+read_image_data(gd_GIF *gif, int interlace, int fw, int fh)
 {
     uint8_t sub_len, shift, byte;
     int init_key_size, key_size, table_is_full=0;
@@ -400,7 +419,7 @@ read_image_data(gd_GIF *gif, int interlace)
     key = get_key(gif, key_size, &sub_len, &shift, &byte); /* clear code */
     frm_off = 0;
     ret = 0;
-    frm_size = gif->fw*gif->fh;
+    frm_size = fw*fh;
     while (frm_off < frm_size) {
         if (key == clear) {
             key_size = init_key_size;
@@ -425,11 +444,12 @@ read_image_data(gd_GIF *gif, int interlace)
         str_len = entry.length;
         for (i = 0; i < str_len; i++) {
             p = frm_off + entry.length - 1;
-            x = p % gif->fw;
-            y = p / gif->fw;
+            x = p % fw;
+            y = p / fw;
             if (interlace)
-                y = interlaced_line_index((int) gif->fh, y);
-            gif->frame[(gif->fy + y) * gif->width + gif->fx + x] = entry.suffix;
+                y = interlaced_line_index(fh, y);
+            if (x < gif->fw && y < gif->fh)
+                gif->frame[(gif->fy + y) * gif->width + gif->fx + x] = entry.suffix;
             if (entry.prefix == 0xFFF)
                 break;
             else
@@ -452,12 +472,21 @@ read_image(gd_GIF *gif)
 {
     uint8_t fisrz;
     int interlace;
+    int fw, fh;
 
     /* Image Descriptor. */
     gif->fx = read_num(gif);
     gif->fy = read_num(gif);
-    gif->fw = read_num(gif);
-    gif->fh = read_num(gif);
+    fw = read_num(gif);
+    fh = read_num(gif);
+    /* Clamp the frame rectangle to the canvas. The decoder, render_frame_rect(),
+     * copy_saved_rect() and the partial invalidate all index the canvas with it. */
+    if (gif->fx >= gif->width || gif->fy >= gif->height) {
+        gif->fx = gif->fy = gif->fw = gif->fh = 0;
+    } else {
+        gif->fw = (uint16_t) LV_MIN(fw, gif->width - gif->fx);
+        gif->fh = (uint16_t) LV_MIN(fh, gif->height - gif->fy);
+    }
     f_gif_read(gif, &fisrz, 1);
     interlace = fisrz & 0x40;
     /* Ignore Sort Flag. */
@@ -467,92 +496,103 @@ read_image(gd_GIF *gif)
         gif->lct.size = 1 << ((fisrz & 0x07) + 1);
         f_gif_read(gif, gif->lct.colors, 3 * gif->lct.size);
         gif->palette = &gif->lct;
+        gif->lut_palette = NULL;
     } else
         gif->palette = &gif->gct;
     /* Image Data. */
-    return read_image_data(gif, interlace);
+    return read_image_data(gif, interlace, fw, fh);
+}
+
+/* Convert the current palette to canvas colors once, instead of once per pixel. */
+static void
+update_lut(gd_GIF *gif)
+{
+    int i;
+    uint8_t *color;
+
+    if (gif->lut_palette == gif->palette)
+        return;
+    for (i = 0; i < 0x100; i++) {
+        color = &gif->palette->colors[i*3];
+        gif->lut[i] = lv_color_make(*(color + 0), *(color + 1), *(color + 2));
+    }
+    gif->lut_palette = gif->palette;
 }
 
 static void
 render_frame_rect(gd_GIF *gif, uint8_t *buffer)
 {
     int i, j, k;
-    uint8_t index, *color;
+    uint8_t index;
+    const uint8_t *src;
+    int transparency = gif->gce.transparency;
+    uint8_t tindex = gif->gce.tindex;
+
+    update_lut(gif);
     i = gif->fy * gif->width + gif->fx;
     for (j = 0; j < gif->fh; j++) {
-        for (k = 0; k < gif->fw; k++) {
-            index = gif->frame[(gif->fy + j) * gif->width + gif->fx + k];
-            color = &gif->palette->colors[index*3];
-            if (!gif->gce.transparency || index != gif->gce.tindex) {
-#if LV_COLOR_DEPTH == 32
-                buffer[(i+k)*4 + 0] = *(color + 2);
-                buffer[(i+k)*4 + 1] = *(color + 1);
-                buffer[(i+k)*4 + 2] = *(color + 0);
-                buffer[(i+k)*4 + 3] = 0xFF;
-#elif LV_COLOR_DEPTH == 16
-                lv_color_t c = lv_color_make(*(color + 0), *(color + 1), *(color + 2));
-                buffer[(i+k)*3 + 0] = c.full & 0xff;
-                buffer[(i+k)*3 + 1] = (c.full >> 8) & 0xff;
-                buffer[(i+k)*3 + 2] = 0xff;
-#elif LV_COLOR_DEPTH == 8
-                lv_color_t c = lv_color_make(*(color + 0), *(color + 1), *(color + 2));
-                buffer[(i+k)*2 + 0] = c.full;
-                buffer[(i+k)*2 + 1] = 0xff;
-#elif LV_COLOR_DEPTH == 1
-                uint8_t b = (*(color + 0)) | (*(color + 1)) | (*(color + 2));
-                buffer[(i+k)*2 + 0] = b > 128 ? 1 : 0;
-                buffer[(i+k)*2 + 1] = 0xff;
-#endif
+        src = &gif->frame[i];
+        if (transparency) {
+            for (k = 0; k < gif->fw; k++) {
+                index = src[k];
+                if (index != tindex)
+                    put_pixel(buffer, i + k, gif->lut[index], 0xFF);
             }
+        } else {
+            for (k = 0; k < gif->fw; k++)
+                put_pixel(buffer, i + k, gif->lut[src[k]], 0xFF);
         }
         i += gif->width;
     }
 }
 
+/* Copy the frame rectangle between the canvas and the "restore to previous" buffer. */
+static void
+copy_saved_rect(gd_GIF *gif, int to_canvas)
+{
+    int j;
+    size_t row = (size_t) gif->dw * CANVAS_PX_SIZE;
+    uint8_t *canvas = &gif->canvas[((size_t) gif->dy * gif->width + gif->dx) * CANVAS_PX_SIZE];
+    uint8_t *saved = gif->saved;
+
+    for (j = 0; j < gif->dh; j++) {
+        if (to_canvas)
+            memcpy(canvas, saved, row);
+        else
+            memcpy(saved, canvas, row);
+        canvas += (size_t) gif->width * CANVAS_PX_SIZE;
+        saved += row;
+    }
+}
+
+/* Undo the last rendered frame according to its disposal method.
+ * Only the frame rectangle is touched; the rest of the canvas is already up to date. */
 static void
 dispose(gd_GIF *gif)
 {
     int i, j, k;
-    uint8_t *bgcolor;
-    switch (gif->gce.disposal) {
+    uint8_t opa;
+    switch (gif->dmode) {
     case 2: /* Restore to background color. */
-        bgcolor = &gif->palette->colors[gif->bgindex*3];
-
-        uint8_t opa = 0xff;
+        update_lut(gif);
+        opa = 0xff;
         if(gif->gce.transparency) opa = 0x00;
 
-        i = gif->fy * gif->width + gif->fx;
-        for (j = 0; j < gif->fh; j++) {
-            for (k = 0; k < gif->fw; k++) {
-#if LV_COLOR_DEPTH == 32
-                gif->canvas[(i+k)*4 + 0] = *(bgcolor + 2);
-                gif->canvas[(i+k)*4 + 1] = *(bgcolor + 1);
-                gif->canvas[(i+k)*4 + 2] = *(bgcolor + 0);
-                gif->canvas[(i+k)*4 + 3] = opa;
-#elif LV_COLOR_DEPTH == 16
-                lv_color_t c = lv_color_make(*(bgcolor + 0), *(bgcolor + 1), *(bgcolor + 2));
-                gif->canvas[(i+k)*3 + 0] = c.full & 0xff;
-                gif->canvas[(i+k)*3 + 1] = (c.full >> 8) & 0xff;
-                gif->canvas[(i+k)*3 + 2] = opa;
-#elif LV_COLOR_DEPTH == 8
-                lv_color_t c = lv_color_make(*(bgcolor + 0), *(bgcolor + 1), *(bgcolor + 2));
-                gif->canvas[(i+k)*2 + 0] = c.full;
-                gif->canvas[(i+k)*2 + 1] = opa;
-#elif LV_COLOR_DEPTH == 1
-                uint8_t b = (*(bgcolor + 0)) | (*(bgcolor + 1)) | (*(bgcolor + 2));
-                gif->canvas[(i+k)*2 + 0] = b > 128 ? 1 : 0;
-                gif->canvas[(i+k)*2 + 1] = opa;
-#endif
-            }
+        i = gif->dy * gif->width + gif->dx;
+        for (j = 0; j < gif->dh; j++) {
+            for (k = 0; k < gif->dw; k++)
+                put_pixel(gif->canvas, i + k, gif->lut[gif->bgindex], opa);
             i += gif->width;
         }
         break;
-    case 3: /* Restore to previous, i.e., don't update canvas.*/
+    case 3: /* Restore to previous. */
+        copy_saved_rect(gif, 1);
         break;
     default:
-        /* Add frame non-transparent pixels to canvas. */
-        render_frame_rect(gif, gif->canvas);
+        /* Leave the frame on the canvas, it was drawn there by gd_render_frame(). */
+        break;
     }
+    gif->dmode = 0;
 }
 
 /* Return 1 if got a frame; 0 if got GIF trailer; -1 if error. */
@@ -579,18 +619,45 @@ gd_get_frame(gd_GIF *gif)
 void
 gd_render_frame(gd_GIF *gif, uint8_t *buffer)
 {
-//    uint32_t i;
-//    uint32_t j;
-//    for(i = 0, j = 0; i < gif->width * gif->height * 3; i+= 3, j+=4) {
-//        buffer[j + 0] = gif->canvas[i + 2];
-//        buffer[j + 1] = gif->canvas[i + 1];
-//        buffer[j + 2] = gif->canvas[i + 0];
-//        buffer[j + 3] = 0xFF;
-//    }
-//    memcpy(buffer, gif->canvas, gif->width * gif->height * 3);
+    size_t size;
+    uint8_t *saved;
+
+    gif->dx = gif->fx;
+    gif->dy = gif->fy;
+    gif->dw = gif->fw;
+    gif->dh = gif->fh;
+    gif->dmode = gif->gce.disposal;
+    if (gif->dmode == 3) {
+        size = (size_t) gif->fw * gif->fh * CANVAS_PX_SIZE;
+        if (size > gif->saved_size) {
+            saved = lv_mem_realloc(gif->saved, size);
+            if (saved) {
+                gif->saved = saved;
+                gif->saved_size = size;
+            }
+        }
+        if (size <= gif->saved_size) {
+            copy_saved_rect(gif, 0);
+        } else {
+            LV_LOG_WARN("no memory to restore the previous frame\n");
+            gif->dmode = 1;
+        }
+    }
     render_frame_rect(gif, buffer);
 }
 
+int
+gd_get_dispose_area(const gd_GIF *gif, uint16_t *x, uint16_t *y, uint16_t *w, uint16_t *h)
+{
+    if (gif->dmode != 2 && gif->dmode != 3)
+        return 0;
+    *x = gif->dx;
+    *y = gif->dy;
+    *w = gif->dw;
+    *h = gif->dh;
+    return 1;
+}
+
 void
 gd_rewind(gd_GIF *gif)
 {
@@ -601,6 +668,8 @@ void
 gd_close_gif(gd_GIF *gif)
 {
     f_gif_close(gif);
+    if (gif->saved)
+        lv_mem_free(gif->saved);
     lv_mem_free(gif);
 }
 
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include "../../../misc/lv_fs.h"
+#include "../../../misc/lv_color.h"
 
 #if LV_USE_GIF
 
@@ -43,14 +44,30 @@ typedef struct gd_GIF {
     uint16_t fx, fy, fw, fh;
     uint8_t bgindex;
     uint8_t *canvas, *frame;
+    /* Disposal still pending for the last rendered frame (applied by the next gd_get_frame()) */
+    uint16_t dx, dy, dw, dh;
+    uint8_t dmode;
+    /* Canvas pixels under the last frame, kept for "restore to previous" */
+    uint8_t *saved;
+    size_t saved_size;
+    /* Current palette converted to canvas pixels; lut_palette is NULL when it must be rebuilt.
+     * lut points into the gd_GIF allocation (0x100 entries, ahead of canvas and frame). */
+    gd_Palette *lut_palette;
+    lv_color_t *lut;
 } gd_GIF;
 
 gd_GIF * gd_open_gif_file(const char *fname);
 
 gd_GIF * gd_open_gif_data(const void *data);
 
+/* Draw the frame rectangle (fx, fy, fw, fh) into buffer, which must be gif->canvas:
+ * the canvas keeps the composed image and only the frame rectangle changes. */
 void gd_render_frame(gd_GIF *gif, uint8_t *buffer);
 
+/* Canvas area the next gd_get_frame() will change by disposing the last frame.
+ * Returns 0 and leaves the area untouched when the disposal keeps the canvas. */
+int gd_get_dispose_area(const gd_GIF *gif, uint16_t *x, uint16_t *y, uint16_t *w, uint16_t *h);
+
 int gd_get_frame(gd_GIF *gif);
 void gd_rewind(gd_GIF *gif);
 void gd_close_gif(gd_GIF *gif);
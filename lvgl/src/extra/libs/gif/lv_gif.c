@@ -27,6 +27,7 @@
 static void lv_gif_constructor(const lv_obj_class_t * class_p, lv_obj_t * obj);
 static void lv_gif_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj);
 static void next_frame_task_cb(lv_timer_t * t);
+static void invalidate_frame_area(lv_obj_t * obj, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
 
 /**********************
  *  STATIC VARIABLES
@@ -99,6 +100,8 @@ void lv_gif_restart(lv_obj_t * obj)
 {
     lv_gif_t * gifobj = (lv_gif_t *) obj;
     gd_rewind(gifobj->gif);
+    lv_timer_resume(gifobj->timer);
+    lv_timer_reset(gifobj->timer);
 }
 
 /**********************
@@ -133,23 +136,66 @@ static void next_frame_task_cb(lv_timer_t * t)
 
     gifobj->last_call = lv_tick_get();
 
+    /*The previous frame's disposal changes the canvas too*/
+    uint16_t x, y, w, h;
+    bool disposed = gd_get_dispose_area(gifobj->gif, &x, &y, &w, &h);
+
     int has_next = gd_get_frame(gifobj->gif);
     if(has_next == 0) {
         /*It was the last repeat*/
         if(gifobj->gif->loop_count == 1) {
-            lv_res_t res = lv_event_send(obj, LV_EVENT_READY, NULL);
-            if(res != LV_FS_RES_OK) return;
+            lv_timer_pause(t);
+            lv_event_send(obj, LV_EVENT_READY, NULL);
+            return;
         }
         else {
             if(gifobj->gif->loop_count > 1)  gifobj->gif->loop_count--;
             gd_rewind(gifobj->gif);
+            /*Continue with the first frame instead of showing the last one twice*/
+            has_next = gd_get_frame(gifobj->gif);
         }
     }
+    if(has_next < 0) {
+        LV_LOG_WARN("Couldn't decode the next frame");
+        lv_timer_pause(t);
+        if(disposed) invalidate_frame_area(obj, x, y, w, h);
+        return;
+    }
 
     gd_render_frame(gifobj->gif, (uint8_t *)gifobj->imgdsc.data);
 
     lv_img_cache_invalidate_src(lv_img_get_src(obj));
-    lv_obj_invalidate(obj);
+    if(disposed) invalidate_frame_area(obj, x, y, w, h);
+    invalidate_frame_area(obj, gifobj->gif->fx, gifobj->gif->fy, gifobj->gif->fw, gifobj->gif->fh);
+}
+
+/**
+ * Invalidate the part of the object showing an area of the GIF canvas.
+ * Falls back to the whole object if the image is zoomed, rotated, offset or tiled.
+ */
+static void invalidate_frame_area(lv_obj_t * obj, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    if(w == 0 || h == 0) return;
+
+    lv_img_t * img = (lv_img_t *) obj;
+    int32_t zoom = (lv_obj_get_style_transform_zoom(obj, LV_PART_MAIN) * img->zoom) >> 8;
+    int32_t angle = lv_obj_get_style_transform_angle(obj, LV_PART_MAIN) + img->angle;
+    lv_coord_t border_width = lv_obj_get_style_border_width(obj, LV_PART_MAIN);
+    lv_coord_t pleft = lv_obj_get_style_pad_left(obj, LV_PART_MAIN) + border_width;
+    lv_coord_t ptop = lv_obj_get_style_pad_top(obj, LV_PART_MAIN) + border_width;
+
+    if(zoom != LV_IMG_ZOOM_NONE || angle != 0 || img->offset.x != 0 || img->offset.y != 0 ||
+       lv_obj_get_content_width(obj) > img->w || lv_obj_get_content_height(obj) > img->h) {
+        lv_obj_invalidate(obj);
+        return;
+    }
+
+    lv_area_t area;
+    area.x1 = obj->coords.x1 + pleft + x;
+    area.y1 = obj->coords.y1 + ptop + y;
+    area.x2 = area.x1 + w - 1;
+    area.y2 = area.y1 + h - 1;
+    lv_obj_invalidate_area(obj, &area);
 }
 
 #endif /*LV_USE_GIF*/
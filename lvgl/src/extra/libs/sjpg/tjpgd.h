@@ -56,6 +56,8 @@ struct JDEC {
 	uint8_t ncomp;				/* Number of color components 1:grayscale, 3:color */
 	int16_t dcv[3];				/* Previous DC element of each component */
 	uint16_t nrst;				/* Restart inverval */
+	uint16_t rst, rsc;			/* Restart interval counters (for row-by-row decompression) */
+	uint16_t mcuy;				/* Next MCU row to be decompressed (pixel) */
 	uint16_t width, height;		/* Size of the input image (pixel) */
 	uint8_t* huffbits[2][2];	/* Huffman bit distribution tables [id][dcac] */
 	uint16_t* huffcode[2][2];	/* Huffman code word tables [id][dcac] */
@@ -83,6 +85,8 @@ struct JDEC {
 /* TJpgDec API functions */
 JRESULT jd_prepare (JDEC* jd, size_t (*infunc)(JDEC*,uint8_t*,size_t), void* pool, size_t sz_pool, void* dev);
 JRESULT jd_decomp (JDEC* jd, int (*outfunc)(JDEC*,void*,JRECT*), uint8_t scale);
+JRESULT jd_decomp_start (JDEC* jd, uint8_t scale);
+JRESULT jd_decomp_mcurow (JDEC* jd, int (*outfunc)(JDEC*,void*,JRECT*));
 
 #endif /*LV_USE_SJPG*/
 
@@ -6,16 +6,25 @@
 #include "src/common/common.h"
 #include "src/common/touch_device.h"
 #include "src/file_scanner/file_scanner.h"
+#include "src/file_scanner/media_catalog.h"
+#include "src/file_scanner/media_search.h"
 #include "src/media_player/simple_video_player.h"
 #include "src/media_player/audio_player.h"
 #include "src/ui/video_touch_control.h"
 #include "src/time_sync/time_sync.h"
+#include "src/image_viewer/image_cache.h"
+#include "src/image_viewer/thumb_cache.h"
 #include <stdio.h>
 #include <unistd.h>
 #include <time.h>
 #include <stdlib.h>
 #include <signal.h>
 
+/* 媒体目录文件（元数据缓存） */
+#ifndef MEDIA_CATALOG_FILE
+    #define MEDIA_CATALOG_FILE MEDIA_DIR "/.media.catalog"
+#endif
+
 int main(void)
 {
     /* 初始化LVGL */
@@ -49,10 +58,11 @@ int main(void)
     simple_video_init();
     video_touch_control_init();
 
-    /* 扫描媒体文件 */
-    scan_image_directory(IMAGE_DIR);
-    scan_audio_directory(MEDIA_DIR);
-    scan_video_directory(MEDIA_DIR);
+    /* 加载媒体目录（元数据缓存），需要在建立索引之前，索引中的文件直接使用缓存的元数据 */
+    media_catalog_open(MEDIA_CATALOG_FILE);
+
+    /* 建立媒体索引（IMAGE_DIR和MEDIA_DIR是同一个目录，一次扫描同时得到图片、音频和视频） */
+    media_index_build(MEDIA_DIR, false);
 
     /* 创建UI界面 */
     create_main_screen();
@@ -66,6 +76,9 @@ int main(void)
     while(!should_exit) {
         lv_timer_handler();
         
+        // 处理媒体目录的文件变化（新增、删除、插拔U盘）
+        media_index_poll();
+        
         // 检查屏保是否解锁
         extern void screensaver_win_check_unlock(void);
         screensaver_win_check_unlock();
@@ -132,6 +145,19 @@ int main(void)
 
     /* 程序退出时关闭触摸屏设备 */
     touch_device_deinit();
+    
+    /* 退出常驻的音频、视频mplayer进程 */
+    audio_player_cleanup();
+    simple_video_cleanup();
+    
+    /* 停止图片预取和缩略图线程，释放解码缓存并同步缩略图缓存文件 */
+    image_cache_deinit();
+    thumb_cache_close();
+    
+    /* 停止监视媒体目录，停止提取线程并保存媒体目录 */
+    media_index_close();
+    media_catalog_close();
+    media_search_free();
 
     return 0;
 }
@@ -15,6 +15,8 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <time.h>
+#include <poll.h>
+#include <pthread.h>
 
 // 巴法云TCP客户端结构
 typedef struct {
@@ -26,8 +28,46 @@ typedef struct {
     bemfa_tcp_state_callback_t state_callback;
     void *state_user_data;
     time_t last_ping_time;
+    pthread_mutex_t tx_mutex;               // 保证每条命令整行写入（接收线程的心跳和其他线程的发布可能同时发送）
+    char rx_buf[BEMFA_TCP_RX_BUFFER_SIZE];  // 接收重组缓冲区（跨recv保留不完整的行）
+    size_t rx_len;                          // 缓冲区中的数据长度
+    size_t rx_scanned;                      // 已确认不含换行符的前缀长度
+    bool rx_discarding;                     // 正在丢弃超长行，直到下一个换行符
 } bemfa_tcp_client_t;
 
+// 清空接收缓冲区（新连接或断开时）
+static void rx_reset(bemfa_tcp_client_t *client) {
+    client->rx_len = 0;
+    client->rx_scanned = 0;
+    client->rx_discarding = false;
+}
+
+// 发送完整的一条命令（socket为非阻塞，缓冲区满时等待可写，避免半条命令留在流中）
+// 等待可写期间持有tx_mutex，其他线程的命令不会插入到这条命令中间
+static int send_all(bemfa_tcp_client_t *client, const char *buf, int len) {
+    int sent = 0;
+    pthread_mutex_lock(&client->tx_mutex);
+    while (sent < len) {
+        int n = send(client->socket_fd, buf + sent, len - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = {client->socket_fd, POLLOUT, 0};
+            if (poll(&pfd, 1, BEMFA_TCP_SEND_TIMEOUT_MS) > 0) {
+                continue;
+            }
+        }
+        break;
+    }
+    pthread_mutex_unlock(&client->tx_mutex);
+    return sent;
+}
+
 bemfa_tcp_handle_t bemfa_tcp_init(const bemfa_tcp_config_t *config) {
     if (!config) {
         return NULL;
@@ -43,6 +83,7 @@ bemfa_tcp_handle_t bemfa_tcp_init(const bemfa_tcp_config_t *config) {
     client->socket_fd = -1;
     client->state = BEMFA_TCP_STATE_DISCONNECTED;
     client->last_ping_time = 0;
+    pthread_mutex_init(&client->tx_mutex, NULL);
     
     return (bemfa_tcp_handle_t)client;
 }
@@ -108,6 +149,7 @@ int bemfa_tcp_connect(bemfa_tcp_handle_t handle) {
     
     client->state = BEMFA_TCP_STATE_CONNECTED;
     client->last_ping_time = time(NULL);
+    rx_reset(client);
     
     if (client->state_callback) {
         client->state_callback(client->state, client->state_user_data);
@@ -127,6 +169,7 @@ void bemfa_tcp_disconnect(bemfa_tcp_handle_t handle) {
         close(client->socket_fd);
         client->socket_fd = -1;
     }
+    rx_reset(client);
     
     client->state = BEMFA_TCP_STATE_DISCONNECTED;
     if (client->state_callback) {
@@ -155,7 +198,7 @@ int bemfa_tcp_subscribe(bemfa_tcp_handle_t handle, const char *topic) {
     printf("[BemfaTCP] 发送命令: %s", cmd);
     
     // 发送订阅命令
-    int sent = send(client->socket_fd, cmd, len, 0);
+    int sent = send_all(client, cmd, len);
     if (sent != len) {
         printf("[BemfaTCP] 发送订阅命令失败: sent=%d, expected=%d\n", sent, len);
         return -1;
@@ -180,10 +223,8 @@ int bemfa_tcp_publish(bemfa_tcp_handle_t handle, const char *topic, const char *
         return -1;
     }
     
-    printf("[BemfaTCP] 发布消息: topic=%s, msg_len=%zu\n", topic, strlen(msg));
-    
-    // 发送发布命令
-    int sent = send(client->socket_fd, cmd, len, 0);
+    // 发送发布命令（每条消息都会调用，不打印日志）
+    int sent = send_all(client, cmd, len);
     if (sent != len) {
         printf("[BemfaTCP] 发送发布命令失败: sent=%d, expected=%d\n", sent, len);
         if (errno == ECONNRESET || errno == EPIPE) {
@@ -206,7 +247,7 @@ int bemfa_tcp_ping(bemfa_tcp_handle_t handle) {
     
     // 发送心跳: ping\r\n
     const char *ping_cmd = "ping\r\n";
-    int sent = send(client->socket_fd, ping_cmd, strlen(ping_cmd), 0);
+    int sent = send_all(client, ping_cmd, strlen(ping_cmd));
     if (sent == strlen(ping_cmd)) {
         client->last_ping_time = time(NULL);
         return 0;
@@ -216,27 +257,12 @@ int bemfa_tcp_ping(bemfa_tcp_handle_t handle) {
     }
 }
 
-// 解析TCP响应
-static int parse_tcp_response(bemfa_tcp_client_t *client, const char *buf, int len) {
+// 解析一行TCP响应（temp为接收缓冲区内已去掉\r\n并以'\0'结尾的行，原地解析）
+static int parse_tcp_response(bemfa_tcp_client_t *client, char *temp, size_t len) {
     if (len < 3) {
         return -1;
     }
     
-    // 复制到临时缓冲区并添加结束符
-    char temp[1024];
-    if (len >= sizeof(temp)) {
-        len = sizeof(temp) - 1;
-    }
-    memcpy(temp, buf, len);
-    temp[len] = '\0';
-    
-    // 移除\r\n
-    while (len > 0 && (temp[len-1] == '\n' || temp[len-1] == '\r')) {
-        temp[--len] = '\0';
-    }
-    
-    printf("[BemfaTCP] 收到响应: %s (长度=%d)\n", temp, (int)strlen(temp));
-    
     // 解析响应
     if (strncmp(temp, "cmd=0&res=1", 11) == 0) {
         // 心跳响应
@@ -261,8 +287,7 @@ static int parse_tcp_response(bemfa_tcp_client_t *client, const char *buf, int l
         }
         return -1;
     } else if (strncmp(temp, "cmd=2&res=1", 11) == 0) {
-        // 发布成功响应
-        printf("[BemfaTCP] 发布成功\n");
+        // 发布成功响应（每条消息都会收到，不打印日志）
         return 0;
     } else if (strncmp(temp, "cmd=2&res=0", 11) == 0) {
         // 发布失败响应
@@ -270,52 +295,82 @@ static int parse_tcp_response(bemfa_tcp_client_t *client, const char *buf, int l
         return -1;
     } else if (strncmp(temp, "cmd=", 4) == 0) {
         // 消息格式: cmd=1&uid=xxx&topic=xxx&msg=xxx 或 cmd=9&uid=xxx&topic=xxx&msg=xxx
-        // 解析消息
-        char *topic = NULL;
-        char *msg = NULL;
-        char *p = temp;
-        
-        // 查找topic=
-        char *topic_start = strstr(p, "&topic=");
-        if (topic_start) {
-            topic_start += 7;  // 跳过"&topic="
-            char *topic_end = strchr(topic_start, '&');
+        // 原地解析：topic和msg直接指向接收缓冲区，不分配内存
+        char *msg = strstr(temp, "&msg=");
+        char *topic = strstr(temp, "&topic=");
+        if (msg) {
+            msg += 5;  // 跳过"&msg="
+        }
+        if (topic) {
+            topic += 7;  // 跳过"&topic="
+            char *topic_end = strchr(topic, '&');
             if (topic_end) {
-                int topic_len = topic_end - topic_start;
-                topic = (char *)malloc(topic_len + 1);
-                memcpy(topic, topic_start, topic_len);
-                topic[topic_len] = '\0';
-                p = topic_end + 1;
-            } else {
-                // topic可能是最后一个字段
-                topic = strdup(topic_start);
+                *topic_end = '\0';
             }
         }
         
-        // 查找msg=
-        char *msg_start = strstr(temp, "&msg=");
-        if (msg_start) {
-            msg_start += 5;  // 跳过"&msg="
-            msg = strdup(msg_start);
-        }
-        
         if (topic && msg && client->msg_callback) {
-            printf("[BemfaTCP] 解析到消息: topic=%s, msg_len=%zu\n", topic, strlen(msg));
-            client->msg_callback(topic, msg, strlen(msg), client->msg_user_data);
+            client->msg_callback(topic, msg, temp + len - msg, client->msg_user_data);
         } else {
             printf("[BemfaTCP] 警告：消息解析失败或回调未设置: topic=%p, msg=%p, callback=%p\n", 
                    topic, msg, client->msg_callback);
         }
         
-        if (topic) free(topic);
-        if (msg) free(msg);
-        
         return 0;
     }
     
     return -1;
 }
 
+// 从接收缓冲区中切分出完整的行并逐行解析，剩余的不完整行保留到下次recv
+static void rx_process_lines(bemfa_tcp_client_t *client) {
+    char *buf = client->rx_buf;
+    size_t start = 0;
+    size_t scan = client->rx_scanned;
+    
+    while (scan < client->rx_len) {
+        char *nl = memchr(buf + scan, '\n', client->rx_len - scan);
+        if (!nl) {
+            break;
+        }
+        
+        size_t end = nl - buf;
+        size_t line_len = end - start;
+        if (line_len > 0 && buf[start + line_len - 1] == '\r') {
+            line_len--;
+        }
+        buf[start + line_len] = '\0';
+        
+        if (client->rx_discarding) {
+            client->rx_discarding = false;
+        } else if (line_len > 0) {
+            parse_tcp_response(client, buf + start, line_len);
+        }
+        
+        // 回调中可能断开连接并清空缓冲区
+        if (client->rx_len == 0) {
+            return;
+        }
+        start = end + 1;
+        scan = start;
+    }
+    
+    // 将不完整的行移到缓冲区开头
+    if (start > 0) {
+        memmove(buf, buf + start, client->rx_len - start);
+        client->rx_len -= start;
+    }
+    client->rx_scanned = client->rx_len;
+    
+    // 缓冲区已满仍没有换行符：丢弃这一行的剩余部分
+    if (client->rx_len >= sizeof(client->rx_buf) - 1) {
+        printf("[BemfaTCP] 警告：单行超过%d字节，已丢弃\n", (int)sizeof(client->rx_buf));
+        client->rx_len = 0;
+        client->rx_scanned = 0;
+        client->rx_discarding = true;
+    }
+}
+
 int bemfa_tcp_loop(bemfa_tcp_handle_t handle) {
     bemfa_tcp_client_t *client = (bemfa_tcp_client_t *)handle;
     if (!client) {
@@ -333,32 +388,17 @@ int bemfa_tcp_loop(bemfa_tcp_handle_t handle) {
     
     // 检查心跳（建议60秒发送一次）
     time_t now = time(NULL);
-    if (now - client->last_ping_time >= 60) {
+    if (now - client->last_ping_time >= BEMFA_TCP_PING_INTERVAL) {
         bemfa_tcp_ping(handle);
     }
     
-    // 接收数据
-    char buf[2048];
-    int received = recv(client->socket_fd, buf, sizeof(buf) - 1, MSG_DONTWAIT);
+    // 接收数据（追加到重组缓冲区，保留1字节用于行结束符）
+    size_t space = sizeof(client->rx_buf) - 1 - client->rx_len;
+    int received = recv(client->socket_fd, client->rx_buf + client->rx_len, space, MSG_DONTWAIT);
     
     if (received > 0) {
-        buf[received] = '\0';
-        printf("[BemfaTCP] 收到数据: %s (长度=%d)\n", buf, received);
-        // 可能有多个响应，按\r\n分割
-        char *line = buf;
-        char *next;
-        while ((next = strstr(line, "\r\n")) != NULL) {
-            *next = '\0';
-            printf("[BemfaTCP] 处理一行: %s\n", line);
-            parse_tcp_response(client, line, next - line);
-            line = next + 2;
-            if (line >= buf + received) break;
-        }
-        // 处理最后一行（如果没有\r\n结尾）
-        if (line < buf + received && strlen(line) > 0) {
-            printf("[BemfaTCP] 处理最后一行: %s\n", line);
-            parse_tcp_response(client, line, strlen(line));
-        }
+        client->rx_len += received;
+        rx_process_lines(client);
         return 0;
     } else if (received < 0) {
         if (errno == EAGAIN || errno == EWOULDBLOCK) {
@@ -394,6 +434,14 @@ bemfa_tcp_state_t bemfa_tcp_get_state(bemfa_tcp_handle_t handle) {
     return client->state;
 }
 
+int bemfa_tcp_get_fd(bemfa_tcp_handle_t handle) {
+    bemfa_tcp_client_t *client = (bemfa_tcp_client_t *)handle;
+    if (!client) {
+        return -1;
+    }
+    return client->socket_fd;
+}
+
 void bemfa_tcp_set_message_callback(bemfa_tcp_handle_t handle,
                                     bemfa_tcp_message_callback_t callback,
                                     void *user_data) {
@@ -421,5 +469,6 @@ void bemfa_tcp_cleanup(bemfa_tcp_handle_t handle) {
     }
     
     bemfa_tcp_disconnect(handle);
+    pthread_mutex_destroy(&client->tx_mutex);
     free(client);
 }
@@ -13,6 +13,15 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+// 心跳间隔（秒），服务器超过65秒未收到数据会断线
+#define BEMFA_TCP_PING_INTERVAL 60
+
+// 发送缓冲区满时等待socket可写的超时（毫秒）
+#define BEMFA_TCP_SEND_TIMEOUT_MS 1000
+
+// 接收重组缓冲区大小（单行最大长度）
+#define BEMFA_TCP_RX_BUFFER_SIZE 8192
+
 // 巴法云TCP客户端状态
 typedef enum {
     BEMFA_TCP_STATE_DISCONNECTED = 0,
@@ -29,7 +38,7 @@ typedef struct {
     char topic[128];          // 主题名称
 } bemfa_tcp_config_t;
 
-// 消息回调函数
+// 消息回调函数（topic和msg指向客户端接收缓冲区，仅在回调期间有效）
 typedef void (*bemfa_tcp_message_callback_t)(const char *topic, const char *msg, size_t msg_len, void *user_data);
 typedef void (*bemfa_tcp_state_callback_t)(bemfa_tcp_state_t state, void *user_data);
 
@@ -75,13 +84,15 @@ int bemfa_tcp_publish(bemfa_tcp_handle_t handle, const char *topic, const char *
 
 /**
  * @brief 发送心跳
+ *
+ * 与bemfa_tcp_publish()可以在不同线程中调用：每条命令在客户端的发送锁内整行写入。
  * @param handle 客户端句柄
  * @return 成功返回0，失败返回-1
  */
 int bemfa_tcp_ping(bemfa_tcp_handle_t handle);
 
 /**
- * @brief 处理接收循环（需要在单独线程中调用）
+ * @brief 处理接收循环（需要在单独线程中调用，socket可读时调用即可）
  * @param handle 客户端句柄
  * @return 成功返回0，失败返回-1
  */
@@ -94,6 +105,13 @@ int bemfa_tcp_loop(bemfa_tcp_handle_t handle);
  */
 bemfa_tcp_state_t bemfa_tcp_get_state(bemfa_tcp_handle_t handle);
 
+/**
+ * @brief 获取socket文件描述符（用于epoll等事件循环）
+ * @param handle 客户端句柄
+ * @return socket描述符，未连接返回-1
+ */
+int bemfa_tcp_get_fd(bemfa_tcp_handle_t handle);
+
 /**
  * @brief 设置消息回调
  * @param handle 客户端句柄
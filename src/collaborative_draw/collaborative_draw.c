@@ -2,12 +2,14 @@
  * @file collaborative_draw.c
  * @brief 实时多人在线协作绘图系统实现
  * 
- * 使用巴法云TCP协议实现设备间通信
+ * 使用巴法云TCP协议实现设备间通信，局域网内可改用UDP组播直连（lan_transport）
  */
 
 #include "collaborative_draw.h"
 #include "draw_protocol.h"
 #include "bemfa_tcp_client.h"
+#include "lan_transport.h"
+#include "latency_stats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -18,43 +20,418 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#define COLLAB_MAX_PEERS 8        // 同时跟踪的远端用户数
+#define COLLAB_FRAME_MAX 256      // 单帧二进制上限
+#define COLLAB_SYNC_FRAME_MAX 512 // 快照帧二进制上限（base64后约680字符，仍在bemfa单条消息限制内；等于LAN_TRANSPORT_FRAME_MAX）
+#define COLLAB_SYNC_TILE_PIXELS (DRAW_SYNC_TILE_SIZE * DRAW_SYNC_TILE_SIZE)
+
+// 批量发送默认参数
+#define COLLAB_BATCH_DEFAULT_BYTES    200
+#define COLLAB_BATCH_DEFAULT_POINTS   32
+#define COLLAB_BATCH_DEFAULT_DELAY_MS 8
+#define COLLAB_E2E_LATENCY_LIMIT_MS   60000   // 超过此值视为两端时钟未同步，不计入统计
+#define COLLAB_STROKE_RECORD_ENV      "COLLAB_STROKE_RECORD"  // 设置后把本地笔画录制到该文件（供负载生成器回放）
+#define COLLAB_TRANSPORT_ENV          "COLLAB_TRANSPORT"      // lan/bemfa，覆盖配置中的传输方式
 
 // 协作绘图模块状态
 static struct {
     collaborative_draw_config_t config;
     collaborative_draw_state_t state;
     bemfa_tcp_handle_t bemfa_tcp_handle;  // 巴法云TCP客户端句柄
-    pthread_t recv_thread;
-    pthread_t send_thread;
+    lan_transport_handle_t lan_handle;    // 局域网组播句柄（非NULL时所有帧走局域网）
+    pthread_t io_thread;                  // 网络I/O线程（epoll）
     bool threads_running;
+    int epoll_fd;                         // 监听socket、wake_fd、ping_fd
+    int wake_fd;                          // eventfd：有出站数据或需要退出时唤醒I/O线程
+    int ping_fd;                          // timerfd：心跳定时器
     pthread_mutex_t send_mutex;
     void (*remote_draw_callback)(uint16_t x, uint16_t y, uint16_t prev_x, uint16_t prev_y,
                                  uint8_t pen_size, uint32_t color, bool is_eraser, void *user_data);
     void *remote_draw_user_data;
+    void (*remote_undo_callback)(uint32_t user_id, bool redo, void *user_data);
+    void *remote_undo_user_data;
+    draw_codec_state_t send_codec;        // 发送端差分编码状态（受send_mutex保护）
+    struct {
+        uint8_t frame[COLLAB_FRAME_MAX];  // 待发送的批量帧
+        int len;                          // 帧长度（0表示空）
+        int points;                       // 帧内点数
+        uint64_t first_ms;                // 第一个点入队时间（单调时钟）
+        uint64_t first_us;                // 第一个点入队时间（单调时钟微秒，延迟统计用）
+        uint64_t first_input_us;          // 第一个点的触摸时间（单调时钟微秒）
+        uint64_t latency_sum_ms;          // 累计入队延迟（按点）
+    } batch;                              // 受send_mutex保护
+    collaborative_draw_stats_t stats;     // 受send_mutex保护（发送和接收路径都在锁内更新）
+    uint64_t rate_window_start_ms;
+    uint32_t rate_window_msgs;
+    uint64_t e2e_latency_sum_ms;          // 计入平均值的端到端延迟之和（受send_mutex保护）
+    uint32_t e2e_latency_count;           // 计入平均值的消息数（有时间戳且未超过上限）
+    uint32_t rx_timestamp;                // 正在分发的帧的发送端时间戳（仅网络I/O线程访问）
+    uint32_t rx_user_id;                  // 正在分发的帧的发送者ID（仅网络I/O线程访问）
+    FILE *record_fp;                      // 笔画录制文件（受send_mutex保护）
+    struct {
+        bool in_use;
+        uint32_t user_id;
+        draw_codec_state_t codec;
+    } peers[COLLAB_MAX_PEERS];            // 远端用户解码状态（仅网络接收线程访问）
+    int next_peer_victim;
+    collaborative_draw_sync_t sync;       // 画布快照处理器
+    bool sync_enabled;
+    // 快照编解码缓冲区（仅网络I/O线程访问）
+    uint32_t sync_pixels[COLLAB_SYNC_TILE_PIXELS];
+    uint8_t sync_frame[COLLAB_SYNC_FRAME_MAX];
+    uint8_t sync_payload[COLLAB_SYNC_FRAME_MAX];
 } g_collab_draw = {0};
 
-// 二进制数据转十六进制字符串
-static void bin_to_hex(const uint8_t *bin, int bin_len, char *hex, int hex_size) {
-    int len = 0;
-    for (int i = 0; i < bin_len && len < hex_size - 1; i++) {
-        len += snprintf(hex + len, hex_size - len, "%02X", bin[i]);
+// 查找（或分配）远端用户的差分解码状态
+static draw_codec_state_t *get_peer_codec(uint32_t user_id) {
+    int free_slot = -1;
+    for (int i = 0; i < COLLAB_MAX_PEERS; i++) {
+        if (g_collab_draw.peers[i].in_use) {
+            if (g_collab_draw.peers[i].user_id == user_id) {
+                return &g_collab_draw.peers[i].codec;
+            }
+        } else if (free_slot < 0) {
+            free_slot = i;
+        }
+    }
+    
+    // 表满时轮换覆盖最旧的槽位（被覆盖的用户会在下一个关键帧重新同步）
+    if (free_slot < 0) {
+        free_slot = g_collab_draw.next_peer_victim;
+        g_collab_draw.next_peer_victim = (g_collab_draw.next_peer_victim + 1) % COLLAB_MAX_PEERS;
     }
-    hex[len] = '\0';
+    
+    g_collab_draw.peers[free_slot].in_use = true;
+    g_collab_draw.peers[free_slot].user_id = user_id;
+    draw_codec_reset(&g_collab_draw.peers[free_slot].codec);
+    return &g_collab_draw.peers[free_slot].codec;
 }
 
-// 十六进制字符串转二进制数据
-static int hex_to_bin(const char *hex, uint8_t *bin, int bin_size) {
-    int hex_len = strlen(hex);
-    if (hex_len % 2 != 0) {
-        return -1;
+// 单调时钟毫秒数（用于批量超时）
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// 发布一帧二进制数据（base64url文本）到主题/set
+static int publish_frame(const uint8_t *frame, int frame_len) {
+    int ret;
+    size_t sent_bytes = frame_len;
+    if (g_collab_draw.lan_handle) {
+        // 局域网模式：二进制帧直接组播，不需要base64
+        ret = lan_transport_send(g_collab_draw.lan_handle, frame, frame_len);
+    } else {
+        char text[DRAW_WIRE_TEXT_LEN(COLLAB_SYNC_FRAME_MAX) + 1];
+        if (draw_wire_to_text(frame, frame_len, text, sizeof(text)) < 0) {
+            return -1;
+        }
+        
+        // 发布消息到主题/set（推送模式，向所有订阅者推送）
+        char topic_set[128];
+        snprintf(topic_set, sizeof(topic_set), "%s/set", g_collab_draw.config.device_name);
+        
+        ret = bemfa_tcp_publish(g_collab_draw.bemfa_tcp_handle, topic_set, text);
+        sent_bytes = strlen(text);
+    }
+    if (ret == 0) {
+        g_collab_draw.stats.msgs_sent++;
+        g_collab_draw.stats.bytes_sent += sent_bytes;
+        g_collab_draw.rate_window_msgs++;
+    }
+    
+    uint64_t now = monotonic_ms();
+    if (now - g_collab_draw.rate_window_start_ms >= 1000) {
+        g_collab_draw.stats.msgs_per_sec = (uint32_t)(g_collab_draw.rate_window_msgs * 1000ULL /
+                                                     (now - g_collab_draw.rate_window_start_ms));
+        g_collab_draw.rate_window_start_ms = now;
+        g_collab_draw.rate_window_msgs = 0;
+    }
+    return ret;
+}
+
+// 发布当前批量帧（调用者需持有send_mutex）
+static int flush_batch_locked(void) {
+    if (g_collab_draw.batch.len == 0) {
+        return 0;
+    }
+    
+    // 帧头补上发送端延迟（第一个点从触摸到现在），空间不足时不带
+    uint64_t send_us = latency_now_us();
+    int len = draw_frame_set_sender_delay(g_collab_draw.batch.frame, sizeof(g_collab_draw.batch.frame),
+                                          g_collab_draw.batch.len,
+                                          (uint32_t)(send_us - g_collab_draw.batch.first_input_us));
+    if (len > 0) {
+        g_collab_draw.batch.len = len;
+    }
+    
+    int ret = publish_frame(g_collab_draw.batch.frame, g_collab_draw.batch.len);
+    if (ret == 0) {
+        latency_stats_record(LATENCY_STAGE_BATCH_SEND, (uint32_t)(latency_now_us() - g_collab_draw.batch.first_us));
+        uint64_t now = monotonic_ms();
+        uint32_t latency = (uint32_t)(now - g_collab_draw.batch.first_ms);
+        g_collab_draw.stats.points_sent += g_collab_draw.batch.points;
+        g_collab_draw.batch.latency_sum_ms += (uint64_t)latency * g_collab_draw.batch.points;
+        if (g_collab_draw.stats.points_sent > 0) {
+            g_collab_draw.stats.batch_latency_avg_ms =
+                (uint32_t)(g_collab_draw.batch.latency_sum_ms / g_collab_draw.stats.points_sent);
+        }
+        if (latency > g_collab_draw.stats.batch_latency_max_ms) {
+            g_collab_draw.stats.batch_latency_max_ms = latency;
+        }
+    } else {
+        // 发布失败：丢弃本帧，下一个点从关键帧开始以免接收端差分错位
+        draw_codec_reset(&g_collab_draw.send_codec);
+    }
+    
+    g_collab_draw.batch.len = 0;
+    g_collab_draw.batch.points = 0;
+    return ret;
+}
+
+// 发布一帧快照（加锁以免与批量帧交错写socket）
+static int publish_sync_frame(const uint8_t *frame, int frame_len) {
+    pthread_mutex_lock(&g_collab_draw.send_mutex);
+    int ret = publish_frame(frame, frame_len);
+    pthread_mutex_unlock(&g_collab_draw.send_mutex);
+    return ret;
+}
+
+// 向快照帧追加一个分块记录，帧满时先发布当前帧（网络I/O线程调用）
+static int sync_append_tile(const draw_sync_tile_t *tile, int *frame_len) {
+    uint8_t *frame = g_collab_draw.sync_frame;
+    int rec_len = draw_frame_append_tile(tile, frame + *frame_len, COLLAB_SYNC_FRAME_MAX - *frame_len);
+    if (rec_len < 0) {
+        if (publish_sync_frame(frame, *frame_len) != 0) {
+            return -1;
+        }
+        *frame_len = draw_frame_begin(frame, COLLAB_SYNC_FRAME_MAX, g_collab_draw.config.user_id, 0);
+        rec_len = draw_frame_append_tile(tile, frame + *frame_len, COLLAB_SYNC_FRAME_MAX - *frame_len);
+        if (rec_len < 0) {
+            return -1;
+        }
+    }
+    *frame_len += rec_len;
+    g_collab_draw.stats.sync_tiles_sent++;
+    return 0;
+}
+
+// 响应同步请求：先发一条整区域背景记录，再逐块发送非背景分块（网络I/O线程调用）
+static void answer_sync_request(uint32_t requester) {
+    const collaborative_draw_sync_t *sync = &g_collab_draw.sync;
+    uint32_t *pixels = g_collab_draw.sync_pixels;
+    int frame_len = draw_frame_begin(g_collab_draw.sync_frame, COLLAB_SYNC_FRAME_MAX,
+                                     g_collab_draw.config.user_id, 0);
+    // 每个分块负载上限：保证空帧中一定放得下
+    size_t payload_max = COLLAB_SYNC_FRAME_MAX - frame_len - DRAW_TILE_RECORD_MAX;
+    uint32_t tiles_before = g_collab_draw.stats.sync_tiles_sent;
+    uint32_t msgs_before = g_collab_draw.stats.msgs_sent;
+    
+    draw_sync_tile_t tile = {0};
+    tile.target_user = requester;
+    tile.x = sync->area_x;
+    tile.y = sync->area_y;
+    tile.w = sync->area_w;
+    tile.h = sync->area_h;
+    if (sync_append_tile(&tile, &frame_len) != 0) {
+        return;
+    }
+    
+    for (int ty = 0; ty < sync->area_h; ty += DRAW_SYNC_TILE_SIZE) {
+        for (int tx = 0; tx < sync->area_w; tx += DRAW_SYNC_TILE_SIZE) {
+            if (!g_collab_draw.threads_running) {
+                return;
+            }
+            
+            int tw = sync->area_w - tx < DRAW_SYNC_TILE_SIZE ? sync->area_w - tx : DRAW_SYNC_TILE_SIZE;
+            int th = sync->area_h - ty < DRAW_SYNC_TILE_SIZE ? sync->area_h - ty : DRAW_SYNC_TILE_SIZE;
+            if (sync->read_rect(sync->area_x + tx, sync->area_y + ty, tw, th,
+                                pixels, sync->user_data) != 0) {
+                printf("[协作绘图] 读取画布分块失败，中止同步\n");
+                return;
+            }
+            
+            int count = tw * th;
+            int k = 0;
+            while (k < count && pixels[k] == sync->background) {
+                k++;
+            }
+            if (k == count) {
+                continue;  // 背景分块已由整区域记录覆盖
+            }
+            
+            // 压缩后放不进一帧的分块按行对半拆分（单行最坏情况也放得下）
+            int row = 0;
+            while (row < th) {
+                int rows = th - row;
+                int len;
+                while ((len = draw_tile_encode(pixels + row * tw, tw, rows, tw,
+                                               g_collab_draw.sync_payload, payload_max)) < 0) {
+                    rows /= 2;
+                }
+                
+                tile.x = sync->area_x + tx;
+                tile.y = sync->area_y + ty + row;
+                tile.w = tw;
+                tile.h = rows;
+                tile.data = g_collab_draw.sync_payload;
+                tile.data_len = (uint16_t)len;
+                if (sync_append_tile(&tile, &frame_len) != 0) {
+                    printf("[协作绘图] 发送画布快照失败，中止同步\n");
+                    return;
+                }
+                row += rows;
+            }
+        }
+    }
+    
+    if (publish_sync_frame(g_collab_draw.sync_frame, frame_len) != 0) {
+        printf("[协作绘图] 发送画布快照失败\n");
+        return;
+    }
+    printf("[协作绘图] 已向用户%u发送画布快照：%u个分块，%u条消息\n", requester,
+           g_collab_draw.stats.sync_tiles_sent - tiles_before,
+           g_collab_draw.stats.msgs_sent - msgs_before);
+}
+
+// 应用一条快照记录（客机，网络I/O线程调用），返回是否已应用
+static bool apply_sync_tile(const draw_sync_tile_t *tile) {
+    const collaborative_draw_sync_t *sync = &g_collab_draw.sync;
+    if (tile->target_user != g_collab_draw.config.user_id || !sync->apply_rect) {
+        return false;
+    }
+    
+    if (tile->data_len == 0) {
+        sync->apply_rect(tile->x, tile->y, tile->w, tile->h, NULL, sync->user_data);
+    } else {
+        int count = tile->w * tile->h;
+        if (count <= 0 || count > COLLAB_SYNC_TILE_PIXELS ||
+            draw_tile_decode(tile->data, tile->data_len, g_collab_draw.sync_pixels, count) != 0) {
+            printf("[协作绘图] 画布快照分块格式错误，已丢弃\n");
+            return false;
+        }
+        sync->apply_rect(tile->x, tile->y, tile->w, tile->h, g_collab_draw.sync_pixels, sync->user_data);
+    }
+    return true;
+}
+
+// 记录收到一帧（帧头部分），持有send_mutex，与collaborative_draw_get_stats()读取时同一把锁
+static void record_frame_received(uint32_t timestamp) {
+    pthread_mutex_lock(&g_collab_draw.send_mutex);
+    g_collab_draw.stats.msgs_received++;
+    if (timestamp) {
+        uint32_t latency = latency_wall_ms() - timestamp;
+        if (latency < COLLAB_E2E_LATENCY_LIMIT_MS) {
+            // 平均值只除以计入的消息数（没有时间戳或超过上限的消息不计入）
+            g_collab_draw.e2e_latency_sum_ms += latency;
+            g_collab_draw.e2e_latency_count++;
+            g_collab_draw.stats.e2e_latency_avg_ms =
+                (uint32_t)(g_collab_draw.e2e_latency_sum_ms / g_collab_draw.e2e_latency_count);
+            if (latency > g_collab_draw.stats.e2e_latency_max_ms) {
+                g_collab_draw.stats.e2e_latency_max_ms = latency;
+            }
+        }
+    }
+    pthread_mutex_unlock(&g_collab_draw.send_mutex);
+}
+
+// 累加一帧内绘制的点数和应用的快照分块数（帧处理完后加锁一次，不在回调期间持有锁）
+static void record_frame_applied(uint32_t points, uint32_t tiles) {
+    if (points == 0 && tiles == 0) {
+        return;
+    }
+    pthread_mutex_lock(&g_collab_draw.send_mutex);
+    g_collab_draw.stats.points_received += points;
+    g_collab_draw.stats.sync_tiles_received += tiles;
+    pthread_mutex_unlock(&g_collab_draw.send_mutex);
+}
+
+// 解码并分发一个二进制帧（两种传输共用，网络I/O线程调用）；rx_us为收到消息的时刻
+static void handle_frame(const uint8_t *buffer, int bin_len, uint64_t rx_us) {
+    draw_frame_reader_t reader;
+    if (draw_frame_reader_init(&reader, buffer, bin_len) != 0) {
+        printf("[协作绘图] 解码绘图帧失败（版本不匹配或格式错误）\n");
+        return;
+    }
+    reader.state = get_peer_codec(reader.user_id);
+    
+    g_collab_draw.rx_timestamp = reader.timestamp;
+    g_collab_draw.rx_user_id = reader.user_id;
+    if (reader.sender_delay_us) {
+        latency_stats_record_since_wall(LATENCY_STAGE_NETWORK, reader.timestamp, reader.sender_delay_us);
+    }
+    record_frame_received(reader.timestamp);
+    
+    draw_operation_t op;
+    int ret;
+    uint32_t points = 0;
+    uint32_t tiles = 0;
+    while ((ret = draw_frame_reader_next(&reader, &op)) == 1) {
+        // 检查状态和回调（防止在解码过程中状态改变）
+        if (g_collab_draw.state != COLLAB_DRAW_STATE_CONNECTED ||
+            !g_collab_draw.threads_running ||
+            !g_collab_draw.remote_draw_callback) {
+            record_frame_applied(points, tiles);
+            return;
+        }
+        
+        if (op.msg_type == MSG_TYPE_CLEAR) {
+            // 清屏操作：通过回调函数传递特殊参数（pen_size=0表示清屏，color=白色）
+            g_collab_draw.remote_draw_callback(
+                0, 0, 0, 0,
+                0, 0xFFFFFFFF, false,
+                g_collab_draw.remote_draw_user_data);
+            continue;
+        }
+        
+        if (op.msg_type == MSG_TYPE_UNDO || op.msg_type == MSG_TYPE_REDO) {
+            // 撤销/重做按发送者的笔画历史执行，忽略自己发出的（本地已经执行过）
+            if (g_collab_draw.remote_undo_callback && reader.user_id != g_collab_draw.config.user_id) {
+                g_collab_draw.remote_undo_callback(reader.user_id, op.msg_type == MSG_TYPE_REDO,
+                                                   g_collab_draw.remote_undo_user_data);
+            }
+            continue;
+        }
+        
+        if (op.msg_type == MSG_TYPE_SYNC_REQUEST) {
+            // 只有提供了画布读取接口的一端（主机）响应，忽略自己发出的请求
+            if (g_collab_draw.sync_enabled && g_collab_draw.sync.read_rect &&
+                reader.user_id != g_collab_draw.config.user_id) {
+                answer_sync_request(reader.user_id);
+            }
+            continue;
+        }
+        
+        if (op.msg_type == MSG_TYPE_SYNC_RESPONSE) {
+            if (g_collab_draw.sync_enabled && apply_sync_tile(&reader.tile)) {
+                tiles++;
+            }
+            continue;
+        }
+        
+        // 检查pen_size是否有效（pen_size=0表示无效数据）
+        if (op.pen_size == 0) {
+            continue;
+        }
+        
+        points++;
+        
+        // 批量帧内的每一段分别回调绘制（不打印日志以提高性能）
+        g_collab_draw.remote_draw_callback(
+            op.x, op.y, op.prev_x, op.prev_y,
+            op.pen_size, op.color, op.is_eraser,
+            g_collab_draw.remote_draw_user_data);
     }
     
-    int bin_len = 0;
-    for (int i = 0; i < hex_len && bin_len < bin_size; i += 2) {
-        char hex_byte[3] = {hex[i], hex[i+1], '\0'};
-        bin[bin_len++] = (uint8_t)strtoul(hex_byte, NULL, 16);
+    record_frame_applied(points, tiles);
+    if (ret < 0) {
+        printf("[协作绘图] 解码绘图操作失败\n");
     }
-    return bin_len;
+    latency_stats_record(LATENCY_STAGE_DECODE, (uint32_t)(latency_now_us() - rx_us));
 }
 
 // 巴法云TCP消息处理器
@@ -92,126 +469,265 @@ static void bemfa_tcp_message_handler(const char *topic, const char *msg, size_t
     if (!msg || msg_len == 0) {
         return;
     }
+    uint64_t rx_us = latency_now_us();
     
-    // 将十六进制字符串解码为二进制数据
-    uint8_t buffer[256];
-    int bin_len = hex_to_bin(msg, buffer, sizeof(buffer));
+    // 将base64url文本还原为二进制帧
+    uint8_t buffer[COLLAB_SYNC_FRAME_MAX];
+    int bin_len = draw_wire_from_text(msg, msg_len, buffer, sizeof(buffer));
     if (bin_len <= 0) {
-        printf("[协作绘图] 解码消息失败: hex_to_bin返回%d\n", bin_len);
+        printf("[协作绘图] 解码消息失败: draw_wire_from_text返回%d\n", bin_len);
         return;
     }
     
-    // 解码绘图操作
-    draw_operation_t op;
-    if (draw_operation_decode(buffer, bin_len, &op) == 0) {
-        if (debug_enabled && msg_count % 100 == 0) {
-            printf("[协作绘图] 解码绘图操作成功: x=%d, y=%d, pen_size=%d\n",
-                   op.x, op.y, op.pen_size);
-        }
-        
-        // 检查消息类型
-        if (op.msg_type == MSG_TYPE_CLEAR) {
-            // 清屏操作：通过回调函数传递特殊参数（pen_size=0表示清屏）
-            if (g_collab_draw.state == COLLAB_DRAW_STATE_CONNECTED && 
-                g_collab_draw.threads_running && 
-                g_collab_draw.remote_draw_callback) {
-                // 调用回调函数，使用pen_size=0和color=0xFFFFFFFF（白色）表示清屏
-                g_collab_draw.remote_draw_callback(
-                    0, 0, 0, 0,
-                    0, 0xFFFFFFFF, false,  // pen_size=0表示清屏，color=白色
-                    g_collab_draw.remote_draw_user_data);
-            }
-            return;
+    handle_frame(buffer, bin_len, rx_us);
+}
+
+// 局域网帧回调（网络I/O线程调用）
+static void lan_frame_handler(uint32_t sender, const uint8_t *frame, size_t len, bool after_gap, void *user_data) {
+    (void)user_data;
+    uint64_t rx_us = latency_now_us();
+    
+    // 放弃过缺口：该用户的差分状态已不可信，从下一个关键帧重新开始
+    if (after_gap) {
+        draw_codec_reset(get_peer_codec(sender));
+    }
+    
+    if (g_collab_draw.state != COLLAB_DRAW_STATE_CONNECTED || !g_collab_draw.threads_running ||
+        !g_collab_draw.remote_draw_callback) {
+        return;
+    }
+    handle_frame(frame, (int)len, rx_us);
+}
+
+// 唤醒网络I/O线程
+static void wake_io_thread(void) {
+    if (g_collab_draw.wake_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t ret = write(g_collab_draw.wake_fd, &one, sizeof(one));
+        (void)ret;  // 计数器已满(EAGAIN)时线程必然已被唤醒
+    }
+}
+
+// 关闭I/O线程使用的文件描述符
+static void close_io_fds(void) {
+    if (g_collab_draw.epoll_fd >= 0) {
+        close(g_collab_draw.epoll_fd);
+        g_collab_draw.epoll_fd = -1;
+    }
+    if (g_collab_draw.wake_fd >= 0) {
+        close(g_collab_draw.wake_fd);
+        g_collab_draw.wake_fd = -1;
+    }
+    if (g_collab_draw.ping_fd >= 0) {
+        close(g_collab_draw.ping_fd);
+        g_collab_draw.ping_fd = -1;
+    }
+}
+
+// 创建epoll、eventfd和心跳timerfd（局域网模式不需要心跳，定时器不启动）
+static int open_io_fds(int socket_fd, bool ping) {
+    g_collab_draw.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    g_collab_draw.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    g_collab_draw.ping_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (g_collab_draw.epoll_fd < 0 || g_collab_draw.wake_fd < 0 || g_collab_draw.ping_fd < 0) {
+        printf("[协作绘图] 创建epoll/eventfd/timerfd失败: %s\n", strerror(errno));
+        close_io_fds();
+        return -1;
+    }
+    
+    if (ping) {
+        struct itimerspec its = {0};
+        its.it_value.tv_sec = BEMFA_TCP_PING_INTERVAL;
+        its.it_interval.tv_sec = BEMFA_TCP_PING_INTERVAL;
+        timerfd_settime(g_collab_draw.ping_fd, 0, &its, NULL);
+    }
+    
+    int fds[3] = {socket_fd, g_collab_draw.wake_fd, g_collab_draw.ping_fd};
+    for (int i = 0; i < 3; i++) {
+        struct epoll_event ev = {0};
+        ev.events = EPOLLIN | (i == 0 ? EPOLLRDHUP : 0);
+        ev.data.fd = fds[i];
+        if (epoll_ctl(g_collab_draw.epoll_fd, EPOLL_CTL_ADD, fds[i], &ev) != 0) {
+            printf("[协作绘图] epoll_ctl失败: %s\n", strerror(errno));
+            close_io_fds();
+            return -1;
         }
-        
-        // 检查pen_size是否有效（pen_size=0表示无效数据）
-        if (op.pen_size == 0) {
-            return;
+    }
+    return 0;
+}
+
+// 处理socket可读（含对端关闭/错误）
+static bool handle_socket_readable(void) {
+    if (g_collab_draw.lan_handle) {
+        if (lan_transport_poll(g_collab_draw.lan_handle) < 0) {
+            printf("[协作绘图] 局域网组播socket错误，更新状态并停止线程\n");
+            g_collab_draw.state = COLLAB_DRAW_STATE_DISCONNECTED;
+            g_collab_draw.threads_running = false;
+            return false;
         }
-        
-        // 再次检查状态和回调（防止在解码过程中状态改变）
-        if (g_collab_draw.state == COLLAB_DRAW_STATE_CONNECTED &&
-            g_collab_draw.threads_running && 
-            g_collab_draw.remote_draw_callback) {
-            // 直接调用回调函数绘制（不打印日志以提高性能）
-            g_collab_draw.remote_draw_callback(
-                op.x, op.y, op.prev_x, op.prev_y,
-                op.pen_size, op.color, op.is_eraser,
-                g_collab_draw.remote_draw_user_data);
+        return true;
+    }
+    
+    if (bemfa_tcp_loop(g_collab_draw.bemfa_tcp_handle) < 0) {
+        bemfa_tcp_state_t tcp_state = bemfa_tcp_get_state(g_collab_draw.bemfa_tcp_handle);
+        if (tcp_state == BEMFA_TCP_STATE_DISCONNECTED || tcp_state == BEMFA_TCP_STATE_ERROR) {
+            printf("[协作绘图] 巴法云TCP连接已断开或错误，更新状态并停止线程\n");
+            g_collab_draw.state = COLLAB_DRAW_STATE_DISCONNECTED;
+            g_collab_draw.threads_running = false;
+            return false;
         }
-    } else {
-        printf("[协作绘图] 解码绘图操作失败\n");
     }
+    return true;
 }
 
-// 网络接收线程函数
-static void* network_recv_thread_func(void *arg) {
+// 网络I/O线程函数：socket可读、出站批量帧、心跳均由epoll事件驱动，空闲时不占用CPU
+static void* network_io_thread_func(void *arg) {
     (void)arg;
     
-    printf("[协作绘图] 网络接收线程启动\n");
+    printf("[协作绘图] 网络I/O线程启动\n");
     
+    struct epoll_event events[4];
     while (g_collab_draw.threads_running) {
-        // 检查状态，如果已断开或错误，退出循环
-        if (g_collab_draw.state != COLLAB_DRAW_STATE_CONNECTED) {
-            // 如果状态不是已连接，等待一段时间后退出
-            usleep(100000);  // 100ms
-            if (!g_collab_draw.threads_running) {
-                break;  // 如果停止标志已设置，立即退出
+        // 局域网模式：HELLO、NACK重试等定时任务（可能交付帧，不能持有send_mutex）
+        int timeout_ms = -1;
+        lan_transport_stats_t lan_stats = {0};
+        if (g_collab_draw.lan_handle) {
+            timeout_ms = lan_transport_tick(g_collab_draw.lan_handle);
+            lan_transport_get_stats(g_collab_draw.lan_handle, &lan_stats);
+        }
+        
+        // 有待发送的批量帧时，最多等待到其超时时刻
+        pthread_mutex_lock(&g_collab_draw.send_mutex);
+        if (g_collab_draw.lan_handle) {
+            g_collab_draw.stats.lan_peers = lan_stats.peers;
+            g_collab_draw.stats.lan_nacks_sent = lan_stats.nacks_sent;
+            g_collab_draw.stats.lan_retransmits = lan_stats.retransmits;
+            g_collab_draw.stats.lan_lost = lan_stats.lost;
+        }
+        if (g_collab_draw.batch.len > 0) {
+            uint64_t now = monotonic_ms();
+            uint64_t deadline = g_collab_draw.batch.first_ms + g_collab_draw.config.batch_max_delay_ms;
+            if (now >= deadline) {
+                flush_batch_locked();
+            } else if (timeout_ms < 0 || (int)(deadline - now) < timeout_ms) {
+                timeout_ms = (int)(deadline - now);
             }
-            continue;
         }
+        pthread_mutex_unlock(&g_collab_draw.send_mutex);
         
-        // 使用bemfa_tcp_loop处理接收
-        if (g_collab_draw.bemfa_tcp_handle) {
-            int ret = bemfa_tcp_loop(g_collab_draw.bemfa_tcp_handle);
-            if (ret < 0) {
-                bemfa_tcp_state_t tcp_state = bemfa_tcp_get_state(g_collab_draw.bemfa_tcp_handle);
-                if (tcp_state == BEMFA_TCP_STATE_DISCONNECTED || tcp_state == BEMFA_TCP_STATE_ERROR) {
-                    printf("[协作绘图] 巴法云TCP连接已断开或错误，更新状态并停止线程\n");
-                    g_collab_draw.state = COLLAB_DRAW_STATE_DISCONNECTED;
-                    // 设置停止标志，让发送线程也退出
-                    g_collab_draw.threads_running = false;
-                    break;  // 退出循环
-                }
+        int n = epoll_wait(g_collab_draw.epoll_fd, events, 4, timeout_ms);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
             }
-        } else {
-            // TCP句柄无效，连接已断开
-            printf("[协作绘图] TCP句柄无效，退出接收线程\n");
+            printf("[协作绘图] epoll_wait失败: %s\n", strerror(errno));
             g_collab_draw.state = COLLAB_DRAW_STATE_DISCONNECTED;
             g_collab_draw.threads_running = false;
-            break;  // 退出循环
+            break;
         }
         
-        usleep(10000);  // 10ms
+        for (int i = 0; i < n && g_collab_draw.threads_running; i++) {
+            int fd = events[i].data.fd;
+            uint64_t counter;
+            if (fd == g_collab_draw.wake_fd) {
+                // 出站数据或退出请求：清空计数，循环开头处理批量帧
+                while (read(fd, &counter, sizeof(counter)) > 0) {
+                }
+            } else if (fd == g_collab_draw.ping_fd) {
+                while (read(fd, &counter, sizeof(counter)) > 0) {
+                }
+                // 与发布使用同一把锁：send_all等待可写时心跳不能插入半条发布命令
+                pthread_mutex_lock(&g_collab_draw.send_mutex);
+                if (g_collab_draw.bemfa_tcp_handle) {
+                    bemfa_tcp_ping(g_collab_draw.bemfa_tcp_handle);
+                }
+                pthread_mutex_unlock(&g_collab_draw.send_mutex);
+            } else if (!handle_socket_readable()) {
+                break;
+            }
+        }
     }
     
-    printf("[协作绘图] 网络接收线程退出\n");
+    // 退出前尽量发出剩余的点
+    pthread_mutex_lock(&g_collab_draw.send_mutex);
+    if (g_collab_draw.state == COLLAB_DRAW_STATE_CONNECTED) {
+        flush_batch_locked();
+    }
+    g_collab_draw.batch.len = 0;
+    g_collab_draw.batch.points = 0;
+    pthread_mutex_unlock(&g_collab_draw.send_mutex);
+    
+    printf("[协作绘图] 网络I/O线程退出\n");
     return NULL;
 }
 
-// 网络发送线程函数（用于定期发送心跳）
-static void* network_send_thread_func(void *arg) {
-    (void)arg;
+// 加入局域网组播
+static int open_lan_transport(void) {
+    lan_transport_config_t lan_config = {0};
+    snprintf(lan_config.group, sizeof(lan_config.group), "%s", g_collab_draw.config.lan_group);
+    lan_config.port = g_collab_draw.config.lan_port;
+    snprintf(lan_config.iface, sizeof(lan_config.iface), "%s", g_collab_draw.config.lan_iface);
+    lan_config.user_id = g_collab_draw.config.user_id;
+    snprintf(lan_config.room, sizeof(lan_config.room), "%s", g_collab_draw.config.device_name);
     
-    printf("[协作绘图] 网络发送线程启动\n");
+    g_collab_draw.lan_handle = lan_transport_open(&lan_config);
+    if (!g_collab_draw.lan_handle) {
+        return -1;
+    }
+    lan_transport_set_frame_callback(g_collab_draw.lan_handle, lan_frame_handler, NULL);
+    return 0;
+}
+
+// 连接巴法云并订阅主题，失败时释放客户端
+static int connect_bemfa(void) {
+    bemfa_tcp_config_t tcp_config = {0};
+    strncpy(tcp_config.server_host, g_collab_draw.config.server_host, sizeof(tcp_config.server_host) - 1);
+    tcp_config.server_port = g_collab_draw.config.server_port;
+    strncpy(tcp_config.uid, g_collab_draw.config.private_key, sizeof(tcp_config.uid) - 1);
+    strncpy(tcp_config.topic, g_collab_draw.config.device_name, sizeof(tcp_config.topic) - 1);
     
-    while (g_collab_draw.threads_running) {
-        // 检查状态，如果已断开或错误，退出循环
-        if (g_collab_draw.state != COLLAB_DRAW_STATE_CONNECTED) {
-            // 如果状态不是已连接，等待一段时间后退出
-            usleep(100000);  // 100ms
-            if (!g_collab_draw.threads_running) {
-                break;  // 如果停止标志已设置，立即退出
-            }
-            continue;
-        }
-        
-        // 心跳由bemfa_tcp_loop自动处理（60秒一次）
-        usleep(100000);  // 100ms
+    g_collab_draw.bemfa_tcp_handle = bemfa_tcp_init(&tcp_config);
+    if (!g_collab_draw.bemfa_tcp_handle) {
+        printf("[协作绘图] 巴法云TCP客户端初始化失败\n");
+        return -1;
     }
     
-    printf("[协作绘图] 网络发送线程退出\n");
-    return NULL;
+    // 设置消息回调
+    bemfa_tcp_set_message_callback(g_collab_draw.bemfa_tcp_handle, bemfa_tcp_message_handler, NULL);
+    
+    // 连接服务器
+    if (bemfa_tcp_connect(g_collab_draw.bemfa_tcp_handle) != 0) {
+        printf("[协作绘图] 巴法云TCP连接失败\n");
+        bemfa_tcp_cleanup(g_collab_draw.bemfa_tcp_handle);
+        g_collab_draw.bemfa_tcp_handle = NULL;
+        return -1;
+    }
+    
+    // 订阅主题（使用设备名称作为主题）
+    char topic[128];
+    snprintf(topic, sizeof(topic), "%s", g_collab_draw.config.device_name);
+    
+    if (bemfa_tcp_subscribe(g_collab_draw.bemfa_tcp_handle, topic) != 0) {
+        printf("[协作绘图] 发送订阅命令失败: %s\n", topic);
+        bemfa_tcp_disconnect(g_collab_draw.bemfa_tcp_handle);
+        bemfa_tcp_cleanup(g_collab_draw.bemfa_tcp_handle);
+        g_collab_draw.bemfa_tcp_handle = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// 关闭当前传输（I/O线程已退出后调用）
+static void close_transport(void) {
+    if (g_collab_draw.lan_handle) {
+        lan_transport_close(g_collab_draw.lan_handle);
+        g_collab_draw.lan_handle = NULL;
+    }
+    if (g_collab_draw.bemfa_tcp_handle) {
+        bemfa_tcp_disconnect(g_collab_draw.bemfa_tcp_handle);
+        bemfa_tcp_cleanup(g_collab_draw.bemfa_tcp_handle);
+        g_collab_draw.bemfa_tcp_handle = NULL;
+    }
 }
 
 int collaborative_draw_init(const collaborative_draw_config_t *config) {
@@ -219,11 +735,41 @@ int collaborative_draw_init(const collaborative_draw_config_t *config) {
         return -1;
     }
     
+    if (g_collab_draw.record_fp) {
+        fclose(g_collab_draw.record_fp);  // 未经cleanup重复初始化
+    }
     memset(&g_collab_draw, 0, sizeof(g_collab_draw));
     memcpy(&g_collab_draw.config, config, sizeof(collaborative_draw_config_t));
     g_collab_draw.state = COLLAB_DRAW_STATE_DISCONNECTED;
     g_collab_draw.bemfa_tcp_handle = NULL;
     pthread_mutex_init(&g_collab_draw.send_mutex, NULL);
+    g_collab_draw.epoll_fd = -1;
+    g_collab_draw.wake_fd = -1;
+    g_collab_draw.ping_fd = -1;
+    
+    // 批量参数缺省值
+    if (g_collab_draw.config.batch_max_bytes == 0 || g_collab_draw.config.batch_max_bytes > COLLAB_FRAME_MAX) {
+        g_collab_draw.config.batch_max_bytes = COLLAB_BATCH_DEFAULT_BYTES;
+    }
+    if (g_collab_draw.config.batch_max_points == 0) {
+        g_collab_draw.config.batch_max_points = COLLAB_BATCH_DEFAULT_POINTS;
+    }
+    if (g_collab_draw.config.batch_max_delay_ms == 0) {
+        g_collab_draw.config.batch_max_delay_ms = COLLAB_BATCH_DEFAULT_DELAY_MS;
+    }
+    
+    const char *transport = getenv(COLLAB_TRANSPORT_ENV);
+    if (transport && strcmp(transport, "lan") == 0) {
+        g_collab_draw.config.transport = COLLAB_TRANSPORT_LAN;
+    } else if (transport && strcmp(transport, "bemfa") == 0) {
+        g_collab_draw.config.transport = COLLAB_TRANSPORT_BEMFA;
+    }
+    
+    const char *record_path = getenv(COLLAB_STROKE_RECORD_ENV);
+    if (record_path && record_path[0]) {
+        g_collab_draw.record_fp = fopen(record_path, "a");
+        printf("[协作绘图] 笔画录制%s: %s\n", g_collab_draw.record_fp ? "已开启" : "打开文件失败", record_path);
+    }
     
     printf("[协作绘图] 模块初始化完成\n");
     return 0;
@@ -237,8 +783,7 @@ int collaborative_draw_start(void) {
     
     // 确保所有状态都被重置（清理之前可能的残留状态）
     g_collab_draw.threads_running = false;
-    g_collab_draw.recv_thread = 0;
-    g_collab_draw.send_thread = 0;
+    g_collab_draw.io_thread = 0;
     
     // 清理之前的TCP连接
     if (g_collab_draw.bemfa_tcp_handle) {
@@ -248,54 +793,59 @@ int collaborative_draw_start(void) {
     
     g_collab_draw.state = COLLAB_DRAW_STATE_CONNECTING;
     
-    // 巴法云TCP协议模式
-    bemfa_tcp_config_t tcp_config = {0};
-    strncpy(tcp_config.server_host, g_collab_draw.config.server_host, sizeof(tcp_config.server_host) - 1);
-    tcp_config.server_port = g_collab_draw.config.server_port;
-    strncpy(tcp_config.uid, g_collab_draw.config.private_key, sizeof(tcp_config.uid) - 1);
-    strncpy(tcp_config.topic, g_collab_draw.config.device_name, sizeof(tcp_config.topic) - 1);
+    // 新连接从关键帧开始，丢弃旧的差分状态和未发送的批量帧
+    pthread_mutex_lock(&g_collab_draw.send_mutex);
+    draw_codec_reset(&g_collab_draw.send_codec);
+    g_collab_draw.batch.len = 0;
+    g_collab_draw.batch.points = 0;
+    pthread_mutex_unlock(&g_collab_draw.send_mutex);
+    memset(g_collab_draw.peers, 0, sizeof(g_collab_draw.peers));
+    g_collab_draw.next_peer_victim = 0;
     
-    g_collab_draw.bemfa_tcp_handle = bemfa_tcp_init(&tcp_config);
-    if (!g_collab_draw.bemfa_tcp_handle) {
-        printf("[协作绘图] 巴法云TCP客户端初始化失败\n");
-        g_collab_draw.state = COLLAB_DRAW_STATE_DISCONNECTED;
-        return -1;
+    // 局域网模式：加入组播失败时回退到巴法云
+    int socket_fd = -1;
+    if (g_collab_draw.config.transport == COLLAB_TRANSPORT_LAN) {
+        if (open_lan_transport() == 0) {
+            socket_fd = lan_transport_get_fd(g_collab_draw.lan_handle);
+        } else {
+            printf("[协作绘图] 局域网组播不可用，回退到巴法云TCP\n");
+        }
+    }
+    if (socket_fd < 0) {
+        if (connect_bemfa() != 0) {
+            g_collab_draw.state = COLLAB_DRAW_STATE_DISCONNECTED;
+            return -1;
+        }
+        socket_fd = bemfa_tcp_get_fd(g_collab_draw.bemfa_tcp_handle);
     }
     
-    // 设置消息回调
-    bemfa_tcp_set_message_callback(g_collab_draw.bemfa_tcp_handle, bemfa_tcp_message_handler, NULL);
-    
-    // 连接服务器
-    if (bemfa_tcp_connect(g_collab_draw.bemfa_tcp_handle) != 0) {
-        printf("[协作绘图] 巴法云TCP连接失败\n");
-        bemfa_tcp_cleanup(g_collab_draw.bemfa_tcp_handle);
-        g_collab_draw.bemfa_tcp_handle = NULL;
+    // 启动网络I/O线程
+    if (open_io_fds(socket_fd, g_collab_draw.lan_handle == NULL) != 0) {
+        close_transport();
         g_collab_draw.state = COLLAB_DRAW_STATE_DISCONNECTED;
         return -1;
     }
-    
-    // 订阅主题（使用设备名称作为主题）
-    char topic[128];
-    snprintf(topic, sizeof(topic), "%s", g_collab_draw.config.device_name);
-    
-    if (bemfa_tcp_subscribe(g_collab_draw.bemfa_tcp_handle, topic) != 0) {
-        printf("[协作绘图] 发送订阅命令失败: %s\n", topic);
-        bemfa_tcp_disconnect(g_collab_draw.bemfa_tcp_handle);
-        bemfa_tcp_cleanup(g_collab_draw.bemfa_tcp_handle);
-        g_collab_draw.bemfa_tcp_handle = NULL;
+    g_collab_draw.threads_running = true;
+    if (pthread_create(&g_collab_draw.io_thread, NULL, network_io_thread_func, NULL) != 0) {
+        printf("[协作绘图] 创建网络I/O线程失败\n");
+        g_collab_draw.threads_running = false;
+        g_collab_draw.io_thread = 0;
+        close_io_fds();
+        close_transport();
         g_collab_draw.state = COLLAB_DRAW_STATE_DISCONNECTED;
         return -1;
     }
     
-    // 启动接收和发送线程
-    g_collab_draw.threads_running = true;
-    pthread_create(&g_collab_draw.recv_thread, NULL, network_recv_thread_func, NULL);
-    pthread_create(&g_collab_draw.send_thread, NULL, network_send_thread_func, NULL);
+    if (g_collab_draw.lan_handle) {
+        g_collab_draw.state = COLLAB_DRAW_STATE_CONNECTED;
+        printf("[协作绘图] 已加入局域网组播房间: %s\n", g_collab_draw.config.device_name);
+        return 0;
+    }
     
     // 注意：订阅响应是异步的，这里先设置为CONNECTED
     // 如果订阅失败（res=0），网络接收线程会检测到并更新状态
     g_collab_draw.state = COLLAB_DRAW_STATE_CONNECTED;
-    printf("[协作绘图] 订阅命令已发送，等待服务器响应: %s (TCP协议)\n", topic);
+    printf("[协作绘图] 订阅命令已发送，等待服务器响应: %s (TCP协议)\n", g_collab_draw.config.device_name);
     printf("[协作绘图] 注意：如果收到res=0，订阅将失败\n");
     
     return 0;
@@ -307,66 +857,30 @@ void collaborative_draw_stop(void) {
     // g_collab_draw.remote_draw_callback = NULL;
     // g_collab_draw.remote_draw_user_data = NULL;
     
-    // 设置停止标志
+    // 设置停止标志并唤醒I/O线程（epoll_wait立即返回，因此可以直接join）
     g_collab_draw.threads_running = false;
+    wake_io_thread();
     
-    // 等待接收线程退出（使用轮询方式，最多等待2秒）
-    if (g_collab_draw.recv_thread != 0) {
-        pthread_t recv_thread_id = g_collab_draw.recv_thread;  // 保存线程ID
-        int wait_count = 0;
-        int thread_alive = 1;
-        while (wait_count < 20) {  // 最多等待2秒（20 * 100ms）
-            int ret = pthread_kill(recv_thread_id, 0);
-            if (ret != 0) {
-                // 线程已退出（ESRCH = 线程不存在）
-                thread_alive = 0;
-                break;
-            }
-            usleep(100000);  // 100ms
-            wait_count++;
-        }
-        if (thread_alive && wait_count >= 20) {
-            printf("[协作绘图] 警告：接收线程退出超时，强制继续\n");
-        } else if (thread_alive) {
-            // 线程还存在，尝试join（使用保存的线程ID）
-            int ret = pthread_join(recv_thread_id, NULL);
-            if (ret != 0 && ret != ESRCH) {
-                printf("[协作绘图] 警告：接收线程join失败: %s (ret=%d)\n", strerror(ret), ret);
-            }
-        }
-        g_collab_draw.recv_thread = 0;  // 重置线程ID
-    }
-    
-    // 等待发送线程退出（使用轮询方式，最多等待2秒）
-    if (g_collab_draw.send_thread != 0) {
-        pthread_t send_thread_id = g_collab_draw.send_thread;  // 保存线程ID
-        int wait_count = 0;
-        int thread_alive = 1;
-        while (wait_count < 20) {  // 最多等待2秒（20 * 100ms）
-            int ret = pthread_kill(send_thread_id, 0);
-            if (ret != 0) {
-                // 线程已退出
-                thread_alive = 0;
-                break;
-            }
-            usleep(100000);  // 100ms
-            wait_count++;
-        }
-        if (thread_alive && wait_count >= 20) {
-            printf("[协作绘图] 警告：发送线程退出超时，强制继续\n");
-        } else if (thread_alive) {
-            // 线程还存在，尝试join（使用保存的线程ID）
-            int ret = pthread_join(send_thread_id, NULL);
-            if (ret != 0 && ret != ESRCH) {
-                printf("[协作绘图] 警告：发送线程join失败: %s (ret=%d)\n", strerror(ret), ret);
-            }
+    if (g_collab_draw.io_thread != 0) {
+        int ret = pthread_join(g_collab_draw.io_thread, NULL);
+        if (ret != 0 && ret != ESRCH) {
+            printf("[协作绘图] 警告：网络I/O线程join失败: %s (ret=%d)\n", strerror(ret), ret);
         }
-        g_collab_draw.send_thread = 0;  // 重置线程ID
+        g_collab_draw.io_thread = 0;  // 重置线程ID
     }
+    pthread_mutex_lock(&g_collab_draw.send_mutex);
+    close_io_fds();
+    pthread_mutex_unlock(&g_collab_draw.send_mutex);
     
     if (g_collab_draw.bemfa_tcp_handle) {
         bemfa_tcp_disconnect(g_collab_draw.bemfa_tcp_handle);
     }
+    if (g_collab_draw.lan_handle) {
+        pthread_mutex_lock(&g_collab_draw.send_mutex);
+        lan_transport_close(g_collab_draw.lan_handle);
+        g_collab_draw.lan_handle = NULL;
+        pthread_mutex_unlock(&g_collab_draw.send_mutex);
+    }
     
     g_collab_draw.state = COLLAB_DRAW_STATE_DISCONNECTED;
     printf("[协作绘图] 已断开连接\n");
@@ -376,18 +890,29 @@ int collaborative_draw_send_operation(uint16_t x, uint16_t y,
                                       uint16_t prev_x, uint16_t prev_y,
                                       uint8_t pen_size, uint32_t color, 
                                       bool is_eraser) {
+    return collaborative_draw_send_operation_at(x, y, prev_x, prev_y, pen_size, color, is_eraser,
+                                                latency_now_us());
+}
+
+int collaborative_draw_send_operation_at(uint16_t x, uint16_t y,
+                                         uint16_t prev_x, uint16_t prev_y,
+                                         uint8_t pen_size, uint32_t color,
+                                         bool is_eraser, uint64_t input_us) {
     // 检查状态，如果未连接则静默失败
     if (g_collab_draw.state != COLLAB_DRAW_STATE_CONNECTED) {
         return -1;
     }
     
-    if (!g_collab_draw.bemfa_tcp_handle) {
+    if (!g_collab_draw.bemfa_tcp_handle && !g_collab_draw.lan_handle) {
         return -1;
     }
     
     draw_operation_t op = {0};
     op.user_id = g_collab_draw.config.user_id;
-    op.timestamp = (uint32_t)(time(NULL) * 1000);  // 毫秒时间戳
+    // 帧头时间戳为触摸时刻的墙上时钟，接收端据此计算端到端延迟
+    uint64_t now_us = latency_now_us();
+    uint64_t input_age_ms = input_us < now_us ? (now_us - input_us) / 1000 : 0;
+    op.timestamp = latency_wall_ms() - (uint32_t)input_age_ms;
     op.x = x;
     op.y = y;
     op.prev_x = prev_x;
@@ -397,22 +922,65 @@ int collaborative_draw_send_operation(uint16_t x, uint16_t y,
     op.is_eraser = is_eraser;
     op.msg_type = is_eraser ? MSG_TYPE_ERASE : MSG_TYPE_DRAW_LINE;
     
-    // 编码绘图操作
-    uint8_t buffer[256];
-    int encoded_len = draw_operation_encode(&op, buffer, sizeof(buffer));
-    if (encoded_len <= 0) {
-        return -1;
+    // 追加到批量帧（坐标相对上一个点差分编码）
+    int ret = 0;
+    pthread_mutex_lock(&g_collab_draw.send_mutex);
+    
+    // 录制笔画（每行"x y"，空行分隔笔画，格式见tools/collab_bench）
+    draw_codec_state_t *codec = &g_collab_draw.send_codec;
+    if (g_collab_draw.record_fp) {
+        if (!codec->valid || prev_x != codec->last_x || prev_y != codec->last_y) {
+            fprintf(g_collab_draw.record_fp, "\n%u %u\n", prev_x, prev_y);
+        }
+        fprintf(g_collab_draw.record_fp, "%u %u\n", x, y);
     }
     
-    // 将二进制数据转换为十六进制字符串
-    char hex_msg[512];
-    bin_to_hex(buffer, encoded_len, hex_msg, sizeof(hex_msg));
+    // 笔画中断时先发出上一笔的剩余点，使每个批量帧只包含同一笔画
+    if (g_collab_draw.batch.len > 0 && (prev_x != codec->last_x || prev_y != codec->last_y)) {
+        ret = flush_batch_locked();
+    }
+    
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (g_collab_draw.batch.len == 0) {
+            int head_len = draw_frame_begin(g_collab_draw.batch.frame, sizeof(g_collab_draw.batch.frame),
+                                            op.user_id, op.timestamp);
+            if (head_len < 0) {
+                ret = -1;
+                break;
+            }
+            g_collab_draw.batch.len = head_len;
+            g_collab_draw.batch.first_ms = monotonic_ms();
+            g_collab_draw.batch.first_us = now_us;
+            g_collab_draw.batch.first_input_us = input_us < now_us ? input_us : now_us;
+        }
+        
+        int room = g_collab_draw.config.batch_max_bytes - g_collab_draw.batch.len;
+        int rec_len = room > 0 ?
+            draw_frame_append(codec, &op, g_collab_draw.batch.frame + g_collab_draw.batch.len, room) : -1;
+        if (rec_len > 0) {
+            g_collab_draw.batch.len += rec_len;
+            g_collab_draw.batch.points++;
+            break;
+        }
+        
+        // 帧已满：先发出当前帧再重试一次
+        if (g_collab_draw.batch.points == 0) {
+            ret = -1;
+            break;
+        }
+        ret = flush_batch_locked();
+    }
     
-    // 发布消息到主题/set（推送模式，向所有订阅者推送）
-    char topic_set[128];
-    snprintf(topic_set, sizeof(topic_set), "%s/set", g_collab_draw.config.device_name);
+    if (g_collab_draw.batch.points >= g_collab_draw.config.batch_max_points ||
+        g_collab_draw.batch.len + DRAW_RECORD_MAX > g_collab_draw.config.batch_max_bytes) {
+        ret = flush_batch_locked();
+    } else if (g_collab_draw.batch.points == 1) {
+        // 新帧开始计时，唤醒I/O线程设置超时
+        wake_io_thread();
+    }
     
-    return bemfa_tcp_publish(g_collab_draw.bemfa_tcp_handle, topic_set, hex_msg);
+    pthread_mutex_unlock(&g_collab_draw.send_mutex);
+    return ret;
 }
 
 int collaborative_draw_send_clear(void) {
@@ -421,36 +989,70 @@ int collaborative_draw_send_clear(void) {
         return -1;
     }
     
-    if (!g_collab_draw.bemfa_tcp_handle) {
+    if (!g_collab_draw.bemfa_tcp_handle && !g_collab_draw.lan_handle) {
         return -1;
     }
     
     draw_operation_t op = {0};
     op.user_id = g_collab_draw.config.user_id;
-    op.timestamp = (uint32_t)(time(NULL) * 1000);
+    op.timestamp = latency_wall_ms();
     op.msg_type = MSG_TYPE_CLEAR;
     
-    uint8_t buffer[256];
-    int encoded_len = draw_operation_encode(&op, buffer, sizeof(buffer));
-    if (encoded_len <= 0) {
+    uint8_t frame[COLLAB_FRAME_MAX];
+    int frame_len = draw_operation_encode(&op, frame, sizeof(frame));
+    if (frame_len <= 0) {
         return -1;
     }
     
-    // 将二进制数据转换为十六进制字符串
-    char hex_msg[512];
-    bin_to_hex(buffer, encoded_len, hex_msg, sizeof(hex_msg));
+    // 先发出未完成的批量帧，保证清屏不会越过之前的笔画
+    pthread_mutex_lock(&g_collab_draw.send_mutex);
+    flush_batch_locked();
+    int ret = publish_frame(frame, frame_len);
+    pthread_mutex_unlock(&g_collab_draw.send_mutex);
+    return ret;
+}
+
+int collaborative_draw_send_undo(bool redo) {
+    if (g_collab_draw.state != COLLAB_DRAW_STATE_CONNECTED ||
+        (!g_collab_draw.bemfa_tcp_handle && !g_collab_draw.lan_handle)) {
+        return -1;
+    }
     
-    // 发布消息到主题/set（推送模式）
-    char topic_set[128];
-    snprintf(topic_set, sizeof(topic_set), "%s/set", g_collab_draw.config.device_name);
+    draw_operation_t op = {0};
+    op.user_id = g_collab_draw.config.user_id;
+    op.timestamp = latency_wall_ms();
+    op.msg_type = redo ? MSG_TYPE_REDO : MSG_TYPE_UNDO;
+    
+    uint8_t frame[COLLAB_FRAME_MAX];
+    int frame_len = draw_operation_encode(&op, frame, sizeof(frame));
+    if (frame_len <= 0) {
+        return -1;
+    }
     
-    return bemfa_tcp_publish(g_collab_draw.bemfa_tcp_handle, topic_set, hex_msg);
+    // 与清屏相同，先发出未完成的批量帧，保证撤销的是对端已经收到的笔画
+    pthread_mutex_lock(&g_collab_draw.send_mutex);
+    flush_batch_locked();
+    int ret = publish_frame(frame, frame_len);
+    pthread_mutex_unlock(&g_collab_draw.send_mutex);
+    return ret;
 }
 
 collaborative_draw_state_t collaborative_draw_get_state(void) {
     return g_collab_draw.state;
 }
 
+uint32_t collaborative_draw_get_rx_timestamp(void) {
+    return g_collab_draw.rx_timestamp;
+}
+
+uint32_t collaborative_draw_get_rx_user(void) {
+    return g_collab_draw.rx_user_id;
+}
+
+collaborative_draw_transport_t collaborative_draw_get_transport(void) {
+    return g_collab_draw.lan_handle ? COLLAB_TRANSPORT_LAN : COLLAB_TRANSPORT_BEMFA;
+}
+
 void collaborative_draw_set_remote_draw_callback(
     void (*callback)(uint16_t x, uint16_t y, uint16_t prev_x, uint16_t prev_y,
                      uint8_t pen_size, uint32_t color, bool is_eraser, void *user_data),
@@ -459,6 +1061,55 @@ void collaborative_draw_set_remote_draw_callback(
     g_collab_draw.remote_draw_user_data = user_data;
 }
 
+void collaborative_draw_set_remote_undo_callback(
+    void (*callback)(uint32_t user_id, bool redo, void *user_data),
+    void *user_data) {
+    g_collab_draw.remote_undo_callback = callback;
+    g_collab_draw.remote_undo_user_data = user_data;
+}
+
+void collaborative_draw_set_sync_handler(const collaborative_draw_sync_t *sync) {
+    g_collab_draw.sync_enabled = false;
+    if (sync) {
+        memcpy(&g_collab_draw.sync, sync, sizeof(*sync));
+        g_collab_draw.sync_enabled = true;
+    }
+}
+
+int collaborative_draw_request_sync(void) {
+    if (g_collab_draw.state != COLLAB_DRAW_STATE_CONNECTED ||
+        (!g_collab_draw.bemfa_tcp_handle && !g_collab_draw.lan_handle)) {
+        return -1;
+    }
+    
+    draw_operation_t op = {0};
+    op.user_id = g_collab_draw.config.user_id;
+    op.msg_type = MSG_TYPE_SYNC_REQUEST;
+    
+    uint8_t frame[DRAW_FRAME_HEADER_MAX + DRAW_RECORD_MAX];
+    int frame_len = draw_operation_encode(&op, frame, sizeof(frame));
+    if (frame_len <= 0) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&g_collab_draw.send_mutex);
+    int ret = publish_frame(frame, frame_len);
+    pthread_mutex_unlock(&g_collab_draw.send_mutex);
+    
+    printf("[协作绘图] 已请求画布快照\n");
+    return ret;
+}
+
+void collaborative_draw_get_stats(collaborative_draw_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+    
+    pthread_mutex_lock(&g_collab_draw.send_mutex);
+    memcpy(stats, &g_collab_draw.stats, sizeof(*stats));
+    pthread_mutex_unlock(&g_collab_draw.send_mutex);
+}
+
 void collaborative_draw_cleanup(void) {
     collaborative_draw_stop();
     
@@ -467,6 +1118,11 @@ void collaborative_draw_cleanup(void) {
         g_collab_draw.bemfa_tcp_handle = NULL;
     }
     
+    if (g_collab_draw.record_fp) {
+        fclose(g_collab_draw.record_fp);
+        g_collab_draw.record_fp = NULL;
+    }
+    
     // 销毁互斥锁（如果已初始化）
     // 注意：如果互斥锁未初始化，pthread_mutex_destroy 可能失败
     // 但通常不会导致段错误，只是返回错误
@@ -12,6 +12,12 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// 传输方式
+typedef enum {
+    COLLAB_TRANSPORT_BEMFA = 0,     // 经巴法云TCP服务器转发（默认）
+    COLLAB_TRANSPORT_LAN            // 局域网UDP组播直连（失败时回退到巴法云）
+} collaborative_draw_transport_t;
+
 // 协作绘图配置
 typedef struct {
     bool enabled;                   // 是否启用协作模式
@@ -21,8 +27,51 @@ typedef struct {
     char room_id[64];               // 房间ID（保留，未使用）
     char device_name[128];          // 巴法云设备名称（主题名称）
     char private_key[128];          // 巴法云个人私钥（UID）
+    uint16_t batch_max_bytes;       // 批量帧字节上限（0=默认，最大256）
+    uint16_t batch_max_points;      // 批量帧点数上限（0=默认）
+    uint16_t batch_max_delay_ms;    // 批量帧最长等待时间（0=默认）
+    collaborative_draw_transport_t transport;  // 传输方式（环境变量COLLAB_TRANSPORT=lan/bemfa可覆盖）
+    char lan_group[32];             // 局域网组播地址（空=默认239.255.43.21）
+    uint16_t lan_port;              // 局域网组播端口（0=默认8345）
+    char lan_iface[32];             // 局域网网卡IPv4地址（空=系统默认）
 } collaborative_draw_config_t;
 
+// 协作绘图统计信息
+typedef struct {
+    uint32_t msgs_sent;             // 已发布消息数
+    uint32_t points_sent;           // 已发送的点数
+    uint32_t bytes_sent;            // 已发送的文本字节数（局域网模式为二进制字节数）
+    uint32_t msgs_per_sec;          // 最近一秒的发布速率
+    uint32_t batch_latency_avg_ms;  // 点入队到发布的平均延迟
+    uint32_t batch_latency_max_ms;  // 点入队到发布的最大延迟
+    uint32_t msgs_received;         // 已接收消息数
+    uint32_t points_received;       // 已接收的点数
+    uint32_t e2e_latency_avg_ms;    // 端到端笔画延迟（发送端触摸到本地接收，需两端时间同步）
+    uint32_t e2e_latency_max_ms;    // 端到端笔画最大延迟
+    uint32_t sync_tiles_sent;       // 已发送的画布快照分块数（主机）
+    uint32_t sync_tiles_received;   // 已应用的画布快照分块数（客机）
+    uint32_t lan_peers;             // 局域网模式：最近发现的同房间设备数
+    uint32_t lan_nacks_sent;        // 局域网模式：发出的重传请求
+    uint32_t lan_retransmits;       // 局域网模式：响应重传请求的包
+    uint32_t lan_lost;              // 局域网模式：重试后仍丢失的包
+} collaborative_draw_stats_t;
+
+// 画布快照同步处理器（坐标均为framebuffer像素坐标，像素为ARGB）
+typedef struct {
+    uint16_t area_x;                // 同步区域左上角X
+    uint16_t area_y;                // 同步区域左上角Y
+    uint16_t area_w;                // 同步区域宽度
+    uint16_t area_h;                // 同步区域高度
+    uint32_t background;            // 背景色（全为背景色的分块不发送）
+    // 读取画布矩形（主机，网络I/O线程调用），成功返回0；为NULL时不响应同步请求
+    int (*read_rect)(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                     uint32_t *pixels, void *user_data);
+    // 应用快照矩形（客机，网络I/O线程调用）；pixels为NULL表示用背景色填充
+    void (*apply_rect)(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                       const uint32_t *pixels, void *user_data);
+    void *user_data;
+} collaborative_draw_sync_t;
+
 // 协作绘图状态
 typedef enum {
     COLLAB_DRAW_STATE_DISCONNECTED = 0,
@@ -39,7 +88,9 @@ typedef enum {
 int collaborative_draw_init(const collaborative_draw_config_t *config);
 
 /**
- * @brief 启动协作绘图（连接服务器）
+ * @brief 启动协作绘图（连接服务器或加入局域网组播）
+ *
+ * 配置为局域网模式时先尝试加入组播，失败（无组播路由、端口被占用等）则回退到巴法云。
  * @return 成功返回0，失败返回-1
  */
 int collaborative_draw_start(void);
@@ -51,6 +102,8 @@ void collaborative_draw_stop(void);
 
 /**
  * @brief 发送绘图操作到服务器
+ *
+ * 操作先进入批量帧，达到字节/点数上限、笔画中断或等待超时后由发送线程发布。
  * @param x X坐标
  * @param y Y坐标
  * @param prev_x 上一个X坐标
@@ -65,18 +118,59 @@ int collaborative_draw_send_operation(uint16_t x, uint16_t y,
                                       uint8_t pen_size, uint32_t color, 
                                       bool is_eraser);
 
+/**
+ * @brief 发送绘图操作，并指定该点的触摸时间（用于分阶段延迟统计）
+ *
+ * 参数同collaborative_draw_send_operation；input_us为读到触摸事件的时刻
+ * （latency_now_us()时间基准，即单调时钟微秒），帧头时间戳据此回推到触摸时刻。
+ * @return 成功返回0，失败返回-1
+ */
+int collaborative_draw_send_operation_at(uint16_t x, uint16_t y,
+                                         uint16_t prev_x, uint16_t prev_y,
+                                         uint8_t pen_size, uint32_t color,
+                                         bool is_eraser, uint64_t input_us);
+
 /**
  * @brief 发送清屏操作
  * @return 成功返回0，失败返回-1
  */
 int collaborative_draw_send_clear(void);
 
+/**
+ * @brief 发送撤销/重做操作（对端撤销或重做本用户最近的一笔）
+ * @param redo true为重做，false为撤销
+ * @return 成功返回0，失败返回-1
+ */
+int collaborative_draw_send_undo(bool redo);
+
 /**
  * @brief 获取当前连接状态
  * @return 连接状态
  */
 collaborative_draw_state_t collaborative_draw_get_state(void);
 
+/**
+ * @brief 获取正在分发的帧的发送端时间戳（触摸时刻的墙上时钟毫秒，0表示无）
+ *
+ * 只在远程绘图回调中调用有效，用于把端到端延迟统计延伸到本地写入framebuffer。
+ * @return 时间戳
+ */
+uint32_t collaborative_draw_get_rx_timestamp(void);
+
+/**
+ * @brief 获取正在分发的帧的发送者用户ID
+ *
+ * 只在远程绘图回调中调用有效，用于按用户区分远程笔画（撤销历史）。
+ * @return 用户ID
+ */
+uint32_t collaborative_draw_get_rx_user(void);
+
+/**
+ * @brief 获取当前实际使用的传输方式（局域网回退后为巴法云）
+ * @return 传输方式
+ */
+collaborative_draw_transport_t collaborative_draw_get_transport(void);
+
 /**
  * @brief 设置远程绘图回调（当收到其他用户的绘图操作时调用）
  * @param callback 回调函数
@@ -87,6 +181,36 @@ void collaborative_draw_set_remote_draw_callback(
                      uint8_t pen_size, uint32_t color, bool is_eraser, void *user_data),
     void *user_data);
 
+/**
+ * @brief 设置远程撤销/重做回调（收到其他用户的撤销或重做操作时在网络I/O线程调用）
+ * @param callback 回调函数，user_id为发出操作的用户，redo为true表示重做
+ * @param user_data 用户数据
+ */
+void collaborative_draw_set_remote_undo_callback(
+    void (*callback)(uint32_t user_id, bool redo, void *user_data),
+    void *user_data);
+
+/**
+ * @brief 设置画布快照同步处理器
+ *
+ * 主机提供read_rect，收到同步请求时按分块读取画布，跳过背景分块，
+ * RLE压缩后分多条消息发给请求者；客机提供apply_rect，逐块应用收到的快照。
+ * @param sync 处理器（NULL表示取消）
+ */
+void collaborative_draw_set_sync_handler(const collaborative_draw_sync_t *sync);
+
+/**
+ * @brief 向主机请求画布快照（客机加入后调用）
+ * @return 成功返回0，失败返回-1
+ */
+int collaborative_draw_request_sync(void);
+
+/**
+ * @brief 获取统计信息（消息速率、批量延迟、端到端延迟）
+ * @param stats 输出统计信息
+ */
+void collaborative_draw_get_stats(collaborative_draw_stats_t *stats);
+
 /**
  * @brief 清理协作绘图模块
  */
@@ -7,48 +7,665 @@
 #include <string.h>
 #include <stdio.h>
 
+// base64url 字母表（不含 '+' '/' '='，可安全放入 bemfa 的 msg= 字段）
+static const char b64_alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+// 快照RLE的最近使用颜色表大小（索引7保留给颜色字面量）
+#define DRAW_TILE_MRU_SIZE 7
+
+// 是否为携带坐标的记录类型
+static bool record_has_coords(uint8_t msg_type) {
+    return msg_type == MSG_TYPE_DRAW_LINE ||
+           msg_type == MSG_TYPE_DRAW_POINT ||
+           msg_type == MSG_TYPE_ERASE;
+}
+
+// 写入无符号varint，返回写入字节数，空间不足返回0
+static size_t put_varint(uint8_t *p, const uint8_t *end, uint32_t v) {
+    size_t n = 0;
+    do {
+        if (p + n >= end) {
+            return 0;
+        }
+        uint8_t b = v & 0x7F;
+        v >>= 7;
+        p[n++] = v ? (b | 0x80) : b;
+    } while (v);
+    return n;
+}
+
+// 读取无符号varint，失败返回false
+static bool get_varint(const uint8_t **pp, const uint8_t *end, uint32_t *out) {
+    const uint8_t *p = *pp;
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (p >= end) {
+            return false;
+        }
+        uint8_t b = *p++;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *pp = p;
+            *out = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32_t zigzag_encode(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t zigzag_decode(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/**
+ * @brief 重置差分编解码状态（下一条记录将作为关键帧）
+ * @param state 编解码状态
+ */
+void draw_codec_reset(draw_codec_state_t *state) {
+    if (state) {
+        memset(state, 0, sizeof(*state));
+    }
+}
+
+/**
+ * @brief 写入帧头
+ * @param buffer 输出缓冲区
+ * @param buffer_size 缓冲区大小
+ * @param user_id 发送者用户ID
+ * @param timestamp 毫秒时间戳，0表示不携带
+ * @return 帧头长度，失败返回-1
+ */
+int draw_frame_begin(uint8_t *buffer, size_t buffer_size, uint32_t user_id, uint32_t timestamp) {
+    if (!buffer || buffer_size < 2) {
+        return -1;
+    }
+
+    const uint8_t *end = buffer + buffer_size;
+    uint8_t flags = timestamp ? DRAW_FRAME_F_TIMESTAMP : 0;
+    buffer[0] = (uint8_t)((DRAW_PROTOCOL_VERSION << 4) | flags);
+
+    size_t pos = 1;
+    size_t n = put_varint(buffer + pos, end, user_id);
+    if (n == 0) {
+        return -1;
+    }
+    pos += n;
+
+    if (timestamp) {
+        n = put_varint(buffer + pos, end, timestamp);
+        if (n == 0) {
+            return -1;
+        }
+        pos += n;
+    }
+
+    return (int)pos;
+}
+
+/**
+ * @brief 在帧头插入发送端延迟（发送前调用，此时才知道第一个点等待了多久）
+ *
+ * 接收端用 墙上时钟 - 帧头时间戳 - 发送端延迟 得到网络（含服务器转发）延迟。
+ * @param buffer 帧缓冲区
+ * @param buffer_size 缓冲区大小
+ * @param frame_len 当前帧长度
+ * @param delay_us 发送端延迟（微秒）
+ * @return 新的帧长度；空间不足或帧头无效时不修改帧，返回-1
+ */
+int draw_frame_set_sender_delay(uint8_t *buffer, size_t buffer_size, int frame_len, uint32_t delay_us) {
+    if (!buffer || frame_len < 2 || (size_t)frame_len > buffer_size ||
+        (buffer[0] & DRAW_FRAME_F_SENDER_DELAY)) {
+        return -1;
+    }
+
+    // 跳过用户ID和时间戳，延迟字段紧随其后
+    const uint8_t *p = buffer + 1;
+    const uint8_t *end = buffer + frame_len;
+    uint32_t v;
+    if (!get_varint(&p, end, &v) || ((buffer[0] & DRAW_FRAME_F_TIMESTAMP) && !get_varint(&p, end, &v))) {
+        return -1;
+    }
+
+    uint8_t field[5];
+    size_t n = put_varint(field, field + sizeof(field), delay_us);
+    if ((size_t)frame_len + n > buffer_size) {
+        return -1;
+    }
+
+    size_t head_len = (size_t)(p - buffer);
+    memmove(buffer + head_len + n, buffer + head_len, frame_len - head_len);
+    memcpy(buffer + head_len, field, n);
+    buffer[0] |= DRAW_FRAME_F_SENDER_DELAY;
+    return frame_len + (int)n;
+}
+
+/**
+ * @brief 向帧追加一条绘图记录（坐标相对编码状态做差分）
+ *
+ * 新笔画（起点与上一个点不连续）、状态无效或距上个关键帧过久时写关键帧，
+ * 关键帧总是携带笔触和颜色；其余记录只在笔触/颜色变化时携带。
+ * 空间不足时不修改状态，调用者可先发送当前帧再重试。
+ *
+ * @param state 发送端编码状态
+ * @param op 绘图操作
+ * @param buffer 记录输出位置（帧当前末尾）
+ * @param buffer_size 剩余空间
+ * @return 写入字节数，空间不足或参数错误返回-1
+ */
+int draw_frame_append(draw_codec_state_t *state, const draw_operation_t *op,
+                      uint8_t *buffer, size_t buffer_size) {
+    if (!state || !op || !buffer || buffer_size < 1) {
+        return -1;
+    }
+
+    const uint8_t *end = buffer + buffer_size;
+    uint8_t type = op->msg_type & DRAW_REC_TYPE_MASK;
+    bool coords = record_has_coords(type);
+    uint8_t head = type;
+
+    bool keyframe = false;
+    if (coords) {
+        keyframe = !state->valid ||
+                   op->prev_x != state->last_x || op->prev_y != state->last_y ||
+                   state->since_keyframe >= DRAW_KEYFRAME_INTERVAL;
+        if (keyframe) {
+            head |= DRAW_REC_F_KEYFRAME | DRAW_REC_F_PEN | DRAW_REC_F_COLOR;
+        } else {
+            if (op->pen_size != state->pen_size) head |= DRAW_REC_F_PEN;
+            if (op->color != state->color) head |= DRAW_REC_F_COLOR;
+        }
+    }
+
+    size_t pos = 0;
+    buffer[pos++] = head;
+
+    if (head & DRAW_REC_F_PEN) {
+        if (buffer + pos >= end) return -1;
+        buffer[pos++] = op->pen_size;
+    }
+    if (head & DRAW_REC_F_COLOR) {
+        if (buffer + pos + 4 > end) return -1;
+        buffer[pos++] = (uint8_t)(op->color);
+        buffer[pos++] = (uint8_t)(op->color >> 8);
+        buffer[pos++] = (uint8_t)(op->color >> 16);
+        buffer[pos++] = (uint8_t)(op->color >> 24);
+    }
+
+    if (coords) {
+        size_t n;
+        if (keyframe) {
+            if ((n = put_varint(buffer + pos, end, op->prev_x)) == 0) return -1;
+            pos += n;
+            if ((n = put_varint(buffer + pos, end, op->prev_y)) == 0) return -1;
+            pos += n;
+        }
+        if ((n = put_varint(buffer + pos, end,
+                            zigzag_encode((int32_t)op->x - (int32_t)op->prev_x))) == 0) return -1;
+        pos += n;
+        if ((n = put_varint(buffer + pos, end,
+                            zigzag_encode((int32_t)op->y - (int32_t)op->prev_y))) == 0) return -1;
+        pos += n;
+
+        // 写入成功后才更新状态
+        state->valid = true;
+        state->last_x = op->x;
+        state->last_y = op->y;
+        state->pen_size = op->pen_size;
+        state->color = op->color;
+        state->since_keyframe = keyframe ? 0 : (uint16_t)(state->since_keyframe + 1);
+    }
+
+    return (int)pos;
+}
+
+/**
+ * @brief 向帧追加一条画布快照分块记录（SYNC_RESPONSE）
+ * @param tile 分块（负载需已用draw_tile_encode编码）
+ * @param buffer 记录输出位置（帧当前末尾）
+ * @param buffer_size 剩余空间
+ * @return 写入字节数，空间不足或参数错误返回-1
+ */
+int draw_frame_append_tile(const draw_sync_tile_t *tile, uint8_t *buffer, size_t buffer_size) {
+    if (!tile || !buffer || buffer_size < 1 || (tile->data_len && !tile->data)) {
+        return -1;
+    }
+
+    const uint8_t *end = buffer + buffer_size;
+    const uint32_t fields[6] = {tile->target_user, tile->x, tile->y, tile->w, tile->h, tile->data_len};
+    size_t pos = 0;
+    buffer[pos++] = MSG_TYPE_SYNC_RESPONSE;
+
+    for (int i = 0; i < 6; i++) {
+        size_t n = put_varint(buffer + pos, end, fields[i]);
+        if (n == 0) {
+            return -1;
+        }
+        pos += n;
+    }
+
+    if (buffer + pos + tile->data_len > end) {
+        return -1;
+    }
+    if (tile->data_len) {
+        memcpy(buffer + pos, tile->data, tile->data_len);
+    }
+    return (int)(pos + tile->data_len);
+}
+
+/**
+ * @brief 解析帧头并初始化读取器
+ * @param reader 读取器
+ * @param buffer 帧数据
+ * @param buffer_size 帧长度
+ * @return 成功返回0，版本不匹配或格式错误返回-1
+ */
+int draw_frame_reader_init(draw_frame_reader_t *reader, const uint8_t *buffer, size_t buffer_size) {
+    if (!reader || !buffer || buffer_size < 2) {
+        return -1;
+    }
+
+    memset(reader, 0, sizeof(*reader));
+    if ((buffer[0] >> 4) != DRAW_PROTOCOL_VERSION) {
+        return -1;
+    }
+
+    uint8_t flags = buffer[0] & 0x0F;
+    const uint8_t *p = buffer + 1;
+    const uint8_t *end = buffer + buffer_size;
+
+    if (!get_varint(&p, end, &reader->user_id)) {
+        return -1;
+    }
+    if (flags & DRAW_FRAME_F_TIMESTAMP) {
+        if (!get_varint(&p, end, &reader->timestamp)) {
+            return -1;
+        }
+    }
+    if (flags & DRAW_FRAME_F_SENDER_DELAY) {
+        if (!get_varint(&p, end, &reader->sender_delay_us)) {
+            return -1;
+        }
+    }
+
+    reader->pos = p;
+    reader->end = end;
+    return 0;
+}
+
+/**
+ * @brief 读取下一条绘图记录
+ *
+ * reader->state 为NULL时使用读取器内部无状态解码（只接受关键帧）。
+ * 在收到该用户的关键帧之前，差分记录会被跳过并计入 reader->skipped。
+ * SYNC_RESPONSE记录的分块信息写入 reader->tile（负载指向帧内数据）。
+ *
+ * @param reader 读取器
+ * @param op 输出绘图操作
+ * @return 读到记录返回1，帧结束返回0，格式错误返回-1
+ */
+int draw_frame_reader_next(draw_frame_reader_t *reader, draw_operation_t *op) {
+    if (!reader || !op) {
+        return -1;
+    }
+
+    draw_codec_state_t scratch;
+    draw_codec_state_t *state = reader->state;
+    if (!state) {
+        draw_codec_reset(&scratch);
+        state = &scratch;
+    }
+
+    while (reader->pos < reader->end) {
+        const uint8_t *p = reader->pos;
+        const uint8_t *end = reader->end;
+        uint8_t head = *p++;
+        uint8_t type = head & DRAW_REC_TYPE_MASK;
+
+        uint8_t pen = state->pen_size;
+        uint32_t color = state->color;
+        if (head & DRAW_REC_F_PEN) {
+            if (p >= end) return -1;
+            pen = *p++;
+        }
+        if (head & DRAW_REC_F_COLOR) {
+            if (p + 4 > end) return -1;
+            color = (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                    ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+            p += 4;
+        }
+
+        memset(op, 0, sizeof(*op));
+        op->user_id = reader->user_id;
+        op->timestamp = reader->timestamp;
+        op->msg_type = type;
+
+        if (record_has_coords(type)) {
+            uint32_t px = state->last_x, py = state->last_y, zx, zy;
+            if (head & DRAW_REC_F_KEYFRAME) {
+                if (!get_varint(&p, end, &px) || !get_varint(&p, end, &py)) return -1;
+            }
+            if (!get_varint(&p, end, &zx) || !get_varint(&p, end, &zy)) return -1;
+            reader->pos = p;
+
+            if (!(head & DRAW_REC_F_KEYFRAME) && !state->valid) {
+                // 中途加入且尚未收到关键帧：无法还原坐标，跳过
+                reader->skipped++;
+                continue;
+            }
+
+            op->prev_x = (uint16_t)px;
+            op->prev_y = (uint16_t)py;
+            op->x = (uint16_t)((int32_t)px + zigzag_decode(zx));
+            op->y = (uint16_t)((int32_t)py + zigzag_decode(zy));
+            op->pen_size = pen;
+            op->color = color;
+            op->is_eraser = (type == MSG_TYPE_ERASE);
+
+            state->valid = true;
+            state->last_x = op->x;
+            state->last_y = op->y;
+            state->pen_size = pen;
+            state->color = color;
+        } else if (type == MSG_TYPE_SYNC_RESPONSE) {
+            uint32_t fields[6];
+            for (int i = 0; i < 6; i++) {
+                if (!get_varint(&p, end, &fields[i])) return -1;
+            }
+            if (fields[1] > 0xFFFF || fields[2] > 0xFFFF || fields[3] > 0xFFFF ||
+                fields[4] > 0xFFFF || fields[5] > (uint32_t)(end - p)) {
+                return -1;
+            }
+            reader->tile.target_user = fields[0];
+            reader->tile.x = (uint16_t)fields[1];
+            reader->tile.y = (uint16_t)fields[2];
+            reader->tile.w = (uint16_t)fields[3];
+            reader->tile.h = (uint16_t)fields[4];
+            reader->tile.data_len = (uint16_t)fields[5];
+            reader->tile.data = p;
+            reader->pos = p + fields[5];
+        } else {
+            reader->pos = p;
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief RLE编码像素块（用于画布快照）
+ *
+ * 每个游程编码为 varint((长度-1) << 3 | 索引)：索引0~6引用最近使用的颜色表，
+ * 索引7表示其后跟4字节小端颜色字面量。颜色表按最近使用顺序维护，
+ * 编解码两端同步更新，画笔颜色少的画布通常每个游程只需1~2字节。
+ *
+ * @param pixels 块左上角像素
+ * @param w 块宽度
+ * @param h 块高度
+ * @param stride 源图像每行像素数
+ * @param buffer 输出缓冲区
+ * @param buffer_size 缓冲区大小
+ * @return 编码长度，空间不足返回-1（调用者可减小块后重试）
+ */
+int draw_tile_encode(const uint32_t *pixels, int w, int h, int stride,
+                     uint8_t *buffer, size_t buffer_size) {
+    if (!pixels || !buffer || w <= 0 || h <= 0 || stride < w) {
+        return -1;
+    }
+
+    const uint8_t *end = buffer + buffer_size;
+    uint32_t mru[DRAW_TILE_MRU_SIZE];
+    int mru_count = 0;
+    size_t pos = 0;
+    const uint32_t *row = pixels;
+    int y = 0, x = 0;
+
+    while (y < h) {
+        // 游程可以跨行；按行指针推进，不对每个像素做除法
+        uint32_t color = row[x];
+        int run = 0;
+        while (y < h) {
+            int x0 = x;
+            while (x < w && row[x] == color) {
+                x++;
+            }
+            run += x - x0;
+            if (x < w) {
+                break;
+            }
+            x = 0;
+            y++;
+            row += stride;
+        }
+
+        int idx = 0;
+        while (idx < mru_count && mru[idx] != color) {
+            idx++;
+        }
+        bool literal = (idx == mru_count);
+
+        size_t n = put_varint(buffer + pos, end,
+                              ((uint32_t)(run - 1) << 3) | (literal ? DRAW_TILE_MRU_SIZE : idx));
+        if (n == 0) {
+            return -1;
+        }
+        pos += n;
+
+        if (literal) {
+            if (buffer + pos + 4 > end) {
+                return -1;
+            }
+            buffer[pos++] = (uint8_t)(color);
+            buffer[pos++] = (uint8_t)(color >> 8);
+            buffer[pos++] = (uint8_t)(color >> 16);
+            buffer[pos++] = (uint8_t)(color >> 24);
+            if (mru_count < DRAW_TILE_MRU_SIZE) {
+                mru_count++;
+            }
+            idx = mru_count - 1;
+        }
+        // 移到表头
+        memmove(&mru[1], &mru[0], idx * sizeof(uint32_t));
+        mru[0] = color;
+    }
+
+    return (int)pos;
+}
+
 /**
- * @brief 编码绘图操作为二进制数据
+ * @brief 解码RLE像素块
+ * @param data RLE负载
+ * @param data_len 负载长度
+ * @param pixels 输出像素（行优先，连续存放）
+ * @param count 像素数（宽*高），负载必须恰好填满
+ * @return 成功返回0，格式错误返回-1
+ */
+int draw_tile_decode(const uint8_t *data, size_t data_len, uint32_t *pixels, int count) {
+    if (!data || !pixels || count <= 0) {
+        return -1;
+    }
+
+    const uint8_t *p = data;
+    const uint8_t *end = data + data_len;
+    uint32_t mru[DRAW_TILE_MRU_SIZE];
+    int mru_count = 0;
+    int i = 0;
+
+    while (i < count) {
+        uint32_t token;
+        if (!get_varint(&p, end, &token)) {
+            return -1;
+        }
+        uint32_t run = (token >> 3) + 1;
+        int idx = (int)(token & 7);
+        if (run > (uint32_t)(count - i)) {
+            return -1;
+        }
+
+        uint32_t color;
+        if (idx == DRAW_TILE_MRU_SIZE) {
+            if (p + 4 > end) {
+                return -1;
+            }
+            color = (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                    ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+            p += 4;
+            if (mru_count < DRAW_TILE_MRU_SIZE) {
+                mru_count++;
+            }
+            idx = mru_count - 1;
+        } else if (idx < mru_count) {
+            color = mru[idx];
+        } else {
+            return -1;
+        }
+        memmove(&mru[1], &mru[0], idx * sizeof(uint32_t));
+        mru[0] = color;
+
+        for (uint32_t k = 0; k < run; k++) {
+            pixels[i++] = color;
+        }
+    }
+
+    return p == end ? 0 : -1;
+}
+
+/**
+ * @brief 编码绘图操作为二进制数据（单条关键帧记录，与编码状态无关）
  * @param op 绘图操作
  * @param buffer 输出缓冲区
  * @param buffer_size 缓冲区大小
  * @return 编码后的数据长度，失败返回-1
  */
 int draw_operation_encode(const draw_operation_t *op, uint8_t *buffer, size_t buffer_size) {
-    if (!op || !buffer || buffer_size < sizeof(draw_operation_t)) {
+    if (!op || !buffer) {
+        return -1;
+    }
+
+    int head_len = draw_frame_begin(buffer, buffer_size, op->user_id, op->timestamp);
+    if (head_len < 0) {
         return -1;
     }
-    
-    // 直接内存拷贝（结构体已对齐）
-    memcpy(buffer, op, sizeof(draw_operation_t));
-    
-    return sizeof(draw_operation_t);
+
+    draw_codec_state_t state;
+    draw_codec_reset(&state);
+    int rec_len = draw_frame_append(&state, op, buffer + head_len, buffer_size - head_len);
+    if (rec_len < 0) {
+        return -1;
+    }
+
+    return head_len + rec_len;
 }
 
 /**
- * @brief 解码二进制数据为绘图操作
+ * @brief 解码二进制数据为绘图操作（取帧中第一条记录）
  * @param buffer 输入缓冲区
  * @param buffer_size 缓冲区大小
  * @param op 输出绘图操作
  * @return 成功返回0，失败返回-1
  */
 int draw_operation_decode(const uint8_t *buffer, size_t buffer_size, draw_operation_t *op) {
-    if (!buffer || !op || buffer_size < sizeof(draw_operation_t)) {
+    draw_frame_reader_t reader;
+    if (!op || draw_frame_reader_init(&reader, buffer, buffer_size) != 0) {
         return -1;
     }
-    
-    // 直接内存拷贝
-    memcpy(op, buffer, sizeof(draw_operation_t));
-    
-    return 0;
+
+    return draw_frame_reader_next(&reader, op) == 1 ? 0 : -1;
 }
 
 /**
- * @brief 获取绘图操作的数据大小
+ * @brief 获取绘图操作编码后的数据大小
  * @param op 绘图操作
- * @return 数据大小（字节）
+ * @return 数据大小（字节），失败返回0
  */
 size_t draw_operation_get_size(const draw_operation_t *op) {
-    (void)op;  // 未使用参数
-    return sizeof(draw_operation_t);
+    uint8_t buffer[DRAW_FRAME_HEADER_MAX + DRAW_RECORD_MAX];
+    int len = draw_operation_encode(op, buffer, sizeof(buffer));
+    return len > 0 ? (size_t)len : 0;
+}
+
+/**
+ * @brief 二进制帧转为base64url文本（无填充，带结束符）
+ * @param bin 二进制数据
+ * @param bin_len 数据长度
+ * @param text 输出文本缓冲区
+ * @param text_size 缓冲区大小（需 >= DRAW_WIRE_TEXT_LEN(bin_len) + 1）
+ * @return 文本长度，空间不足返回-1
+ */
+int draw_wire_to_text(const uint8_t *bin, size_t bin_len, char *text, size_t text_size) {
+    if (!bin || !text || text_size < DRAW_WIRE_TEXT_LEN(bin_len) + 1) {
+        return -1;
+    }
+
+    size_t i = 0, o = 0;
+    for (; i + 3 <= bin_len; i += 3) {
+        uint32_t v = ((uint32_t)bin[i] << 16) | ((uint32_t)bin[i + 1] << 8) | bin[i + 2];
+        text[o++] = b64_alphabet[(v >> 18) & 0x3F];
+        text[o++] = b64_alphabet[(v >> 12) & 0x3F];
+        text[o++] = b64_alphabet[(v >> 6) & 0x3F];
+        text[o++] = b64_alphabet[v & 0x3F];
+    }
+    if (bin_len - i == 1) {
+        uint32_t v = (uint32_t)bin[i] << 16;
+        text[o++] = b64_alphabet[(v >> 18) & 0x3F];
+        text[o++] = b64_alphabet[(v >> 12) & 0x3F];
+    } else if (bin_len - i == 2) {
+        uint32_t v = ((uint32_t)bin[i] << 16) | ((uint32_t)bin[i + 1] << 8);
+        text[o++] = b64_alphabet[(v >> 18) & 0x3F];
+        text[o++] = b64_alphabet[(v >> 12) & 0x3F];
+        text[o++] = b64_alphabet[(v >> 6) & 0x3F];
+    }
+    text[o] = '\0';
+    return (int)o;
+}
+
+// base64url 字符反查，非法字符返回-1
+static int b64_value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '-') return 62;
+    if (c == '_') return 63;
+    return -1;
+}
+
+/**
+ * @brief base64url文本还原为二进制帧
+ * @param text 文本（可不以'\0'结尾）
+ * @param text_len 文本长度
+ * @param bin 输出缓冲区
+ * @param bin_size 缓冲区大小
+ * @return 二进制长度，格式错误或空间不足返回-1
+ */
+int draw_wire_from_text(const char *text, size_t text_len, uint8_t *bin, size_t bin_size) {
+    if (!text || !bin || text_len % 4 == 1) {
+        return -1;
+    }
+
+    size_t out_len = text_len / 4 * 3 + (text_len % 4 ? text_len % 4 - 1 : 0);
+    if (out_len > bin_size) {
+        return -1;
+    }
+
+    size_t o = 0;
+    uint32_t acc = 0;
+    int bits = 0;
+    for (size_t i = 0; i < text_len; i++) {
+        int v = b64_value(text[i]);
+        if (v < 0) {
+            return -1;
+        }
+        acc = (acc << 6) | (uint32_t)v;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            bin[o++] = (uint8_t)(acc >> bits);
+        }
+    }
+    return (int)o;
 }
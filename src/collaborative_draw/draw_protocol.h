@@ -1,9 +1,16 @@
 /**
  * @file draw_protocol.h
  * @brief 协作绘图协议定义
- * 
+ *
  * 定义客户端与服务器之间的通信协议，包括绘图操作的数据结构
  * 和消息格式，支持线条绘制、图形填充等操作。
+ *
+ * 线上格式（版本2）为紧凑的变长编码帧：
+ *   帧头：  [版本(高4位)|帧标志(低4位)] [varint 用户ID] [varint 时间戳(可选)]
+ *   记录：  [类型(低5位)|HAS_PEN|HAS_COLOR|KEYFRAME] [笔触] [颜色(小端4字节)] [坐标]
+ * 坐标相对上一个点做差分，以zigzag varint存储；关键帧携带绝对起点。
+ * 同步请求只有记录头；同步响应携带目标用户、区域和RLE压缩的像素块。
+ * 帧在bemfa消息中以base64url（无填充）文本传输。
  */
 
 #ifndef DRAW_PROTOCOL_H
@@ -14,7 +21,27 @@
 #include <stddef.h>
 
 // 协议版本
-#define DRAW_PROTOCOL_VERSION 1
+#define DRAW_PROTOCOL_VERSION 2
+
+// 帧头标志（低4位）
+#define DRAW_FRAME_F_TIMESTAMP   0x01   // 帧头带时间戳
+#define DRAW_FRAME_F_SENDER_DELAY 0x02  // 帧头带发送端延迟（第一个点触摸到写socket的微秒数）
+
+// 记录头标志（类型占低5位）
+#define DRAW_REC_TYPE_MASK       0x1F
+#define DRAW_REC_F_PEN           0x20   // 携带笔触大小
+#define DRAW_REC_F_COLOR         0x40   // 携带颜色
+#define DRAW_REC_F_KEYFRAME      0x80   // 关键帧：起点为绝对坐标
+
+// 编码尺寸上限
+#define DRAW_FRAME_HEADER_MAX    16     // 1 + varint32 + varint32 + varint32
+#define DRAW_RECORD_MAX          18     // 1 + 1 + 4 + 4 * varint16
+#define DRAW_KEYFRAME_INTERVAL   32     // 连续笔画每隔N条记录强制关键帧（便于中途加入者同步）
+#define DRAW_TILE_RECORD_MAX     21     // 同步分块记录头：1 + varint32 + 4 * varint16 + varint16
+#define DRAW_SYNC_TILE_SIZE      32     // 画布快照分块边长（像素）
+
+// base64url 文本长度（无填充）
+#define DRAW_WIRE_TEXT_LEN(bin_len) ((((bin_len) * 4) + 2) / 3)
 
 // 消息类型
 typedef enum {
@@ -22,6 +49,8 @@ typedef enum {
     MSG_TYPE_DRAW_POINT = 2,     // 绘制点
     MSG_TYPE_CLEAR = 3,          // 清屏
     MSG_TYPE_ERASE = 4,           // 橡皮擦
+    MSG_TYPE_UNDO = 5,            // 撤销发送者最近的一笔（只有记录头）
+    MSG_TYPE_REDO = 6,            // 重做发送者最近撤销的一笔（只有记录头）
     MSG_TYPE_USER_JOIN = 10,      // 用户加入
     MSG_TYPE_USER_LEAVE = 11,     // 用户离开
     MSG_TYPE_SYNC_REQUEST = 20,   // 同步请求
@@ -57,9 +86,59 @@ typedef struct {
     uint8_t data[];              // 可变长度数据
 } draw_msg_t;
 
+// 差分编解码状态（发送端一份；接收端每个远端用户一份）
+typedef struct {
+    bool valid;                  // 是否有参考点（false时只接受关键帧）
+    uint16_t last_x;             // 上一个点X
+    uint16_t last_y;             // 上一个点Y
+    uint32_t color;              // 当前颜色
+    uint8_t pen_size;            // 当前笔触
+    uint16_t since_keyframe;     // 距上一关键帧的记录数
+} draw_codec_state_t;
+
+// 画布快照分块（SYNC_RESPONSE记录）
+// 负载为分块像素（行优先）的RLE编码；data_len为0表示该区域整体为背景色
+typedef struct {
+    uint32_t target_user;        // 请求同步的用户ID
+    uint16_t x;                  // 区域左上角X
+    uint16_t y;                  // 区域左上角Y
+    uint16_t w;                  // 区域宽度
+    uint16_t h;                  // 区域高度
+    const uint8_t *data;         // RLE负载（指向帧内数据，不拷贝）
+    uint16_t data_len;           // 负载长度
+} draw_sync_tile_t;
+
+// 帧读取器
+typedef struct {
+    const uint8_t *pos;          // 当前读取位置
+    const uint8_t *end;          // 帧结束位置
+    uint32_t user_id;            // 帧头中的用户ID
+    uint32_t timestamp;          // 帧头中的时间戳（无则为0）
+    uint32_t sender_delay_us;    // 帧头中的发送端延迟（无则为0）
+    draw_codec_state_t *state;   // 该用户的解码状态（由调用者在init后设置）
+    uint32_t skipped;            // 因缺少关键帧而丢弃的记录数
+    draw_sync_tile_t tile;       // 最近一条SYNC_RESPONSE记录
+} draw_frame_reader_t;
+
 // 函数声明
 int draw_operation_encode(const draw_operation_t *op, uint8_t *buffer, size_t buffer_size);
 int draw_operation_decode(const uint8_t *buffer, size_t buffer_size, draw_operation_t *op);
 size_t draw_operation_get_size(const draw_operation_t *op);
 
+void draw_codec_reset(draw_codec_state_t *state);
+int draw_frame_begin(uint8_t *buffer, size_t buffer_size, uint32_t user_id, uint32_t timestamp);
+int draw_frame_set_sender_delay(uint8_t *buffer, size_t buffer_size, int frame_len, uint32_t delay_us);
+int draw_frame_append(draw_codec_state_t *state, const draw_operation_t *op,
+                      uint8_t *buffer, size_t buffer_size);
+int draw_frame_append_tile(const draw_sync_tile_t *tile, uint8_t *buffer, size_t buffer_size);
+int draw_frame_reader_init(draw_frame_reader_t *reader, const uint8_t *buffer, size_t buffer_size);
+int draw_frame_reader_next(draw_frame_reader_t *reader, draw_operation_t *op);
+
+int draw_tile_encode(const uint32_t *pixels, int w, int h, int stride,
+                     uint8_t *buffer, size_t buffer_size);
+int draw_tile_decode(const uint8_t *data, size_t data_len, uint32_t *pixels, int count);
+
+int draw_wire_to_text(const uint8_t *bin, size_t bin_len, char *text, size_t text_size);
+int draw_wire_from_text(const char *text, size_t text_len, uint8_t *bin, size_t bin_size);
+
 #endif /* DRAW_PROTOCOL_H */
@@ -0,0 +1,576 @@
+/**
+ * @file lan_transport.c
+ * @brief 局域网UDP组播点对点传输实现
+ *
+ * 数据包格式（小端）：
+ *   [magic 2][版本 1][类型 1][房间哈希 4][发送者ID 4][序号 4] + 负载
+ *   DATA : 负载为绘图帧（与巴法云路径相同的二进制帧，不做base64）
+ *   HELLO: 负载为发送者的下一个序号 [4]
+ *   NACK : 负载为 [目标发送者ID 4][起始序号 4][个数 2]
+ * 序号按32位回绕比较。重传仍走组播，其他缺同一包的接收者也能补齐。
+ */
+
+#include "lan_transport.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define LAN_MAGIC               0x4443   // "CD"
+#define LAN_VERSION             1
+#define LAN_HEADER_SIZE         16
+#define LAN_PACKET_MAX          (LAN_HEADER_SIZE + LAN_TRANSPORT_FRAME_MAX)
+#define LAN_TX_HISTORY          256      // 重传历史（2的幂）
+#define LAN_REORDER_WINDOW      32       // 每个发送者的乱序缓存（2的幂），同时是单次NACK的最大个数
+#define LAN_MAX_PEERS           8
+#define LAN_HELLO_INTERVAL_MS   1000
+#define LAN_PEER_TIMEOUT_MS     3000
+#define LAN_NACK_INTERVAL_MS    20       // NACK重试间隔
+#define LAN_NACK_MAX_TRIES      5        // 超过后放弃缺口
+#define LAN_RESYNC_DISTANCE     (1 << 16) // 序号跳变超过此值视为对端重启
+
+enum {
+    LAN_PKT_DATA = 1,
+    LAN_PKT_HELLO = 2,
+    LAN_PKT_NACK = 3,
+};
+
+// 发送历史槽位（保存完整数据包，收到NACK时原样重发）
+typedef struct {
+    bool valid;
+    uint32_t seq;
+    uint16_t len;
+    uint8_t packet[LAN_PACKET_MAX];
+} lan_tx_slot_t;
+
+// 乱序缓存槽位（只保存帧）
+typedef struct {
+    bool valid;
+    uint32_t seq;
+    uint16_t len;
+    uint8_t frame[LAN_TRANSPORT_FRAME_MAX];
+} lan_rx_slot_t;
+
+// 远端发送者
+typedef struct {
+    bool in_use;
+    bool synced;                    // 已确定起始序号
+    uint32_t user_id;
+    uint64_t last_seen_ms;
+    uint32_t next_seq;              // 下一个应交付的序号
+    uint32_t known_end;             // 已知存在的最大序号+1（来自DATA或HELLO）
+    bool after_gap;                 // 下一帧交付时通知上层有缺口被放弃
+    bool gap_active;                // 正在等待缺口补齐
+    int nack_tries;
+    uint64_t next_nack_ms;
+    lan_rx_slot_t reorder[LAN_REORDER_WINDOW];
+} lan_peer_t;
+
+typedef struct {
+    lan_transport_config_t config;
+    int fd;
+    struct sockaddr_in group_addr;
+    uint32_t room_hash;
+    pthread_mutex_t tx_mutex;       // 保护next_seq和tx（发送线程与poll线程的重传并发）
+    uint32_t next_seq;
+    uint64_t next_hello_ms;
+    unsigned int rand_state;
+    lan_transport_frame_callback_t frame_callback;
+    void *frame_user_data;
+    lan_transport_stats_t stats;
+    lan_tx_slot_t tx[LAN_TX_HISTORY];
+    lan_peer_t peers[LAN_MAX_PEERS];
+} lan_transport_t;
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// FNV-1a：房间名哈希
+static uint32_t room_hash(const char *room) {
+    uint32_t h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)room; *p; p++) {
+        h = (h ^ *p) * 16777619u;
+    }
+    return h;
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// 写入包头，返回包头长度
+static int write_header(lan_transport_t *t, uint8_t *buf, uint8_t type, uint32_t seq) {
+    put_u16(buf, LAN_MAGIC);
+    buf[2] = LAN_VERSION;
+    buf[3] = type;
+    put_u32(buf + 4, t->room_hash);
+    put_u32(buf + 8, t->config.user_id);
+    put_u32(buf + 12, seq);
+    return LAN_HEADER_SIZE;
+}
+
+static int send_packet(lan_transport_t *t, const uint8_t *buf, size_t len) {
+    ssize_t n = sendto(t->fd, buf, len, 0, (const struct sockaddr *)&t->group_addr, sizeof(t->group_addr));
+    return n == (ssize_t)len ? 0 : -1;
+}
+
+// 查找（或分配）远端发送者，表满时替换最久未见的
+static lan_peer_t *get_peer(lan_transport_t *t, uint32_t user_id, uint64_t now) {
+    lan_peer_t *victim = &t->peers[0];
+    for (int i = 0; i < LAN_MAX_PEERS; i++) {
+        lan_peer_t *p = &t->peers[i];
+        if (p->in_use && p->user_id == user_id) {
+            p->last_seen_ms = now;
+            return p;
+        }
+        if (!p->in_use) {
+            if (victim->in_use) {
+                victim = p;
+            }
+        } else if (victim->in_use && p->last_seen_ms < victim->last_seen_ms) {
+            victim = p;
+        }
+    }
+
+    memset(victim, 0, sizeof(*victim));
+    victim->in_use = true;
+    victim->user_id = user_id;
+    victim->last_seen_ms = now;
+    return victim;
+}
+
+// 以seq为起点重新同步（新发送者、对端重启）
+static void peer_resync(lan_peer_t *p, uint32_t seq) {
+    for (int i = 0; i < LAN_REORDER_WINDOW; i++) {
+        p->reorder[i].valid = false;
+    }
+    p->synced = true;
+    p->next_seq = seq;
+    p->known_end = seq;
+    p->gap_active = false;
+    p->nack_tries = 0;
+    p->after_gap = true;
+}
+
+// 请求重传从next_seq开始的连续缺失包
+static void send_nack(lan_transport_t *t, lan_peer_t *p, uint64_t now) {
+    uint16_t count = 0;
+    while (count < LAN_REORDER_WINDOW && (int32_t)(p->known_end - (p->next_seq + count)) > 0) {
+        const lan_rx_slot_t *slot = &p->reorder[(p->next_seq + count) & (LAN_REORDER_WINDOW - 1)];
+        if (slot->valid && slot->seq == p->next_seq + count) {
+            break;
+        }
+        count++;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    uint8_t buf[LAN_HEADER_SIZE + 10];
+    int pos = write_header(t, buf, LAN_PKT_NACK, 0);
+    put_u32(buf + pos, p->user_id);
+    put_u32(buf + pos + 4, p->next_seq);
+    put_u16(buf + pos + 8, count);
+    if (send_packet(t, buf, sizeof(buf)) == 0) {
+        t->stats.nacks_sent++;
+    }
+    p->nack_tries++;
+    p->next_nack_ms = now + LAN_NACK_INTERVAL_MS;
+}
+
+// 按序交付缓存中已连续的帧；仍有缺口时安排NACK
+static void peer_deliver_ready(lan_transport_t *t, lan_peer_t *p, uint64_t now) {
+    for (;;) {
+        lan_rx_slot_t *slot = &p->reorder[p->next_seq & (LAN_REORDER_WINDOW - 1)];
+        if (!slot->valid || slot->seq != p->next_seq) {
+            break;
+        }
+        slot->valid = false;
+        p->next_seq++;
+        t->stats.frames_delivered++;
+        bool after_gap = p->after_gap;
+        p->after_gap = false;
+        if (t->frame_callback) {
+            t->frame_callback(p->user_id, slot->frame, slot->len, after_gap, t->frame_user_data);
+        }
+    }
+
+    if ((int32_t)(p->known_end - p->next_seq) <= 0) {
+        p->gap_active = false;
+        p->nack_tries = 0;
+    } else if (!p->gap_active) {
+        // 新缺口：立即请求重传（局域网极少乱序，等待只会增加延迟）
+        p->gap_active = true;
+        p->nack_tries = 0;
+        send_nack(t, p, now);
+    }
+}
+
+// 放弃next_seq处的缺口，跳到下一个已缓存的包
+static void peer_skip_gap(lan_transport_t *t, lan_peer_t *p, uint64_t now) {
+    while ((int32_t)(p->known_end - p->next_seq) > 0) {
+        const lan_rx_slot_t *slot = &p->reorder[p->next_seq & (LAN_REORDER_WINDOW - 1)];
+        if (slot->valid && slot->seq == p->next_seq) {
+            break;
+        }
+        p->next_seq++;
+        p->after_gap = true;
+        t->stats.lost++;
+    }
+    p->gap_active = false;
+    p->nack_tries = 0;
+    peer_deliver_ready(t, p, now);
+}
+
+static void handle_data(lan_transport_t *t, uint32_t sender, uint32_t seq,
+                        const uint8_t *frame, size_t len, uint64_t now) {
+    if (len == 0 || len > LAN_TRANSPORT_FRAME_MAX) {
+        return;
+    }
+
+    lan_peer_t *p = get_peer(t, sender, now);
+    if (!p->synced) {
+        // 第一次收到该发送者：从当前序号开始
+        peer_resync(p, seq);
+    }
+
+    int32_t d = (int32_t)(seq - p->next_seq);
+    if (d < -LAN_RESYNC_DISTANCE || d > LAN_RESYNC_DISTANCE) {
+        peer_resync(p, seq);
+        d = 0;
+    }
+    if (d < 0) {
+        t->stats.duplicates++;
+        return;
+    }
+
+    // 超出乱序窗口：窗口外的旧缺口直接放弃
+    while (d >= LAN_REORDER_WINDOW) {
+        lan_rx_slot_t *slot = &p->reorder[p->next_seq & (LAN_REORDER_WINDOW - 1)];
+        if (slot->valid && slot->seq == p->next_seq) {
+            peer_deliver_ready(t, p, now);
+        } else {
+            p->next_seq++;
+            p->after_gap = true;
+            t->stats.lost++;
+        }
+        d = (int32_t)(seq - p->next_seq);
+    }
+
+    lan_rx_slot_t *slot = &p->reorder[seq & (LAN_REORDER_WINDOW - 1)];
+    if (slot->valid && slot->seq == seq) {
+        t->stats.duplicates++;
+        return;
+    }
+    slot->valid = true;
+    slot->seq = seq;
+    slot->len = (uint16_t)len;
+    memcpy(slot->frame, frame, len);
+    if (d > 0) {
+        t->stats.reordered++;
+    }
+    if ((int32_t)(seq + 1 - p->known_end) > 0) {
+        p->known_end = seq + 1;
+    }
+
+    peer_deliver_ready(t, p, now);
+}
+
+static void handle_hello(lan_transport_t *t, uint32_t sender, const uint8_t *payload, size_t len, uint64_t now) {
+    if (len < 4) {
+        return;
+    }
+    uint32_t next = get_u32(payload);
+    lan_peer_t *p = get_peer(t, sender, now);
+    if (!p->synced) {
+        peer_resync(p, next);
+        return;
+    }
+
+    int32_t d = (int32_t)(next - p->known_end);
+    if (d > LAN_RESYNC_DISTANCE || (int32_t)(next - p->next_seq) < -LAN_RESYNC_DISTANCE) {
+        peer_resync(p, next);
+    } else if (d > 0) {
+        // 尾部丢包：发送者已发出的包我们还没收到
+        p->known_end = next;
+        peer_deliver_ready(t, p, now);
+    }
+}
+
+static void handle_nack(lan_transport_t *t, const uint8_t *payload, size_t len) {
+    if (len < 10 || get_u32(payload) != t->config.user_id) {
+        return;
+    }
+    uint32_t first = get_u32(payload + 4);
+    uint16_t count = get_u16(payload + 8);
+    if (count > LAN_REORDER_WINDOW) {
+        count = LAN_REORDER_WINDOW;
+    }
+
+    pthread_mutex_lock(&t->tx_mutex);
+    for (uint32_t i = 0; i < count; i++) {
+        const lan_tx_slot_t *slot = &t->tx[(first + i) & (LAN_TX_HISTORY - 1)];
+        if (slot->valid && slot->seq == first + i && send_packet(t, slot->packet, slot->len) == 0) {
+            t->stats.retransmits++;
+        }
+    }
+    pthread_mutex_unlock(&t->tx_mutex);
+}
+
+lan_transport_handle_t lan_transport_open(const lan_transport_config_t *config) {
+    if (!config) {
+        return NULL;
+    }
+
+    lan_transport_t *t = (lan_transport_t *)calloc(1, sizeof(lan_transport_t));
+    if (!t) {
+        return NULL;
+    }
+    memcpy(&t->config, config, sizeof(*config));
+    if (t->config.group[0] == '\0') {
+        strncpy(t->config.group, LAN_TRANSPORT_DEFAULT_GROUP, sizeof(t->config.group) - 1);
+    }
+    if (t->config.port == 0) {
+        t->config.port = LAN_TRANSPORT_DEFAULT_PORT;
+    }
+    t->room_hash = room_hash(t->config.room);
+    t->rand_state = (unsigned int)(config->user_id ^ (uint32_t)monotonic_ms());
+
+    memset(&t->group_addr, 0, sizeof(t->group_addr));
+    t->group_addr.sin_family = AF_INET;
+    t->group_addr.sin_port = htons(t->config.port);
+    struct in_addr iface_addr;
+    iface_addr.s_addr = htonl(INADDR_ANY);
+    if (inet_pton(AF_INET, t->config.group, &t->group_addr.sin_addr) != 1 ||
+        (t->config.iface[0] && inet_pton(AF_INET, t->config.iface, &iface_addr) != 1)) {
+        printf("[局域网传输] 无效的组播地址或网卡地址: %s / %s\n", t->config.group, t->config.iface);
+        free(t);
+        return NULL;
+    }
+
+    t->fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (t->fd < 0) {
+        printf("[局域网传输] 创建socket失败: %s\n", strerror(errno));
+        free(t);
+        return NULL;
+    }
+
+    // 允许同一台机器上多个进程加入同一组（回环测试）
+    int one = 1;
+    setsockopt(t->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+#ifdef SO_REUSEPORT
+    setsockopt(t->fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+#endif
+    int rcvbuf = 256 * 1024;  // 快照突发时避免内核丢包
+    setsockopt(t->fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    struct sockaddr_in bind_addr;
+    memset(&bind_addr, 0, sizeof(bind_addr));
+    bind_addr.sin_family = AF_INET;
+    bind_addr.sin_port = htons(t->config.port);
+    bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    struct ip_mreq mreq;
+    mreq.imr_multiaddr = t->group_addr.sin_addr;
+    mreq.imr_interface = iface_addr;
+    unsigned char loop = 1, ttl = 1;
+
+    if (bind(t->fd, (struct sockaddr *)&bind_addr, sizeof(bind_addr)) != 0 ||
+        setsockopt(t->fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0 ||
+        setsockopt(t->fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) != 0 ||
+        setsockopt(t->fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) != 0 ||
+        (t->config.iface[0] &&
+         setsockopt(t->fd, IPPROTO_IP, IP_MULTICAST_IF, &iface_addr, sizeof(iface_addr)) != 0)) {
+        printf("[局域网传输] 加入组播%s:%u失败: %s\n", t->config.group, t->config.port, strerror(errno));
+        close(t->fd);
+        free(t);
+        return NULL;
+    }
+
+    pthread_mutex_init(&t->tx_mutex, NULL);
+    printf("[局域网传输] 已加入组播 %s:%u，房间=%s\n", t->config.group, t->config.port, t->config.room);
+    return (lan_transport_handle_t)t;
+}
+
+void lan_transport_close(lan_transport_handle_t handle) {
+    lan_transport_t *t = (lan_transport_t *)handle;
+    if (!t) {
+        return;
+    }
+    if (t->fd >= 0) {
+        close(t->fd);
+    }
+    pthread_mutex_destroy(&t->tx_mutex);
+    free(t);
+}
+
+int lan_transport_get_fd(lan_transport_handle_t handle) {
+    lan_transport_t *t = (lan_transport_t *)handle;
+    return t ? t->fd : -1;
+}
+
+void lan_transport_set_frame_callback(lan_transport_handle_t handle,
+                                      lan_transport_frame_callback_t callback,
+                                      void *user_data) {
+    lan_transport_t *t = (lan_transport_t *)handle;
+    if (t) {
+        t->frame_callback = callback;
+        t->frame_user_data = user_data;
+    }
+}
+
+int lan_transport_send(lan_transport_handle_t handle, const uint8_t *frame, size_t len) {
+    lan_transport_t *t = (lan_transport_t *)handle;
+    if (!t || !frame || len == 0 || len > LAN_TRANSPORT_FRAME_MAX) {
+        return -1;
+    }
+
+    // 先写入重传历史，发送失败的包也可以被NACK补发
+    pthread_mutex_lock(&t->tx_mutex);
+    uint32_t seq = t->next_seq++;
+    lan_tx_slot_t *slot = &t->tx[seq & (LAN_TX_HISTORY - 1)];
+    int pos = write_header(t, slot->packet, LAN_PKT_DATA, seq);
+    memcpy(slot->packet + pos, frame, len);
+    slot->len = (uint16_t)(pos + len);
+    slot->seq = seq;
+    slot->valid = true;
+
+    int ret = send_packet(t, slot->packet, slot->len);
+    if (ret == 0) {
+        t->stats.packets_sent++;
+    }
+    pthread_mutex_unlock(&t->tx_mutex);
+    return ret;
+}
+
+int lan_transport_poll(lan_transport_handle_t handle) {
+    lan_transport_t *t = (lan_transport_t *)handle;
+    if (!t) {
+        return -1;
+    }
+
+    uint8_t buf[LAN_PACKET_MAX];
+    for (;;) {
+        ssize_t n = recv(t->fd, buf, sizeof(buf), 0);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            printf("[局域网传输] 接收失败: %s\n", strerror(errno));
+            return -1;
+        }
+        if (n < LAN_HEADER_SIZE || get_u16(buf) != LAN_MAGIC || buf[2] != LAN_VERSION ||
+            get_u32(buf + 4) != t->room_hash) {
+            continue;
+        }
+
+        uint32_t sender = get_u32(buf + 8);
+        if (sender == t->config.user_id) {
+            continue;  // 组播回环收到自己发出的包
+        }
+
+        uint64_t now = monotonic_ms();
+        const uint8_t *payload = buf + LAN_HEADER_SIZE;
+        size_t payload_len = (size_t)n - LAN_HEADER_SIZE;
+        switch (buf[3]) {
+        case LAN_PKT_DATA:
+            if (t->config.rx_drop_permille &&
+                (unsigned)(rand_r(&t->rand_state) % 1000) < t->config.rx_drop_permille) {
+                continue;
+            }
+            t->stats.packets_received++;
+            handle_data(t, sender, get_u32(buf + 12), payload, payload_len, now);
+            break;
+        case LAN_PKT_HELLO:
+            handle_hello(t, sender, payload, payload_len, now);
+            break;
+        case LAN_PKT_NACK:
+            handle_nack(t, payload, payload_len);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+int lan_transport_tick(lan_transport_handle_t handle) {
+    lan_transport_t *t = (lan_transport_t *)handle;
+    if (!t) {
+        return LAN_HELLO_INTERVAL_MS;
+    }
+
+    uint64_t now = monotonic_ms();
+    if (now >= t->next_hello_ms) {
+        uint8_t buf[LAN_HEADER_SIZE + 4];
+        int pos = write_header(t, buf, LAN_PKT_HELLO, 0);
+        pthread_mutex_lock(&t->tx_mutex);
+        put_u32(buf + pos, t->next_seq);
+        pthread_mutex_unlock(&t->tx_mutex);
+        send_packet(t, buf, sizeof(buf));
+        t->next_hello_ms = now + LAN_HELLO_INTERVAL_MS;
+    }
+    uint64_t next_wake = t->next_hello_ms;
+
+    uint32_t peers = 0;
+    for (int i = 0; i < LAN_MAX_PEERS; i++) {
+        lan_peer_t *p = &t->peers[i];
+        if (!p->in_use) {
+            continue;
+        }
+        if (now - p->last_seen_ms > LAN_PEER_TIMEOUT_MS) {
+            p->in_use = false;
+            continue;
+        }
+        peers++;
+
+        if (p->gap_active && now >= p->next_nack_ms) {
+            if (p->nack_tries >= LAN_NACK_MAX_TRIES) {
+                peer_skip_gap(t, p, now);
+            } else {
+                send_nack(t, p, now);
+            }
+        }
+        if (p->gap_active && p->next_nack_ms < next_wake) {
+            next_wake = p->next_nack_ms;
+        }
+    }
+    t->stats.peers = peers;
+
+    return next_wake > now ? (int)(next_wake - now) : 0;
+}
+
+void lan_transport_get_stats(lan_transport_handle_t handle, lan_transport_stats_t *stats) {
+    lan_transport_t *t = (lan_transport_t *)handle;
+    if (!t || !stats) {
+        return;
+    }
+    memcpy(stats, &t->stats, sizeof(*stats));
+}
@@ -0,0 +1,115 @@
+/**
+ * @file lan_transport.h
+ * @brief 局域网UDP组播点对点传输
+ *
+ * 同一局域网内的设备直接通过UDP组播交换绘图帧，不经过巴法云服务器。
+ * 每个发送者的数据包带递增序号，接收端按序交付，发现序号缺口时
+ * 组播NACK请求重传，超过重试次数后放弃缺口并通知上层（上层重置差分解码状态）。
+ * 周期性HELLO包用于发现同房间的设备，并携带发送者的下一个序号以检测尾部丢包。
+ *
+ * 线程模型：lan_transport_poll/lan_transport_tick由同一个I/O线程调用，
+ * lan_transport_send可在任意线程调用（重传历史有独立的锁）。
+ */
+
+#ifndef LAN_TRANSPORT_H
+#define LAN_TRANSPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define LAN_TRANSPORT_DEFAULT_GROUP "239.255.43.21"
+#define LAN_TRANSPORT_DEFAULT_PORT  8345
+#define LAN_TRANSPORT_FRAME_MAX     512      // 单个绘图帧上限（与快照帧一致）
+
+// 局域网传输配置
+typedef struct {
+    char group[32];                 // 组播地址（空=默认）
+    uint16_t port;                  // 组播端口（0=默认）
+    char iface[32];                 // 本机网卡IPv4地址（空=系统默认，回环测试用127.0.0.1）
+    uint32_t user_id;               // 本地用户ID（同时用于过滤自己发出的组播）
+    char room[128];                 // 房间名（不同房间的数据包互相忽略）
+    uint16_t rx_drop_permille;      // 测试用：随机丢弃收到的数据包（千分比，0=不丢）
+} lan_transport_config_t;
+
+// 局域网传输统计
+typedef struct {
+    uint32_t packets_sent;          // 发出的数据包（不含重传）
+    uint32_t packets_received;      // 收到的数据包（含乱序、重复）
+    uint32_t frames_delivered;      // 按序交付给上层的帧
+    uint32_t reordered;             // 先到达、暂存等待缺口补齐的包
+    uint32_t duplicates;            // 重复包
+    uint32_t nacks_sent;            // 发出的NACK
+    uint32_t retransmits;           // 响应NACK重传的包
+    uint32_t lost;                  // 重试后仍未收到、被放弃的包
+    uint32_t peers;                 // 最近发现的同房间设备数
+} lan_transport_stats_t;
+
+// 帧回调：after_gap为true表示此帧之前有包被放弃，上层应重置该发送者的解码状态
+typedef void (*lan_transport_frame_callback_t)(uint32_t sender, const uint8_t *frame, size_t len,
+                                               bool after_gap, void *user_data);
+
+// 局域网传输句柄
+typedef void* lan_transport_handle_t;
+
+/**
+ * @brief 创建组播socket并加入组
+ * @param config 配置参数
+ * @return 句柄，失败（无组播路由、端口不可用等）返回NULL
+ */
+lan_transport_handle_t lan_transport_open(const lan_transport_config_t *config);
+
+/**
+ * @brief 关闭socket并释放句柄
+ * @param handle 句柄
+ */
+void lan_transport_close(lan_transport_handle_t handle);
+
+/**
+ * @brief 获取socket描述符（用于epoll/poll）
+ * @param handle 句柄
+ * @return 描述符，无效句柄返回-1
+ */
+int lan_transport_get_fd(lan_transport_handle_t handle);
+
+/**
+ * @brief 设置帧回调（在lan_transport_poll/lan_transport_tick中调用）
+ * @param handle 句柄
+ * @param callback 回调函数
+ * @param user_data 用户数据
+ */
+void lan_transport_set_frame_callback(lan_transport_handle_t handle,
+                                      lan_transport_frame_callback_t callback,
+                                      void *user_data);
+
+/**
+ * @brief 组播发送一帧（分配序号并保存到重传历史）
+ * @param handle 句柄
+ * @param frame 绘图帧
+ * @param len 帧长度（不超过LAN_TRANSPORT_FRAME_MAX）
+ * @return 成功返回0，失败返回-1
+ */
+int lan_transport_send(lan_transport_handle_t handle, const uint8_t *frame, size_t len);
+
+/**
+ * @brief 读取并处理所有待处理的数据包（socket可读时调用）
+ * @param handle 句柄
+ * @return 成功返回0，socket错误返回-1
+ */
+int lan_transport_poll(lan_transport_handle_t handle);
+
+/**
+ * @brief 处理定时任务（HELLO、NACK重试、放弃缺口）
+ * @param handle 句柄
+ * @return 距下一次需要调用的毫秒数
+ */
+int lan_transport_tick(lan_transport_handle_t handle);
+
+/**
+ * @brief 获取统计信息
+ * @param handle 句柄
+ * @param stats 输出统计信息
+ */
+void lan_transport_get_stats(lan_transport_handle_t handle, lan_transport_stats_t *stats);
+
+#endif /* LAN_TRANSPORT_H */
@@ -0,0 +1,211 @@
+/**
+ * @file latency_stats.c
+ * @brief 协作绘图分阶段延迟统计实现
+ *
+ * 直方图桶：0~15微秒每微秒一个桶；之后每个2的幂区间分8个桶，
+ * 共 16 + 28 * 8 = 240 个桶，覆盖完整的32位范围。
+ */
+
+#include "latency_stats.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+
+#define LATENCY_LINEAR_BUCKETS  16
+#define LATENCY_SUB_BITS        3
+#define LATENCY_SUB_BUCKETS     (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS         (LATENCY_LINEAR_BUCKETS + (32 - 4) * LATENCY_SUB_BUCKETS)
+#define LATENCY_WALL_SLACK_US   2000                // 跨设备阶段允许的毫秒截断误差
+#define LATENCY_WALL_LIMIT_US   60000000            // 跨设备阶段上限（60秒）
+
+typedef struct {
+    _Atomic uint32_t buckets[LATENCY_BUCKETS];
+    _Atomic uint32_t max_us;
+    _Atomic uint64_t sum_us;
+} latency_histogram_t;
+
+static latency_histogram_t g_latency[LATENCY_STAGE_COUNT];
+
+static const char *const g_stage_names[LATENCY_STAGE_COUNT] = {
+    "touch", "draw", "send", "net", "decode", "queue", "fb", "e2e",
+};
+
+uint64_t latency_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int bucket_index(uint32_t us) {
+    if (us < LATENCY_LINEAR_BUCKETS) {
+        return (int)us;
+    }
+    int e = 31 - __builtin_clz(us);  // >= 4
+    int sub = (int)(us >> (e - LATENCY_SUB_BITS)) & (LATENCY_SUB_BUCKETS - 1);
+    return LATENCY_LINEAR_BUCKETS + (e - 4) * LATENCY_SUB_BUCKETS + sub;
+}
+
+// 桶的代表值（区间中点）
+static uint32_t bucket_value(int index) {
+    if (index < LATENCY_LINEAR_BUCKETS) {
+        return (uint32_t)index;
+    }
+    int e = (index - LATENCY_LINEAR_BUCKETS) / LATENCY_SUB_BUCKETS + 4;
+    int sub = (index - LATENCY_LINEAR_BUCKETS) % LATENCY_SUB_BUCKETS;
+    uint64_t width = 1ULL << (e - LATENCY_SUB_BITS);
+    uint64_t low = (1ULL << e) + sub * width;
+    return (uint32_t)(low + width / 2);
+}
+
+void latency_stats_record(latency_stage_t stage, uint32_t us) {
+    if ((unsigned)stage >= LATENCY_STAGE_COUNT) {
+        return;
+    }
+    latency_histogram_t *h = &g_latency[stage];
+    atomic_fetch_add_explicit(&h->buckets[bucket_index(us)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum_us, us, memory_order_relaxed);
+
+    uint32_t max = atomic_load_explicit(&h->max_us, memory_order_relaxed);
+    while (us > max && !atomic_compare_exchange_weak_explicit(&h->max_us, &max, us,
+                                                              memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void latency_stats_reset(void) {
+    // 与记录并发时可能丢失少量样本，统计用途可以接受
+    for (int s = 0; s < LATENCY_STAGE_COUNT; s++) {
+        for (int i = 0; i < LATENCY_BUCKETS; i++) {
+            atomic_store_explicit(&g_latency[s].buckets[i], 0, memory_order_relaxed);
+        }
+        atomic_store_explicit(&g_latency[s].max_us, 0, memory_order_relaxed);
+        atomic_store_explicit(&g_latency[s].sum_us, 0, memory_order_relaxed);
+    }
+}
+
+uint32_t latency_wall_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint32_t ms = (uint32_t)((uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+    return ms ? ms : 1;  // 0表示"无时间戳"
+}
+
+void latency_stats_record_since_wall(latency_stage_t stage, uint32_t sent_ms, uint32_t offset_us) {
+    if (sent_ms == 0) {
+        return;
+    }
+    // 毫秒截断误差在±1ms内，略小于0的结果按0计；更大的负值或超过上限说明两端时钟未同步
+    int64_t us = (int64_t)(int32_t)(latency_wall_ms() - sent_ms) * 1000 - offset_us;
+    if (us < -LATENCY_WALL_SLACK_US || us > LATENCY_WALL_LIMIT_US) {
+        return;
+    }
+    latency_stats_record(stage, us < 0 ? 0 : (uint32_t)us);
+}
+
+// 第rank个样本（从1开始）所在桶的代表值
+static uint32_t value_at_rank(const uint32_t *buckets, uint64_t rank, uint32_t max_us) {
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            uint32_t v = bucket_value(i);
+            return v < max_us ? v : max_us;
+        }
+    }
+    return max_us;
+}
+
+void latency_stats_get(latency_stage_t stage, latency_summary_t *summary) {
+    if (!summary) {
+        return;
+    }
+    memset(summary, 0, sizeof(*summary));
+    if ((unsigned)stage >= LATENCY_STAGE_COUNT) {
+        return;
+    }
+
+    // 先拷贝一份快照，百分位在同一组数据上计算
+    const latency_histogram_t *h = &g_latency[stage];
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint64_t total = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        buckets[i] = atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+        total += buckets[i];
+    }
+    if (total == 0) {
+        return;
+    }
+
+    uint32_t max_us = atomic_load_explicit(&h->max_us, memory_order_relaxed);
+    summary->count = (uint32_t)total;
+    summary->avg_us = (uint32_t)(atomic_load_explicit(&h->sum_us, memory_order_relaxed) / total);
+    summary->p50_us = value_at_rank(buckets, (total * 50 + 99) / 100, max_us);
+    summary->p95_us = value_at_rank(buckets, (total * 95 + 99) / 100, max_us);
+    summary->p99_us = value_at_rank(buckets, (total * 99 + 99) / 100, max_us);
+    summary->max_us = max_us;
+}
+
+const char *latency_stats_stage_name(latency_stage_t stage) {
+    return (unsigned)stage < LATENCY_STAGE_COUNT ? g_stage_names[stage] : "?";
+}
+
+int latency_stats_format(char *buffer, size_t size) {
+    if (!buffer || size == 0) {
+        return 0;
+    }
+
+    size_t pos = 0;
+    buffer[0] = '\0';
+    for (int s = 0; s < LATENCY_STAGE_COUNT && pos < size; s++) {
+        latency_summary_t sum;
+        latency_stats_get((latency_stage_t)s, &sum);
+        if (sum.count == 0) {
+            continue;
+        }
+        int n = snprintf(buffer + pos, size - pos, "%-6s %6.1f %6.1f %6.1f ms\n",
+                         g_stage_names[s], sum.p50_us / 1000.0, sum.p95_us / 1000.0, sum.p99_us / 1000.0);
+        if (n < 0) {
+            break;
+        }
+        pos += (size_t)n;
+    }
+    return (int)(pos < size ? pos : size - 1);
+}
+
+int latency_stats_dump(const char *path) {
+    if (!path) {
+        return -1;
+    }
+
+    char tmp_path[512];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *fp = fopen(tmp_path, "w");
+    if (!fp) {
+        return -1;
+    }
+
+    fprintf(fp, "# stage count avg_us p50_us p95_us p99_us max_us\n");
+    for (int s = 0; s < LATENCY_STAGE_COUNT; s++) {
+        latency_summary_t sum;
+        latency_stats_get((latency_stage_t)s, &sum);
+        fprintf(fp, "%s %u %u %u %u %u %u\n", g_stage_names[s], sum.count, sum.avg_us,
+                sum.p50_us, sum.p95_us, sum.p99_us, sum.max_us);
+    }
+
+    // 直方图原始数据：每行 阶段 桶代表值us 样本数（只写非空桶）
+    fprintf(fp, "# histogram: stage bucket_us count\n");
+    for (int s = 0; s < LATENCY_STAGE_COUNT; s++) {
+        for (int i = 0; i < LATENCY_BUCKETS; i++) {
+            uint32_t c = atomic_load_explicit(&g_latency[s].buckets[i], memory_order_relaxed);
+            if (c) {
+                fprintf(fp, "%s %u %u\n", g_stage_names[s], bucket_value(i), c);
+            }
+        }
+    }
+
+    if (fclose(fp) != 0 || rename(tmp_path, path) != 0) {
+        remove(tmp_path);
+        return -1;
+    }
+    return 0;
+}
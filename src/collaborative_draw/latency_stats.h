@@ -0,0 +1,106 @@
+/**
+ * @file latency_stats.h
+ * @brief 协作绘图分阶段延迟统计
+ *
+ * 一个点从一台设备的触摸到另一台设备的像素，依次经过：
+ *   触摸读取 → 本地绘制 → 批量等待/发送 → 网络（含服务器转发） → 解码入队 → 队列等待 → 写入framebuffer
+ * 每个阶段一个对数直方图（相对误差不超过12.5%），多线程无锁记录，
+ * 可输出p50/p95/p99，用于调试叠加层和统计文件。
+ *
+ * 本地阶段使用单调时钟微秒；跨设备阶段（网络、端到端）使用帧头中的墙上时钟毫秒，
+ * 需要两端时钟同步（NTP），超过60秒或为负的样本视为时钟未同步而丢弃。
+ */
+
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 延迟阶段
+typedef enum {
+    LATENCY_STAGE_TOUCH_READ = 0,   // 发送端：内核触摸事件时间戳 → 应用读到该事件
+    LATENCY_STAGE_LOCAL_DRAW,       // 发送端：读到触摸 → 本地绘制完成、交给协作模块
+    LATENCY_STAGE_BATCH_SEND,       // 发送端：帧内第一个点入队 → 帧写入socket
+    LATENCY_STAGE_NETWORK,          // 接收端：发送端写socket → 本端收到（含服务器转发，需时钟同步）
+    LATENCY_STAGE_DECODE,           // 接收端：收到消息 → 解码完成并压入远程绘图队列
+    LATENCY_STAGE_QUEUE_WAIT,       // 接收端：入队 → LVGL定时器出队
+    LATENCY_STAGE_FB_WRITE,         // 接收端：出队 → 写入framebuffer完成（每次出队一个样本）
+    LATENCY_STAGE_END_TO_END,       // 接收端：发送端触摸 → 本端写入framebuffer（需时钟同步）
+    LATENCY_STAGE_COUNT
+} latency_stage_t;
+
+// 单个阶段的统计摘要（微秒）
+typedef struct {
+    uint32_t count;
+    uint32_t avg_us;
+    uint32_t p50_us;
+    uint32_t p95_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} latency_summary_t;
+
+/**
+ * @brief 单调时钟微秒（本地阶段的时间基准）
+ * @return 微秒数
+ */
+uint64_t latency_now_us(void);
+
+/**
+ * @brief 墙上时钟毫秒（截断为32位，与帧头时间戳相同的时间基准）
+ * @return 毫秒数（不为0）
+ */
+uint32_t latency_wall_ms(void);
+
+/**
+ * @brief 记录一个样本（任意线程可调用）
+ * @param stage 阶段
+ * @param us 延迟（微秒）
+ */
+void latency_stats_record(latency_stage_t stage, uint32_t us);
+
+/**
+ * @brief 记录跨设备阶段：当前墙上时钟 - sent_ms - offset_us
+ *
+ * sent_ms为0（帧没有时间戳）或结果明显超出范围（两端时钟未同步）时不记录。
+ * @param stage 阶段
+ * @param sent_ms 发送端墙上时钟毫秒（帧头时间戳）
+ * @param offset_us 需要扣除的发送端本地耗时（微秒）
+ */
+void latency_stats_record_since_wall(latency_stage_t stage, uint32_t sent_ms, uint32_t offset_us);
+
+/**
+ * @brief 清空所有直方图
+ */
+void latency_stats_reset(void);
+
+/**
+ * @brief 获取阶段摘要
+ * @param stage 阶段
+ * @param summary 输出摘要
+ */
+void latency_stats_get(latency_stage_t stage, latency_summary_t *summary);
+
+/**
+ * @brief 阶段短名称（用于叠加层和统计文件）
+ * @param stage 阶段
+ * @return 名称，无效阶段返回"?"
+ */
+const char *latency_stats_stage_name(latency_stage_t stage);
+
+/**
+ * @brief 格式化为多行文本（每个有样本的阶段一行：名称 p50/p95/p99 毫秒）
+ * @param buffer 输出缓冲区
+ * @param size 缓冲区大小
+ * @return 写入的字符数（不含结尾0）
+ */
+int latency_stats_format(char *buffer, size_t size);
+
+/**
+ * @brief 把摘要和非空直方图桶写入文件（覆盖写，先写临时文件再rename）
+ * @param path 文件路径
+ * @return 成功返回0，失败返回-1
+ */
+int latency_stats_dump(const char *path);
+
+#endif /* LATENCY_STATS_H */
@@ -0,0 +1,99 @@
+/**
+ * @file remote_op_queue.c
+ * @brief 远程绘图操作队列实现
+ *
+ * head/tail为单调递增的计数器，取模得到槽位；生产者只写tail，消费者只写head。
+ * 生产者写完槽位后以release语义发布tail，消费者以acquire语义读取tail，
+ * 保证读到的槽位内容完整；head同理，保证槽位被读完后才会被覆盖。
+ */
+
+#include "remote_op_queue.h"
+#include <string.h>
+
+#define REMOTE_OP_QUEUE_MASK (REMOTE_OP_QUEUE_CAPACITY - 1)
+
+_Static_assert((REMOTE_OP_QUEUE_CAPACITY & REMOTE_OP_QUEUE_MASK) == 0,
+               "REMOTE_OP_QUEUE_CAPACITY must be a power of two");
+
+void remote_op_queue_init(remote_op_queue_t *q) {
+    if (!q) {
+        return;
+    }
+    
+    atomic_store_explicit(&q->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->tail, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->overflow, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->backpressure, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->high_watermark, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->pushed, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->popped, 0, memory_order_relaxed);
+}
+
+bool remote_op_queue_push(remote_op_queue_t *q, const remote_op_t *op) {
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    uint32_t used = tail - head;
+    
+    if (used >= REMOTE_OP_QUEUE_CAPACITY) {
+        atomic_fetch_add_explicit(&q->overflow, 1, memory_order_relaxed);
+        return false;
+    }
+    
+    q->slots[tail & REMOTE_OP_QUEUE_MASK] = *op;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    
+    // 统计（只有生产者写这些计数，relaxed即可）
+    used++;
+    atomic_fetch_add_explicit(&q->pushed, 1, memory_order_relaxed);
+    if (used > REMOTE_OP_QUEUE_CAPACITY * 3 / 4) {
+        atomic_fetch_add_explicit(&q->backpressure, 1, memory_order_relaxed);
+    }
+    if (used > atomic_load_explicit(&q->high_watermark, memory_order_relaxed)) {
+        atomic_store_explicit(&q->high_watermark, used, memory_order_relaxed);
+    }
+    return true;
+}
+
+int remote_op_queue_pop_batch(remote_op_queue_t *q, remote_op_t *out, int max) {
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    uint32_t avail = tail - head;
+    
+    if (max <= 0 || avail == 0) {
+        return 0;
+    }
+    if (avail > (uint32_t)max) {
+        avail = (uint32_t)max;
+    }
+    
+    // 环形缓冲区可能分两段拷贝
+    uint32_t start = head & REMOTE_OP_QUEUE_MASK;
+    uint32_t first = REMOTE_OP_QUEUE_CAPACITY - start;
+    if (first > avail) {
+        first = avail;
+    }
+    memcpy(out, &q->slots[start], first * sizeof(remote_op_t));
+    memcpy(out + first, &q->slots[0], (avail - first) * sizeof(remote_op_t));
+    
+    atomic_store_explicit(&q->head, head + avail, memory_order_release);
+    atomic_fetch_add_explicit(&q->popped, avail, memory_order_relaxed);
+    return (int)avail;
+}
+
+uint32_t remote_op_queue_size(remote_op_queue_t *q) {
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    return tail - head;
+}
+
+void remote_op_queue_get_stats(remote_op_queue_t *q, remote_op_queue_stats_t *stats) {
+    if (!q || !stats) {
+        return;
+    }
+    
+    stats->pushed = atomic_load_explicit(&q->pushed, memory_order_relaxed);
+    stats->popped = atomic_load_explicit(&q->popped, memory_order_relaxed);
+    stats->overflow = atomic_load_explicit(&q->overflow, memory_order_relaxed);
+    stats->backpressure = atomic_load_explicit(&q->backpressure, memory_order_relaxed);
+    stats->high_watermark = atomic_load_explicit(&q->high_watermark, memory_order_relaxed);
+}
@@ -0,0 +1,105 @@
+/**
+ * @file remote_op_queue.h
+ * @brief 远程绘图操作队列（单生产者/单消费者无锁环形队列）
+ *
+ * 网络I/O线程（生产者）把解码后的远程绘图操作压入队列，
+ * LVGL线程（消费者）在定时器中按帧批量取出并绘制，
+ * 避免在网络线程中直接操作framebuffer并与本地绘制争用锁。
+ */
+
+#ifndef REMOTE_OP_QUEUE_H
+#define REMOTE_OP_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// 队列容量（必须是2的幂）
+#define REMOTE_OP_QUEUE_CAPACITY 1024
+
+// 远程操作类型
+typedef enum {
+    REMOTE_OP_STROKE = 0,        // 笔画线段/清屏
+    REMOTE_OP_TILE,              // 画布快照矩形（x/y/w/h + pixels）
+    REMOTE_OP_UNDO,              // 撤销user_id最近的一笔
+    REMOTE_OP_REDO,              // 重做user_id最近撤销的一笔
+} remote_op_kind_t;
+
+// 远程绘图操作（pen_size=0 且 color=0xFFFFFFFF 表示清屏，与远程绘图回调约定一致）
+// 快照矩形与笔画走同一队列以保持先后顺序；pixels由生产者malloc、消费者free，
+// 为NULL表示用背景色填充该矩形
+typedef struct {
+    uint8_t kind;                // remote_op_kind_t
+    uint32_t user_id;            // 发送者用户ID（撤销历史按用户区分笔画）
+    uint16_t x;
+    uint16_t y;
+    uint16_t prev_x;
+    uint16_t prev_y;
+    uint32_t color;
+    uint8_t pen_size;
+    bool is_eraser;
+    uint16_t w;                  // 快照矩形宽度
+    uint16_t h;                  // 快照矩形高度
+    uint32_t *pixels;            // 快照像素（行优先，w*h）
+    uint32_t sent_ms;            // 发送端触摸时刻的墙上时钟毫秒（0=无，延迟统计用）
+    uint32_t enqueue_us;         // 入队时刻（latency_now_us()低32位，延迟统计用）
+} remote_op_t;
+
+// 队列统计信息
+typedef struct {
+    uint32_t pushed;             // 成功入队数
+    uint32_t popped;             // 已出队数
+    uint32_t overflow;           // 队列满被丢弃的操作数
+    uint32_t backpressure;       // 入队时占用超过3/4的次数
+    uint32_t high_watermark;     // 历史最大占用
+} remote_op_queue_stats_t;
+
+typedef struct {
+    remote_op_t slots[REMOTE_OP_QUEUE_CAPACITY];
+    _Atomic uint32_t head;       // 消费者读取位置
+    _Atomic uint32_t tail;       // 生产者写入位置
+    _Atomic uint32_t overflow;
+    _Atomic uint32_t backpressure;
+    _Atomic uint32_t high_watermark;
+    _Atomic uint32_t pushed;
+    _Atomic uint32_t popped;
+} remote_op_queue_t;
+
+/**
+ * @brief 初始化队列（不得与push/pop并发调用；静态存储的队列零初始化即为空队列）
+ * @param q 队列
+ */
+void remote_op_queue_init(remote_op_queue_t *q);
+
+/**
+ * @brief 入队（仅生产者线程调用）
+ * @param q 队列
+ * @param op 远程绘图操作
+ * @return 成功返回true，队列满返回false（计入overflow）
+ */
+bool remote_op_queue_push(remote_op_queue_t *q, const remote_op_t *op);
+
+/**
+ * @brief 批量出队（仅消费者线程调用）
+ * @param q 队列
+ * @param out 输出数组
+ * @param max 最多取出的数量
+ * @return 实际取出的数量
+ */
+int remote_op_queue_pop_batch(remote_op_queue_t *q, remote_op_t *out, int max);
+
+/**
+ * @brief 获取当前队列中的操作数
+ * @param q 队列
+ * @return 操作数
+ */
+uint32_t remote_op_queue_size(remote_op_queue_t *q);
+
+/**
+ * @brief 获取统计信息
+ * @param q 队列
+ * @param stats 输出统计信息
+ */
+void remote_op_queue_get_stats(remote_op_queue_t *q, remote_op_queue_stats_t *stats);
+
+#endif /* REMOTE_OP_QUEUE_H */
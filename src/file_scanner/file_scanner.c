@@ -1,6 +1,6 @@
 /**
  * @file file_scanner.c
- * @brief 文件扫描模块实现
+ * @brief 文件扫描模块实现（媒体索引）
  */
 
 #include <stdio.h>
@@ -9,9 +9,28 @@
 #include <strings.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/inotify.h>
 #include <errno.h>
 #include <stdbool.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include "file_scanner.h"
+#include "media_catalog.h"
+
+// 递归扫描的最大目录深度（根目录为0）
+#ifndef MEDIA_INDEX_MAX_DEPTH
+#define MEDIA_INDEX_MAX_DEPTH 8
+#endif
+
+// 根目录下最多跟踪的挂载点数量（U盘、SD卡等）
+#ifndef MEDIA_INDEX_MAX_MOUNTS
+#define MEDIA_INDEX_MAX_MOUNTS 16
+#endif
+
+#define MEDIA_PATH_MAX 512              // 文件路径最大长度
 
 // 图片文件相关全局变量（非static，供其他模块访问）
 char **image_files = NULL;
@@ -28,525 +47,670 @@ char **video_files = NULL;
 char **video_names = NULL;
 int video_count = 0;
 
-int scan_image_directory(const char *dir_path) {
-    DIR *dir;
-    struct dirent *entry;
-    struct stat st;
-    char full_path[512];
-    int count = 0;
-    int capacity = 32;  // 初始容量
-    
-    // 先释放旧的数组（如果存在）
-    free_image_arrays();
-    
-    // 分配初始内存
-    image_files = (char **)malloc(capacity * sizeof(char *));
-    image_names = (char **)malloc(capacity * sizeof(char *));
-    if (image_files == NULL || image_names == NULL) {
-        printf("错误: 内存分配失败\n");
-        return -1;
+// 媒体类型
+typedef enum {
+    MEDIA_TYPE_IMAGE = 0,
+    MEDIA_TYPE_AUDIO,
+    MEDIA_TYPE_VIDEO,
+    MEDIA_TYPE_COUNT,
+    MEDIA_TYPE_NONE = -1
+} media_type_t;
+
+// 一种媒体的列表（指向上面的全局变量）
+typedef struct {
+    char ***files;
+    char ***names;
+    int *count;
+    int capacity;                   // 数组容量（不含NULL终止符）
+} media_list_t;
+
+static media_list_t media_lists[MEDIA_TYPE_COUNT] = {
+    { &image_files, &image_names, &image_count, 0 },
+    { &audio_files, &audio_names, &audio_count, 0 },
+    { &video_files, &video_names, &video_count, 0 },
+};
+
+// 被监视的目录（inotify watch描述符 -> 目录路径）
+typedef struct {
+    int wd;
+    char *path;
+} dir_watch_t;
+
+static dir_watch_t *watches = NULL;
+static int watch_count = 0;
+static int watch_capacity = 0;
+static bool watch_limit_warned = false;
+
+static int inotify_fd = -1;
+static int mounts_fd = -1;                  // /proc/self/mounts，挂载表变化时poll返回POLLPRI
+static char mount_points[MEDIA_INDEX_MAX_MOUNTS][MEDIA_PATH_MAX];
+static int mount_count = 0;
+
+static char index_root[MEDIA_PATH_MAX];     // 索引的根目录（空表示未建立）
+static int added_files = 0;                 // 本次更新新增/删除的文件数（用于日志）
+static int removed_files = 0;
+
+// 列表修改在主线程中进行，其他线程读取列表时需要加锁
+static pthread_mutex_t index_mutex = PTHREAD_MUTEX_INITIALIZER;
+static _Atomic uint32_t index_gen = 0;      // 列表变化计数
+
+static void index_walk(const char *dir_path, int depth);
+
+// 根据扩展名判断媒体类型，图片同时返回显示名称的类型标识
+static media_type_t classify_file(const char *name, const char **suffix) {
+    const char *ext = strrchr(name, '.');
+    if (ext == NULL) {
+        return MEDIA_TYPE_NONE;
     }
-    
-    // 打开目录
-    dir = opendir(dir_path);
-    if (dir == NULL) {
-        printf("错误: 无法打开目录 %s: %s\n", dir_path, strerror(errno));
-        free(image_files);
-        free(image_names);
-        image_files = NULL;
-        image_names = NULL;
-        return -1;
+
+    if (strcasecmp(ext, ".bmp") == 0) {
+        *suffix = " (BMP)";
+        return MEDIA_TYPE_IMAGE;
     }
-    
-    printf("开始扫描目录: %s\n", dir_path);
-    
-    // 遍历目录中的文件
-    while ((entry = readdir(dir)) != NULL) {
-        // 跳过 . 和 ..
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-            continue;
-        }
-        
-        // 构建完整路径
-        snprintf(full_path, sizeof(full_path), "%s/%s", dir_path, entry->d_name);
-        
-        // 检查文件类型
-        if (stat(full_path, &st) != 0) {
-            continue;  // 跳过无法访问的文件
-        }
-        
-        // 只处理普通文件
-        if (!S_ISREG(st.st_mode)) {
-            continue;
-        }
-        
-        // 检查文件扩展名
-        const char *ext = strrchr(entry->d_name, '.');
-        if (ext == NULL) {
-            continue;
-        }
-        
-        bool is_bmp = (strcasecmp(ext, ".bmp") == 0);
-        bool is_gif = (strcasecmp(ext, ".gif") == 0);
-        
-        if (!is_bmp && !is_gif) {
-            continue;  // 跳过非BMP/GIF文件
-        }
-        
-        // 如果数组已满，扩容
-        if (count >= capacity) {
-            capacity *= 2;
-            char **new_files = (char **)realloc(image_files, capacity * sizeof(char *));
-            char **new_names = (char **)realloc(image_names, capacity * sizeof(char *));
-            if (new_files == NULL || new_names == NULL) {
-                printf("错误: 内存重新分配失败\n");
-                // 释放已分配的内存
-                for (int i = 0; i < count; i++) {
-                    free(image_files[i]);
-                    free(image_names[i]);
-                }
-                free(image_files);
-                free(image_names);
-                closedir(dir);
-                return -1;
-            }
-            image_files = new_files;
-            image_names = new_names;
-        }
-        
-        // 分配并复制文件路径
-        image_files[count] = (char *)malloc(strlen(full_path) + 1);
-        if (image_files[count] == NULL) {
-            printf("错误: 无法分配内存存储文件路径\n");
-            continue;
-        }
-        strcpy(image_files[count], full_path);
-        
-        // 生成显示名称（使用文件名，不含路径和扩展名）
-        char name_buf[256];
-        char temp_buf[256];
-        int name_len = ext - entry->d_name;
-        // 为后缀留出空间：" (BMP)" 或 " (GIF)" 最多6字节
-        const char *suffix = is_bmp ? " (BMP)" : " (GIF)";
-        int suffix_len = strlen(suffix);
-        int max_name_len = sizeof(name_buf) - suffix_len - 1;  // 保留结束符
-        if (name_len > max_name_len) name_len = max_name_len;
-        strncpy(temp_buf, entry->d_name, name_len);
-        temp_buf[name_len] = '\0';
-        
-        // 添加类型标识（使用临时缓冲区避免覆盖）
-        // 已确保有足够空间，抑制编译器误报警告
-        #pragma GCC diagnostic push
-        #pragma GCC diagnostic ignored "-Wformat-truncation"
-        snprintf(name_buf, sizeof(name_buf), "%s%s", temp_buf, suffix);
-        #pragma GCC diagnostic pop
-        
-        image_names[count] = (char *)malloc(strlen(name_buf) + 1);
-        if (image_names[count] == NULL) {
-            printf("错误: 无法分配内存存储文件名\n");
-            free(image_files[count]);
-            continue;
-        }
-        strcpy(image_names[count], name_buf);
-        
-        printf("找到图片文件[%d]: %s (%s)\n", count, full_path, name_buf);
-        count++;
+    if (strcasecmp(ext, ".gif") == 0) {
+        *suffix = " (GIF)";
+        return MEDIA_TYPE_IMAGE;
     }
-    
-    closedir(dir);
-    
-    // 添加NULL终止符
-    if (count < capacity) {
-        image_files[count] = NULL;
-        image_names[count] = NULL;
-    } else {
-        // 如果数组已满，需要再分配一个位置用于NULL
-        char **new_files = (char **)realloc(image_files, (capacity + 1) * sizeof(char *));
-        char **new_names = (char **)realloc(image_names, (capacity + 1) * sizeof(char *));
-        if (new_files != NULL && new_names != NULL) {
-            image_files = new_files;
-            image_names = new_names;
-            image_files[count] = NULL;
-            image_names[count] = NULL;
+    if (strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0) {
+        *suffix = " (JPG)";
+        return MEDIA_TYPE_IMAGE;
+    }
+    if (strcasecmp(ext, ".png") == 0) {
+        *suffix = " (PNG)";
+        return MEDIA_TYPE_IMAGE;
+    }
+
+    // 支持的音频格式
+    if (strcasecmp(ext, ".mp3") == 0 || strcasecmp(ext, ".wav") == 0 ||
+        strcasecmp(ext, ".ogg") == 0 || strcasecmp(ext, ".flac") == 0 ||
+        strcasecmp(ext, ".aac") == 0 || strcasecmp(ext, ".m4a") == 0) {
+        *suffix = " (音频)";
+        return MEDIA_TYPE_AUDIO;
+    }
+
+    // 支持的视频格式
+    if (strcasecmp(ext, ".mp4") == 0 || strcasecmp(ext, ".avi") == 0 ||
+        strcasecmp(ext, ".mkv") == 0 || strcasecmp(ext, ".mov") == 0 ||
+        strcasecmp(ext, ".flv") == 0 || strcasecmp(ext, ".wmv") == 0) {
+        *suffix = " (视频)";
+        return MEDIA_TYPE_VIDEO;
+    }
+
+    return MEDIA_TYPE_NONE;
+}
+
+// 生成显示名称（文件名去掉扩展名，加上类型标识）
+static void make_display_name(const char *name, const char *suffix, char *buf, size_t size) {
+    const char *ext = strrchr(name, '.');
+    int name_len = ext ? (int)(ext - name) : (int)strlen(name);
+    int max_name_len = (int)size - (int)strlen(suffix) - 1;    // 为后缀和结束符留出空间
+    if (name_len > max_name_len) {
+        name_len = max_name_len;
+    }
+    snprintf(buf, size, "%.*s%s", name_len, name, suffix);
+}
+
+// 路径是否位于目录prefix之下
+static bool path_under(const char *path, const char *prefix) {
+    size_t len = strlen(prefix);
+    return strncmp(path, prefix, len) == 0 && path[len] == '/';
+}
+
+// 在列表中查找路径
+static int list_find(const media_list_t *list, const char *path) {
+    for (int i = 0; i < *list->count; i++) {
+        if (strcmp((*list->files)[i], path) == 0) {
+            return i;
         }
     }
-    
-    image_count = count;
-    printf("扫描完成，共找到 %d 个图片文件\n", count);
-    
-    return count;
+    return -1;
 }
 
-int scan_audio_directory(const char *dir_path) {
-    DIR *dir;
-    struct dirent *entry;
-    struct stat st;
-    char full_path[512];
-    int count = 0;
-    int capacity = 32;  // 初始容量
-    
-    // 先释放旧的数组（如果存在）
-    free_audio_arrays();
-    
-    // 分配初始内存
-    audio_files = (char **)malloc(capacity * sizeof(char *));
-    audio_names = (char **)malloc(capacity * sizeof(char *));
-    if (audio_files == NULL || audio_names == NULL) {
-        printf("错误: 内存分配失败\n");
-        return -1;
+// 在列表末尾追加一个文件（调用者持有index_mutex）
+static int list_append(media_list_t *list, const char *path, const char *name) {
+    int count = *list->count;
+    if (count >= list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 32;   // 初始容量32，按需翻倍
+        // 多分配一个位置用于NULL终止符
+        char **new_files = (char **)realloc(*list->files, (capacity + 1) * sizeof(char *));
+        if (new_files == NULL) {
+            printf("错误: 内存重新分配失败\n");
+            return -1;
+        }
+        *list->files = new_files;
+        char **new_names = (char **)realloc(*list->names, (capacity + 1) * sizeof(char *));
+        if (new_names == NULL) {
+            printf("错误: 内存重新分配失败\n");
+            return -1;
+        }
+        *list->names = new_names;
+        list->capacity = capacity;
     }
-    
-    // 打开目录
-    dir = opendir(dir_path);
-    if (dir == NULL) {
-        printf("错误: 无法打开目录 %s: %s\n", dir_path, strerror(errno));
-        free(audio_files);
-        free(audio_names);
-        audio_files = NULL;
-        audio_names = NULL;
+
+    char *file_copy = strdup(path);
+    char *name_copy = strdup(name);
+    if (file_copy == NULL || name_copy == NULL) {
+        printf("错误: 无法分配内存存储文件路径\n");
+        free(file_copy);
+        free(name_copy);
         return -1;
     }
-    
-    printf("开始扫描音频目录: %s\n", dir_path);
-    
-    // 遍历目录中的文件
-    while ((entry = readdir(dir)) != NULL) {
-        // 跳过 . 和 ..
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+    (*list->files)[count] = file_copy;
+    (*list->names)[count] = name_copy;
+    (*list->files)[count + 1] = NULL;
+    (*list->names)[count + 1] = NULL;
+    *list->count = count + 1;
+    atomic_fetch_add(&index_gen, 1);
+    return 0;
+}
+
+// 删除列表中满足条件的文件，保持其余文件的顺序（调用者持有index_mutex）
+// prefix为NULL时删除path指定的文件，否则删除prefix目录下的所有文件
+static int list_remove(media_list_t *list, const char *path, const char *prefix) {
+    int kept = 0;
+    int count = *list->count;
+    for (int i = 0; i < count; i++) {
+        const char *file = (*list->files)[i];
+        bool remove = prefix ? path_under(file, prefix) : strcmp(file, path) == 0;
+        if (remove) {
+            media_catalog_remove(file);
+            free((*list->files)[i]);
+            free((*list->names)[i]);
             continue;
         }
-        
-        // 构建完整路径
-        snprintf(full_path, sizeof(full_path), "%s/%s", dir_path, entry->d_name);
-        
-        // 检查文件类型
-        if (stat(full_path, &st) != 0) {
-            continue;  // 跳过无法访问的文件
+        (*list->files)[kept] = (*list->files)[i];
+        (*list->names)[kept] = (*list->names)[i];
+        kept++;
+    }
+    if (*list->files != NULL) {
+        // 容量不缩小：整个尾部置空，不留下已释放的指针（NULL终止符也在其中）
+        for (int i = kept; i <= count; i++) {
+            (*list->files)[i] = NULL;
+            (*list->names)[i] = NULL;
         }
-        
-        // 只处理普通文件
-        if (!S_ISREG(st.st_mode)) {
-            continue;
+    }
+    *list->count = kept;
+    if (kept != count) {
+        atomic_fetch_add(&index_gen, 1);
+    }
+    return count - kept;
+}
+
+// 释放一个列表
+static void list_free(media_list_t *list) {
+    pthread_mutex_lock(&index_mutex);
+    for (int i = 0; i < *list->count; i++) {
+        free((*list->files)[i]);
+        free((*list->names)[i]);
+    }
+    free(*list->files);
+    free(*list->names);
+    *list->files = NULL;
+    *list->names = NULL;
+    *list->count = 0;
+    list->capacity = 0;
+    atomic_fetch_add(&index_gen, 1);
+    pthread_mutex_unlock(&index_mutex);
+}
+
+// 把一个文件加入索引（不是媒体文件时忽略）
+// 扫描目录时每个文件只出现一次，不查重；inotify事件可能重复（如文件被再次写入），需要查重
+static void index_add_file(const char *path, const char *name, bool check_dup) {
+    const char *suffix = NULL;
+    media_type_t type = classify_file(name, &suffix);
+    if (type == MEDIA_TYPE_NONE) {
+        return;
+    }
+
+    char display_name[256];
+    make_display_name(name, suffix, display_name, sizeof(display_name));
+
+    media_list_t *list = &media_lists[type];
+    pthread_mutex_lock(&index_mutex);
+    if ((!check_dup || list_find(list, path) < 0) && list_append(list, path, display_name) == 0) {
+        added_files++;
+    }
+    pthread_mutex_unlock(&index_mutex);
+    // 已在列表中的文件也通知目录（文件被重新写入时重新提取元数据）
+    media_catalog_add(path);
+}
+
+// 从索引中删除一个文件
+static void index_remove_file(const char *path, const char *name) {
+    const char *suffix = NULL;
+    media_type_t type = classify_file(name, &suffix);
+    if (type == MEDIA_TYPE_NONE) {
+        return;
+    }
+    pthread_mutex_lock(&index_mutex);
+    removed_files += list_remove(&media_lists[type], path, NULL);
+    pthread_mutex_unlock(&index_mutex);
+}
+
+// 从索引中删除目录下的所有文件
+static void index_remove_dir(const char *dir_path) {
+    pthread_mutex_lock(&index_mutex);
+    for (int t = 0; t < MEDIA_TYPE_COUNT; t++) {
+        removed_files += list_remove(&media_lists[t], NULL, dir_path);
+    }
+    pthread_mutex_unlock(&index_mutex);
+}
+
+// 查找watch描述符对应的目录
+static int watch_find(int wd) {
+    for (int i = 0; i < watch_count; i++) {
+        if (watches[i].wd == wd) {
+            return i;
         }
-        
-        // 检查文件扩展名
-        const char *ext = strrchr(entry->d_name, '.');
-        if (ext == NULL) {
-            continue;
+    }
+    return -1;
+}
+
+// 监视一个目录（同一目录再次添加时inotify返回相同的wd，只更新路径）
+static void watch_add(const char *dir_path) {
+    if (inotify_fd < 0) {
+        return;
+    }
+    int wd = inotify_add_watch(inotify_fd, dir_path,
+                               IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE |
+                               IN_DELETE | IN_DELETE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW);
+    if (wd < 0) {
+        if (!watch_limit_warned) {
+            printf("[媒体索引] 无法监视目录 %s: %s（该目录的变化需要重新扫描）\n", dir_path, strerror(errno));
+            watch_limit_warned = true;
+        }
+        return;
+    }
+
+    char *path_copy = strdup(dir_path);
+    if (path_copy == NULL) {
+        inotify_rm_watch(inotify_fd, wd);
+        return;
+    }
+    int i = watch_find(wd);
+    if (i >= 0) {
+        free(watches[i].path);
+        watches[i].path = path_copy;
+        return;
+    }
+    if (watch_count >= watch_capacity) {
+        int capacity = watch_capacity ? watch_capacity * 2 : 16;
+        dir_watch_t *new_watches = (dir_watch_t *)realloc(watches, capacity * sizeof(dir_watch_t));
+        if (new_watches == NULL) {
+            free(path_copy);
+            inotify_rm_watch(inotify_fd, wd);
+            return;
+        }
+        watches = new_watches;
+        watch_capacity = capacity;
+    }
+    watches[watch_count].wd = wd;
+    watches[watch_count].path = path_copy;
+    watch_count++;
+}
+
+// 删除watch表中的第i项（rm为true时同时取消inotify监视）
+static void watch_remove_at(int i, bool rm) {
+    if (rm && inotify_fd >= 0) {
+        inotify_rm_watch(inotify_fd, watches[i].wd);
+    }
+    free(watches[i].path);
+    watches[i] = watches[--watch_count];
+}
+
+// 取消目录本身及其子目录的监视（目录被移走或删除）
+static void watch_remove_dir(const char *dir_path) {
+    for (int i = watch_count - 1; i >= 0; i--) {
+        if (strcmp(watches[i].path, dir_path) == 0 || path_under(watches[i].path, dir_path)) {
+            watch_remove_at(i, true);
         }
-        
-        // 支持的音频格式
-        bool is_audio = (strcasecmp(ext, ".mp3") == 0 ||
-                         strcasecmp(ext, ".wav") == 0 ||
-                         strcasecmp(ext, ".ogg") == 0 ||
-                         strcasecmp(ext, ".flac") == 0 ||
-                         strcasecmp(ext, ".aac") == 0 ||
-                         strcasecmp(ext, ".m4a") == 0);
-        
-        if (!is_audio) {
-            continue;  // 跳过非音频文件
+    }
+}
+
+// 处理一个目录项：普通文件加入索引，子目录递归扫描
+// d_type可用时不需要stat；文件系统不提供类型（DT_UNKNOWN）或是符号链接时才stat
+static void index_entry(const char *dir_path, const char *name, unsigned char d_type, int depth, bool check_dup) {
+    char full_path[MEDIA_PATH_MAX];
+    const char *suffix = NULL;
+
+    if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+        return;
+    }
+    if (snprintf(full_path, sizeof(full_path), "%s/%s", dir_path, name) >= (int)sizeof(full_path)) {
+        return;     // 路径过长
+    }
+
+    if (d_type == DT_UNKNOWN || d_type == DT_LNK) {
+        struct stat st;
+        if (stat(full_path, &st) != 0) {
+            return;  // 跳过无法访问的文件
         }
-        
-        // 如果数组已满，扩容
-        if (count >= capacity) {
-            capacity *= 2;
-            char **new_files = (char **)realloc(audio_files, capacity * sizeof(char *));
-            char **new_names = (char **)realloc(audio_names, capacity * sizeof(char *));
-            if (new_files == NULL || new_names == NULL) {
-                printf("错误: 内存重新分配失败\n");
-                // 释放已分配的内存
-                for (int i = 0; i < count; i++) {
-                    free(audio_files[i]);
-                    free(audio_names[i]);
-                }
-                free(audio_files);
-                free(audio_names);
-                closedir(dir);
-                return -1;
-            }
-            audio_files = new_files;
-            audio_names = new_names;
+        if (S_ISREG(st.st_mode)) {
+            d_type = DT_REG;
+        } else if (S_ISDIR(st.st_mode) && d_type == DT_UNKNOWN) {
+            d_type = DT_DIR;     // 不进入符号链接指向的目录，避免循环
+        } else {
+            return;
         }
-        
-        // 分配并复制文件路径
-        audio_files[count] = (char *)malloc(strlen(full_path) + 1);
-        if (audio_files[count] == NULL) {
-            printf("错误: 无法分配内存存储文件路径\n");
-            continue;
+    }
+
+    if (d_type == DT_REG) {
+        if (classify_file(name, &suffix) != MEDIA_TYPE_NONE) {
+            index_add_file(full_path, name, check_dup);
         }
-        strcpy(audio_files[count], full_path);
-        
-        // 生成显示名称（使用文件名，不含路径和扩展名）
-        char name_buf[256];
-        char temp_buf[256];
-        int name_len = ext - entry->d_name;
-        const char *suffix = " (音频)";
-        int suffix_len = strlen(suffix);
-        int max_name_len = sizeof(name_buf) - suffix_len - 1;
-        if (name_len > max_name_len) name_len = max_name_len;
-        strncpy(temp_buf, entry->d_name, name_len);
-        temp_buf[name_len] = '\0';
-        
-        #pragma GCC diagnostic push
-        #pragma GCC diagnostic ignored "-Wformat-truncation"
-        snprintf(name_buf, sizeof(name_buf), "%s%s", temp_buf, suffix);
-        #pragma GCC diagnostic pop
-        
-        audio_names[count] = (char *)malloc(strlen(name_buf) + 1);
-        if (audio_names[count] == NULL) {
-            printf("错误: 无法分配内存存储文件名\n");
-            free(audio_files[count]);
-            continue;
+    } else if (d_type == DT_DIR) {
+        // 跳过隐藏目录（回收站、缩略图等）
+        if (name[0] != '.' && depth < MEDIA_INDEX_MAX_DEPTH) {
+            index_walk(full_path, depth + 1);
         }
-        strcpy(audio_names[count], name_buf);
-        
-        printf("找到音频文件[%d]: %s (%s)\n", count, full_path, name_buf);
-        count++;
     }
-    
+}
+
+// 递归扫描目录并监视它
+static void index_walk(const char *dir_path, int depth) {
+    DIR *dir = opendir(dir_path);
+    if (dir == NULL) {
+        printf("错误: 无法打开目录 %s: %s\n", dir_path, strerror(errno));
+        return;
+    }
+    // 先监视再读取，读取期间新建的文件也不会漏掉（之后收到的重复事件会查重）
+    watch_add(dir_path);
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        index_entry(dir_path, entry->d_name, entry->d_type, depth, false);
+    }
     closedir(dir);
-    
-    // 添加NULL终止符
-    if (count < capacity) {
-        audio_files[count] = NULL;
-        audio_names[count] = NULL;
-    } else {
-        char **new_files = (char **)realloc(audio_files, (capacity + 1) * sizeof(char *));
-        char **new_names = (char **)realloc(audio_names, (capacity + 1) * sizeof(char *));
-        if (new_files != NULL && new_names != NULL) {
-            audio_files = new_files;
-            audio_names = new_names;
-            audio_files[count] = NULL;
-            audio_names[count] = NULL;
+}
+
+// 计算目录相对根目录的深度
+static int dir_depth(const char *dir_path) {
+    int depth = 0;
+    for (const char *p = dir_path + strlen(index_root); *p; p++) {
+        if (*p == '/') {
+            depth++;
         }
     }
-    
-    audio_count = count;
-    printf("扫描完成，共找到 %d 个音频文件\n", count);
-    
-    return count;
+    return depth;
 }
 
-int scan_video_directory(const char *dir_path) {
-    DIR *dir;
-    struct dirent *entry;
-    struct stat st;
-    char full_path[512];
+// 读取根目录下的挂载点（/proc/self/mounts第二列，空格等字符以\ooo转义）
+static int read_mount_points(char points[][MEDIA_PATH_MAX], int max) {
+    static char buf[16384];
     int count = 0;
-    int capacity = 32;  // 初始容量
-    
-    // 先释放旧的数组（如果存在）
-    free_video_arrays();
-    
-    // 分配初始内存
-    video_files = (char **)malloc(capacity * sizeof(char *));
-    video_names = (char **)malloc(capacity * sizeof(char *));
-    if (video_files == NULL || video_names == NULL) {
-        printf("错误: 内存分配失败\n");
-        return -1;
+    if (mounts_fd < 0 || lseek(mounts_fd, 0, SEEK_SET) < 0) {
+        return 0;
     }
-    
-    // 打开目录
-    dir = opendir(dir_path);
-    if (dir == NULL) {
-        printf("错误: 无法打开目录 %s: %s\n", dir_path, strerror(errno));
-        free(video_files);
-        free(video_names);
-        video_files = NULL;
-        video_names = NULL;
-        return -1;
+    // proc文件每次read可能只返回一部分
+    size_t len = 0;
+    ssize_t got;
+    while (len < sizeof(buf) - 1 && (got = read(mounts_fd, buf + len, sizeof(buf) - 1 - len)) > 0) {
+        len += (size_t)got;
     }
-    
-    printf("开始扫描视频目录: %s\n", dir_path);
-    
-    // 遍历目录中的文件
-    while ((entry = readdir(dir)) != NULL) {
-        // 跳过 . 和 ..
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-            continue;
-        }
-        
-        // 构建完整路径
-        snprintf(full_path, sizeof(full_path), "%s/%s", dir_path, entry->d_name);
-        
-        // 检查文件类型
-        if (stat(full_path, &st) != 0) {
-            continue;  // 跳过无法访问的文件
-        }
-        
-        // 只处理普通文件
-        if (!S_ISREG(st.st_mode)) {
-            continue;
-        }
-        
-        // 检查文件扩展名
-        const char *ext = strrchr(entry->d_name, '.');
-        if (ext == NULL) {
-            continue;
-        }
-        
-        // 支持的视频格式
-        bool is_video = (strcasecmp(ext, ".mp4") == 0 ||
-                         strcasecmp(ext, ".avi") == 0 ||
-                         strcasecmp(ext, ".mkv") == 0 ||
-                         strcasecmp(ext, ".mov") == 0 ||
-                         strcasecmp(ext, ".flv") == 0 ||
-                         strcasecmp(ext, ".wmv") == 0);
-        
-        if (!is_video) {
-            continue;  // 跳过非视频文件
-        }
-        
-        // 如果数组已满，扩容
-        if (count >= capacity) {
-            capacity *= 2;
-            char **new_files = (char **)realloc(video_files, capacity * sizeof(char *));
-            char **new_names = (char **)realloc(video_names, capacity * sizeof(char *));
-            if (new_files == NULL || new_names == NULL) {
-                printf("错误: 内存重新分配失败\n");
-                // 释放已分配的内存
-                for (int i = 0; i < count; i++) {
-                    free(video_files[i]);
-                    free(video_names[i]);
+    buf[len] = '\0';
+
+    for (char *line = buf; line && *line && count < max; ) {
+        char *next = strchr(line, '\n');
+        if (next) {
+            *next++ = '\0';
+        }
+        char *field = strchr(line, ' ');
+        if (field) {
+            field++;
+            char path[MEDIA_PATH_MAX];
+            size_t n = 0;
+            for (char *p = field; *p && *p != ' ' && n < sizeof(path) - 1; p++) {
+                if (p[0] == '\\' && p[1] >= '0' && p[1] <= '3' && p[2] && p[3]) {
+                    path[n++] = (char)(((p[1] - '0') << 6) | ((p[2] - '0') << 3) | (p[3] - '0'));
+                    p += 3;
+                } else {
+                    path[n++] = *p;
                 }
-                free(video_files);
-                free(video_names);
-                closedir(dir);
-                return -1;
             }
-            video_files = new_files;
-            video_names = new_names;
-        }
-        
-        // 分配并复制文件路径
-        video_files[count] = (char *)malloc(strlen(full_path) + 1);
-        if (video_files[count] == NULL) {
-            printf("错误: 无法分配内存存储文件路径\n");
-            continue;
-        }
-        strcpy(video_files[count], full_path);
-        
-        // 生成显示名称（使用文件名，不含路径和扩展名）
-        char name_buf[256];
-        char temp_buf[256];
-        int name_len = ext - entry->d_name;
-        const char *suffix = " (视频)";
-        int suffix_len = strlen(suffix);
-        int max_name_len = sizeof(name_buf) - suffix_len - 1;
-        if (name_len > max_name_len) name_len = max_name_len;
-        strncpy(temp_buf, entry->d_name, name_len);
-        temp_buf[name_len] = '\0';
-        
-        #pragma GCC diagnostic push
-        #pragma GCC diagnostic ignored "-Wformat-truncation"
-        snprintf(name_buf, sizeof(name_buf), "%s%s", temp_buf, suffix);
-        #pragma GCC diagnostic pop
-        
-        video_names[count] = (char *)malloc(strlen(name_buf) + 1);
-        if (video_names[count] == NULL) {
-            printf("错误: 无法分配内存存储文件名\n");
-            free(video_files[count]);
-            continue;
+            path[n] = '\0';
+            if (path_under(path, index_root)) {
+                snprintf(points[count++], MEDIA_PATH_MAX, "%s", path);
+            }
         }
-        strcpy(video_names[count], name_buf);
-        
-        printf("找到视频文件[%d]: %s (%s)\n", count, full_path, name_buf);
-        count++;
+        line = next;
     }
-    
-    closedir(dir);
-    
-    // 添加NULL终止符
-    if (count < capacity) {
-        video_files[count] = NULL;
-        video_names[count] = NULL;
-    } else {
-        char **new_files = (char **)realloc(video_files, (capacity + 1) * sizeof(char *));
-        char **new_names = (char **)realloc(video_names, (capacity + 1) * sizeof(char *));
-        if (new_files != NULL && new_names != NULL) {
-            video_files = new_files;
-            video_names = new_names;
-            video_files[count] = NULL;
-            video_names[count] = NULL;
+    return count;
+}
+
+// 挂载点是否在列表中
+static bool mount_listed(char points[][MEDIA_PATH_MAX], int count, const char *path) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(points[i], path) == 0) {
+            return true;
         }
     }
-    
-    video_count = count;
-    printf("扫描完成，共找到 %d 个视频文件\n", count);
-    
-    return count;
+    return false;
 }
 
-void free_image_arrays(void) {
-    if (image_files != NULL) {
-        for (int i = 0; i < image_count; i++) {
-            if (image_files[i] != NULL) {
-                free(image_files[i]);
-            }
+// 重新扫描一个目录（挂载或卸载后目录内容整体变化）
+static void index_rescan_dir(const char *dir_path) {
+    index_remove_dir(dir_path);
+    watch_remove_dir(dir_path);
+    struct stat st;
+    if (stat(dir_path, &st) == 0 && S_ISDIR(st.st_mode)) {
+        index_walk(dir_path, dir_depth(dir_path));
+    }
+}
+
+// 挂载表变化：只重新扫描新挂载或已卸载的目录
+static void check_mounts(void) {
+    static char points[MEDIA_INDEX_MAX_MOUNTS][MEDIA_PATH_MAX];
+    int count = read_mount_points(points, MEDIA_INDEX_MAX_MOUNTS);
+
+    for (int i = 0; i < count; i++) {
+        if (!mount_listed(mount_points, mount_count, points[i])) {
+            printf("[媒体索引] 检测到挂载: %s\n", points[i]);
+            index_rescan_dir(points[i]);
         }
-        free(image_files);
-        image_files = NULL;
-    }
-    
-    if (image_names != NULL) {
-        for (int i = 0; i < image_count; i++) {
-            if (image_names[i] != NULL) {
-                free(image_names[i]);
-            }
+    }
+    for (int i = 0; i < mount_count; i++) {
+        if (!mount_listed(points, count, mount_points[i])) {
+            printf("[媒体索引] 检测到卸载: %s\n", mount_points[i]);
+            index_rescan_dir(mount_points[i]);
         }
-        free(image_names);
-        image_names = NULL;
     }
-    
-    image_count = 0;
+    memcpy(mount_points, points, sizeof(points[0]) * count);
+    mount_count = count;
 }
 
-void free_audio_arrays(void) {
-    if (audio_files != NULL) {
-        for (int i = 0; i < audio_count; i++) {
-            if (audio_files[i] != NULL) {
-                free(audio_files[i]);
-            }
-        }
-        free(audio_files);
-        audio_files = NULL;
-    }
-    
-    if (audio_names != NULL) {
-        for (int i = 0; i < audio_count; i++) {
-            if (audio_names[i] != NULL) {
-                free(audio_names[i]);
+// 处理一个inotify事件
+static void handle_event(const struct inotify_event *ev) {
+    int i = watch_find(ev->wd);
+    if (i < 0) {
+        return;
+    }
+    if (ev->mask & (IN_IGNORED | IN_DELETE_SELF | IN_UNMOUNT)) {
+        // 目录已删除或所在文件系统已卸载
+        index_remove_dir(watches[i].path);
+        watch_remove_at(i, false);
+        return;
+    }
+    if (ev->len == 0) {
+        return;
+    }
+
+    char full_path[MEDIA_PATH_MAX];
+    if (snprintf(full_path, sizeof(full_path), "%s/%s", watches[i].path, ev->name) >= (int)sizeof(full_path)) {
+        return;
+    }
+
+    if (ev->mask & IN_ISDIR) {
+        if (ev->mask & (IN_CREATE | IN_MOVED_TO)) {
+            // 新目录（或移入的目录）：扫描整个子树
+            if (ev->name[0] != '.' && dir_depth(full_path) <= MEDIA_INDEX_MAX_DEPTH) {
+                index_walk(full_path, dir_depth(full_path));
             }
+        } else if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) {
+            index_remove_dir(full_path);
+            watch_remove_dir(full_path);
         }
-        free(audio_names);
-        audio_names = NULL;
+        return;
+    }
+
+    if (ev->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+        // 文件写完或移入（刚创建还在写入的文件等IN_CLOSE_WRITE）
+        index_entry(watches[i].path, ev->name, DT_UNKNOWN, dir_depth(watches[i].path), true);
+    } else if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) {
+        index_remove_file(full_path, ev->name);
     }
-    
-    audio_count = 0;
 }
 
-void free_video_arrays(void) {
-    if (video_files != NULL) {
-        for (int i = 0; i < video_count; i++) {
-            if (video_files[i] != NULL) {
-                free(video_files[i]);
-            }
+int media_index_build(const char *root, bool force) {
+    char path[MEDIA_PATH_MAX];
+    snprintf(path, sizeof(path), "%s", root);
+    size_t len = strlen(path);
+    while (len > 1 && path[len - 1] == '/') {
+        path[--len] = '\0';
+    }
+
+    if (!force && index_root[0] != '\0' && strcmp(index_root, path) == 0) {
+        return 0;   // 已建立，inotify保持最新
+    }
+
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        printf("错误: 无法打开目录 %s\n", path);
+        return -1;
+    }
+
+    media_index_close();
+    snprintf(index_root, sizeof(index_root), "%s", path);
+    printf("开始扫描目录: %s\n", index_root);
+
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+        printf("[媒体索引] inotify不可用: %s（文件变化需要重新扫描）\n", strerror(errno));
+    }
+    mounts_fd = open("/proc/self/mounts", O_RDONLY | O_CLOEXEC);
+    mount_count = read_mount_points(mount_points, MEDIA_INDEX_MAX_MOUNTS);
+
+    added_files = 0;
+    index_walk(index_root, 0);
+    added_files = 0;
+
+    printf("扫描完成，共找到 %d 个图片文件、%d 个音频文件、%d 个视频文件（监视%d个目录）\n",
+           image_count, audio_count, video_count, watch_count);
+    return 0;
+}
+
+void media_index_poll(void) {
+    if (index_root[0] == '\0') {
+        return;
+    }
+
+    added_files = 0;
+    removed_files = 0;
+
+    if (mounts_fd >= 0) {
+        struct pollfd pfd = { .fd = mounts_fd, .events = POLLPRI };
+        if (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLPRI | POLLERR))) {
+            check_mounts();
         }
-        free(video_files);
-        video_files = NULL;
-    }
-    
-    if (video_names != NULL) {
-        for (int i = 0; i < video_count; i++) {
-            if (video_names[i] != NULL) {
-                free(video_names[i]);
+    }
+
+    bool overflow = false;
+    if (inotify_fd >= 0) {
+        // 按inotify_event对齐的缓冲区（只在主线程中使用）
+        static char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t len;
+        while (!overflow && (len = read(inotify_fd, buf, sizeof(buf))) > 0) {
+            for (char *p = buf; p < buf + len; ) {
+                const struct inotify_event *ev = (const struct inotify_event *)p;
+                if (ev->mask & IN_Q_OVERFLOW) {
+                    overflow = true;
+                    break;
+                }
+                handle_event(ev);
+                p += sizeof(struct inotify_event) + ev->len;
             }
         }
-        free(video_names);
-        video_names = NULL;
     }
-    
-    video_count = 0;
+    if (overflow) {
+        // 事件队列溢出，丢失了变化，只能重新扫描
+        printf("[媒体索引] 事件过多，重新扫描 %s\n", index_root);
+        char root[MEDIA_PATH_MAX];
+        snprintf(root, sizeof(root), "%s", index_root);
+        media_index_build(root, true);
+        return;
+    }
+
+    if (added_files > 0 || removed_files > 0) {
+        printf("[媒体索引] 更新: 新增%d个、删除%d个，现有图片%d、音频%d、视频%d\n",
+               added_files, removed_files, image_count, audio_count, video_count);
+    }
+}
+
+void media_index_close(void) {
+    while (watch_count > 0) {
+        watch_remove_at(watch_count - 1, false);
+    }
+    free(watches);
+    watches = NULL;
+    watch_capacity = 0;
+    watch_limit_warned = false;
+    if (inotify_fd >= 0) {
+        close(inotify_fd);      // 关闭时自动取消所有监视
+        inotify_fd = -1;
+    }
+    if (mounts_fd >= 0) {
+        close(mounts_fd);
+        mounts_fd = -1;
+    }
+    mount_count = 0;
+    index_root[0] = '\0';
+    free_image_arrays();
+    free_audio_arrays();
+    free_video_arrays();
+}
+
+void media_index_lock(void) {
+    pthread_mutex_lock(&index_mutex);
+}
+
+void media_index_unlock(void) {
+    pthread_mutex_unlock(&index_mutex);
+}
+
+uint32_t media_index_generation(void) {
+    return atomic_load(&index_gen);
+}
+
+int scan_image_directory(const char *dir_path) {
+    if (media_index_build(dir_path, false) != 0) {
+        return -1;
+    }
+    return image_count;
+}
+
+int scan_audio_directory(const char *dir_path) {
+    if (media_index_build(dir_path, false) != 0) {
+        return -1;
+    }
+    return audio_count;
+}
+
+int scan_video_directory(const char *dir_path) {
+    if (media_index_build(dir_path, false) != 0) {
+        return -1;
+    }
+    return video_count;
+}
+
+void free_image_arrays(void) {
+    list_free(&media_lists[MEDIA_TYPE_IMAGE]);
+}
+
+void free_audio_arrays(void) {
+    list_free(&media_lists[MEDIA_TYPE_AUDIO]);
+}
+
+void free_video_arrays(void) {
+    list_free(&media_lists[MEDIA_TYPE_VIDEO]);
 }
 
 char **get_image_files(void) {
@@ -584,4 +748,3 @@ char **get_video_names(void) {
 int get_video_count(void) {
     return video_count;
 }
-
@@ -6,8 +6,57 @@
 #ifndef FILE_SCANNER_H
 #define FILE_SCANNER_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 建立媒体索引：一次递归扫描根目录，同时分类图片、音频和视频文件
+ *
+ * 扫描时使用readdir返回的d_type判断文件类型，只有文件系统不提供类型或是符号链接时才stat；
+ * 跳过隐藏目录，不进入符号链接指向的目录，最大深度MEDIA_INDEX_MAX_DEPTH。
+ * 之后用inotify监视所有目录、用/proc/self/mounts监视挂载（U盘、SD卡），
+ * 由media_index_poll()增量更新，不再整体重新扫描。
+ * @param root 根目录
+ * @param force 为false且已对同一根目录建立索引时直接返回（索引保持最新）；为true时重新扫描
+ * @return 成功返回0，失败返回-1
+ */
+int media_index_build(const char *root, bool force);
+
+/**
+ * @brief 处理已发生的文件变化（新增、删除、移动、挂载、卸载），不阻塞
+ *
+ * 在主循环中调用。新增文件追加到列表末尾，删除文件时其余文件保持原有顺序。
+ */
+void media_index_poll(void);
+
+/**
+ * @brief 关闭媒体索引（停止监视，释放所有列表）
+ */
+void media_index_close(void);
+
+/**
+ * @brief 锁定媒体列表
+ *
+ * 列表只在主线程（media_index_poll）中修改。其他线程读取列表时需要加锁，
+ * 并在解锁前复制需要的路径。
+ */
+void media_index_lock(void);
+
+/**
+ * @brief 解锁媒体列表
+ */
+void media_index_unlock(void);
+
+/**
+ * @brief 媒体列表变化计数，每次新增、删除文件或释放列表时增加（调用者据此判断列表是否变化）
+ * @return 计数
+ */
+uint32_t media_index_generation(void);
+
 /**
- * @brief 扫描指定目录中的图片文件（BMP和GIF）
+ * @brief 扫描指定目录中的图片文件（BMP、GIF、JPEG和PNG）
+ *
+ * 建立（或复用）dir_path的媒体索引，返回其中的图片数量。
  * @param dir_path 目录路径
  * @return 找到的文件数量，失败返回-1
  */
@@ -15,6 +64,8 @@ int scan_image_directory(const char *dir_path);
 
 /**
  * @brief 扫描指定目录中的音频文件
+ *
+ * 建立（或复用）dir_path的媒体索引，返回其中的音频数量。
  * @param dir_path 目录路径
  * @return 找到的文件数量，失败返回-1
  */
@@ -22,6 +73,8 @@ int scan_audio_directory(const char *dir_path);
 
 /**
  * @brief 扫描指定目录中的视频文件
+ *
+ * 建立（或复用）dir_path的媒体索引，返回其中的视频数量。
  * @param dir_path 目录路径
  * @return 找到的文件数量，失败返回-1
  */
@@ -0,0 +1,677 @@
+/**
+ * @file media_catalog.c
+ * @brief 持久化媒体目录实现
+ */
+
+#include "media_catalog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+// 提取元数据的线程数
+#ifndef MEDIA_CATALOG_WORKERS
+    #define MEDIA_CATALOG_WORKERS 2
+#endif
+
+// 提取线程的nice值（后台工作，不和界面、索引扫描抢CPU）
+#ifndef MEDIA_CATALOG_NICE
+    #define MEDIA_CATALOG_NICE 10
+#endif
+
+// 队列空闲后延迟保存（合并连续的删除、新增），以及队列一直不空时的最长保存间隔
+#ifndef MEDIA_CATALOG_SAVE_DELAY_MS
+    #define MEDIA_CATALOG_SAVE_DELAY_MS 2000
+#endif
+#ifndef MEDIA_CATALOG_SAVE_MAX_MS
+    #define MEDIA_CATALOG_SAVE_MAX_MS 30000
+#endif
+
+#define CATALOG_MAGIC 0x5441434Du              // "MCAT"
+#define CATALOG_VERSION 1
+#define CATALOG_PATH_MAX 512
+#define CATALOG_NO_TITLE UINT32_MAX
+
+// 目录文件头
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t string_bytes;                      // 记录之后的字符串区大小
+} catalog_file_header_t;
+
+// 目录文件中的记录（48字节），字符串（路径、标题）以0结尾保存在字符串区
+typedef struct {
+    int64_t size;
+    int64_t mtime;
+    uint32_t path_off;
+    uint32_t title_off;                         // CATALOG_NO_TITLE表示没有标题
+    uint16_t width;
+    uint16_t height;
+    uint8_t kind;
+    uint8_t container;
+    uint8_t state;                              // MEDIA_INFO_READY或MEDIA_INFO_FAILED
+    uint8_t reserved;
+    uint32_t frames;
+    uint32_t delay_ms;
+    uint32_t duration_ms;
+    uint32_t reserved2;
+} catalog_record_t;
+
+// 内存中的条目（删除的文件只清除seen，条目保留到程序退出）
+typedef struct {
+    const char *path;                           // 指向目录文件映射，或单独分配（owned）
+    uint32_t hash;
+    uint8_t state;                              // media_info_state_t
+    bool seen;                                  // 当前在媒体索引中
+    bool owned;
+    bool queued;                                // 已在提取或校验队列中
+    media_info_t info;
+} catalog_entry_t;
+
+// 条目下标的环形队列
+typedef struct {
+    uint32_t *items;
+    uint32_t head;
+    uint32_t count;
+    uint32_t capacity;
+} job_queue_t;
+
+static pthread_mutex_t catalog_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t catalog_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t workers[MEDIA_CATALOG_WORKERS];
+static int worker_count = 0;
+static bool catalog_running = false;
+
+static char catalog_file[CATALOG_PATH_MAX];
+static void *catalog_map = NULL;                // 加载的目录文件（只读映射）
+static size_t catalog_map_size = 0;
+
+static catalog_entry_t *entries = NULL;
+static uint32_t entry_count = 0;
+static uint32_t entry_capacity = 0;
+static uint32_t *slots = NULL;                  // 开放寻址哈希表：条目下标+1，0为空
+static uint32_t slot_capacity = 0;              // 2的幂
+static uint32_t seen_count = 0;
+
+static job_queue_t extract_queue;               // 新文件，优先处理
+static job_queue_t verify_queue;                // 加载的条目，确认文件没有修改
+static int busy_workers = 0;
+static int idle_workers = 0;                    // 正在等待的线程数（没有等待的线程时不需要唤醒）
+static bool catalog_dirty = false;
+static bool catalog_saving = false;
+static double dirty_since_ms = 0;
+
+static _Atomic uint32_t catalog_gen = 0;
+static media_catalog_stats_t catalog_stats;
+
+static double catalog_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// FNV-1a
+static uint32_t path_hash(const char *path) {
+    uint32_t h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)path; *p; p++) {
+        h = (h ^ *p) * 16777619u;
+    }
+    return h;
+}
+
+static int queue_push(job_queue_t *q, uint32_t item) {
+    if (q->count == q->capacity) {
+        uint32_t new_cap = q->capacity ? q->capacity * 2 : 256;
+        uint32_t *items = (uint32_t *)malloc(new_cap * sizeof(uint32_t));
+        if (!items) {
+            return -1;
+        }
+        for (uint32_t i = 0; i < q->count; i++) {
+            items[i] = q->items[(q->head + i) % q->capacity];
+        }
+        free(q->items);
+        q->items = items;
+        q->head = 0;
+        q->capacity = new_cap;
+    }
+    q->items[(q->head + q->count) % q->capacity] = item;
+    q->count++;
+    return 0;
+}
+
+static bool queue_pop(job_queue_t *q, uint32_t *item) {
+    if (q->count == 0) {
+        return false;
+    }
+    *item = q->items[q->head];
+    q->head = (q->head + 1) % q->capacity;
+    q->count--;
+    return true;
+}
+
+static void queue_free(job_queue_t *q) {
+    free(q->items);
+    memset(q, 0, sizeof(*q));
+}
+
+static void mark_dirty(void) {
+    if (!catalog_dirty) {
+        catalog_dirty = true;
+        dirty_since_ms = catalog_now_ms();
+    }
+}
+
+// 按路径查找条目（持有锁时调用），找不到返回-1
+static int64_t find_entry(const char *path, uint32_t hash) {
+    if (slot_capacity == 0) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < slot_capacity; i++) {
+        uint32_t s = slots[(hash + i) & (slot_capacity - 1)];
+        if (s == 0) {
+            return -1;
+        }
+        const catalog_entry_t *e = &entries[s - 1];
+        if (e->hash == hash && strcmp(e->path, path) == 0) {
+            return s - 1;
+        }
+    }
+    return -1;
+}
+
+// 哈希表扩容（负载不超过1/2）
+static int grow_slots(void) {
+    uint32_t new_cap = slot_capacity ? slot_capacity * 2 : 1024;
+    uint32_t *new_slots = (uint32_t *)calloc(new_cap, sizeof(uint32_t));
+    if (!new_slots) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < entry_count; i++) {
+        uint32_t pos = entries[i].hash & (new_cap - 1);
+        while (new_slots[pos] != 0) {
+            pos = (pos + 1) & (new_cap - 1);
+        }
+        new_slots[pos] = i + 1;
+    }
+    free(slots);
+    slots = new_slots;
+    slot_capacity = new_cap;
+    return 0;
+}
+
+// 新增条目（持有锁时调用），path为映射中的字符串时owned为false，否则复制
+static int64_t insert_entry(const char *path, uint32_t hash, bool copy) {
+    if ((entry_count + 1) * 2 > slot_capacity && grow_slots() != 0) {
+        return -1;
+    }
+    if (entry_count == entry_capacity) {
+        uint32_t new_cap = entry_capacity ? entry_capacity * 2 : 256;
+        catalog_entry_t *new_entries = (catalog_entry_t *)realloc(entries, new_cap * sizeof(catalog_entry_t));
+        if (!new_entries) {
+            return -1;
+        }
+        entries = new_entries;
+        entry_capacity = new_cap;
+    }
+    catalog_entry_t *e = &entries[entry_count];
+    memset(e, 0, sizeof(*e));
+    e->path = copy ? strdup(path) : path;
+    if (!e->path) {
+        return -1;
+    }
+    e->owned = copy;
+    e->hash = hash;
+    uint32_t pos = hash & (slot_capacity - 1);
+    while (slots[pos] != 0) {
+        pos = (pos + 1) & (slot_capacity - 1);
+    }
+    slots[pos] = entry_count + 1;
+    return entry_count++;
+}
+
+// 检查字符串区中的偏移是否指向以0结尾的字符串
+static const char *pool_string(const char *pool, uint32_t pool_size, uint32_t off) {
+    if (off >= pool_size || memchr(pool + off, '\0', pool_size - off) == NULL) {
+        return NULL;
+    }
+    return pool + off;
+}
+
+// 加载目录文件（映射保留到关闭，条目的路径直接指向映射）
+static void load_catalog(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        printf("[媒体目录] 目录文件不存在，首次启动需要提取元数据: %s\n", path);
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(catalog_file_header_t)) {
+        close(fd);
+        return;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return;
+    }
+    const catalog_file_header_t *hdr = (const catalog_file_header_t *)map;
+    size_t body_bytes = (size_t)st.st_size - sizeof(*hdr);
+    // 先按文件大小限制条目数再相乘，避免损坏的entry_count让乘法回绕
+    if (hdr->magic != CATALOG_MAGIC || hdr->version != CATALOG_VERSION ||
+        hdr->entry_count > body_bytes / sizeof(catalog_record_t) ||
+        hdr->string_bytes != body_bytes - (size_t)hdr->entry_count * sizeof(catalog_record_t)) {
+        printf("[媒体目录] 目录文件格式不兼容，重新建立: %s\n", path);
+        munmap(map, (size_t)st.st_size);
+        return;
+    }
+    catalog_map = map;
+    catalog_map_size = (size_t)st.st_size;
+
+    size_t records_bytes = (size_t)hdr->entry_count * sizeof(catalog_record_t);
+    const catalog_record_t *records = (const catalog_record_t *)(hdr + 1);
+    const char *pool = (const char *)map + sizeof(*hdr) + records_bytes;
+    for (uint32_t i = 0; i < hdr->entry_count; i++) {
+        const catalog_record_t *r = &records[i];
+        const char *file = pool_string(pool, hdr->string_bytes, r->path_off);
+        if (!file || (r->state != MEDIA_INFO_READY && r->state != MEDIA_INFO_FAILED)) {
+            continue;
+        }
+        uint32_t hash = path_hash(file);
+        if (find_entry(file, hash) >= 0) {
+            continue;
+        }
+        int64_t idx = insert_entry(file, hash, false);
+        if (idx < 0) {
+            break;
+        }
+        catalog_entry_t *e = &entries[idx];
+        e->state = r->state;
+        e->info.size = r->size;
+        e->info.mtime = r->mtime;
+        e->info.kind = r->kind;
+        e->info.container = r->container;
+        e->info.width = r->width;
+        e->info.height = r->height;
+        e->info.frames = r->frames;
+        e->info.delay_ms = r->delay_ms;
+        e->info.duration_ms = r->duration_ms;
+        if (r->title_off != CATALOG_NO_TITLE) {
+            const char *title = pool_string(pool, hdr->string_bytes, r->title_off);
+            if (title) {
+                snprintf(e->info.title, sizeof(e->info.title), "%s", title);
+            }
+        }
+        catalog_stats.loaded++;
+    }
+}
+
+// 保存目录文件（不持有锁时调用）：在锁内生成内容，锁外写临时文件再rename
+static int save_catalog(void) {
+    pthread_mutex_lock(&catalog_mutex);
+    uint32_t count = 0;
+    size_t string_bytes = 0;
+    for (uint32_t i = 0; i < entry_count; i++) {
+        const catalog_entry_t *e = &entries[i];
+        if (e->seen && (e->state == MEDIA_INFO_READY || e->state == MEDIA_INFO_FAILED)) {
+            count++;
+            string_bytes += strlen(e->path) + 1;
+            if (e->info.title[0] != '\0') {
+                string_bytes += strlen(e->info.title) + 1;
+            }
+        }
+    }
+    size_t records_bytes = (size_t)count * sizeof(catalog_record_t);
+    size_t total = sizeof(catalog_file_header_t) + records_bytes + string_bytes;
+    uint8_t *buf = (uint8_t *)malloc(total);
+    if (!buf || string_bytes >= CATALOG_NO_TITLE) {
+        pthread_mutex_unlock(&catalog_mutex);
+        free(buf);
+        printf("[媒体目录] 内存分配失败，目录文件未保存\n");
+        return -1;
+    }
+    catalog_file_header_t *hdr = (catalog_file_header_t *)buf;
+    hdr->magic = CATALOG_MAGIC;
+    hdr->version = CATALOG_VERSION;
+    hdr->entry_count = count;
+    hdr->string_bytes = (uint32_t)string_bytes;
+    catalog_record_t *r = (catalog_record_t *)(hdr + 1);
+    char *pool = (char *)buf + sizeof(*hdr) + records_bytes;
+    uint32_t pos = 0;
+    for (uint32_t i = 0; i < entry_count; i++) {
+        const catalog_entry_t *e = &entries[i];
+        if (!e->seen || (e->state != MEDIA_INFO_READY && e->state != MEDIA_INFO_FAILED)) {
+            continue;
+        }
+        memset(r, 0, sizeof(*r));
+        r->size = e->info.size;
+        r->mtime = e->info.mtime;
+        r->kind = e->info.kind;
+        r->container = e->info.container;
+        r->state = e->state;
+        r->width = e->info.width;
+        r->height = e->info.height;
+        r->frames = e->info.frames;
+        r->delay_ms = e->info.delay_ms;
+        r->duration_ms = e->info.duration_ms;
+        size_t len = strlen(e->path) + 1;
+        memcpy(pool + pos, e->path, len);
+        r->path_off = pos;
+        pos += (uint32_t)len;
+        r->title_off = CATALOG_NO_TITLE;
+        if (e->info.title[0] != '\0') {
+            len = strlen(e->info.title) + 1;
+            memcpy(pool + pos, e->info.title, len);
+            r->title_off = pos;
+            pos += (uint32_t)len;
+        }
+        r++;
+    }
+    catalog_dirty = false;
+    catalog_stats.saves++;
+    pthread_mutex_unlock(&catalog_mutex);
+
+    char tmp_path[CATALOG_PATH_MAX + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", catalog_file);
+    int ret = -1;
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd >= 0) {
+        size_t done = 0;
+        while (done < total) {
+            ssize_t n = write(fd, buf + done, total - done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            done += (size_t)n;
+        }
+        // 先落盘再替换，断电时保留旧的目录文件
+        if (done == total && fsync(fd) == 0) {
+            ret = 0;
+        }
+        close(fd);
+        if (ret == 0 && rename(tmp_path, catalog_file) != 0) {
+            ret = -1;
+        }
+        if (ret != 0) {
+            unlink(tmp_path);
+        }
+    }
+    free(buf);
+    if (ret != 0) {
+        printf("[媒体目录] 保存目录文件失败: %s\n", catalog_file);
+        pthread_mutex_lock(&catalog_mutex);
+        mark_dirty();
+        pthread_mutex_unlock(&catalog_mutex);
+    }
+    return ret;
+}
+
+// 是否应该保存（持有锁时调用），*wait_ms输出还需要等待的时间
+static bool should_save(bool idle, double *wait_ms) {
+    *wait_ms = -1;
+    if (!catalog_dirty || catalog_saving || catalog_file[0] == '\0') {
+        return false;
+    }
+    double delay = idle ? MEDIA_CATALOG_SAVE_DELAY_MS : MEDIA_CATALOG_SAVE_MAX_MS;
+    double elapsed = catalog_now_ms() - dirty_since_ms;
+    if (elapsed >= delay) {
+        return idle ? busy_workers == 0 : true;
+    }
+    *wait_ms = delay - elapsed;
+    return false;
+}
+
+static void *catalog_worker(void *arg) {
+    (void)arg;
+    char path[CATALOG_PATH_MAX];
+    // Linux的nice值是按线程的，只降低本线程的优先级
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), MEDIA_CATALOG_NICE);
+    pthread_mutex_lock(&catalog_mutex);
+    while (catalog_running) {
+        bool idle = extract_queue.count == 0 && verify_queue.count == 0;
+        double wait_ms;
+        if (should_save(idle, &wait_ms)) {
+            catalog_saving = true;
+            pthread_mutex_unlock(&catalog_mutex);
+            save_catalog();
+            pthread_mutex_lock(&catalog_mutex);
+            catalog_saving = false;
+            continue;
+        }
+
+        uint32_t idx;
+        bool verify = false;
+        if (!queue_pop(&extract_queue, &idx)) {
+            if (!queue_pop(&verify_queue, &idx)) {
+                idle_workers++;
+                if (wait_ms >= 0) {
+                    struct timespec ts;
+                    clock_gettime(CLOCK_REALTIME, &ts);
+                    long long ns = ts.tv_nsec + (long long)(wait_ms * 1000000.0) + 1000000;
+                    ts.tv_sec += (time_t)(ns / 1000000000);
+                    ts.tv_nsec = (long)(ns % 1000000000);
+                    pthread_cond_timedwait(&catalog_cond, &catalog_mutex, &ts);
+                } else {
+                    pthread_cond_wait(&catalog_cond, &catalog_mutex);
+                }
+                idle_workers--;
+                continue;
+            }
+            verify = true;
+        }
+        catalog_entry_t *e = &entries[idx];
+        e->queued = false;
+        if (!e->seen || strlen(e->path) >= sizeof(path)) {
+            continue;       // 已从索引中删除
+        }
+        memcpy(path, e->path, strlen(e->path) + 1);
+        int64_t old_size = e->info.size;
+        int64_t old_mtime = e->info.mtime;
+        busy_workers++;
+        pthread_mutex_unlock(&catalog_mutex);
+
+        // 校验：只stat，修改时间和大小都没变时不打开文件
+        bool gone = false;
+        bool changed = true;
+        if (verify) {
+            struct stat st;
+            if (stat(path, &st) != 0) {
+                gone = true;
+            } else {
+                changed = (int64_t)st.st_size != old_size || (int64_t)st.st_mtime != old_mtime;
+            }
+        }
+        media_info_t info;
+        int ret = -1;
+        if (changed && !gone) {
+            ret = media_probe(path, &info);
+        }
+
+        pthread_mutex_lock(&catalog_mutex);
+        busy_workers--;
+        e = &entries[idx];      // 条目数组可能已重新分配
+        if (verify) {
+            catalog_stats.verified++;
+        }
+        if (gone) {
+            if (e->seen) {
+                e->seen = false;
+                seen_count--;
+                mark_dirty();
+            }
+        } else if (changed) {
+            e->info = info;
+            e->state = ret == 0 ? MEDIA_INFO_READY : MEDIA_INFO_FAILED;
+            catalog_stats.probed++;
+            if (verify) {
+                catalog_stats.changed++;
+            }
+            mark_dirty();
+            atomic_fetch_add(&catalog_gen, 1);
+        }
+    }
+    pthread_mutex_unlock(&catalog_mutex);
+    return NULL;
+}
+
+int media_catalog_open(const char *catalog_path) {
+    if (catalog_running) {
+        return 0;
+    }
+    double start_ms = catalog_now_ms();
+    memset(&catalog_stats, 0, sizeof(catalog_stats));
+    snprintf(catalog_file, sizeof(catalog_file), "%s", catalog_path ? catalog_path : "");
+    pthread_mutex_lock(&catalog_mutex);
+    if (catalog_file[0] != '\0') {
+        load_catalog(catalog_file);
+    }
+    catalog_stats.load_ms = catalog_now_ms() - start_ms;
+    catalog_running = true;
+    pthread_mutex_unlock(&catalog_mutex);
+
+    for (int i = 0; i < MEDIA_CATALOG_WORKERS; i++) {
+        if (pthread_create(&workers[worker_count], NULL, catalog_worker, NULL) != 0) {
+            printf("[媒体目录] 创建提取线程失败\n");
+            break;
+        }
+        worker_count++;
+    }
+    if (worker_count == 0) {
+        media_catalog_close();
+        return -1;
+    }
+    printf("[媒体目录] 已加载%u个文件的元数据 (%.2f ms)，%d个提取线程\n",
+           catalog_stats.loaded, catalog_stats.load_ms, worker_count);
+    return 0;
+}
+
+void media_catalog_close(void) {
+    pthread_mutex_lock(&catalog_mutex);
+    catalog_running = false;
+    pthread_cond_broadcast(&catalog_cond);
+    pthread_mutex_unlock(&catalog_mutex);
+    for (int i = 0; i < worker_count; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    worker_count = 0;
+
+    if (catalog_dirty && catalog_file[0] != '\0') {
+        save_catalog();
+    }
+
+    pthread_mutex_lock(&catalog_mutex);
+    for (uint32_t i = 0; i < entry_count; i++) {
+        if (entries[i].owned) {
+            free((void *)entries[i].path);
+        }
+    }
+    free(entries);
+    free(slots);
+    entries = NULL;
+    slots = NULL;
+    entry_count = entry_capacity = slot_capacity = seen_count = 0;
+    queue_free(&extract_queue);
+    queue_free(&verify_queue);
+    catalog_dirty = false;
+    if (catalog_map) {
+        munmap(catalog_map, catalog_map_size);
+        catalog_map = NULL;
+        catalog_map_size = 0;
+    }
+    pthread_mutex_unlock(&catalog_mutex);
+}
+
+void media_catalog_add(const char *path) {
+    if (!catalog_running || !path) {
+        return;
+    }
+    uint32_t hash = path_hash(path);
+    pthread_mutex_lock(&catalog_mutex);
+    int64_t idx = find_entry(path, hash);
+    job_queue_t *queue = &verify_queue;
+    if (idx < 0) {
+        // 新文件：等待提取
+        idx = insert_entry(path, hash, true);
+        if (idx < 0) {
+            pthread_mutex_unlock(&catalog_mutex);
+            return;
+        }
+        entries[idx].state = MEDIA_INFO_PENDING;
+        queue = &extract_queue;
+    } else if (entries[idx].state == MEDIA_INFO_PENDING) {
+        queue = &extract_queue;
+    }
+    // 已有的文件（加载的条目，或被重新写入、移回的文件）：空闲时stat确认
+    catalog_entry_t *e = &entries[idx];
+    if (!e->seen) {
+        e->seen = true;
+        seen_count++;
+    }
+    if (!e->queued && queue_push(queue, (uint32_t)idx) == 0) {
+        e->queued = true;
+        if (idle_workers > 0) {
+            pthread_cond_signal(&catalog_cond);
+        }
+    }
+    pthread_mutex_unlock(&catalog_mutex);
+}
+
+void media_catalog_remove(const char *path) {
+    if (!catalog_running || !path) {
+        return;
+    }
+    uint32_t hash = path_hash(path);
+    pthread_mutex_lock(&catalog_mutex);
+    int64_t idx = find_entry(path, hash);
+    if (idx >= 0 && entries[idx].seen) {
+        entries[idx].seen = false;
+        seen_count--;
+        mark_dirty();
+        if (idle_workers > 0) {
+            pthread_cond_signal(&catalog_cond);
+        }
+    }
+    pthread_mutex_unlock(&catalog_mutex);
+}
+
+media_info_state_t media_catalog_lookup(const char *path, media_info_t *info) {
+    if (!path) {
+        return MEDIA_INFO_MISSING;
+    }
+    uint32_t hash = path_hash(path);
+    media_info_state_t state = MEDIA_INFO_MISSING;
+    pthread_mutex_lock(&catalog_mutex);
+    int64_t idx = find_entry(path, hash);
+    if (idx >= 0) {
+        state = (media_info_state_t)entries[idx].state;
+        if (info && state == MEDIA_INFO_READY) {
+            *info = entries[idx].info;
+        }
+    }
+    pthread_mutex_unlock(&catalog_mutex);
+    return state;
+}
+
+uint32_t media_catalog_generation(void) {
+    return atomic_load(&catalog_gen);
+}
+
+void media_catalog_get_stats(media_catalog_stats_t *stats) {
+    pthread_mutex_lock(&catalog_mutex);
+    *stats = catalog_stats;
+    stats->entries = seen_count;
+    stats->pending = extract_queue.count;
+    pthread_mutex_unlock(&catalog_mutex);
+}
@@ -0,0 +1,90 @@
+/**
+ * @file media_catalog.h
+ * @brief 持久化媒体目录：缓存每个媒体文件的元数据（尺寸、帧数、时长、标题）
+ *
+ * 媒体索引（file_scanner）只知道路径和扩展名。目录在此基础上记录media_probe提取的元数据：
+ *   - 保存在一个紧凑的目录文件中（文件头 + 定长记录 + 字符串区），启动时mmap映射，
+ *     记录中的路径直接指向映射，不需要打开任何媒体文件就能显示列表和元数据
+ *   - 新文件由后台线程池（MEDIA_CATALOG_WORKERS个线程）提取元数据；
+ *     从目录文件加载的条目在空闲时逐个stat，修改时间或大小变化的重新提取
+ *   - 队列处理完且有变化时保存（先写临时文件再rename），退出时再保存一次
+ *   - 只保存当前在索引中的文件，删除的文件下次保存时从目录文件中消失
+ * 所有函数都可以在任意线程调用。
+ */
+
+#ifndef MEDIA_CATALOG_H
+#define MEDIA_CATALOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "media_probe.h"
+
+// 元数据状态
+typedef enum {
+    MEDIA_INFO_MISSING = 0,         // 不在目录中
+    MEDIA_INFO_PENDING,             // 等待提取
+    MEDIA_INFO_READY,               // 可以使用
+    MEDIA_INFO_FAILED,              // 无法识别（不再重试，直到文件被修改）
+} media_info_state_t;
+
+// 统计信息
+typedef struct {
+    uint32_t entries;               // 目录中的文件数（当前在索引中）
+    uint32_t loaded;                // 从目录文件加载的条目数
+    uint32_t pending;               // 等待提取的文件数
+    uint32_t probed;                // 本次运行提取的文件数
+    uint32_t verified;              // 本次运行校验（stat）过的已加载条目数
+    uint32_t changed;               // 校验时发现已修改、重新提取的文件数
+    uint32_t saves;                 // 保存目录文件的次数
+    double load_ms;                 // 加载目录文件的耗时
+} media_catalog_stats_t;
+
+/**
+ * @brief 加载目录文件（不存在或格式不兼容时为空目录）并启动提取线程（重复调用直接返回）
+ *
+ * 需要在media_index_build之前调用，索引中的文件才能直接使用加载的元数据。
+ * @param catalog_path 目录文件路径
+ * @return 成功返回0，失败返回-1
+ */
+int media_catalog_open(const char *catalog_path);
+
+/**
+ * @brief 停止提取线程，保存并关闭目录文件
+ */
+void media_catalog_close(void);
+
+/**
+ * @brief 把一个文件加入目录（由媒体索引在文件加入列表时调用）
+ *
+ * 已有元数据的文件不读取文件；新文件加入提取队列。
+ * @param path 文件路径
+ */
+void media_catalog_add(const char *path);
+
+/**
+ * @brief 从目录中删除一个文件（由媒体索引在文件删除时调用）
+ * @param path 文件路径
+ */
+void media_catalog_remove(const char *path);
+
+/**
+ * @brief 查询文件的元数据（只查内存中的目录，不访问文件）
+ * @param path 文件路径
+ * @param info 输出的元数据（状态为MEDIA_INFO_READY时有效，可为NULL）
+ * @return 元数据状态
+ */
+media_info_state_t media_catalog_lookup(const char *path, media_info_t *info);
+
+/**
+ * @brief 元数据变化计数，每提取完一个文件加1（调用者据此判断是否需要刷新显示）
+ * @return 计数
+ */
+uint32_t media_catalog_generation(void);
+
+/**
+ * @brief 获取统计信息
+ * @param stats 输出的统计信息
+ */
+void media_catalog_get_stats(media_catalog_stats_t *stats);
+
+#endif /* MEDIA_CATALOG_H */
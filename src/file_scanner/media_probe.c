@@ -0,0 +1,999 @@
+/**
+ * @file media_probe.c
+ * @brief 媒体文件元数据提取实现
+ */
+
+#include "media_probe.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#define PROBE_WINDOW 65536                  // 读取窗口大小
+#define PROBE_MAX_STEPS 100000              // 遍历块结构的步数上限（防止损坏的文件死循环）
+
+// 带窗口的随机读取
+typedef struct {
+    int fd;
+    int64_t size;
+    uint8_t *buf;
+    int64_t win_off;
+    size_t win_len;
+} probe_reader_t;
+
+// 返回文件[off, off+n)的内容（n不超过PROBE_WINDOW），超出文件或读取失败返回NULL
+static const uint8_t *probe_at(probe_reader_t *r, int64_t off, size_t n) {
+    if (off < 0 || n > PROBE_WINDOW || off + (int64_t)n > r->size) {
+        return NULL;
+    }
+    if (off < r->win_off || off + (int64_t)n > r->win_off + (int64_t)r->win_len) {
+        ssize_t got = pread(r->fd, r->buf, PROBE_WINDOW, (off_t)off);
+        if (got < (ssize_t)n) {
+            return NULL;
+        }
+        r->win_off = off;
+        r->win_len = (size_t)got;
+    }
+    return r->buf + (off - r->win_off);
+}
+
+static uint32_t rd16le(const uint8_t *p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8); }
+static uint32_t rd32le(const uint8_t *p) { return rd16le(p) | (rd16le(p + 2) << 16); }
+static uint64_t rd64le(const uint8_t *p) { return rd32le(p) | ((uint64_t)rd32le(p + 4) << 32); }
+static uint32_t rd16be(const uint8_t *p) { return ((uint32_t)p[0] << 8) | p[1]; }
+static uint32_t rd32be(const uint8_t *p) { return (rd16be(p) << 16) | rd16be(p + 2); }
+static uint64_t rd64be(const uint8_t *p) { return ((uint64_t)rd32be(p) << 32) | rd32be(p + 4); }
+
+static double be_double(const uint8_t *p) {
+    uint64_t bits = rd64be(p);
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+// 在[p, p+n)中查找字节序列（memmem是GNU扩展，这里自己实现）
+static const uint8_t *find_bytes(const uint8_t *p, size_t n, const char *needle, size_t len) {
+    for (size_t i = 0; i + len <= n; i++) {
+        if (p[i] == (uint8_t)needle[0] && memcmp(p + i, needle, len) == 0) {
+            return p + i;
+        }
+    }
+    return NULL;
+}
+
+static uint16_t clamp16(uint64_t v) {
+    return v > 65535 ? 65535 : (uint16_t)v;
+}
+
+static uint32_t clamp_ms(double ms) {
+    if (!(ms > 0)) {
+        return 0;
+    }
+    return ms > 4294967295.0 ? UINT32_MAX : (uint32_t)ms;
+}
+
+/* ---------------- 图片 ---------------- */
+
+static int probe_bmp(probe_reader_t *r, media_info_t *info) {
+    const uint8_t *p = probe_at(r, 0, 26);
+    if (!p) {
+        return -1;
+    }
+    int32_t w = (int32_t)rd32le(p + 18);
+    int32_t h = (int32_t)rd32le(p + 22);
+    info->width = clamp16((uint64_t)(w < 0 ? -(int64_t)w : w));
+    info->height = clamp16((uint64_t)(h < 0 ? -(int64_t)h : h));
+    return 0;
+}
+
+static int probe_png(probe_reader_t *r, media_info_t *info) {
+    const uint8_t *p = probe_at(r, 0, 24);
+    if (!p || memcmp(p + 12, "IHDR", 4) != 0) {
+        return -1;
+    }
+    info->width = clamp16(rd32be(p + 16));
+    info->height = clamp16(rd32be(p + 20));
+    return 0;
+}
+
+static int probe_jpeg(probe_reader_t *r, media_info_t *info) {
+    int64_t off = 2;
+    for (int step = 0; step < PROBE_MAX_STEPS; step++) {
+        const uint8_t *p = probe_at(r, off, 4);
+        if (!p || p[0] != 0xFF) {
+            return -1;
+        }
+        uint8_t marker = p[1];
+        if (marker == 0xFF) {           // 填充字节
+            off++;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+            off += 2;                   // 没有长度的标记
+            continue;
+        }
+        if (marker == 0xDA || marker == 0xD9) {
+            return -1;                  // 到了扫描数据还没有SOF
+        }
+        // SOF0~SOF15（C4、C8、CC不是SOF）
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            const uint8_t *sof = probe_at(r, off + 5, 4);
+            if (!sof) {
+                return -1;
+            }
+            info->height = (uint16_t)rd16be(sof);
+            info->width = (uint16_t)rd16be(sof + 2);
+            return 0;
+        }
+        off += 2 + rd16be(p + 2);
+    }
+    return -1;
+}
+
+// 跳过GIF数据子块，返回之后的位置，失败返回-1
+static int64_t gif_skip_sub_blocks(probe_reader_t *r, int64_t off) {
+    for (int step = 0; step < PROBE_MAX_STEPS; step++) {
+        const uint8_t *p = probe_at(r, off, 1);
+        if (!p) {
+            return -1;
+        }
+        off += 1 + p[0];
+        if (p[0] == 0) {
+            return off;
+        }
+    }
+    return -1;
+}
+
+static int probe_gif(probe_reader_t *r, media_info_t *info) {
+    const uint8_t *p = probe_at(r, 0, 13);
+    if (!p) {
+        return -1;
+    }
+    info->width = (uint16_t)rd16le(p + 6);
+    info->height = (uint16_t)rd16le(p + 8);
+    int64_t off = 13;
+    if (p[10] & 0x80) {
+        off += 3 * (1 << ((p[10] & 7) + 1));
+    }
+
+    // 只遍历块结构：图像块的LZW数据按子块长度跳过，不解码
+    uint32_t frames = 0;
+    uint32_t delay_cs = 0;
+    uint64_t total_cs = 0;
+    while (off >= 0 && frames < PROBE_MAX_STEPS) {
+        p = probe_at(r, off, 1);
+        if (!p || p[0] == ';') {
+            break;
+        }
+        if (p[0] == '!') {
+            p = probe_at(r, off, 2);
+            if (!p) {
+                break;
+            }
+            uint8_t label = p[1];
+            off += 2;
+            if (label == 0xF9 && (p = probe_at(r, off, 5)) != NULL && p[0] >= 4) {
+                delay_cs = rd16le(p + 2);   // 和gifdec一样，延时一直沿用到下一个图形控制扩展
+            }
+            off = gif_skip_sub_blocks(r, off);
+        } else if (p[0] == ',') {
+            p = probe_at(r, off, 10);
+            if (!p) {
+                break;
+            }
+            off += 10;
+            if (p[9] & 0x80) {
+                off += 3 * (1 << ((p[9] & 7) + 1));
+            }
+            off = gif_skip_sub_blocks(r, off + 1);  // 跳过LZW最小码长和数据子块
+            frames++;
+            total_cs += delay_cs;
+        } else {
+            break;
+        }
+    }
+    info->frames = frames;
+    info->duration_ms = clamp_ms((double)total_cs * 10);
+    info->delay_ms = frames ? (uint32_t)(total_cs * 10 / frames) : 0;
+    return 0;
+}
+
+/* ---------------- 音频 ---------------- */
+
+// 追加一个Unicode字符（UTF-8编码），空间不足返回false
+static bool utf8_put(char *out, size_t size, size_t *len, uint32_t c) {
+    char tmp[4];
+    size_t n;
+    if (c < 0x80) {
+        tmp[0] = (char)c;
+        n = 1;
+    } else if (c < 0x800) {
+        tmp[0] = (char)(0xC0 | (c >> 6));
+        tmp[1] = (char)(0x80 | (c & 0x3F));
+        n = 2;
+    } else if (c < 0x10000) {
+        tmp[0] = (char)(0xE0 | (c >> 12));
+        tmp[1] = (char)(0x80 | ((c >> 6) & 0x3F));
+        tmp[2] = (char)(0x80 | (c & 0x3F));
+        n = 3;
+    } else {
+        tmp[0] = (char)(0xF0 | (c >> 18));
+        tmp[1] = (char)(0x80 | ((c >> 12) & 0x3F));
+        tmp[2] = (char)(0x80 | ((c >> 6) & 0x3F));
+        tmp[3] = (char)(0x80 | (c & 0x3F));
+        n = 4;
+    }
+    if (*len + n >= size) {
+        return false;
+    }
+    memcpy(out + *len, tmp, n);
+    *len += n;
+    out[*len] = '\0';
+    return true;
+}
+
+// 检查是否为合法的UTF-8
+static bool utf8_valid(const uint8_t *s, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+        uint8_t c = s[i];
+        size_t extra = c < 0x80 ? 0 : (c & 0xE0) == 0xC0 ? 1 : (c & 0xF0) == 0xE0 ? 2 : (c & 0xF8) == 0xF0 ? 3 : 9;
+        if (extra == 9 || i + extra >= n + (extra ? 0 : 1)) {
+            return false;
+        }
+        for (size_t k = 1; k <= extra; k++) {
+            if ((s[i + k] & 0xC0) != 0x80) {
+                return false;
+            }
+        }
+        i += extra + 1;
+    }
+    return true;
+}
+
+// 把ID3文本帧转换成UTF-8
+// 编码0按规范是ISO-8859-1，但很多中文MP3实际写的是GBK；不是合法UTF-8的非ASCII文本直接放弃（显示文件名）
+static void id3_text(const uint8_t *d, size_t n, char *out, size_t size) {
+    size_t len = 0;
+    out[0] = '\0';
+    if (n < 2) {
+        return;
+    }
+    uint8_t enc = d[0];
+    d++;
+    n--;
+    if (enc == 0 || enc == 3) {
+        size_t end = 0;
+        bool ascii = true;
+        while (end < n && d[end] != 0) {
+            ascii = ascii && d[end] < 0x80;
+            end++;
+        }
+        if (!ascii && !utf8_valid(d, end)) {
+            return;
+        }
+        // 在UTF-8字符边界截断
+        size_t copy = end < size - 1 ? end : size - 1;
+        while (copy > 0 && copy < end && (d[copy] & 0xC0) == 0x80) {
+            copy--;
+        }
+        memcpy(out, d, copy);
+        out[copy] = '\0';
+        return;
+    }
+
+    // UTF-16（编码1带BOM，编码2为大端）
+    bool big_endian = enc == 2;
+    if (enc == 1 && n >= 2) {
+        big_endian = d[0] == 0xFE && d[1] == 0xFF;
+        if ((d[0] == 0xFF && d[1] == 0xFE) || big_endian) {
+            d += 2;
+            n -= 2;
+        }
+    }
+    for (size_t i = 0; i + 1 < n; i += 2) {
+        uint32_t c = big_endian ? rd16be(d + i) : rd16le(d + i);
+        if (c == 0) {
+            break;
+        }
+        if (c >= 0xD800 && c < 0xDC00 && i + 3 < n) {
+            uint32_t lo = big_endian ? rd16be(d + i + 2) : rd16le(d + i + 2);
+            if (lo >= 0xDC00 && lo < 0xE000) {
+                c = 0x10000 + ((c - 0xD800) << 10) + (lo - 0xDC00);
+                i += 2;
+            }
+        }
+        if (!utf8_put(out, size, &len, c)) {
+            break;
+        }
+    }
+}
+
+static uint32_t synchsafe32(const uint8_t *p) {
+    return ((uint32_t)(p[0] & 0x7F) << 21) | ((uint32_t)(p[1] & 0x7F) << 14) |
+           ((uint32_t)(p[2] & 0x7F) << 7) | (p[3] & 0x7F);
+}
+
+// 读取ID3v2标签中的标题（TIT2/TT2）
+static void id3_title(probe_reader_t *r, const uint8_t *hdr, char *out, size_t size) {
+    int ver = hdr[3];
+    int flags = hdr[5];
+    int64_t end = 10 + (int64_t)synchsafe32(hdr + 6);
+    int64_t off = 10;
+    int frame_hdr = ver == 2 ? 6 : 10;
+
+    if ((flags & 0x40) && ver >= 3) {       // 扩展头
+        const uint8_t *p = probe_at(r, off, 4);
+        if (!p) {
+            return;
+        }
+        off += ver == 3 ? 4 + (int64_t)rd32be(p) : (int64_t)synchsafe32(p);
+    }
+    for (int step = 0; step < 1000 && off + frame_hdr <= end; step++) {
+        const uint8_t *p = probe_at(r, off, (size_t)frame_hdr);
+        if (!p || p[0] == 0) {
+            return;                         // 填充区
+        }
+        uint32_t frame_size;
+        bool is_title;
+        if (ver == 2) {
+            frame_size = ((uint32_t)p[3] << 16) | rd16be(p + 4);
+            is_title = memcmp(p, "TT2", 3) == 0;
+        } else {
+            frame_size = ver == 4 ? synchsafe32(p + 4) : rd32be(p + 4);
+            is_title = memcmp(p, "TIT2", 4) == 0;
+        }
+        if (is_title) {
+            size_t n = frame_size < 512 ? frame_size : 512;
+            const uint8_t *d = probe_at(r, off + frame_hdr, n);
+            if (d) {
+                id3_text(d, n, out, size);
+            }
+            return;
+        }
+        off += frame_hdr + (int64_t)frame_size;
+    }
+}
+
+// MPEG音频帧头
+typedef struct {
+    int version;                    // 0为MPEG1，1为MPEG2，2为MPEG2.5
+    int layer;                      // 1~3
+    int bitrate;                    // kbps
+    int sample_rate;
+    int samples;                    // 每帧采样数
+    int frame_len;                  // 帧长度（字节）
+    bool mono;
+} mpeg_header_t;
+
+static bool mpeg_parse_header(const uint8_t *p, mpeg_header_t *h) {
+    static const uint16_t bitrates[5][15] = {
+        { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },  // MPEG1 Layer I
+        { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },     // MPEG1 Layer II
+        { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 },      // MPEG1 Layer III
+        { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },     // MPEG2/2.5 Layer I
+        { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },          // MPEG2/2.5 Layer II/III
+    };
+    static const uint16_t rates[3][3] = {
+        { 44100, 48000, 32000 }, { 22050, 24000, 16000 }, { 11025, 12000, 8000 },
+    };
+    if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) {
+        return false;
+    }
+    int ver_bits = (p[1] >> 3) & 3;
+    int layer_bits = (p[1] >> 1) & 3;
+    int br_index = p[2] >> 4;
+    int sr_index = (p[2] >> 2) & 3;
+    if (ver_bits == 1 || layer_bits == 0 || br_index == 0 || br_index == 15 || sr_index == 3) {
+        return false;
+    }
+    h->version = ver_bits == 3 ? 0 : ver_bits == 2 ? 1 : 2;
+    h->layer = 4 - layer_bits;
+    int table = h->version == 0 ? h->layer - 1 : (h->layer == 1 ? 3 : 4);
+    h->bitrate = bitrates[table][br_index];
+    h->sample_rate = rates[h->version][sr_index];
+    int padding = (p[2] >> 1) & 1;
+    h->mono = (p[3] >> 6) == 3;
+    if (h->layer == 1) {
+        h->samples = 384;
+        h->frame_len = (12 * h->bitrate * 1000 / h->sample_rate + padding) * 4;
+    } else {
+        h->samples = (h->layer == 3 && h->version != 0) ? 576 : 1152;
+        h->frame_len = h->samples / 8 * h->bitrate * 1000 / h->sample_rate + padding;
+    }
+    return h->frame_len > 4;
+}
+
+static int probe_mp3(probe_reader_t *r, media_info_t *info) {
+    int64_t start = 0;
+    const uint8_t *p = probe_at(r, 0, 10);
+    if (p && memcmp(p, "ID3", 3) == 0) {
+        id3_title(r, p, info->title, sizeof(info->title));
+        p = probe_at(r, 0, 10);
+        if (!p) {
+            return -1;
+        }
+        start = 10 + (int64_t)synchsafe32(p + 6) + ((p[5] & 0x10) ? 10 : 0);
+    }
+
+    // 找到第一个帧头（后面紧跟着另一个帧头，避免把数据误认为同步字）
+    mpeg_header_t h;
+    int64_t frame = -1;
+    for (int64_t off = start; off < start + PROBE_WINDOW; off++) {
+        p = probe_at(r, off, 4);
+        if (!p) {
+            break;
+        }
+        if (!mpeg_parse_header(p, &h)) {
+            continue;
+        }
+        mpeg_header_t next;
+        const uint8_t *q = probe_at(r, off + h.frame_len, 4);
+        if (q == NULL || mpeg_parse_header(q, &next)) {
+            frame = off;
+            break;
+        }
+    }
+    if (frame < 0) {
+        return -1;
+    }
+    info->container = MEDIA_CONTAINER_MP3;
+
+    // VBR文件的第一帧是Xing/Info或VBRI头，里面有总帧数
+    int side = h.version == 0 ? (h.mono ? 17 : 32) : (h.mono ? 9 : 17);
+    uint32_t frames = 0;
+    p = probe_at(r, frame + 4 + side, 12);
+    if (p && (memcmp(p, "Xing", 4) == 0 || memcmp(p, "Info", 4) == 0) && (rd32be(p + 4) & 1)) {
+        frames = rd32be(p + 8);
+    } else if ((p = probe_at(r, frame + 36, 18)) != NULL && memcmp(p, "VBRI", 4) == 0) {
+        frames = rd32be(p + 14);
+    }
+    if (frames > 0) {
+        info->duration_ms = clamp_ms((double)frames * h.samples * 1000 / h.sample_rate);
+    } else {
+        // 固定码率：按音频数据大小估算（去掉末尾的ID3v1标签）
+        int64_t bytes = r->size - frame;
+        p = probe_at(r, r->size - 128, 3);
+        if (p && memcmp(p, "TAG", 3) == 0) {
+            bytes -= 128;
+        }
+        info->duration_ms = clamp_ms((double)bytes * 8 / h.bitrate);
+    }
+    return 0;
+}
+
+static int probe_wav(probe_reader_t *r, media_info_t *info) {
+    uint32_t byte_rate = 0;
+    int64_t off = 12;
+    for (int step = 0; step < 64; step++) {
+        const uint8_t *p = probe_at(r, off, 8);
+        if (!p) {
+            break;
+        }
+        uint32_t chunk = rd32le(p + 4);
+        if (memcmp(p, "fmt ", 4) == 0) {
+            const uint8_t *f = probe_at(r, off + 8, 12);
+            if (f) {
+                byte_rate = rd32le(f + 8);
+            }
+        } else if (memcmp(p, "data", 4) == 0) {
+            int64_t bytes = chunk;
+            if (bytes > r->size - off - 8 || bytes == 0) {
+                bytes = r->size - off - 8;      // 录音中断的文件长度字段可能不对
+            }
+            if (byte_rate > 0) {
+                info->duration_ms = clamp_ms((double)bytes * 1000 / byte_rate);
+            }
+            break;
+        }
+        off += 8 + (int64_t)chunk + (chunk & 1);
+    }
+    return 0;
+}
+
+static int probe_flac(probe_reader_t *r, media_info_t *info) {
+    const uint8_t *p = probe_at(r, 0, 26);
+    if (!p || (p[4] & 0x7F) != 0) {             // 第一个元数据块必须是STREAMINFO
+        return 0;
+    }
+    const uint8_t *d = p + 8;
+    uint32_t rate = ((uint32_t)d[10] << 12) | ((uint32_t)d[11] << 4) | (d[12] >> 4);
+    uint64_t samples = ((uint64_t)(d[13] & 0x0F) << 32) | rd32be(d + 14);
+    if (rate > 0) {
+        info->duration_ms = clamp_ms((double)samples * 1000 / rate);
+    }
+    return 0;
+}
+
+static int probe_ogg(probe_reader_t *r, media_info_t *info) {
+    const uint8_t *p = probe_at(r, 0, 27);
+    if (!p) {
+        return 0;
+    }
+    int64_t packet = 27 + p[26];
+    uint32_t rate = 0;
+    uint64_t pre_skip = 0;
+    if ((p = probe_at(r, packet, 16)) != NULL) {
+        if (memcmp(p, "\x01vorbis", 7) == 0) {
+            rate = rd32le(p + 12);
+        } else if (memcmp(p, "OpusHead", 8) == 0) {
+            rate = 48000;
+            pre_skip = rd16le(p + 10);
+        }
+    }
+    if (rate == 0) {
+        return 0;
+    }
+    // 最后一页的granule position就是总采样数
+    size_t tail = r->size < PROBE_WINDOW ? (size_t)r->size : PROBE_WINDOW;
+    p = probe_at(r, r->size - (int64_t)tail, tail);
+    if (!p) {
+        return 0;
+    }
+    for (size_t i = tail >= 14 ? tail - 14 : 0; i > 0; i--) {
+        if (memcmp(p + i, "OggS", 4) == 0) {
+            uint64_t granule = rd64le(p + i + 6);
+            if (granule > pre_skip && granule != UINT64_MAX) {
+                info->duration_ms = clamp_ms((double)(granule - pre_skip) * 1000 / rate);
+            }
+            break;
+        }
+    }
+    return 0;
+}
+
+static int probe_aac(probe_reader_t *r, media_info_t *info) {
+    static const uint32_t rates[13] = {
+        96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000, 12000, 11025, 8000, 7350,
+    };
+    // ADTS没有总长度：用前面最多64帧的平均帧长估算
+    int64_t off = 0;
+    uint64_t bytes = 0;
+    uint32_t frames = 0;
+    uint32_t rate = 0;
+    while (frames < 64) {
+        const uint8_t *p = probe_at(r, off, 7);
+        if (!p || p[0] != 0xFF || (p[1] & 0xF6) != 0xF0) {
+            break;
+        }
+        int sr_index = (p[2] >> 2) & 0x0F;
+        uint32_t len = ((uint32_t)(p[3] & 3) << 11) | ((uint32_t)p[4] << 3) | (p[5] >> 5);
+        if (sr_index >= 13 || len < 7) {
+            break;
+        }
+        rate = rates[sr_index];
+        bytes += len;
+        frames++;
+        off += len;
+    }
+    if (frames > 0 && rate > 0) {
+        double frame_bytes = (double)bytes / frames;
+        info->duration_ms = clamp_ms((double)r->size / frame_bytes * 1024 * 1000 / rate);
+    }
+    return 0;
+}
+
+/* ---------------- 视频 ---------------- */
+
+// 在[start, end)中查找MP4子box，返回内容起点，*box_end为box结束位置
+static int64_t mp4_find(probe_reader_t *r, int64_t start, int64_t end, const char *type, int64_t *box_end) {
+    int64_t off = start;
+    for (int step = 0; step < 4096 && off + 8 <= end; step++) {
+        const uint8_t *p = probe_at(r, off, 16 <= end - off ? 16 : 8);
+        if (!p) {
+            return -1;
+        }
+        uint64_t size = rd32be(p);
+        int64_t hdr = 8;
+        if (size == 1) {
+            if (end - off < 16) {
+                return -1;
+            }
+            size = rd64be(p + 8);
+            hdr = 16;
+        } else if (size == 0) {
+            size = (uint64_t)(end - off);
+        }
+        if (size < (uint64_t)hdr || size > (uint64_t)(end - off)) {
+            return -1;
+        }
+        if (memcmp(p + 4, type, 4) == 0) {
+            *box_end = off + (int64_t)size;
+            return off + hdr;
+        }
+        off += (int64_t)size;
+    }
+    return -1;
+}
+
+static int probe_mp4(probe_reader_t *r, media_info_t *info) {
+    const uint8_t *p = probe_at(r, 0, 12);
+    if (p && memcmp(p + 4, "ftyp", 4) == 0 && memcmp(p + 8, "qt  ", 4) == 0) {
+        info->container = MEDIA_CONTAINER_MOV;
+    }
+    // moov可能在文件末尾（没有做faststart的文件），只读取各个box头
+    int64_t moov_end;
+    int64_t moov = mp4_find(r, 0, r->size, "moov", &moov_end);
+    if (moov < 0) {
+        return 0;
+    }
+    int64_t box_end;
+    int64_t mvhd = mp4_find(r, moov, moov_end, "mvhd", &box_end);
+    if (mvhd >= 0 && (p = probe_at(r, mvhd, 32)) != NULL) {
+        uint32_t timescale;
+        uint64_t duration;
+        if (p[0] == 1) {
+            timescale = rd32be(p + 20);
+            duration = rd64be(p + 24);
+        } else {
+            timescale = rd32be(p + 12);
+            duration = rd32be(p + 16);
+        }
+        if (timescale > 0) {
+            info->duration_ms = clamp_ms((double)duration * 1000 / timescale);
+        }
+    }
+    // 第一个有画面尺寸的轨道（tkhd中的16.16定点数）
+    int64_t off = moov;
+    for (int step = 0; step < 64; step++) {
+        int64_t trak_end;
+        int64_t trak = mp4_find(r, off, moov_end, "trak", &trak_end);
+        if (trak < 0) {
+            break;
+        }
+        int64_t tkhd = mp4_find(r, trak, trak_end, "tkhd", &box_end);
+        if (tkhd >= 0 && (p = probe_at(r, tkhd, 1)) != NULL &&
+            (p = probe_at(r, tkhd + (p[0] == 1 ? 88 : 76), 8)) != NULL) {
+            uint32_t w = rd32be(p) >> 16;
+            uint32_t h = rd32be(p + 4) >> 16;
+            if (w > 0 && h > 0) {
+                info->width = clamp16(w);
+                info->height = clamp16(h);
+                break;
+            }
+        }
+        off = trak_end;
+    }
+    return 0;
+}
+
+static int probe_avi(probe_reader_t *r, media_info_t *info) {
+    const uint8_t *p = probe_at(r, 0, r->size < 8192 ? (size_t)r->size : 8192);
+    if (!p) {
+        return 0;
+    }
+    size_t n = r->size < 8192 ? (size_t)r->size : 8192;
+    const uint8_t *avih = find_bytes(p, n, "avih", 4);
+    if (!avih || (size_t)(avih - p) + 48 > n) {
+        return 0;
+    }
+    const uint8_t *d = avih + 8;
+    uint32_t us_per_frame = rd32le(d);
+    uint32_t frames = rd32le(d + 16);
+    info->width = clamp16(rd32le(d + 32));
+    info->height = clamp16(rd32le(d + 36));
+    // OpenDML（超过1GB的AVI）：avih只记录第一个RIFF块的帧数，总帧数在dmlh中
+    const uint8_t *dmlh = find_bytes(p, n, "dmlh", 4);
+    if (dmlh && (size_t)(dmlh - p) + 12 <= n) {
+        frames = rd32le(dmlh + 8);
+    }
+    info->duration_ms = clamp_ms((double)us_per_frame * frames / 1000);
+    return 0;
+}
+
+// 读取EBML元素头（ID保留长度标记位，size为-1表示未知长度）
+static bool ebml_header(probe_reader_t *r, int64_t *off, uint32_t *id, int64_t *size) {
+    const uint8_t *p = probe_at(r, *off, 12 <= r->size - *off ? 12 : (size_t)(r->size - *off));
+    if (!p || r->size - *off < 2) {
+        return false;
+    }
+    int id_len = p[0] >= 0x80 ? 1 : p[0] >= 0x40 ? 2 : p[0] >= 0x20 ? 3 : p[0] >= 0x10 ? 4 : 0;
+    if (id_len == 0 || r->size - *off < id_len + 1) {
+        return false;
+    }
+    *id = 0;
+    for (int i = 0; i < id_len; i++) {
+        *id = (*id << 8) | p[i];
+    }
+    const uint8_t *s = p + id_len;
+    int size_len = 1;
+    while (size_len <= 8 && !(s[0] & (0x80 >> (size_len - 1)))) {
+        size_len++;
+    }
+    if (size_len > 8 || r->size - *off < id_len + size_len) {
+        return false;
+    }
+    uint64_t v = s[0] & (0xFF >> size_len);
+    bool unknown = v == (uint64_t)(0xFF >> size_len);
+    for (int i = 1; i < size_len; i++) {
+        v = (v << 8) | s[i];
+        unknown = unknown && s[i] == 0xFF;
+    }
+    *size = unknown ? -1 : (int64_t)v;
+    *off += id_len + size_len;
+    return true;
+}
+
+static uint64_t ebml_uint(probe_reader_t *r, int64_t off, int64_t size) {
+    const uint8_t *p = probe_at(r, off, size > 0 && size <= 8 ? (size_t)size : 0);
+    uint64_t v = 0;
+    for (int64_t i = 0; p && i < size && i < 8; i++) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+static double ebml_float(probe_reader_t *r, int64_t off, int64_t size) {
+    const uint8_t *p = probe_at(r, off, size == 4 || size == 8 ? (size_t)size : 0);
+    if (!p) {
+        return 0;
+    }
+    if (size == 4) {
+        uint32_t bits = rd32be(p);
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        return (double)f;
+    }
+    return be_double(p);
+}
+
+static int probe_mkv(probe_reader_t *r, media_info_t *info) {
+    uint32_t id;
+    int64_t size;
+    int64_t off = 0;
+    // EBML头
+    if (!ebml_header(r, &off, &id, &size) || size < 0) {
+        return 0;
+    }
+    off += size;
+    if (!ebml_header(r, &off, &id, &size) || id != 0x18538067) {    // Segment
+        return 0;
+    }
+    int64_t seg_end = size < 0 ? r->size : off + size;
+    uint64_t timescale = 1000000;           // 默认1ms
+    double duration = 0;
+    bool has_video = false;
+
+    // 遍历Segment的子元素，遇到第一个Cluster时停止（Info和Tracks都在它前面）
+    for (int step = 0; step < 1024 && off < seg_end; step++) {
+        if (!ebml_header(r, &off, &id, &size) || size < 0 || id == 0x1F43B675) {
+            break;
+        }
+        int64_t end = off + size;
+        if (id == 0x1549A966) {                                         // Info
+            while (off < end && ebml_header(r, &off, &id, &size) && size >= 0) {
+                if (id == 0x2AD7B1) {
+                    timescale = ebml_uint(r, off, size);
+                } else if (id == 0x4489) {
+                    duration = ebml_float(r, off, size);
+                }
+                off += size;
+            }
+        } else if (id == 0x1654AE6B) {                                  // Tracks
+            // 在TrackEntry/Video中找PixelWidth和PixelHeight
+            while (off < end && ebml_header(r, &off, &id, &size) && size >= 0) {
+                if (id == 0xAE || id == 0xE0) {
+                    if (id == 0xE0) {
+                        has_video = true;
+                    }
+                    continue;                                           // 进入容器元素
+                }
+                if (id == 0xB0 && info->width == 0) {
+                    info->width = clamp16(ebml_uint(r, off, size));
+                } else if (id == 0xBA && info->height == 0) {
+                    info->height = clamp16(ebml_uint(r, off, size));
+                }
+                off += size;
+            }
+        }
+        off = end;
+    }
+    info->duration_ms = clamp_ms(duration * (double)timescale / 1000000.0);
+    if (!has_video) {
+        info->kind = MEDIA_KIND_AUDIO;      // MKA/WebM音频
+    }
+    return 0;
+}
+
+static int probe_flv(probe_reader_t *r, media_info_t *info) {
+    size_t n = r->size < 4096 ? (size_t)r->size : 4096;
+    const uint8_t *p = probe_at(r, 0, n);
+    if (!p) {
+        return 0;
+    }
+    // onMetaData中的AMF0键值：2字节长度 + 键名 + 类型0（double）+ 8字节大端浮点数
+    const uint8_t *v = find_bytes(p, n, "\x00\x08" "duration" "\x00", 11);
+    if (v && (size_t)(v - p) + 19 <= n) {
+        info->duration_ms = clamp_ms(be_double(v + 11) * 1000);
+    }
+    v = find_bytes(p, n, "\x00\x05" "width" "\x00", 8);
+    if (v && (size_t)(v - p) + 16 <= n) {
+        double w = be_double(v + 8);
+        info->width = w > 0 && w < 65536 ? (uint16_t)w : 0;
+    }
+    v = find_bytes(p, n, "\x00\x06" "height" "\x00", 9);
+    if (v && (size_t)(v - p) + 17 <= n) {
+        double h = be_double(v + 9);
+        info->height = h > 0 && h < 65536 ? (uint16_t)h : 0;
+    }
+    return 0;
+}
+
+static const uint8_t asf_header_guid[16] = {
+    0x30, 0x26, 0xB2, 0x75, 0x8E, 0x66, 0xCF, 0x11, 0xA6, 0xD9, 0x00, 0xAA, 0x00, 0x62, 0xCE, 0x6C,
+};
+static const uint8_t asf_file_props_guid[16] = {
+    0xA1, 0xDC, 0xAB, 0x8C, 0x47, 0xA9, 0xCF, 0x11, 0x8E, 0xE4, 0x00, 0xC0, 0x0C, 0x20, 0x53, 0x65,
+};
+static const uint8_t asf_stream_props_guid[16] = {
+    0x91, 0x07, 0xDC, 0xB7, 0xB7, 0xA9, 0xCF, 0x11, 0x8E, 0xE6, 0x00, 0xC0, 0x0C, 0x20, 0x53, 0x65,
+};
+static const uint8_t asf_video_media_guid[16] = {
+    0xC0, 0xEF, 0x19, 0xBC, 0x4D, 0x5B, 0xCF, 0x11, 0xA8, 0xFD, 0x00, 0x80, 0x5F, 0x5C, 0x44, 0x2B,
+};
+
+static int probe_asf(probe_reader_t *r, media_info_t *info) {
+    const uint8_t *p = probe_at(r, 0, 30);
+    if (!p) {
+        return 0;
+    }
+    uint32_t objects = rd32le(p + 24);
+    int64_t header_end = (int64_t)rd64le(p + 16);
+    int64_t off = 30;
+    bool has_video = false;
+    for (uint32_t i = 0; i < objects && i < 256 && off + 24 <= header_end; i++) {
+        p = probe_at(r, off, 24);
+        if (!p) {
+            break;
+        }
+        int64_t size = (int64_t)rd64le(p + 16);
+        if (size < 24) {
+            break;
+        }
+        if (memcmp(p, asf_file_props_guid, 16) == 0 && (p = probe_at(r, off, 88)) != NULL) {
+            uint64_t play = rd64le(p + 64);             // 100ns
+            uint64_t preroll = rd64le(p + 80);          // ms
+            double ms = (double)play / 10000 - (double)preroll;
+            info->duration_ms = clamp_ms(ms);
+        } else if (memcmp(p, asf_stream_props_guid, 16) == 0 && (p = probe_at(r, off, 86)) != NULL &&
+                   memcmp(p + 24, asf_video_media_guid, 16) == 0) {
+            has_video = true;
+            if (info->width == 0) {
+                info->width = clamp16(rd32le(p + 78));
+                info->height = clamp16(rd32le(p + 82));
+            }
+        }
+        off += size;
+    }
+    if (!has_video) {
+        info->kind = MEDIA_KIND_AUDIO;      // WMA
+    }
+    return 0;
+}
+
+/* ---------------- 入口 ---------------- */
+
+// 按文件头识别格式并提取
+static int probe_dispatch(probe_reader_t *r, media_info_t *info) {
+    const uint8_t *p = probe_at(r, 0, r->size < 16 ? (size_t)r->size : 16);
+    if (!p || r->size < 4) {
+        return -1;
+    }
+    size_t n = r->size < 16 ? (size_t)r->size : 16;
+
+    if (n >= 2 && p[0] == 'B' && p[1] == 'M') {
+        info->kind = MEDIA_KIND_IMAGE;
+        info->container = MEDIA_CONTAINER_BMP;
+        return probe_bmp(r, info);
+    }
+    if (n >= 8 && memcmp(p, "\x89PNG\r\n\x1a\n", 8) == 0) {
+        info->kind = MEDIA_KIND_IMAGE;
+        info->container = MEDIA_CONTAINER_PNG;
+        return probe_png(r, info);
+    }
+    if (p[0] == 0xFF && p[1] == 0xD8) {
+        info->kind = MEDIA_KIND_IMAGE;
+        info->container = MEDIA_CONTAINER_JPEG;
+        return probe_jpeg(r, info);
+    }
+    if (memcmp(p, "GIF8", 4) == 0) {
+        info->kind = MEDIA_KIND_IMAGE;
+        info->container = MEDIA_CONTAINER_GIF;
+        return probe_gif(r, info);
+    }
+    if (n >= 12 && memcmp(p, "RIFF", 4) == 0 && memcmp(p + 8, "WAVE", 4) == 0) {
+        info->kind = MEDIA_KIND_AUDIO;
+        info->container = MEDIA_CONTAINER_WAV;
+        return probe_wav(r, info);
+    }
+    if (n >= 12 && memcmp(p, "RIFF", 4) == 0 && memcmp(p + 8, "AVI ", 4) == 0) {
+        info->kind = MEDIA_KIND_VIDEO;
+        info->container = MEDIA_CONTAINER_AVI;
+        return probe_avi(r, info);
+    }
+    if (memcmp(p, "fLaC", 4) == 0) {
+        info->kind = MEDIA_KIND_AUDIO;
+        info->container = MEDIA_CONTAINER_FLAC;
+        return probe_flac(r, info);
+    }
+    if (memcmp(p, "OggS", 4) == 0) {
+        info->kind = MEDIA_KIND_AUDIO;
+        info->container = MEDIA_CONTAINER_OGG;
+        return probe_ogg(r, info);
+    }
+    if (memcmp(p, "\x1a\x45\xdf\xa3", 4) == 0) {
+        info->kind = MEDIA_KIND_VIDEO;
+        info->container = MEDIA_CONTAINER_MKV;
+        return probe_mkv(r, info);
+    }
+    if (memcmp(p, "FLV", 3) == 0) {
+        info->kind = MEDIA_KIND_VIDEO;
+        info->container = MEDIA_CONTAINER_FLV;
+        return probe_flv(r, info);
+    }
+    if (n >= 16 && memcmp(p, asf_header_guid, 16) == 0) {
+        info->kind = MEDIA_KIND_VIDEO;
+        info->container = MEDIA_CONTAINER_ASF;
+        return probe_asf(r, info);
+    }
+    if (n >= 8 && (memcmp(p + 4, "ftyp", 4) == 0 || memcmp(p + 4, "moov", 4) == 0 ||
+                   memcmp(p + 4, "mdat", 4) == 0 || memcmp(p + 4, "wide", 4) == 0 ||
+                   memcmp(p + 4, "free", 4) == 0)) {
+        info->container = MEDIA_CONTAINER_MP4;
+        int ret = probe_mp4(r, info);
+        info->kind = info->width > 0 ? MEDIA_KIND_VIDEO : MEDIA_KIND_AUDIO;   // 没有画面的是M4A
+        return ret;
+    }
+    if (p[0] == 0xFF && (p[1] & 0xF6) == 0xF0) {
+        info->kind = MEDIA_KIND_AUDIO;
+        info->container = MEDIA_CONTAINER_AAC;
+        return probe_aac(r, info);
+    }
+    // MP3：ID3标签或MPEG帧同步字（前面可能有垃圾数据，probe_mp3会向后查找）
+    info->kind = MEDIA_KIND_AUDIO;
+    if (probe_mp3(r, info) == 0) {
+        return 0;
+    }
+    info->kind = MEDIA_KIND_UNKNOWN;
+    return -1;
+}
+
+int media_probe(const char *path, media_info_t *info) {
+    memset(info, 0, sizeof(*info));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    info->size = (int64_t)st.st_size;
+    info->mtime = (int64_t)st.st_mtime;
+
+    probe_reader_t reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.fd = fd;
+    reader.size = (int64_t)st.st_size;
+    reader.buf = (uint8_t *)malloc(PROBE_WINDOW);
+    int ret = -1;
+    if (reader.buf) {
+        ret = probe_dispatch(&reader, info);
+        free(reader.buf);
+    }
+    close(fd);
+    return ret;
+}
+
+const char *media_container_name(uint8_t container) {
+    static const char *const names[] = {
+        "?", "BMP", "PNG", "JPEG", "GIF", "MP3", "WAV", "FLAC", "OGG", "AAC",
+        "MP4", "MOV", "AVI", "MKV", "FLV", "WMV",
+    };
+    return container < sizeof(names) / sizeof(names[0]) ? names[container] : "?";
+}
@@ -0,0 +1,78 @@
+/**
+ * @file media_probe.h
+ * @brief 媒体文件元数据提取：只读取文件头和少量索引结构，不解码图像和音视频数据
+ *
+ * 按文件内容（不是扩展名）识别格式：
+ *   - 图片：BMP、PNG、JPEG的宽高；GIF的宽高、帧数和平均帧间隔（跳过LZW数据块）
+ *   - 音频：MP3的ID3v2标题和时长（Xing/Info/VBRI帧数，否则按码率估算），
+ *          WAV、FLAC、Ogg的时长，AAC（ADTS）按前64帧的平均帧长估算时长
+ *   - 视频：MP4/MOV（mvhd、tkhd）、AVI（avih）、MKV/WebM（Info、Tracks）、FLV（onMetaData）、
+ *          WMV/ASF（File Properties）的容器类型、时长和可以取到的画面尺寸
+ * 每个文件最多读几次64KB以内的窗口，可以在任意线程中调用。
+ */
+
+#ifndef MEDIA_PROBE_H
+#define MEDIA_PROBE_H
+
+#include <stdint.h>
+
+#define MEDIA_TITLE_MAX 64                  // 标题长度上限（UTF-8，含结尾0）
+
+// 媒体种类
+typedef enum {
+    MEDIA_KIND_UNKNOWN = 0,
+    MEDIA_KIND_IMAGE,
+    MEDIA_KIND_AUDIO,
+    MEDIA_KIND_VIDEO,
+} media_kind_t;
+
+// 文件格式（容器）
+typedef enum {
+    MEDIA_CONTAINER_UNKNOWN = 0,
+    MEDIA_CONTAINER_BMP,
+    MEDIA_CONTAINER_PNG,
+    MEDIA_CONTAINER_JPEG,
+    MEDIA_CONTAINER_GIF,
+    MEDIA_CONTAINER_MP3,
+    MEDIA_CONTAINER_WAV,
+    MEDIA_CONTAINER_FLAC,
+    MEDIA_CONTAINER_OGG,
+    MEDIA_CONTAINER_AAC,
+    MEDIA_CONTAINER_MP4,
+    MEDIA_CONTAINER_MOV,
+    MEDIA_CONTAINER_AVI,
+    MEDIA_CONTAINER_MKV,
+    MEDIA_CONTAINER_FLV,
+    MEDIA_CONTAINER_ASF,
+} media_container_t;
+
+// 一个文件的元数据（未知的字段为0）
+typedef struct {
+    int64_t size;                   // 文件大小
+    int64_t mtime;                  // 修改时间
+    uint8_t kind;                   // media_kind_t
+    uint8_t container;              // media_container_t
+    uint16_t width;                 // 图片或视频画面尺寸
+    uint16_t height;
+    uint32_t frames;                // GIF帧数
+    uint32_t delay_ms;              // GIF平均帧间隔
+    uint32_t duration_ms;           // 音视频时长（GIF为播放一轮的时长）
+    char title[MEDIA_TITLE_MAX];    // ID3标题（UTF-8），没有时为空串
+} media_info_t;
+
+/**
+ * @brief 提取文件的元数据
+ * @param path 文件路径
+ * @param info 输出的元数据（size和mtime在文件能打开时总会填写）
+ * @return 识别出格式返回0，无法打开或无法识别返回-1
+ */
+int media_probe(const char *path, media_info_t *info);
+
+/**
+ * @brief 格式名称（用于显示，如"MP4"）
+ * @param container media_container_t
+ * @return 名称，未知格式返回"?"
+ */
+const char *media_container_name(uint8_t container);
+
+#endif /* MEDIA_PROBE_H */
@@ -0,0 +1,635 @@
+/**
+ * @file media_search.c
+ * @brief 媒体列表排序和搜索实现
+ */
+
+#include "media_search.h"
+#include "file_scanner.h"
+#include "media_catalog.h"
+#include "pinyin_initials.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 一个文件的搜索键（偏移指向字符串区，字符串以0结尾）
+typedef struct {
+    uint32_t name;                  // 名称（去掉扩展名，ASCII转小写）
+    uint32_t abbr;                  // 拼音首字母串
+    uint32_t key;                   // 名称排序键（汉字前插入拼音首字母）
+    uint16_t name_len;
+    uint16_t abbr_len;
+    bool has_meta;                  // 媒体目录中有大小和修改时间
+    int64_t mtime;
+    int64_t size;
+} search_entry_t;
+
+// 一个列表的索引（文件编号就是媒体列表中的下标）
+typedef struct {
+    bool valid;
+    uint32_t index_gen;             // 建立索引时的列表版本
+    bool meta_valid;
+    uint32_t meta_gen;              // 时间、大小排序对应的媒体目录版本
+    int count;
+    search_entry_t *entries;
+    char *pool;
+    int *order[MEDIA_SORT_COUNT];   // 三种排序
+    int *by_name;                   // 按名称字节序（前缀查找）
+    int *by_abbr;                   // 按拼音首字母串字节序
+    uint32_t *tri_keys;             // 有序且不重复的trigram
+    uint32_t *tri_start;            // tri_keys[i]的倒排表为postings[tri_start[i]]到postings[tri_start[i+1]]
+    int tri_count;
+    int *postings;                  // 每个倒排表内文件编号递增
+    uint8_t *mark;                  // 查询时标记命中的文件
+} search_index_t;
+
+static search_index_t indexes[MEDIA_LIST_COUNT];
+static const search_index_t *sort_index = NULL;     // qsort比较函数使用
+
+static char **list_files(media_list_kind_t list, int *count) {
+    switch (list) {
+    case MEDIA_LIST_IMAGE:
+        *count = get_image_count();
+        return get_image_files();
+    case MEDIA_LIST_AUDIO:
+        *count = get_audio_count();
+        return get_audio_files();
+    case MEDIA_LIST_VIDEO:
+        *count = get_video_count();
+        return get_video_files();
+    default:
+        *count = 0;
+        return NULL;
+    }
+}
+
+// 读取一个UTF-8字符，非法字节按单字节返回
+static uint32_t utf8_next(const unsigned char **s, const unsigned char *end) {
+    const unsigned char *p = *s;
+    uint32_t c = p[0];
+    int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+    if (extra == 0 || end - p <= extra) {
+        *s = p + 1;
+        return c;
+    }
+    uint32_t cp = c & (0x3F >> extra);
+    for (int i = 1; i <= extra; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            *s = p + 1;
+            return c;
+        }
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+    *s = p + extra + 1;
+    return cp;
+}
+
+// ASCII字母转小写，其余字节不变
+static void fold_text(const char *src, char *dst, size_t size) {
+    size_t n = 0;
+    for (; src && *src && n + 1 < size; src++) {
+        char ch = *src;
+        dst[n++] = (ch >= 'A' && ch <= 'Z') ? (char)(ch - 'A' + 'a') : ch;
+    }
+    dst[n] = '\0';
+}
+
+static bool contains(const char *hay, size_t hay_len, const char *needle, size_t len) {
+    for (size_t i = 0; i + len <= hay_len; i++) {
+        if (hay[i] == needle[0] && memcmp(hay + i, needle, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 名称或拼音首字母串是否匹配（substring为false时为前缀匹配）
+static bool entry_matches(const search_index_t *ix, int id, const char *text, size_t len, bool substring) {
+    const search_entry_t *e = &ix->entries[id];
+    const char *name = ix->pool + e->name;
+    const char *abbr = ix->pool + e->abbr;
+    if (substring) {
+        return contains(name, e->name_len, text, len) || contains(abbr, e->abbr_len, text, len);
+    }
+    return (e->name_len >= len && memcmp(name, text, len) == 0) ||
+           (e->abbr_len >= len && memcmp(abbr, text, len) == 0);
+}
+
+/* ---------------- 建立索引 ---------------- */
+
+static int cmp_key(const void *a, const void *b) {
+    int ia = *(const int *)a;
+    int ib = *(const int *)b;
+    int r = strcmp(sort_index->pool + sort_index->entries[ia].key, sort_index->pool + sort_index->entries[ib].key);
+    return r ? r : ia - ib;
+}
+
+static int cmp_name(const void *a, const void *b) {
+    int ia = *(const int *)a;
+    int ib = *(const int *)b;
+    int r = strcmp(sort_index->pool + sort_index->entries[ia].name, sort_index->pool + sort_index->entries[ib].name);
+    return r ? r : ia - ib;
+}
+
+static int cmp_abbr(const void *a, const void *b) {
+    int ia = *(const int *)a;
+    int ib = *(const int *)b;
+    int r = strcmp(sort_index->pool + sort_index->entries[ia].abbr, sort_index->pool + sort_index->entries[ib].abbr);
+    return r ? r : ia - ib;
+}
+
+// 有元数据的在前；时间新的在前；相同时按名称
+static int cmp_date(const void *a, const void *b) {
+    const search_entry_t *ea = &sort_index->entries[*(const int *)a];
+    const search_entry_t *eb = &sort_index->entries[*(const int *)b];
+    if (ea->has_meta != eb->has_meta) {
+        return ea->has_meta ? -1 : 1;
+    }
+    if (ea->mtime != eb->mtime) {
+        return ea->mtime > eb->mtime ? -1 : 1;
+    }
+    return cmp_key(a, b);
+}
+
+static int cmp_size(const void *a, const void *b) {
+    const search_entry_t *ea = &sort_index->entries[*(const int *)a];
+    const search_entry_t *eb = &sort_index->entries[*(const int *)b];
+    if (ea->has_meta != eb->has_meta) {
+        return ea->has_meta ? -1 : 1;
+    }
+    if (ea->size != eb->size) {
+        return ea->size > eb->size ? -1 : 1;
+    }
+    return cmp_key(a, b);
+}
+
+static void sort_ids(search_index_t *ix, int *ids, int (*cmp)(const void *, const void *)) {
+    for (int i = 0; i < ix->count; i++) {
+        ids[i] = i;
+    }
+    sort_index = ix;
+    qsort(ids, (size_t)ix->count, sizeof(int), cmp);
+    sort_index = NULL;
+}
+
+static void index_free(search_index_t *ix) {
+    free(ix->entries);
+    free(ix->pool);
+    for (int s = 0; s < MEDIA_SORT_COUNT; s++) {
+        free(ix->order[s]);
+    }
+    free(ix->by_name);
+    free(ix->by_abbr);
+    free(ix->tri_keys);
+    free(ix->tri_start);
+    free(ix->postings);
+    free(ix->mark);
+    memset(ix, 0, sizeof(*ix));
+}
+
+// 生成一个文件的名称、拼音首字母串和排序键，返回写入字符串区的字节数
+static size_t make_keys(const char *path, char *pool, size_t pos, search_entry_t *e) {
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    const char *ext = strrchr(base, '.');
+    size_t len = (ext && ext != base) ? (size_t)(ext - base) : strlen(base);
+    if (len > 255) {
+        len = 255;
+    }
+    size_t start = pos;
+
+    e->name = (uint32_t)pos;
+    for (size_t i = 0; i < len; i++) {
+        char ch = base[i];
+        pool[pos++] = (ch >= 'A' && ch <= 'Z') ? (char)(ch - 'A' + 'a') : ch;
+    }
+    pool[pos++] = '\0';
+    e->name_len = (uint16_t)len;
+
+    const unsigned char *name = (const unsigned char *)pool + e->name;
+    const unsigned char *end = name + len;
+
+    // 拼音首字母串：字母、数字和汉字首字母
+    e->abbr = (uint32_t)pos;
+    for (const unsigned char *p = name; p < end;) {
+        uint32_t c = utf8_next(&p, end);
+        if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+            pool[pos++] = (char)c;
+        } else if (c >= 0x80) {
+            char initial = pinyin_initial(c);
+            if (initial) {
+                pool[pos++] = initial;
+            }
+        }
+    }
+    e->abbr_len = (uint16_t)(pos - e->abbr);
+    pool[pos++] = '\0';
+
+    // 排序键：汉字前插入首字母，使"稻香"排在d开头的名称中
+    e->key = (uint32_t)pos;
+    for (const unsigned char *p = name; p < end;) {
+        const unsigned char *q = p;
+        uint32_t c = utf8_next(&p, end);
+        char initial = c >= 0x80 ? pinyin_initial(c) : 0;
+        if (initial) {
+            pool[pos++] = initial;
+        }
+        memcpy(pool + pos, q, (size_t)(p - q));
+        pos += (size_t)(p - q);
+    }
+    pool[pos++] = '\0';
+    return pos - start;
+}
+
+// trigram（3个字节）
+static uint32_t tri_of(const char *s) {
+    return ((uint32_t)(unsigned char)s[0] << 16) | ((uint32_t)(unsigned char)s[1] << 8) | (unsigned char)s[2];
+}
+
+// 按trigram做两轮12位的基数排序（稳定，文件编号保持递增）
+static int radix_sort_pairs(uint64_t *pairs, size_t n) {
+    uint64_t *tmp = (uint64_t *)malloc(n * sizeof(uint64_t));
+    uint32_t *counts = (uint32_t *)malloc(4096 * sizeof(uint32_t));
+    if (!tmp || !counts) {
+        free(tmp);
+        free(counts);
+        return -1;
+    }
+    uint64_t *src = pairs;
+    uint64_t *dst = tmp;
+    for (int shift = 32; shift <= 44; shift += 12) {
+        memset(counts, 0, 4096 * sizeof(uint32_t));
+        for (size_t i = 0; i < n; i++) {
+            counts[(src[i] >> shift) & 0xFFF]++;
+        }
+        uint32_t sum = 0;
+        for (int b = 0; b < 4096; b++) {
+            uint32_t c = counts[b];
+            counts[b] = sum;
+            sum += c;
+        }
+        for (size_t i = 0; i < n; i++) {
+            dst[counts[(src[i] >> shift) & 0xFFF]++] = src[i];
+        }
+        uint64_t *t = src;
+        src = dst;
+        dst = t;
+    }
+    // 两轮后结果回到pairs
+    free(tmp);
+    free(counts);
+    return 0;
+}
+
+static int build_trigrams(search_index_t *ix) {
+    size_t n = 0;
+    for (int i = 0; i < ix->count; i++) {
+        const search_entry_t *e = &ix->entries[i];
+        n += (e->name_len > 2 ? e->name_len - 2u : 0) + (e->abbr_len > 2 ? e->abbr_len - 2u : 0);
+    }
+    uint64_t *pairs = (uint64_t *)malloc((n ? n : 1) * sizeof(uint64_t));
+    if (!pairs) {
+        return -1;
+    }
+    size_t k = 0;
+    for (int i = 0; i < ix->count; i++) {
+        const search_entry_t *e = &ix->entries[i];
+        const char *name = ix->pool + e->name;
+        const char *abbr = ix->pool + e->abbr;
+        for (int j = 0; j + 2 < e->name_len; j++) {
+            pairs[k++] = ((uint64_t)tri_of(name + j) << 32) | (uint32_t)i;
+        }
+        for (int j = 0; j + 2 < e->abbr_len; j++) {
+            pairs[k++] = ((uint64_t)tri_of(abbr + j) << 32) | (uint32_t)i;
+        }
+    }
+    if (radix_sort_pairs(pairs, n) != 0) {
+        free(pairs);
+        return -1;
+    }
+
+    // 去掉重复的（trigram, 文件）后生成倒排表
+    int unique = 0;
+    size_t post = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i == 0 || pairs[i] != pairs[i - 1]) {
+            pairs[post++] = pairs[i];
+            if (post == 1 || (pairs[post - 1] >> 32) != (pairs[post - 2] >> 32)) {
+                unique++;
+            }
+        }
+    }
+    ix->tri_keys = (uint32_t *)malloc((size_t)(unique ? unique : 1) * sizeof(uint32_t));
+    ix->tri_start = (uint32_t *)malloc((size_t)(unique + 1) * sizeof(uint32_t));
+    ix->postings = (int *)malloc((post ? post : 1) * sizeof(int));
+    if (!ix->tri_keys || !ix->tri_start || !ix->postings) {
+        free(pairs);
+        return -1;
+    }
+    int t = -1;
+    for (size_t i = 0; i < post; i++) {
+        uint32_t tri = (uint32_t)(pairs[i] >> 32);
+        if (t < 0 || ix->tri_keys[t] != tri) {
+            t++;
+            ix->tri_keys[t] = tri;
+            ix->tri_start[t] = (uint32_t)i;
+        }
+        ix->postings[i] = (int)(uint32_t)pairs[i];
+    }
+    ix->tri_start[unique] = (uint32_t)post;
+    ix->tri_count = unique;
+    free(pairs);
+    return 0;
+}
+
+// 建立列表的索引（列表没有变化时直接返回）
+static search_index_t *index_get(media_list_kind_t list) {
+    if (list < 0 || list >= MEDIA_LIST_COUNT) {
+        return NULL;
+    }
+    search_index_t *ix = &indexes[list];
+    uint32_t gen = media_index_generation();
+    if (ix->valid && ix->index_gen == gen) {
+        return ix;
+    }
+    index_free(ix);
+
+    int count;
+    char **files = list_files(list, &count);
+    size_t pool_size = 0;
+    for (int i = 0; i < count; i++) {
+        size_t len = strlen(files[i]);
+        pool_size += (len > 255 ? 255 : len) * 4 + 3;    // 名称、首字母串、排序键（每个汉字多1字节）
+    }
+    ix->count = count;
+    ix->entries = (search_entry_t *)calloc((size_t)(count ? count : 1), sizeof(search_entry_t));
+    ix->pool = (char *)malloc(pool_size ? pool_size : 1);
+    ix->by_name = (int *)malloc((size_t)(count ? count : 1) * sizeof(int));
+    ix->by_abbr = (int *)malloc((size_t)(count ? count : 1) * sizeof(int));
+    ix->mark = (uint8_t *)calloc((size_t)(count ? count : 1), 1);
+    for (int s = 0; s < MEDIA_SORT_COUNT; s++) {
+        ix->order[s] = (int *)malloc((size_t)(count ? count : 1) * sizeof(int));
+    }
+    bool ok = ix->entries && ix->pool && ix->by_name && ix->by_abbr && ix->mark;
+    for (int s = 0; s < MEDIA_SORT_COUNT; s++) {
+        ok = ok && ix->order[s];
+    }
+    if (!ok) {
+        printf("[媒体搜索] 内存分配失败\n");
+        index_free(ix);
+        return NULL;
+    }
+
+    size_t pos = 0;
+    for (int i = 0; i < count; i++) {
+        pos += make_keys(files[i], ix->pool, pos, &ix->entries[i]);
+    }
+    sort_ids(ix, ix->order[MEDIA_SORT_NAME], cmp_key);
+    sort_ids(ix, ix->by_name, cmp_name);
+    sort_ids(ix, ix->by_abbr, cmp_abbr);
+    if (build_trigrams(ix) != 0) {
+        printf("[媒体搜索] 内存分配失败\n");
+        index_free(ix);
+        return NULL;
+    }
+    ix->valid = true;
+    ix->index_gen = gen;
+    return ix;
+}
+
+// 按时间、大小排序需要的元数据（媒体目录变化后重新排序）
+static void index_update_meta(search_index_t *ix, media_list_kind_t list) {
+    uint32_t gen = media_catalog_generation();
+    if (ix->meta_valid && ix->meta_gen == gen) {
+        return;
+    }
+    int count;
+    char **files = list_files(list, &count);
+    for (int i = 0; i < ix->count && i < count; i++) {
+        media_info_t info;
+        search_entry_t *e = &ix->entries[i];
+        e->has_meta = media_catalog_lookup(files[i], &info) == MEDIA_INFO_READY;
+        e->mtime = e->has_meta ? info.mtime : 0;
+        e->size = e->has_meta ? info.size : 0;
+    }
+    sort_ids(ix, ix->order[MEDIA_SORT_DATE], cmp_date);
+    sort_ids(ix, ix->order[MEDIA_SORT_SIZE], cmp_size);
+    ix->meta_valid = true;
+    ix->meta_gen = gen;
+}
+
+/* ---------------- 查询 ---------------- */
+
+static int query_reserve(media_query_t *q, int n) {
+    if (n <= q->capacity) {
+        return 0;
+    }
+    int *items = (int *)realloc(q->items, (size_t)n * sizeof(int));
+    if (!items) {
+        return -1;
+    }
+    q->items = items;
+    q->capacity = n;
+    return 0;
+}
+
+// 二分查找：ids（按field字节序排列）中第一个不小于text前len个字节的位置
+static int lower_bound(const search_index_t *ix, const int *ids, bool abbr, const char *text, size_t len) {
+    int lo = 0;
+    int hi = ix->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        const search_entry_t *e = &ix->entries[ids[mid]];
+        const char *s = ix->pool + (abbr ? e->abbr : e->name);
+        if (strncmp(s, text, len) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// 前缀查找（1~2个字节）：在两个有序数组中标记命中的文件
+static void mark_prefix(search_index_t *ix, const char *text, size_t len) {
+    for (int pass = 0; pass < 2; pass++) {
+        const int *ids = pass ? ix->by_abbr : ix->by_name;
+        for (int i = lower_bound(ix, ids, pass, text, len); i < ix->count; i++) {
+            const search_entry_t *e = &ix->entries[ids[i]];
+            if (strncmp(ix->pool + (pass ? e->abbr : e->name), text, len) != 0) {
+                break;
+            }
+            ix->mark[ids[i]] = 1;
+        }
+    }
+}
+
+// trigram查找（3个字节以上）：取最短的倒排表，逐个确认子串
+static void mark_substring(search_index_t *ix, const char *text, size_t len) {
+    int best = -1;
+    uint32_t best_len = UINT32_MAX;
+    for (size_t i = 0; i + 2 < len; i++) {
+        uint32_t tri = tri_of(text + i);
+        int lo = 0;
+        int hi = ix->tri_count;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (ix->tri_keys[mid] < tri) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo >= ix->tri_count || ix->tri_keys[lo] != tri) {
+            return;     // 有一个trigram不存在，没有结果
+        }
+        uint32_t n = ix->tri_start[lo + 1] - ix->tri_start[lo];
+        if (n < best_len) {
+            best = lo;
+            best_len = n;
+        }
+    }
+    if (best < 0) {
+        return;
+    }
+    for (uint32_t p = ix->tri_start[best]; p < ix->tri_start[best + 1]; p++) {
+        int id = ix->postings[p];
+        if (len == 3 || entry_matches(ix, id, text, len, true)) {
+            ix->mark[id] = 1;
+        }
+    }
+}
+
+// 完整查询：标记命中的文件，再按排序顺序收集
+static void query_run(media_query_t *q, search_index_t *ix) {
+    q->count = 0;
+    if (!ix || query_reserve(q, ix->count) != 0) {
+        return;
+    }
+    const int *order = ix->order[q->sort];
+    size_t len = strlen(q->text);
+    if (len == 0) {
+        if (ix->count > 0) {        // 空列表时items和order都可能为NULL
+            memcpy(q->items, order, (size_t)ix->count * sizeof(int));
+        }
+        q->count = ix->count;
+        return;
+    }
+    if (len < 3) {
+        mark_prefix(ix, q->text, len);
+    } else {
+        mark_substring(ix, q->text, len);
+    }
+    for (int i = 0; i < ix->count; i++) {
+        int id = order[i];
+        if (ix->mark[id]) {
+            ix->mark[id] = 0;
+            q->items[q->count++] = id;
+        }
+    }
+}
+
+// 准备索引和元数据，返回NULL表示列表为空或内存不足
+static search_index_t *query_index(media_query_t *q) {
+    search_index_t *ix = index_get(q->list);
+    if (ix && q->sort != MEDIA_SORT_NAME) {
+        index_update_meta(ix, q->list);
+    }
+    q->index_gen = ix ? ix->index_gen : media_index_generation();
+    q->meta_gen = ix ? ix->meta_gen : 0;
+    return ix;
+}
+
+void media_query_init(media_query_t *q, media_list_kind_t list, media_sort_t sort) {
+    memset(q, 0, sizeof(*q));
+    q->list = list;
+    q->sort = sort < MEDIA_SORT_COUNT ? sort : MEDIA_SORT_NAME;
+    query_run(q, query_index(q));
+}
+
+int media_query_set_text(media_query_t *q, const char *text) {
+    char folded[MEDIA_QUERY_TEXT_MAX];
+    fold_text(text, folded, sizeof(folded));
+    size_t old_len = strlen(q->text);
+    size_t len = strlen(folded);
+    bool same_list = q->index_gen == media_index_generation() &&
+                     (q->sort == MEDIA_SORT_NAME || q->meta_gen == media_catalog_generation());
+
+    // 输入追加字符且匹配方式不变（都是前缀或都是子串）时，结果只会变少：在上一次的结果中过滤
+    if (same_list && old_len > 0 && len > old_len && strncmp(folded, q->text, old_len) == 0 &&
+        (old_len < 3) == (len < 3)) {
+        search_index_t *ix = &indexes[q->list];
+        int kept = 0;
+        for (int i = 0; i < q->count; i++) {
+            if (entry_matches(ix, q->items[i], folded, len, len >= 3)) {
+                q->items[kept++] = q->items[i];
+            }
+        }
+        q->count = kept;
+        memcpy(q->text, folded, len + 1);
+        return q->count;
+    }
+
+    memcpy(q->text, folded, len + 1);
+    query_run(q, query_index(q));
+    return q->count;
+}
+
+int media_query_set_sort(media_query_t *q, media_sort_t sort) {
+    q->sort = sort < MEDIA_SORT_COUNT ? sort : MEDIA_SORT_NAME;
+    query_run(q, query_index(q));
+    return q->count;
+}
+
+int media_query_refresh(media_query_t *q) {
+    bool changed = q->index_gen != media_index_generation() ||
+                   (q->sort != MEDIA_SORT_NAME && q->meta_gen != media_catalog_generation());
+    if (changed) {
+        query_run(q, query_index(q));
+    }
+    return q->count;
+}
+
+int media_query_jump(media_query_t *q, const char *prefix) {
+    char folded[MEDIA_QUERY_TEXT_MAX];
+    fold_text(prefix, folded, sizeof(folded));
+    size_t len = strlen(folded);
+    search_index_t *ix = &indexes[q->list];
+    if (len == 0 || !ix->valid || q->index_gen != ix->index_gen) {
+        return -1;
+    }
+    // 按名称排序的完整列表：排序键有序，二分查找
+    if (q->sort == MEDIA_SORT_NAME && q->text[0] == '\0' && q->count == ix->count) {
+        int lo = 0;
+        int hi = q->count;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (strncmp(ix->pool + ix->entries[q->items[mid]].key, folded, len) < 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo < q->count && strncmp(ix->pool + ix->entries[q->items[lo]].key, folded, len) == 0) {
+            return lo;
+        }
+    }
+    for (int i = 0; i < q->count; i++) {
+        if (entry_matches(ix, q->items[i], folded, len, false)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void media_query_free(media_query_t *q) {
+    free(q->items);
+    q->items = NULL;
+    q->count = 0;
+    q->capacity = 0;
+}
+
+void media_search_free(void) {
+    for (int i = 0; i < MEDIA_LIST_COUNT; i++) {
+        index_free(&indexes[i]);
+    }
+}
@@ -0,0 +1,106 @@
+/**
+ * @file media_search.h
+ * @brief 媒体列表的排序和搜索：按名称、修改时间、大小排序，按文件名或拼音首字母过滤
+ *
+ * 为媒体索引的每个列表（图片、音频、视频）建立：
+ *   - 三种排序：名称（汉字按拼音首字母排在对应字母中）、修改时间（新的在前）、大小（大的在前）；
+ *     时间和大小来自媒体目录，还没有元数据的文件排在最后
+ *   - 前缀索引：名称和拼音首字母串各一个有序数组，1~2个字节的输入按前缀二分查找
+ *   - 三字节索引（trigram）：3个字节以上的输入（包括一个汉字）取倒排表中最短的一个作为候选，
+ *     再逐个确认名称或拼音首字母串中含有输入的子串
+ * 名称为去掉扩展名的文件名（ASCII字母转小写），拼音首字母串只保留字母、数字和汉字首字母，
+ * 如"周杰伦 - 稻香.mp3"为"zjldx"。
+ *
+ * 索引在列表变化后第一次查询时重建。输入追加字符时只在上一次的结果中过滤。
+ * 只能在主线程（LVGL线程）中调用，返回的下标在下一次media_index_poll()之前有效。
+ */
+
+#ifndef MEDIA_SEARCH_H
+#define MEDIA_SEARCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MEDIA_QUERY_TEXT_MAX 64             // 输入长度上限（字节，含结尾0）
+
+// 媒体列表
+typedef enum {
+    MEDIA_LIST_IMAGE = 0,
+    MEDIA_LIST_AUDIO,
+    MEDIA_LIST_VIDEO,
+    MEDIA_LIST_COUNT,
+} media_list_kind_t;
+
+// 排序方式
+typedef enum {
+    MEDIA_SORT_NAME = 0,
+    MEDIA_SORT_DATE,
+    MEDIA_SORT_SIZE,
+    MEDIA_SORT_COUNT,
+} media_sort_t;
+
+// 一个查询（结果为媒体列表中的下标，如audio_files[items[i]]）
+typedef struct {
+    media_list_kind_t list;
+    media_sort_t sort;
+    char text[MEDIA_QUERY_TEXT_MAX];        // 当前输入（已转小写）
+    int *items;                             // 按排序方式排列的结果
+    int count;
+    int capacity;
+    uint32_t index_gen;                     // 结果对应的列表版本
+    uint32_t meta_gen;                      // 结果对应的媒体目录版本（按时间、大小排序时使用）
+} media_query_t;
+
+/**
+ * @brief 初始化查询（没有输入，结果为整个列表）
+ * @param q 查询
+ * @param list 媒体列表
+ * @param sort 排序方式
+ */
+void media_query_init(media_query_t *q, media_list_kind_t list, media_sort_t sort);
+
+/**
+ * @brief 设置输入并更新结果（输入是上一次的延续时只在上一次的结果中过滤）
+ * @param q 查询
+ * @param text 输入（UTF-8），NULL或空串表示不过滤
+ * @return 结果数量
+ */
+int media_query_set_text(media_query_t *q, const char *text);
+
+/**
+ * @brief 设置排序方式并更新结果
+ * @param q 查询
+ * @param sort 排序方式
+ * @return 结果数量
+ */
+int media_query_set_sort(media_query_t *q, media_sort_t sort);
+
+/**
+ * @brief 列表（或按时间、大小排序时的元数据）变化后重新查询，没有变化时直接返回
+ * @param q 查询
+ * @return 结果数量
+ */
+int media_query_refresh(media_query_t *q);
+
+/**
+ * @brief 跳转：在结果中查找第一个名称或拼音首字母串以prefix开头的文件
+ *
+ * 按名称排序时跳到该字母开始的位置（汉字名称按拼音首字母排在对应字母中）。
+ * @param q 查询
+ * @param prefix 前缀
+ * @return 在结果中的位置（items的下标），没有时返回-1
+ */
+int media_query_jump(media_query_t *q, const char *prefix);
+
+/**
+ * @brief 释放查询的结果
+ * @param q 查询
+ */
+void media_query_free(media_query_t *q);
+
+/**
+ * @brief 释放所有列表的索引（程序退出时调用）
+ */
+void media_search_free(void);
+
+#endif /* MEDIA_SEARCH_H */
@@ -0,0 +1,18 @@
+/**
+ * @file pinyin_initials.h
+ * @brief 汉字拼音首字母查询（用于按拼音首字母搜索和排序）
+ */
+
+#ifndef PINYIN_INITIALS_H
+#define PINYIN_INITIALS_H
+
+#include <stdint.h>
+
+/**
+ * @brief 查询汉字的拼音首字母
+ * @param codepoint Unicode码位
+ * @return 小写首字母（'a'~'z'），不是常用汉字时返回0
+ */
+char pinyin_initial(uint32_t codepoint);
+
+#endif /* PINYIN_INITIALS_H */
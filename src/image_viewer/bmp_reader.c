@@ -0,0 +1,232 @@
+/**
+ * @file bmp_reader.c
+ * @brief BMP流式读取实现
+ */
+
+#include "bmp_reader.h"
+#include "image_decoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define BMP_FILE_HEADER_SIZE 14
+#define BMP_INFO_HEADER_MIN 40             // BITMAPINFOHEADER
+#define BMP_BI_RGB 0
+#define BMP_BI_BITFIELDS 3
+
+static uint16_t rd16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t rd32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// 按掩码设置一个通道，超过8位的掩码只取高8位；掩码必须是连续的位
+static int bmp_set_channel(bmp_reader_t *reader, int c, uint32_t mask) {
+    if (mask == 0) {
+        return -1;
+    }
+    int shift = 0;
+    while (!(mask & 1u)) {
+        mask >>= 1;
+        shift++;
+    }
+    int bits = 0;
+    while (mask & 1u) {
+        mask >>= 1;
+        bits++;
+    }
+    if (mask != 0) {
+        return -1;
+    }
+    if (bits > 8) {
+        shift += bits - 8;
+        bits = 8;
+    }
+    uint32_t max = (1u << bits) - 1;
+    reader->shift[c] = (uint8_t)shift;
+    reader->mask[c] = max;
+    for (uint32_t v = 0; v <= max; v++) {
+        reader->lut[c][v] = (uint8_t)((v * 255 + max / 2) / max);
+    }
+    return 0;
+}
+
+// 设置16/32位的通道掩码（B、G、R顺序）
+static int bmp_set_masks(bmp_reader_t *reader, uint32_t r, uint32_t g, uint32_t b) {
+    if (bmp_set_channel(reader, 0, b) != 0 || bmp_set_channel(reader, 1, g) != 0 ||
+        bmp_set_channel(reader, 2, r) != 0) {
+        printf("[BMP] 不支持的通道掩码: R=0x%X G=0x%X B=0x%X\n", r, g, b);
+        return -1;
+    }
+    reader->plain32 = reader->bpp == 32 && r == 0x00FF0000u && g == 0x0000FF00u && b == 0x000000FFu;
+    return 0;
+}
+
+static int bmp_parse(bmp_reader_t *reader) {
+    const uint8_t *m = reader->map;
+    size_t len = reader->map_len;
+    if (len < BMP_FILE_HEADER_SIZE + BMP_INFO_HEADER_MIN) {
+        printf("[BMP] 文件太小: %zu 字节\n", len);
+        return -1;
+    }
+    if (rd16(m) != 0x4D42) {
+        printf("无效的BMP文件签名: 0x%X\n", rd16(m));
+        return -1;
+    }
+    uint32_t data_offset = rd32(m + 10);
+    const uint8_t *info = m + BMP_FILE_HEADER_SIZE;
+    uint32_t header_size = rd32(info);
+    int32_t width = (int32_t)rd32(info + 4);
+    int32_t height = (int32_t)rd32(info + 8);
+    int bpp = rd16(info + 14);
+    uint32_t compression = rd32(info + 16);
+
+    if (header_size < BMP_INFO_HEADER_MIN || width <= 0 || height == 0 || height == INT32_MIN ||
+        width > 16384 || height > 16384 || height < -16384) {
+        printf("无效的BMP尺寸: %dx%d\n", width, height);
+        return -1;
+    }
+    reader->width = width;
+    reader->height = height > 0 ? height : -height;
+    reader->bottom_up = height > 0;
+    reader->bpp = bpp;
+
+    if (bpp == 24) {
+        if (compression != BMP_BI_RGB) {
+            printf("不支持压缩的BMP图片\n");
+            return -1;
+        }
+    } else if (bpp == 16 || bpp == 32) {
+        if (compression == BMP_BI_BITFIELDS) {
+            // 掩码紧跟在40字节信息头之后（V4/V5信息头的同一位置也是掩码）
+            if (len < BMP_FILE_HEADER_SIZE + BMP_INFO_HEADER_MIN + 12) {
+                printf("[BMP] 缺少通道掩码\n");
+                return -1;
+            }
+            const uint8_t *masks = info + BMP_INFO_HEADER_MIN;
+            if (bmp_set_masks(reader, rd32(masks), rd32(masks + 4), rd32(masks + 8)) != 0) {
+                return -1;
+            }
+        } else if (compression == BMP_BI_RGB) {
+            if (bpp == 16) {
+                bmp_set_masks(reader, 0x7C00u, 0x03E0u, 0x001Fu);
+            } else {
+                bmp_set_masks(reader, 0x00FF0000u, 0x0000FF00u, 0x000000FFu);
+            }
+        } else {
+            printf("不支持压缩的BMP图片\n");
+            return -1;
+        }
+    } else {
+        printf("只支持16/24/32位BMP图片 (当前: %d bpp)\n", bpp);
+        return -1;
+    }
+
+    reader->stride = ((reader->width * bpp + 31) / 32) * 4;
+    // 最后一行可以没有对齐填充
+    size_t need = (size_t)data_offset + (size_t)reader->stride * (reader->height - 1) +
+                  (size_t)reader->width * (bpp / 8);
+    if (header_size > len - BMP_FILE_HEADER_SIZE || data_offset < BMP_FILE_HEADER_SIZE + header_size ||
+        need > len) {
+        printf("图片读取不完整: 需要%zu字节，文件%zu字节\n", need, len);
+        return -1;
+    }
+    reader->pixels = m + data_offset;
+    return 0;
+}
+
+int bmp_reader_open(bmp_reader_t *reader, const char *path) {
+    memset(reader, 0, sizeof(*reader));
+    if (image_map_file(path, "[BMP]", &reader->map, &reader->map_len) != 0) {
+        return -1;
+    }
+
+    if (bmp_parse(reader) != 0) {
+        bmp_reader_close(reader);
+        return -1;
+    }
+    return 0;
+}
+
+const uint8_t *bmp_reader_row_bgr24(const bmp_reader_t *reader, int y, uint8_t *scratch) {
+    int row = reader->bottom_up ? reader->height - 1 - y : y;
+    const uint8_t *p = reader->pixels + (size_t)row * reader->stride;
+    int w = reader->width;
+
+    if (reader->bpp == 24) {
+        return p;
+    }
+    uint8_t *out = scratch;
+    if (reader->plain32) {
+        for (int x = 0; x < w; x++, p += 4, out += 3) {
+            out[0] = p[0];
+            out[1] = p[1];
+            out[2] = p[2];
+        }
+        return scratch;
+    }
+    for (int x = 0; x < w; x++, out += 3) {
+        uint32_t v;
+        if (reader->bpp == 16) {
+            v = rd16(p);
+            p += 2;
+        } else {
+            v = rd32(p);
+            p += 4;
+        }
+        out[0] = reader->lut[0][(v >> reader->shift[0]) & reader->mask[0]];
+        out[1] = reader->lut[1][(v >> reader->shift[1]) & reader->mask[1]];
+        out[2] = reader->lut[2][(v >> reader->shift[2]) & reader->mask[2]];
+    }
+    return scratch;
+}
+
+// image_scale_row_fn适配
+static const uint8_t *bmp_row_fn(void *ctx, int y, uint8_t *scratch) {
+    return bmp_reader_row_bgr24((const bmp_reader_t *)ctx, y, scratch);
+}
+
+void bmp_reader_scale_src(const bmp_reader_t *reader, image_scale_src_t *src) {
+    memset(src, 0, sizeof(*src));
+    src->width = reader->width;
+    src->height = reader->height;
+    src->bottom_up = reader->bottom_up;
+    if (reader->bpp == 24) {
+        // 24位直接按行访问映射
+        src->pixels = reader->pixels;
+        src->stride = reader->stride;
+    } else {
+        src->row_fn = bmp_row_fn;
+        src->row_ctx = (void *)reader;
+    }
+}
+
+int bmp_decode_fit(const char *path, uint32_t *dst, int dst_w, int dst_h, image_scale_mode_t mode) {
+    // 映射BMP文件，缩放时按行读取，不分配整张图片的缓冲区
+    bmp_reader_t bmp;
+    if (bmp_reader_open(&bmp, path) != 0) {
+        return -1;
+    }
+    printf("BMP信息: %dx%d, bpp=%d, row_size=%d\n", bmp.width, bmp.height, bmp.bpp, bmp.stride);
+
+    image_scale_src_t src;
+    bmp_reader_scale_src(&bmp, &src);
+    int ret = image_scale_fit(&src, dst, dst_w, dst_h, mode);
+    bmp_reader_close(&bmp);
+    if (ret != 0) {
+        printf("BMP缩放失败（内存不足）\n");
+    }
+    return ret;
+}
+
+void bmp_reader_close(bmp_reader_t *reader) {
+    if (reader->map) {
+        munmap((void *)reader->map, reader->map_len);
+    }
+    reader->map = NULL;
+    reader->map_len = 0;
+    reader->pixels = NULL;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file bmp_reader.h
+ * @brief BMP流式读取：mmap映射文件，按行取像素，不整体分配像素缓冲区
+ *
+ * 原来加载BMP时malloc(行字节数*高度)并一次read()整个像素数组，大图片会让内存
+ * 峰值增加几MB。这里把文件mmap映射为只读，缩放时按行访问映射：
+ *   - 24位：直接返回映射中的行，不复制
+ *   - 32位/16位：逐行转换成24位BGR写入调用者的临时行缓冲区
+ *   - 高度为正（从下往上存储）和为负（从上往下存储）都按显示顺序取行
+ * 缩小时只有被采样的行所在的页会被读入，额外内存只有一两行。
+ *
+ * 支持的格式：16位（555，或BI_BITFIELDS掩码）、24位、32位（BGRX，或BI_BITFIELDS掩码），
+ * 不支持调色板和RLE压缩。32位的alpha通道被忽略（按不透明显示）。
+ */
+
+#ifndef BMP_READER_H
+#define BMP_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "image_scaler.h"
+
+// 一个打开的BMP文件
+typedef struct {
+    const uint8_t *map;             // 文件映射
+    size_t map_len;
+    const uint8_t *pixels;          // 像素数据起点（文件中的第一行）
+    int width;
+    int height;                     // 高度（正数）
+    int stride;                     // 每行字节数（4字节对齐）
+    int bpp;                        // 16、24或32
+    bool bottom_up;                 // 行是否从下往上存储
+    bool plain32;                   // 32位且掩码为标准BGRX（直接取前三个字节）
+    uint8_t shift[3];               // 16/32位各通道（B、G、R）在像素值中的位置
+    uint32_t mask[3];               // 各通道移位后的掩码
+    uint8_t lut[3][256];            // 各通道值到8位的映射
+} bmp_reader_t;
+
+/**
+ * @brief 打开BMP文件并校验格式
+ * @param reader 输出的读取器
+ * @param path 文件路径
+ * @return 成功返回0，失败返回-1（已打印原因）
+ */
+int bmp_reader_open(bmp_reader_t *reader, const char *path);
+
+/**
+ * @brief 取第y行（显示顺序，0为最上面一行）的24位BGR像素
+ * @param reader 读取器
+ * @param y 行号
+ * @param scratch 临时行缓冲区（width*3字节），非24位时转换到这里
+ * @return 该行像素
+ */
+const uint8_t *bmp_reader_row_bgr24(const bmp_reader_t *reader, int y, uint8_t *scratch);
+
+/**
+ * @brief 填充缩放源描述，缩放时直接从映射按行取像素
+ * @param reader 读取器（缩放完成前不能关闭）
+ * @param src 输出的源描述
+ */
+void bmp_reader_scale_src(const bmp_reader_t *reader, image_scale_src_t *src);
+
+/**
+ * @brief 把BMP文件按比例缩放、居中写入一块32位缓冲区，图片以外的边框填白色
+ *
+ * 不依赖LVGL，可以在后台线程中调用。
+ * @param path 文件路径
+ * @param dst 目标缓冲区（0xAARRGGBB，dst_w*dst_h个像素，行间无填充）
+ * @param dst_w 目标宽度
+ * @param dst_h 目标高度
+ * @param mode 缩放方式
+ * @return 成功返回0，失败返回-1（dst内容未定义）
+ */
+int bmp_decode_fit(const char *path, uint32_t *dst, int dst_w, int dst_h, image_scale_mode_t mode);
+
+/**
+ * @brief 关闭读取器（解除映射）
+ * @param reader 读取器
+ */
+void bmp_reader_close(bmp_reader_t *reader);
+
+#endif /* BMP_READER_H */
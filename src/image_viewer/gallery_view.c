@@ -0,0 +1,351 @@
+/**
+ * @file gallery_view.c
+ * @brief 缩略图网格视图实现
+ */
+
+#include "gallery_view.h"
+#include "thumb_cache.h"
+#include "image_scaler.h"
+#include "image_decoder.h"
+#include "../common/common.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "lvgl/src/extra/libs/gif/gifdec.h"
+
+// 缩略图缓存文件
+#ifndef THUMB_CACHE_FILE
+    #define THUMB_CACHE_FILE IMAGE_DIR "/.thumbs.cache"
+#endif
+
+#define GALLERY_COLS 6                          // 每行单元格数
+#define GALLERY_CELL_W 120                      // 单元格尺寸
+#define GALLERY_CELL_H 104
+#define GALLERY_PITCH_X 128                     // 单元格间距（含间隙）
+#define GALLERY_PITCH_Y 112
+#define GALLERY_GRID_W (GALLERY_COLS * GALLERY_PITCH_X)
+#define GALLERY_GRID_H 400
+#define GALLERY_VISIBLE_ROWS ((GALLERY_GRID_H + GALLERY_PITCH_Y - 1) / GALLERY_PITCH_Y + 1)
+#define GALLERY_POOL (GALLERY_VISIBLE_ROWS * GALLERY_COLS)
+#define GALLERY_AHEAD_ROWS 2                    // 预先生成可见区域下方的行数
+#define GALLERY_TIMER_MS 50
+
+/* 声明SourceHanSansSC_VF字体（定义在bin/SourceHanSansSC_VF.c中） */
+#if LV_FONT_SOURCE_HAN_SANS_SC_VF
+extern const lv_font_t SourceHanSansSC_VF;
+#endif
+
+// 从file_scanner.h中获取图片列表
+extern char **image_files;
+extern char **image_names;
+extern int image_count;
+
+// 可复用的单元格
+typedef struct {
+    lv_obj_t *obj;
+    lv_obj_t *img;
+    lv_obj_t *label;
+    lv_img_dsc_t dsc;                           // 指向缩略图缓存映射中的像素
+    int index;                                  // 绑定的图片序号，-1为未绑定
+    thumb_state_t state;
+} gallery_cell_t;
+
+static gallery_cell_t cells[GALLERY_POOL];
+static lv_obj_t *gallery_root = NULL;
+static lv_obj_t *gallery_grid = NULL;
+static lv_obj_t *gallery_title = NULL;
+static lv_timer_t *gallery_timer = NULL;
+static gallery_select_cb_t select_cb = NULL;
+static int bound_first_row = -1;
+static uint32_t bound_gen = 0;
+static double open_ms = 0;
+static bool first_screen_logged = false;
+
+static double gallery_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+#if LV_COLOR_DEPTH == 32
+// GIF画布（每像素B、G、R、A四个字节）的一行转成24位BGR
+static const uint8_t *gif_row_bgr24(void *ctx, int y, uint8_t *scratch) {
+    const gd_GIF *gif = (const gd_GIF *)ctx;
+    const uint8_t *p = gif->canvas + (size_t)y * gif->width * 4;
+    for (int x = 0; x < gif->width; x++) {
+        scratch[x * 3 + 0] = p[x * 4 + 0];
+        scratch[x * 3 + 1] = p[x * 4 + 1];
+        scratch[x * 3 + 2] = p[x * 4 + 2];
+    }
+    return scratch;
+}
+#endif
+
+/**
+ * @brief 生成GIF缩略图（取第一帧）
+ *
+ * gifdec使用LVGL内存池，只能在LVGL线程中调用。
+ */
+static int gif_thumb(const char *path, uint32_t *out) {
+#if LV_COLOR_DEPTH == 32
+    char lvgl_path[256];
+    snprintf(lvgl_path, sizeof(lvgl_path), "P:%s", path);
+    gd_GIF *gif = gd_open_gif_file(lvgl_path);
+    if (gif == NULL) {
+        return -1;
+    }
+    int ret = -1;
+    if (gd_get_frame(gif) > 0) {
+        gd_render_frame(gif, gif->canvas);
+        image_scale_src_t src;
+        memset(&src, 0, sizeof(src));
+        src.width = gif->width;
+        src.height = gif->height;
+        src.row_fn = gif_row_bgr24;
+        src.row_ctx = gif;
+        ret = image_scale_fit(&src, out, THUMB_WIDTH, THUMB_HEIGHT, IMAGE_SCALE_BOX);
+    }
+    gd_close_gif(gif);
+    return ret;
+#else
+    (void)path;
+    (void)out;
+    return -1;
+#endif
+}
+
+// 把单元格的显示更新为当前绑定图片的缩略图状态
+static void cell_refresh(gallery_cell_t *cell) {
+    const uint32_t *pixels = NULL;
+    cell->state = thumb_cache_lookup(image_files[cell->index], &pixels);
+    if (cell->state == THUMB_READY) {
+        cell->dsc.data = (const uint8_t *)pixels;
+        // 描述符地址不变而像素地址变了，先让LVGL的图片缓存失效
+        lv_img_cache_invalidate_src(&cell->dsc);
+        lv_img_set_src(cell->img, &cell->dsc);
+        lv_obj_clear_flag(cell->img, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_add_flag(cell->img, LV_OBJ_FLAG_HIDDEN);
+    }
+    lv_obj_set_style_bg_color(cell->obj, lv_color_hex(cell->state == THUMB_FAILED ? 0xFFE0E0 : 0xFFFFFF), 0);
+}
+
+// 按滚动位置把单元格绑定到可见的行
+static void gallery_bind(int first_row) {
+    for (int k = 0; k < GALLERY_POOL; k++) {
+        gallery_cell_t *cell = &cells[k];
+        int row = first_row + k / GALLERY_COLS;
+        int col = k % GALLERY_COLS;
+        int index = row * GALLERY_COLS + col;
+        if (index >= image_count || image_files[index] == NULL) {
+            cell->index = -1;
+            lv_obj_add_flag(cell->obj, LV_OBJ_FLAG_HIDDEN);
+            continue;
+        }
+        lv_obj_clear_flag(cell->obj, LV_OBJ_FLAG_HIDDEN);
+        if (cell->index == index) {
+            continue;
+        }
+        cell->index = index;
+        lv_obj_set_pos(cell->obj, col * GALLERY_PITCH_X, row * GALLERY_PITCH_Y);
+        const char *name = (image_names != NULL && image_names[index] != NULL) ? image_names[index] : "";
+        lv_label_set_text(cell->label, name);
+        cell_refresh(cell);
+    }
+    bound_first_row = first_row;
+
+    // 后台生成：先可见区域，再下方几行
+    const char *paths[(GALLERY_VISIBLE_ROWS + GALLERY_AHEAD_ROWS) * GALLERY_COLS];
+    int n = 0;
+    int last = (first_row + GALLERY_VISIBLE_ROWS + GALLERY_AHEAD_ROWS) * GALLERY_COLS;
+    for (int i = first_row * GALLERY_COLS; i < last && i < image_count; i++) {
+        if (image_files[i] != NULL && image_decode_supported(image_files[i])) {
+            paths[n++] = image_files[i];
+        }
+    }
+    thumb_cache_request(paths, n);
+}
+
+static int current_first_row(void) {
+    int row = lv_obj_get_scroll_y(gallery_grid) / GALLERY_PITCH_Y;
+    return row < 0 ? 0 : row;
+}
+
+static void gallery_scroll_cb(lv_event_t *e) {
+    (void)e;
+    int row = current_first_row();
+    if (row != bound_first_row) {
+        gallery_bind(row);
+    }
+}
+
+// 定时器：刷新新生成的缩略图，并在LVGL线程中生成一个可见的GIF缩略图
+static void gallery_timer_cb(lv_timer_t *t) {
+    (void)t;
+    uint32_t gen = thumb_cache_generation();
+    bool all_ready = true;
+    for (int k = 0; k < GALLERY_POOL; k++) {
+        gallery_cell_t *cell = &cells[k];
+        if (cell->index < 0 || cell->state != THUMB_MISSING) {
+            continue;
+        }
+        if (gen != bound_gen) {
+            cell_refresh(cell);
+        }
+        all_ready = all_ready && cell->state != THUMB_MISSING;
+    }
+    bound_gen = gen;
+
+    for (int k = 0; k < GALLERY_POOL; k++) {
+        gallery_cell_t *cell = &cells[k];
+        if (cell->index >= 0 && cell->state == THUMB_MISSING && image_format_from_path(image_files[cell->index]) == IMAGE_FORMAT_GIF) {
+            static uint32_t gif_buf[THUMB_WIDTH * THUMB_HEIGHT];
+            int ret = gif_thumb(image_files[cell->index], gif_buf);
+            thumb_cache_put(image_files[cell->index], ret == 0 ? gif_buf : NULL);
+            break;
+        }
+    }
+
+    if (all_ready && !first_screen_logged) {
+        first_screen_logged = true;
+        thumb_cache_stats_t stats;
+        thumb_cache_get_stats(&stats);
+        printf("[缩略图] 第一屏完成: %.1f ms (共%d张，缓存%u个，本次生成%u个)\n",
+               gallery_now_ms() - open_ms, image_count, stats.entries, stats.generated);
+    }
+}
+
+static void cell_click_cb(lv_event_t *e) {
+    gallery_cell_t *cell = (gallery_cell_t *)lv_event_get_user_data(e);
+    int index = cell->index;
+    if (index < 0) {
+        return;
+    }
+    gallery_select_cb_t cb = select_cb;
+    gallery_view_close();
+    if (cb) {
+        cb(index);
+    }
+}
+
+static void back_click_cb(lv_event_t *e) {
+    (void)e;
+    gallery_view_close();
+}
+
+void gallery_view_show(lv_obj_t *parent, gallery_select_cb_t on_select) {
+    if (gallery_root != NULL) {
+        return;
+    }
+#if LV_COLOR_DEPTH != 32
+    printf("[缩略图] 缩略图网格需要32位色深\n");
+    return;
+#endif
+    open_ms = gallery_now_ms();
+    first_screen_logged = false;
+    thumb_cache_open(THUMB_CACHE_FILE);
+    select_cb = on_select;
+
+    gallery_root = lv_obj_create(parent);
+    lv_obj_set_size(gallery_root, 800, 480);
+    lv_obj_set_pos(gallery_root, 0, 0);
+    lv_obj_set_style_bg_color(gallery_root, lv_color_hex(0xf0f0f0), 0);
+    lv_obj_set_style_border_width(gallery_root, 0, 0);
+    lv_obj_set_style_radius(gallery_root, 0, 0);
+    lv_obj_set_style_pad_all(gallery_root, 0, 0);
+    lv_obj_clear_flag(gallery_root, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_move_foreground(gallery_root);
+
+    // 返回按钮和标题（与图片屏幕相同的位置和样式）
+    lv_obj_t *back_btn = lv_btn_create(gallery_root);
+    lv_obj_set_size(back_btn, 80, 40);
+    lv_obj_set_style_bg_color(back_btn, lv_color_hex(0x9E9E9E), 0);
+    lv_obj_align(back_btn, LV_ALIGN_TOP_LEFT, 10, 10);
+    lv_obj_t *back_label = lv_label_create(back_btn);
+    lv_label_set_text(back_label, "返回");
+    lv_obj_set_style_text_font(back_label, &SourceHanSansSC_VF, 0);
+    lv_obj_center(back_label);
+    lv_obj_add_event_cb(back_btn, back_click_cb, LV_EVENT_CLICKED, NULL);
+
+    gallery_title = lv_label_create(gallery_root);
+    lv_label_set_text_fmt(gallery_title, "缩略图 (%d张)", image_count);
+    lv_obj_set_style_text_font(gallery_title, &SourceHanSansSC_VF, 0);
+    lv_obj_set_style_text_color(gallery_title, lv_color_hex(0x1a1a1a), 0);
+    lv_obj_align(gallery_title, LV_ALIGN_TOP_MID, 0, 20);
+
+    // 滚动区域：内容高度由一个放在最后一行的占位对象撑开，单元格按行号定位
+    gallery_grid = lv_obj_create(gallery_root);
+    lv_obj_set_size(gallery_grid, GALLERY_GRID_W + 8, GALLERY_GRID_H);
+    lv_obj_align(gallery_grid, LV_ALIGN_TOP_MID, 0, 64);
+    lv_obj_set_style_bg_opa(gallery_grid, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(gallery_grid, 0, 0);
+    lv_obj_set_style_pad_all(gallery_grid, 0, 0);
+    lv_obj_set_scroll_dir(gallery_grid, LV_DIR_VER);
+    lv_obj_add_event_cb(gallery_grid, gallery_scroll_cb, LV_EVENT_SCROLL, NULL);
+
+    int rows = (image_count + GALLERY_COLS - 1) / GALLERY_COLS;
+    lv_obj_t *spacer = lv_obj_create(gallery_grid);
+    lv_obj_remove_style_all(spacer);
+    lv_obj_set_size(spacer, 1, 1);
+    lv_obj_set_pos(spacer, 0, rows > 0 ? rows * GALLERY_PITCH_Y - 1 : 0);
+    lv_obj_clear_flag(spacer, LV_OBJ_FLAG_CLICKABLE);
+
+    for (int k = 0; k < GALLERY_POOL; k++) {
+        gallery_cell_t *cell = &cells[k];
+        memset(cell, 0, sizeof(*cell));
+        cell->index = -1;
+        cell->dsc.header.always_zero = 0;
+        cell->dsc.header.w = THUMB_WIDTH;
+        cell->dsc.header.h = THUMB_HEIGHT;
+        cell->dsc.header.cf = LV_IMG_CF_TRUE_COLOR;
+        cell->dsc.data_size = THUMB_WIDTH * THUMB_HEIGHT * sizeof(uint32_t);
+
+        cell->obj = lv_obj_create(gallery_grid);
+        lv_obj_set_size(cell->obj, GALLERY_CELL_W, GALLERY_CELL_H);
+        lv_obj_set_style_pad_all(cell->obj, 4, 0);
+        lv_obj_set_style_radius(cell->obj, 6, 0);
+        lv_obj_set_style_border_width(cell->obj, 1, 0);
+        lv_obj_set_style_border_color(cell->obj, lv_color_hex(0xcccccc), 0);
+        lv_obj_clear_flag(cell->obj, LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_add_event_cb(cell->obj, cell_click_cb, LV_EVENT_CLICKED, cell);
+
+        cell->img = lv_img_create(cell->obj);
+        lv_obj_align(cell->img, LV_ALIGN_TOP_MID, 0, 0);
+
+        cell->label = lv_label_create(cell->obj);
+        lv_obj_set_width(cell->label, GALLERY_CELL_W - 8);
+        lv_label_set_long_mode(cell->label, LV_LABEL_LONG_DOT);
+        lv_obj_set_style_text_align(cell->label, LV_TEXT_ALIGN_CENTER, 0);
+        lv_obj_set_style_text_color(cell->label, lv_color_hex(0x1a1a1a), 0);
+        lv_obj_set_style_text_font(cell->label, &SourceHanSansSC_VF, 0);
+        lv_obj_align(cell->label, LV_ALIGN_BOTTOM_MID, 0, 0);
+    }
+
+    bound_gen = thumb_cache_generation();
+    gallery_bind(0);
+    gallery_timer = lv_timer_create(gallery_timer_cb, GALLERY_TIMER_MS, NULL);
+}
+
+void gallery_view_close(void) {
+    if (gallery_root == NULL) {
+        return;
+    }
+    if (gallery_timer != NULL) {
+        lv_timer_del(gallery_timer);
+        gallery_timer = NULL;
+    }
+    thumb_cache_request(NULL, 0);
+    lv_obj_del(gallery_root);
+    gallery_root = NULL;
+    gallery_grid = NULL;
+    gallery_title = NULL;
+    bound_first_row = -1;
+    for (int k = 0; k < GALLERY_POOL; k++) {
+        cells[k].obj = NULL;
+        cells[k].index = -1;
+    }
+}
+
+bool gallery_view_is_open(void) {
+    return gallery_root != NULL;
+}
@@ -0,0 +1,41 @@
+/**
+ * @file gallery_view.h
+ * @brief 缩略图网格视图
+ *
+ * 以网格显示image_files中的全部图片缩略图，可以上下滚动，点击缩略图打开该图片。
+ * 网格只创建覆盖可见区域的一组单元格，滚动时复用这些单元格并重新绑定图片，
+ * 图片数量再多对象数也不变；缩略图从thumb_cache按需读取，尚未生成的先显示占位，
+ * 生成后自动刷新。
+ */
+
+#ifndef GALLERY_VIEW_H
+#define GALLERY_VIEW_H
+
+#include <stdbool.h>
+#include "lvgl/lvgl.h"
+
+/**
+ * @brief 点击缩略图的回调
+ * @param index 图片在image_files中的序号
+ */
+typedef void (*gallery_select_cb_t)(int index);
+
+/**
+ * @brief 打开缩略图网格（覆盖在parent上，已打开时直接返回）
+ * @param parent 父对象（图片屏幕）
+ * @param on_select 点击缩略图时的回调（网格已关闭后调用）
+ */
+void gallery_view_show(lv_obj_t *parent, gallery_select_cb_t on_select);
+
+/**
+ * @brief 关闭缩略图网格
+ */
+void gallery_view_close(void);
+
+/**
+ * @brief 缩略图网格是否打开
+ * @return 打开返回true
+ */
+bool gallery_view_is_open(void);
+
+#endif /* GALLERY_VIEW_H */
@@ -0,0 +1,359 @@
+/**
+ * @file image_cache.c
+ * @brief 已解码图片缓存实现
+ */
+
+#include "image_cache.h"
+#include "image_decoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+// 缓存字节预算（默认5张680x280的32位图片：当前图片 + 前后预取 + 余量）
+#ifndef IMAGE_CACHE_MAX_BYTES
+    #define IMAGE_CACHE_MAX_BYTES (5 * 680 * 280 * 4)
+#endif
+
+#define IMAGE_CACHE_MAX_SLOTS 16                // 缓存项数上限
+#define IMAGE_CACHE_MAX_PREFETCH 8              // 预取列表长度上限
+#define IMAGE_CACHE_PATH_MAX 256
+
+typedef enum {
+    SLOT_EMPTY = 0,
+    SLOT_DECODING,                              // 正在解码（解码线程不持有锁）
+    SLOT_READY,
+} slot_state_t;
+
+typedef struct {
+    slot_state_t state;
+    char path[IMAGE_CACHE_PATH_MAX];
+    time_t mtime;
+    off_t size;
+    uint32_t *pixels;                           // 缓冲区在淘汰后保留，供下一项复用
+    uint32_t last_used;                         // LRU时间戳
+} cache_slot_t;
+
+// 图片文件的缓存键
+typedef struct {
+    const char *path;
+    time_t mtime;
+    off_t size;
+} cache_key_t;
+
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;     // 预取列表变化/退出
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;     // 某项解码完成
+static pthread_t worker_thread;
+static bool cache_running = false;
+
+static cache_slot_t slots[IMAGE_CACHE_MAX_SLOTS];
+static int slot_count = 0;                      // 按字节预算可用的项数
+static int pinned_slot = -1;                    // 正在显示的项
+static uint32_t lru_clock = 0;
+static int cache_width = 0;
+static int cache_height = 0;
+static image_scale_mode_t cache_mode = IMAGE_SCALE_BILINEAR;
+
+static char prefetch_paths[IMAGE_CACHE_MAX_PREFETCH][IMAGE_CACHE_PATH_MAX];
+static int prefetch_count = 0;
+
+static image_cache_stats_t cache_stats;
+
+static size_t frame_bytes(void) {
+    return (size_t)cache_width * cache_height * sizeof(uint32_t);
+}
+
+static bool make_key(const char *path, cache_key_t *key) {
+    struct stat st;
+    if (strlen(path) >= IMAGE_CACHE_PATH_MAX || stat(path, &st) != 0) {
+        return false;
+    }
+    key->path = path;
+    key->mtime = st.st_mtime;
+    key->size = st.st_size;
+    return true;
+}
+
+static bool slot_matches(const cache_slot_t *slot, const cache_key_t *key) {
+    return slot->state != SLOT_EMPTY && slot->mtime == key->mtime && slot->size == key->size &&
+           strcmp(slot->path, key->path) == 0;
+}
+
+// 查找路径对应的项（持有锁时调用）
+static int find_slot(const cache_key_t *key) {
+    for (int i = 0; i < slot_count; i++) {
+        if (slot_matches(&slots[i], key)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool in_prefetch_list(const char *path) {
+    for (int i = 0; i < prefetch_count; i++) {
+        if (strcmp(prefetch_paths[i], path) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 选一个可以写入的项：优先空项，其次最久未用的已解码项（持有锁时调用）
+// keep_wanted为true时不淘汰预取列表中的项（预取不能挤掉同一批要预取的图片）
+static int pick_victim(bool keep_wanted) {
+    int best = -1;
+    for (int i = 0; i < slot_count; i++) {
+        cache_slot_t *slot = &slots[i];
+        if (slot->state == SLOT_EMPTY) {
+            return i;
+        }
+        if (slot->state != SLOT_READY || i == pinned_slot) {
+            continue;
+        }
+        if (keep_wanted && in_prefetch_list(slot->path)) {
+            continue;
+        }
+        if (best < 0 || slot->last_used < slots[best].last_used) {
+            best = i;
+        }
+    }
+    if (best >= 0) {
+        cache_stats.evictions++;
+        cache_stats.entries--;
+    }
+    return best;
+}
+
+// 占用一项准备解码（持有锁时调用）
+static void claim_slot(int idx, const cache_key_t *key) {
+    cache_slot_t *slot = &slots[idx];
+    slot->state = SLOT_DECODING;
+    snprintf(slot->path, sizeof(slot->path), "%s", key->path);
+    slot->mtime = key->mtime;
+    slot->size = key->size;
+}
+
+// 解码到项的缓冲区（不持有锁，项处于SLOT_DECODING状态，其他线程不会访问其缓冲区）
+static int decode_slot(int idx) {
+    cache_slot_t *slot = &slots[idx];
+    if (!slot->pixels) {
+        slot->pixels = (uint32_t *)malloc(frame_bytes());
+        if (!slot->pixels) {
+            printf("[图片缓存] 内存分配失败\n");
+            return -1;
+        }
+    }
+    return image_decode_fit(slot->path, slot->pixels, cache_width, cache_height, cache_mode);
+}
+
+// 解码结束（持有锁时调用）
+static void finish_slot(int idx, int ret) {
+    cache_slot_t *slot = &slots[idx];
+    if (ret == 0) {
+        slot->state = SLOT_READY;
+        slot->last_used = ++lru_clock;
+        cache_stats.entries++;
+    } else {
+        slot->state = SLOT_EMPTY;
+        slot->path[0] = '\0';
+        cache_stats.failures++;
+    }
+    pthread_cond_broadcast(&done_cond);
+}
+
+// 从预取列表中移除一项（解码失败或文件不存在，避免反复尝试）
+static void drop_prefetch(int i) {
+    memmove(prefetch_paths[i], prefetch_paths[i + 1], (size_t)(prefetch_count - i - 1) * IMAGE_CACHE_PATH_MAX);
+    prefetch_count--;
+}
+
+static void *worker_func(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&cache_mutex);
+    while (cache_running) {
+        // 找预取列表中第一个还没有缓存的图片
+        int want = -1;
+        cache_key_t key;
+        for (int i = 0; i < prefetch_count; i++) {
+            if (!make_key(prefetch_paths[i], &key)) {
+                drop_prefetch(i);
+                i--;
+                continue;
+            }
+            if (find_slot(&key) < 0) {
+                want = i;
+                break;
+            }
+        }
+        int idx = want >= 0 ? pick_victim(true) : -1;
+        if (idx < 0) {
+            pthread_cond_wait(&work_cond, &cache_mutex);
+            continue;
+        }
+
+        char path[IMAGE_CACHE_PATH_MAX];
+        snprintf(path, sizeof(path), "%s", prefetch_paths[want]);
+        key.path = path;
+        claim_slot(idx, &key);
+        pthread_mutex_unlock(&cache_mutex);
+
+        int ret = decode_slot(idx);
+
+        pthread_mutex_lock(&cache_mutex);
+        finish_slot(idx, ret);
+        if (ret == 0) {
+            cache_stats.prefetched++;
+        } else {
+            for (int i = 0; i < prefetch_count; i++) {
+                if (strcmp(prefetch_paths[i], path) == 0) {
+                    drop_prefetch(i);
+                    break;
+                }
+            }
+        }
+    }
+    pthread_mutex_unlock(&cache_mutex);
+    return NULL;
+}
+
+int image_cache_init(int width, int height, image_scale_mode_t mode) {
+    if (cache_running) {
+        return 0;
+    }
+    if (width <= 0 || height <= 0) {
+        return -1;
+    }
+    cache_width = width;
+    cache_height = height;
+    cache_mode = mode;
+    size_t n = IMAGE_CACHE_MAX_BYTES / frame_bytes();
+    if (n < 2) n = 2;                           // 至少能同时容纳显示中和一张预取
+    if (n > IMAGE_CACHE_MAX_SLOTS) n = IMAGE_CACHE_MAX_SLOTS;
+    slot_count = (int)n;
+    memset(slots, 0, sizeof(slots));
+    memset(&cache_stats, 0, sizeof(cache_stats));
+    cache_stats.capacity = (uint32_t)slot_count;
+    pinned_slot = -1;
+    prefetch_count = 0;
+
+    cache_running = true;
+    if (pthread_create(&worker_thread, NULL, worker_func, NULL) != 0) {
+        printf("[图片缓存] 创建预取线程失败\n");
+        cache_running = false;
+        return -1;
+    }
+    printf("[图片缓存] 初始化完成: %dx%d, 最多%d张 (%zu KB)\n", width, height, slot_count,
+           (size_t)slot_count * frame_bytes() / 1024);
+    return 0;
+}
+
+void image_cache_deinit(void) {
+    if (!cache_running) {
+        return;
+    }
+    pthread_mutex_lock(&cache_mutex);
+    cache_running = false;
+    pthread_cond_broadcast(&work_cond);
+    pthread_mutex_unlock(&cache_mutex);
+    pthread_join(worker_thread, NULL);
+
+    for (int i = 0; i < IMAGE_CACHE_MAX_SLOTS; i++) {
+        free(slots[i].pixels);
+        slots[i].pixels = NULL;
+        slots[i].state = SLOT_EMPTY;
+    }
+    pinned_slot = -1;
+    prefetch_count = 0;
+}
+
+const uint32_t *image_cache_acquire(const char *path, bool *hit) {
+    if (hit) {
+        *hit = false;
+    }
+    cache_key_t key;
+    if (!cache_running || !path || !make_key(path, &key)) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&cache_mutex);
+    pinned_slot = -1;
+    int idx;
+    bool waited = false;
+    while ((idx = find_slot(&key)) >= 0 && slots[idx].state == SLOT_DECODING) {
+        // 后台线程正在解码这张图片，等它完成
+        waited = true;
+        pthread_cond_wait(&done_cond, &cache_mutex);
+    }
+
+    if (idx >= 0) {
+        if (waited) {
+            cache_stats.waits++;
+        } else {
+            cache_stats.hits++;
+        }
+        if (hit) {
+            *hit = true;
+        }
+    } else {
+        // 未命中：在当前线程同步解码（可以淘汰预取的图片）
+        cache_stats.misses++;
+        idx = pick_victim(false);
+        while (idx < 0) {
+            // 所有项都在后台解码中，等一项完成
+            pthread_cond_wait(&done_cond, &cache_mutex);
+            idx = pick_victim(false);
+        }
+        claim_slot(idx, &key);
+        pthread_mutex_unlock(&cache_mutex);
+
+        int ret = decode_slot(idx);
+
+        pthread_mutex_lock(&cache_mutex);
+        finish_slot(idx, ret);
+        if (ret != 0) {
+            pthread_mutex_unlock(&cache_mutex);
+            return NULL;
+        }
+    }
+
+    slots[idx].last_used = ++lru_clock;
+    pinned_slot = idx;
+    const uint32_t *pixels = slots[idx].pixels;
+    pthread_mutex_unlock(&cache_mutex);
+    return pixels;
+}
+
+void image_cache_release(void) {
+    pthread_mutex_lock(&cache_mutex);
+    pinned_slot = -1;
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+void image_cache_prefetch(const char *const *paths, int count) {
+    if (!cache_running) {
+        return;
+    }
+    pthread_mutex_lock(&cache_mutex);
+    prefetch_count = 0;
+    for (int i = 0; i < count && prefetch_count < IMAGE_CACHE_MAX_PREFETCH; i++) {
+        if (paths[i] && strlen(paths[i]) < IMAGE_CACHE_PATH_MAX) {
+            snprintf(prefetch_paths[prefetch_count++], IMAGE_CACHE_PATH_MAX, "%s", paths[i]);
+        }
+    }
+    pthread_cond_signal(&work_cond);
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+void image_cache_get_stats(image_cache_stats_t *stats) {
+    pthread_mutex_lock(&cache_mutex);
+    *stats = cache_stats;
+    stats->bytes = 0;
+    for (int i = 0; i < slot_count; i++) {
+        if (slots[i].pixels) {
+            stats->bytes += (uint32_t)frame_bytes();
+        }
+    }
+    pthread_mutex_unlock(&cache_mutex);
+}
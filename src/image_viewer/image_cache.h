@@ -0,0 +1,78 @@
+/**
+ * @file image_cache.h
+ * @brief 已解码图片缓存：按字节预算的LRU + 后台预取线程
+ *
+ * 原来每次切换图片都在UI线程里同步解码图片。本模块缓存已经缩放好的、
+ * 与canvas同样大小的32位像素缓冲区（0xAARRGGBB，可以直接作为canvas缓冲区）：
+ *   - 后台线程按image_cache_prefetch给出的顺序解码当前图片的前后几张
+ *   - image_cache_acquire命中时直接返回缓冲区，调用者只需把canvas切换到该缓冲区；
+ *     后台线程正在解码该图片时等待其完成；未命中时在调用线程同步解码
+ *   - 正在显示的缓冲区被固定，不会被淘汰或复用
+ *   - 缓存键为路径+修改时间+文件大小，文件被替换后自动失效
+ *
+ * 除后台线程外，所有函数只应在LVGL线程中调用。
+ */
+
+#ifndef IMAGE_CACHE_H
+#define IMAGE_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "image_scaler.h"
+
+// 缓存统计
+typedef struct {
+    uint32_t hits;                  // acquire命中（已解码）
+    uint32_t waits;                 // acquire时后台线程正在解码该图片，等待后命中
+    uint32_t misses;                // acquire未命中，同步解码
+    uint32_t prefetched;            // 后台线程解码的图片数
+    uint32_t evictions;             // 被淘汰的缓存项数
+    uint32_t failures;              // 解码失败次数
+    uint32_t entries;               // 当前已解码的项数
+    uint32_t capacity;              // 最多缓存的项数（由字节预算决定）
+    uint32_t bytes;                 // 当前占用的字节数
+} image_cache_stats_t;
+
+/**
+ * @brief 初始化缓存并启动后台解码线程（重复调用直接返回）
+ * @param width 解码后缓冲区宽度（canvas宽度）
+ * @param height 解码后缓冲区高度（canvas高度）
+ * @param mode 缩放方式
+ * @return 成功返回0，失败返回-1
+ */
+int image_cache_init(int width, int height, image_scale_mode_t mode);
+
+/**
+ * @brief 停止后台线程并释放所有缓冲区（调用前canvas不能再使用缓存的缓冲区）
+ */
+void image_cache_deinit(void);
+
+/**
+ * @brief 取得图片解码后的缓冲区并固定（之前固定的缓冲区解除固定）
+ * @param path 图片路径（BMP/JPEG/PNG）
+ * @param hit 输出是否命中（可为NULL；等待后台解码完成也算命中）
+ * @return 缓冲区（width*height个像素），解码失败返回NULL（此时没有固定的缓冲区）
+ */
+const uint32_t *image_cache_acquire(const char *path, bool *hit);
+
+/**
+ * @brief 解除固定（canvas不再使用缓存的缓冲区时调用，如切换到GIF）
+ */
+void image_cache_release(void);
+
+/**
+ * @brief 设置预取列表（替换之前的列表），后台线程按顺序解码尚未缓存的图片
+ *
+ * 只在不需要淘汰列表中其他图片和正在显示的图片时才预取。
+ * @param paths 图片路径，优先级从高到低（会被复制）
+ * @param count 路径数
+ */
+void image_cache_prefetch(const char *const *paths, int count);
+
+/**
+ * @brief 获取统计信息
+ * @param stats 输出
+ */
+void image_cache_get_stats(image_cache_stats_t *stats);
+
+#endif /* IMAGE_CACHE_H */
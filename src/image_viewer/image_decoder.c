@@ -0,0 +1,82 @@
+/**
+ * @file image_decoder.c
+ * @brief 静态图片解码入口实现
+ */
+
+#include "image_decoder.h"
+#include "bmp_reader.h"
+#include "jpeg_reader.h"
+#include "png_reader.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+image_format_t image_format_from_path(const char *path) {
+    const char *ext = path ? strrchr(path, '.') : NULL;
+    if (ext == NULL) {
+        return IMAGE_FORMAT_UNKNOWN;
+    }
+    if (strcasecmp(ext, ".bmp") == 0) {
+        return IMAGE_FORMAT_BMP;
+    }
+    if (strcasecmp(ext, ".gif") == 0) {
+        return IMAGE_FORMAT_GIF;
+    }
+    if (strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0) {
+        return IMAGE_FORMAT_JPEG;
+    }
+    if (strcasecmp(ext, ".png") == 0) {
+        return IMAGE_FORMAT_PNG;
+    }
+    return IMAGE_FORMAT_UNKNOWN;
+}
+
+bool image_decode_supported(const char *path) {
+    image_format_t format = image_format_from_path(path);
+    return format == IMAGE_FORMAT_BMP || format == IMAGE_FORMAT_JPEG || format == IMAGE_FORMAT_PNG;
+}
+
+int image_decode_fit(const char *path, uint32_t *dst, int dst_w, int dst_h, image_scale_mode_t mode) {
+    switch (image_format_from_path(path)) {
+    case IMAGE_FORMAT_BMP:
+        return bmp_decode_fit(path, dst, dst_w, dst_h, mode);
+    case IMAGE_FORMAT_JPEG:
+        return jpeg_decode_fit(path, dst, dst_w, dst_h, mode);
+    case IMAGE_FORMAT_PNG:
+        return png_decode_fit(path, dst, dst_w, dst_h, mode);
+    default:
+        printf("[图片解码] 不支持的格式: %s\n", path ? path : "(null)");
+        return -1;
+    }
+}
+
+int image_map_file(const char *path, const char *tag, const uint8_t **map, size_t *len) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("%s 无法打开文件: %s\n", tag, path);
+        perror("详细原因");
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        printf("%s 无法获取文件大小: %s\n", tag, path);
+        close(fd);
+        return -1;
+    }
+    void *m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);                                  // 映射建立后不再需要文件描述符
+    if (m == MAP_FAILED) {
+        printf("%s 映射文件失败: %s\n", tag, path);
+        perror("详细原因");
+        return -1;
+    }
+    // 解码按文件顺序读取，提示内核加大预读
+    madvise(m, (size_t)st.st_size, MADV_SEQUENTIAL);
+    *map = (const uint8_t *)m;
+    *len = (size_t)st.st_size;
+    return 0;
+}
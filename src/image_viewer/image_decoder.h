@@ -0,0 +1,62 @@
+/**
+ * @file image_decoder.h
+ * @brief 静态图片（BMP/JPEG/PNG）解码入口：按扩展名选择流式读取器，缩放后写入32位缓冲区
+ *
+ * 三种读取器都把文件mmap映射为只读，按行交给image_scaler缩放，
+ * 不分配整张原图的缓冲区，也不使用LVGL内存池，可以在后台线程中调用。
+ * GIF是动画，仍由LVGL的GIF对象（gifdec）在LVGL线程中解码。
+ */
+
+#ifndef IMAGE_DECODER_H
+#define IMAGE_DECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "image_scaler.h"
+
+// 图片格式
+typedef enum {
+    IMAGE_FORMAT_UNKNOWN = 0,
+    IMAGE_FORMAT_BMP,
+    IMAGE_FORMAT_GIF,
+    IMAGE_FORMAT_JPEG,
+    IMAGE_FORMAT_PNG,
+} image_format_t;
+
+/**
+ * @brief 按扩展名判断图片格式（不区分大小写）
+ * @param path 文件路径
+ * @return 图片格式
+ */
+image_format_t image_format_from_path(const char *path);
+
+/**
+ * @brief 是否可以用image_decode_fit解码（BMP/JPEG/PNG）
+ * @param path 文件路径
+ * @return 可以返回true
+ */
+bool image_decode_supported(const char *path);
+
+/**
+ * @brief 把图片按比例缩放、居中写入一块32位缓冲区，图片以外的边框填白色
+ * @param path 文件路径（BMP/JPEG/PNG）
+ * @param dst 目标缓冲区（0xAARRGGBB，dst_w*dst_h个像素，行间无填充）
+ * @param dst_w 目标宽度
+ * @param dst_h 目标高度
+ * @param mode 缩放方式
+ * @return 成功返回0，失败返回-1（dst内容未定义）
+ */
+int image_decode_fit(const char *path, uint32_t *dst, int dst_w, int dst_h, image_scale_mode_t mode);
+
+/**
+ * @brief 把整个文件映射为只读（供各读取器使用），并提示内核按顺序预读
+ * @param path 文件路径
+ * @param tag 日志前缀（如"[JPEG]"）
+ * @param map 输出的映射地址（用munmap解除）
+ * @param len 输出的映射长度
+ * @return 成功返回0，失败返回-1（已打印原因）
+ */
+int image_map_file(const char *path, const char *tag, const uint8_t **map, size_t *len);
+
+#endif /* IMAGE_DECODER_H */
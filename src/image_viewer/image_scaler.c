@@ -0,0 +1,245 @@
+/**
+ * @file image_scaler.c
+ * @brief 按行缩放实现
+ */
+
+#include "image_scaler.h"
+#include <stdlib.h>
+#include <string.h>
+
+// 第y行（显示顺序）的BGR像素，需要转换时写入scratch
+static const uint8_t *src_row(const image_scale_src_t *src, int y, uint8_t *scratch) {
+    if (src->row_fn) {
+        return src->row_fn(src->row_ctx, y, scratch);
+    }
+    int row = src->bottom_up ? src->height - 1 - y : y;
+    return src->pixels + (size_t)row * src->stride;
+}
+
+// 第i个处理的目标行：源数据从下往上存储时从最后一行处理起，按文件顺序读取源数据
+// （源数据是mmap映射时顺序访问才能触发预读）
+static inline int dst_row(const image_scale_src_t *src, int i, int dst_h) {
+    return src->bottom_up ? dst_h - 1 - i : i;
+}
+
+// 3个字节的BGR打包成0xFFRRGGBB
+static inline uint32_t pack_bgr(const uint8_t *p) {
+    return 0xFF000000u | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | p[0];
+}
+
+// 源坐标（8位小数）：目标像素中心映射到源图片，再减半个像素得到左/上邻点
+static int bilinear_coord(int i, int src_len, int dst_len) {
+    int64_t v = ((int64_t)(2 * i + 1) * src_len * 256) / (2 * dst_len) - 128;
+    if (v < 0) v = 0;
+    if (v > (int64_t)(src_len - 1) * 256) v = (int64_t)(src_len - 1) * 256;
+    return (int)v;
+}
+
+// 最近邻：列映射存源字节偏移
+static void scale_nearest(const image_scale_src_t *src, uint32_t *dst, int dst_stride,
+                          int dst_w, int dst_h, int *xoff, uint8_t *scratch) {
+    for (int x = 0; x < dst_w; x++) {
+        xoff[x] = (int)(((int64_t)(2 * x + 1) * src->width) / (2 * dst_w)) * 3;
+    }
+    for (int i = 0; i < dst_h; i++) {
+        int y = dst_row(src, i, dst_h);
+        const uint8_t *row = src_row(src, (int)(((int64_t)(2 * y + 1) * src->height) / (2 * dst_h)), scratch);
+        uint32_t *out = dst + (size_t)y * dst_stride;
+        for (int x = 0; x < dst_w; x++) {
+            out[x] = pack_bgr(row + xoff[x]);
+        }
+    }
+}
+
+// 双线性第一步：上下两行源像素按行权重混合到16位中间行（值为像素*256，连续数组逐元素运算）
+static void bilinear_vblend(const uint8_t *restrict r0, const uint8_t *restrict r1,
+                            uint16_t *restrict out, int n, unsigned w1) {
+    unsigned w0 = 256 - w1;
+    for (int i = 0; i < n; i++) {
+        out[i] = (uint16_t)(r0[i] * w0 + r1[i] * w1);
+    }
+}
+
+// 双线性第二步：中间行按列权重插值并打包成目标像素
+static void bilinear_hrow(const uint16_t *row, uint32_t *out, int dst_w,
+                          const int *xoff0, const int *xoff1, const uint8_t *wx) {
+    for (int x = 0; x < dst_w; x++) {
+        const uint16_t *a = row + xoff0[x];
+        const uint16_t *b = row + xoff1[x];
+        uint32_t w1 = wx[x];
+        uint32_t w0 = 256 - w1;
+        uint32_t bl = (a[0] * w0 + b[0] * w1 + 32768) >> 16;
+        uint32_t g = (a[1] * w0 + b[1] * w1 + 32768) >> 16;
+        uint32_t r = (a[2] * w0 + b[2] * w1 + 32768) >> 16;
+        out[x] = 0xFF000000u | (r << 16) | (g << 8) | bl;
+    }
+}
+
+// 双线性：每个目标行先在源宽度上做一次行混合，再按列插值（两步都只处理一行）
+static int scale_bilinear(const image_scale_src_t *src, uint32_t *dst, int dst_stride,
+                          int dst_w, int dst_h, uint8_t *mem, uint8_t *scratch) {
+    int *xoff0 = (int *)mem;
+    int *xoff1 = xoff0 + dst_w;
+    uint16_t *mid = (uint16_t *)(xoff1 + dst_w);
+    uint8_t *wx = (uint8_t *)(mid + (size_t)src->width * 3);
+
+    for (int x = 0; x < dst_w; x++) {
+        int sx = bilinear_coord(x, src->width, dst_w);
+        int x0 = sx >> 8;
+        xoff0[x] = x0 * 3;
+        xoff1[x] = (x0 + 1 < src->width ? x0 + 1 : x0) * 3;
+        wx[x] = (uint8_t)(sx & 0xFF);
+    }
+
+    for (int i = 0; i < dst_h; i++) {
+        int y = dst_row(src, i, dst_h);
+        int sy = bilinear_coord(y, src->height, dst_h);
+        int y0 = sy >> 8;
+        int y1 = y0 + 1 < src->height ? y0 + 1 : y0;
+        const uint8_t *r0 = src_row(src, y0, scratch);
+        const uint8_t *r1 = src_row(src, y1, scratch + src->width * 3);
+        bilinear_vblend(r0, r1, mid, src->width * 3, (unsigned)(sy & 0xFF));
+        bilinear_hrow(mid, dst + (size_t)y * dst_stride, dst_w, xoff0, xoff1, wx);
+    }
+    return 0;
+}
+
+// 区域平均：每个目标像素覆盖的源像素逐行累加，再乘以面积倒数（32位小数）
+static int scale_box(const image_scale_src_t *src, uint32_t *dst, int dst_stride,
+                     int dst_w, int dst_h, uint8_t *mem, uint8_t *scratch) {
+    int *xs = (int *)mem;                       // 第x列覆盖源列[xs[x], xs[x + 1])
+    uint32_t *acc = (uint32_t *)(xs + dst_w + 1);
+
+    for (int x = 0; x <= dst_w; x++) {
+        xs[x] = (int)(((int64_t)x * src->width) / dst_w);
+    }
+
+    for (int i = 0; i < dst_h; i++) {
+        int y = dst_row(src, i, dst_h);
+        int y0 = (int)(((int64_t)y * src->height) / dst_h);
+        int y1 = (int)(((int64_t)(y + 1) * src->height) / dst_h);
+        if (y1 <= y0) y1 = y0 + 1;                // 放大时至少取一行
+
+        memset(acc, 0, (size_t)dst_w * 3 * sizeof(uint32_t));
+        for (int sy = y0; sy < y1; sy++) {
+            const uint8_t *row = src_row(src, sy, scratch);
+            uint32_t *a = acc;
+            for (int x = 0; x < dst_w; x++, a += 3) {
+                int x0 = xs[x];
+                int x1 = xs[x + 1] > x0 ? xs[x + 1] : x0 + 1;
+                const uint8_t *p = row + x0 * 3;
+                uint32_t b = 0, g = 0, r = 0;
+                for (int sx = x0; sx < x1; sx++, p += 3) {
+                    b += p[0];
+                    g += p[1];
+                    r += p[2];
+                }
+                a[0] += b;
+                a[1] += g;
+                a[2] += r;
+            }
+        }
+
+        uint32_t *out = dst + (size_t)y * dst_stride;
+        const uint32_t *a = acc;
+        for (int x = 0; x < dst_w; x++, a += 3) {
+            int cols = xs[x + 1] > xs[x] ? xs[x + 1] - xs[x] : 1;
+            // 倒数取32位小数，32x32→64位乘法（ARM上一条UMULL）；16位小数在面积较大时误差明显，超过65536时为0
+            uint32_t inv = 0xFFFFFFFFu / (uint32_t)(cols * (y1 - y0));
+            uint32_t b = (uint32_t)(((uint64_t)a[0] * inv + 0x80000000u) >> 32);
+            uint32_t g = (uint32_t)(((uint64_t)a[1] * inv + 0x80000000u) >> 32);
+            uint32_t r = (uint32_t)(((uint64_t)a[2] * inv + 0x80000000u) >> 32);
+            out[x] = 0xFF000000u | ((r > 255 ? 255 : r) << 16) | ((g > 255 ? 255 : g) << 8) | (b > 255 ? 255 : b);
+        }
+    }
+    return 0;
+}
+
+int image_scale_bgr24(const image_scale_src_t *src, uint32_t *dst, int dst_stride,
+                      int dst_w, int dst_h, image_scale_mode_t mode) {
+    if (!src || !dst || src->width <= 0 || src->height <= 0 || dst_w <= 0 || dst_h <= 0 ||
+        dst_stride < dst_w) {
+        return -1;
+    }
+    if (!src->row_fn && (!src->pixels || src->stride < src->width * 3)) {
+        return -1;
+    }
+
+    // 列映射表和中间行一次分配（按最大需求：双线性的两张表 + 权重 + 源宽度的16位中间行）
+    size_t need = (size_t)dst_w * (2 * sizeof(int) + 1) + (size_t)src->width * 3 * sizeof(uint16_t);
+    size_t box_need = (size_t)(dst_w + 1) * sizeof(int) + (size_t)dst_w * 3 * sizeof(uint32_t);
+    if (box_need > need) {
+        need = box_need;
+    }
+    // 按行转换时再加两行24位临时缓冲区（双线性同时需要上下两行）
+    size_t scratch_size = src->row_fn ? (size_t)src->width * 3 * 2 : 0;
+    need = (need + 7) & ~(size_t)7;
+    uint8_t *mem = malloc(need + scratch_size);
+    if (!mem) {
+        return -1;
+    }
+    uint8_t *scratch = src->row_fn ? mem + need : NULL;
+
+    int ret;
+    switch (mode) {
+    case IMAGE_SCALE_BILINEAR:
+        ret = scale_bilinear(src, dst, dst_stride, dst_w, dst_h, mem, scratch);
+        break;
+    case IMAGE_SCALE_BOX:
+        ret = scale_box(src, dst, dst_stride, dst_w, dst_h, mem, scratch);
+        break;
+    case IMAGE_SCALE_NEAREST:
+    default:
+        scale_nearest(src, dst, dst_stride, dst_w, dst_h, (int *)mem, scratch);
+        ret = 0;
+        break;
+    }
+    free(mem);
+    return ret;
+}
+
+int image_scale_fit(const image_scale_src_t *src, uint32_t *dst, int dst_w, int dst_h,
+                    image_scale_mode_t mode) {
+    if (!src || !dst || src->width <= 0 || src->height <= 0 || dst_w <= 0 || dst_h <= 0) {
+        return -1;
+    }
+    // 保持宽高比：按较小的缩放比例
+    float scale_x = (float)dst_w / src->width;
+    float scale_y = (float)dst_h / src->height;
+    float scale = (scale_x < scale_y) ? scale_x : scale_y;
+
+    int scaled_width = (int)(src->width * scale);
+    int scaled_height = (int)(src->height * scale);
+    if (scaled_width > dst_w) scaled_width = dst_w;
+    if (scaled_height > dst_h) scaled_height = dst_h;
+    if (scaled_width <= 0) scaled_width = 1;
+    if (scaled_height <= 0) scaled_height = 1;
+    int x_offset = (dst_w - scaled_width) / 2;
+    int y_offset = (dst_h - scaled_height) / 2;
+
+    // 图片以外的边框填白色
+    for (int y = 0; y < dst_h; y++) {
+        uint32_t *row = dst + (size_t)y * dst_w;
+        if (y < y_offset || y >= y_offset + scaled_height) {
+            memset(row, 0xFF, dst_w * sizeof(uint32_t));
+        } else {
+            memset(row, 0xFF, x_offset * sizeof(uint32_t));
+            memset(row + x_offset + scaled_width, 0xFF,
+                   (dst_w - x_offset - scaled_width) * sizeof(uint32_t));
+        }
+    }
+    return image_scale_bgr24(src, dst + (size_t)y_offset * dst_w + x_offset, dst_w,
+                             scaled_width, scaled_height, mode);
+}
+
+const char *image_scale_mode_name(image_scale_mode_t mode) {
+    switch (mode) {
+    case IMAGE_SCALE_BILINEAR:
+        return "bilinear";
+    case IMAGE_SCALE_BOX:
+        return "box";
+    case IMAGE_SCALE_NEAREST:
+    default:
+        return "nearest";
+    }
+}
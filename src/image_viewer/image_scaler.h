@@ -0,0 +1,84 @@
+/**
+ * @file image_scaler.h
+ * @brief 按行缩放24位BGR图片到32位像素缓冲区（定点数，最近邻/双线性/区域平均）
+ *
+ * 原来的缩放对每个目标像素做一次浮点除法并调用lv_canvas_set_px_color，
+ * 每次调用都要经过图片格式分派。这里按目标行处理：
+ *   - 列映射（源列号、权重）每次缩放只算一次，用16.16定点数
+ *   - 双线性每个目标行先把上下两行源像素按行权重逐元素混合到16位中间行，
+ *     再按列权重插值并打包
+ *   - 区域平均把目标像素覆盖的源像素逐行累加，最后乘以面积倒数
+ *   - 结果直接写入0xAARRGGBB缓冲区（LV_COLOR_DEPTH为32时即lv_color_t）
+ *   - 源数据按行访问，只读取采样到的行（源数据可以是mmap映射，未采样的行不会被读入内存）；
+ *     其他位深通过row_fn逐行转换成24位，临时缓冲区只有一两行
+ * 行混合、累加等内层循环是连续数组上的逐元素运算，编译器可以自动向量化。
+ *
+ * 本模块不依赖LVGL，可以在任意线程中调用。
+ */
+
+#ifndef IMAGE_SCALER_H
+#define IMAGE_SCALER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 缩放方式
+typedef enum {
+    IMAGE_SCALE_NEAREST = 0,        // 最近邻：最快，缩小时有锯齿
+    IMAGE_SCALE_BILINEAR,           // 双线性：放大和小倍数缩小效果好
+    IMAGE_SCALE_BOX,                // 区域平均：大倍数缩小效果最好（放大时等同最近邻）
+} image_scale_mode_t;
+
+/**
+ * @brief 取源图片第y行（显示顺序）的24位BGR像素
+ * @param ctx image_scale_src_t.row_ctx
+ * @param y 行号（0为最上面一行）
+ * @param scratch 可用的临时行缓冲区（width*3字节），需要转换格式时写到这里
+ * @return 该行像素（可以是scratch，也可以直接指向源数据）
+ */
+typedef const uint8_t *(*image_scale_row_fn)(void *ctx, int y, uint8_t *scratch);
+
+// 24位BGR源图片（BMP像素数据）
+typedef struct {
+    const uint8_t *pixels;          // 像素数据起点（BMP文件中的第一行）
+    int width;
+    int height;
+    int stride;                     // 每行字节数（BMP按4字节对齐）
+    bool bottom_up;                 // 行是否从下往上存储（BMP高度为正时），此时从最后一行处理起
+    image_scale_row_fn row_fn;      // 非NULL时按行取像素（其他位深逐行转换），忽略pixels/stride
+    void *row_ctx;                  // row_fn的参数
+} image_scale_src_t;
+
+/**
+ * @brief 把源图片缩放到目标矩形
+ * @param src 源图片
+ * @param dst 目标左上角像素（0xAARRGGBB，alpha为0xFF）
+ * @param dst_stride 目标每行像素数（不是字节数）
+ * @param dst_w 目标宽度
+ * @param dst_h 目标高度
+ * @param mode 缩放方式
+ * @return 成功返回0，参数错误或内存不足返回-1
+ */
+int image_scale_bgr24(const image_scale_src_t *src, uint32_t *dst, int dst_stride,
+                      int dst_w, int dst_h, image_scale_mode_t mode);
+
+/**
+ * @brief 把源图片按比例缩放、居中写入整块目标缓冲区，图片以外的边框填白色
+ * @param src 源图片
+ * @param dst 目标缓冲区（0xAARRGGBB，dst_w*dst_h个像素，行间无填充）
+ * @param dst_w 目标宽度
+ * @param dst_h 目标高度
+ * @param mode 缩放方式
+ * @return 成功返回0，参数错误或内存不足返回-1
+ */
+int image_scale_fit(const image_scale_src_t *src, uint32_t *dst, int dst_w, int dst_h,
+                    image_scale_mode_t mode);
+
+/**
+ * @brief 获取缩放方式名称（用于日志）
+ * @param mode 缩放方式
+ * @return 名称字符串
+ */
+const char *image_scale_mode_name(image_scale_mode_t mode);
+
+#endif /* IMAGE_SCALER_H */
@@ -4,8 +4,13 @@
  */
 
 #include "image_viewer.h"
+#include "image_scaler.h"
+#include "image_decoder.h"
+#include "image_cache.h"
+#include "gallery_view.h"
 #include "../common/common.h"
 #include "../file_scanner/file_scanner.h"
+#include "../file_scanner/media_catalog.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,10 +18,16 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <time.h>
 #include "lvgl/lvgl.h"
 #include "lvgl/src/font/lv_font.h"
 #include "lvgl/src/extra/libs/fsdrv/lv_fsdrv.h"
 
+// 静态图片（BMP/JPEG/PNG）缩放方式（IMAGE_SCALE_NEAREST/IMAGE_SCALE_BILINEAR/IMAGE_SCALE_BOX）
+#ifndef IMAGE_VIEWER_SCALE_MODE
+    #define IMAGE_VIEWER_SCALE_MODE IMAGE_SCALE_BILINEAR
+#endif
+
 /* 声明SourceHanSansSC_VF字体（定义在bin/SourceHanSansSC_VF.c中） */
 #if LV_FONT_SOURCE_HAN_SANS_SC_VF
 extern const lv_font_t SourceHanSansSC_VF;
@@ -39,6 +50,79 @@ extern int image_count;
 // 前向声明
 static void prev_image_cb(lv_event_t * e);
 static void next_image_cb(lv_event_t * e);
+static void gallery_btn_cb(lv_event_t * e);
+
+static int last_shown_index = -1;   // 上一次显示的图片（判断翻页方向，决定预取顺序）
+
+static double viewer_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static bool is_gif_path(const char *path) {
+    return image_format_from_path(path) == IMAGE_FORMAT_GIF;
+}
+
+/**
+ * @brief 在canvas上显示静态图片（BMP/JPEG/PNG）：32位色深时从解码缓存取缓冲区并直接切换canvas缓冲区，
+ *        否则解码到canvas_buf
+ * @return 成功返回0，失败返回-1（canvas显示白色）
+ */
+static int show_still_on_canvas(lv_obj_t *canvas, const char *file_path, bool *hit) {
+    *hit = false;
+#if LV_COLOR_DEPTH == 32
+    if (image_cache_init(680, 280, IMAGE_VIEWER_SCALE_MODE) == 0) {
+        const uint32_t *pixels = image_cache_acquire(file_path, hit);
+        if (pixels != NULL) {
+            // 缓存的缓冲区就是0xAARRGGBB格式，canvas直接使用，不复制
+            lv_canvas_set_buffer(canvas, (void *)pixels, 680, 280, LV_IMG_CF_TRUE_COLOR_ALPHA);
+            lv_obj_invalidate(canvas);
+            return 0;
+        }
+        lv_canvas_set_buffer(canvas, canvas_buf, 680, 280, LV_IMG_CF_TRUE_COLOR_ALPHA);
+        lv_canvas_fill_bg(canvas, lv_color_hex(0xFFFFFF), LV_OPA_COVER);
+        return -1;
+    }
+#endif
+    lv_canvas_set_buffer(canvas, canvas_buf, 680, 280, LV_IMG_CF_TRUE_COLOR_ALPHA);
+    if (load_bmp_to_canvas(canvas, file_path) != 0) {
+        lv_canvas_fill_bg(canvas, lv_color_hex(0xFFFFFF), LV_OPA_COVER);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 让后台线程预取当前图片的相邻图片：先翻页方向的下一张，再反方向一张，再同方向第二张
+ */
+static void prefetch_neighbours(int index) {
+    int dir = 1;
+    if (last_shown_index >= 0 && image_count > 2 &&
+        index == (last_shown_index - 1 + image_count) % image_count) {
+        dir = -1;
+    }
+    last_shown_index = index;
+
+    const char *paths[3];
+    int n = 0;
+    int order[3] = { index + dir, index - dir, index + 2 * dir };
+    for (int k = 0; k < 3; k++) {
+        int i = ((order[k] % image_count) + image_count) % image_count;
+        const char *path = image_files[i];
+        if (i == index || path == NULL || !image_decode_supported(path)) {
+            continue;
+        }
+        bool dup = false;
+        for (int j = 0; j < n; j++) {
+            dup = dup || strcmp(paths[j], path) == 0;
+        }
+        if (!dup) {
+            paths[n++] = path;
+        }
+    }
+    image_cache_prefetch(paths, n);
+}
 
 /**
  * @brief 显示图片列表
@@ -49,15 +133,24 @@ void show_images(void) {
         printf("警告: 没有找到任何图片文件\n");
         // 仍然创建UI，但会显示错误信息
     } else {
-        // 检查文件是否存在
+        // 从媒体目录汇总（不逐个stat；已删除的文件由媒体索引移出列表）
+        int known = 0;
+        int pending = 0;
+        int64_t total_bytes = 0;
         for (int i = 0; i < image_count && image_files[i] != NULL; i++) {
-            struct stat st;
-            if (stat(image_files[i], &st) == 0) {
-                printf("验证图片文件[%d]: %s (大小: %ld 字节)\n", i, image_files[i], st.st_size);
+            media_info_t info;
+            media_info_state_t state = media_catalog_lookup(image_files[i], &info);
+            if (state == MEDIA_INFO_READY) {
+                known++;
+                total_bytes += info.size;
+            } else if (state == MEDIA_INFO_FAILED) {
+                printf("警告: 无法识别的图片文件[%d]: %s\n", i, image_files[i]);
             } else {
-                printf("警告: 图片文件不存在[%d]: %s - %s\n", i, image_files[i], strerror(errno));
+                pending++;
             }
         }
+        printf("图片文件: %d个，已知元数据%d个（共%.1f MB），等待提取%d个\n",
+               image_count, known, total_bytes / (1024.0 * 1024.0), pending);
     }
     
     // 创建图片显示容器（缩小尺寸，为按钮留出空间，避免与返回按钮重叠）
@@ -122,6 +215,16 @@ void show_images(void) {
     lv_obj_center(next_label);
     lv_obj_add_event_cb(next_btn, next_image_cb, LV_EVENT_CLICKED, NULL);
     
+    // 缩略图按钮（打开网格视图）
+    lv_obj_t *gallery_btn = lv_btn_create(btn_container);
+    lv_obj_set_size(gallery_btn, 100, 60);
+    lv_obj_set_style_bg_color(gallery_btn, lv_color_hex(0xFF9800), 0);
+    lv_obj_t *gallery_label = lv_label_create(gallery_btn);
+    lv_label_set_text(gallery_label, "缩略图");
+    lv_obj_set_style_text_font(gallery_label, &SourceHanSansSC_VF, 0);
+    lv_obj_center(gallery_label);
+    lv_obj_add_event_cb(gallery_btn, gallery_btn_cb, LV_EVENT_CLICKED, NULL);
+    
     // 显示当前图片
     current_img_index = 0;
     show_current_image();
@@ -145,13 +248,18 @@ void show_current_image(void) {
         return;
     }
     
+    double start_ms = viewer_now_ms();
+    
     // 检查文件是否存在
     struct stat st;
     const char *file_path = image_files[current_img_index];
     if (stat(file_path, &st) != 0) {
         printf("错误: 图片文件不存在: %s\n", file_path);
-        if (current_img_obj != NULL && !is_gif_obj) {
+        if (current_img_obj != NULL && lv_obj_check_type(current_img_obj, &lv_canvas_class)) {
+            // canvas可能正在使用缓存的缓冲区，换回canvas_buf再清空
+            lv_canvas_set_buffer(current_img_obj, canvas_buf, 680, 280, LV_IMG_CF_TRUE_COLOR_ALPHA);
             lv_canvas_fill_bg(current_img_obj, lv_color_hex(0xFFFFFF), LV_OPA_COVER);
+            image_cache_release();
         }
         if (img_info_label) {
             char info[100];
@@ -164,14 +272,17 @@ void show_current_image(void) {
     printf("加载图片[%d]: %s\n", current_img_index, file_path);
     
     // 判断文件类型并加载
-    const char *ext = strrchr(file_path, '.');
-    bool need_gif = (ext != NULL && strcmp(ext, ".gif") == 0);
+    bool need_gif = is_gif_path(file_path);
+    bool cache_hit = false;
     
-    // 总是删除旧对象并重新创建，确保GIF正确显示
-    if (current_img_obj != NULL) {
+    // 静态图片之间切换时复用canvas，只切换缓冲区；涉及GIF时删除旧对象并重新创建，确保GIF正确显示
+    bool reuse_canvas = !need_gif && current_img_obj != NULL &&
+                        lv_obj_check_type(current_img_obj, &lv_canvas_class);
+    if (current_img_obj != NULL && !reuse_canvas) {
         lv_obj_del(current_img_obj);
         current_img_obj = NULL;
         is_gif_obj = false;
+        image_cache_release();
         
         lv_obj_invalidate(img_container);
         
@@ -264,8 +375,12 @@ void show_current_image(void) {
         }
         
         printf("GIF图片加载完成: %s\n", file_path);
+    } else if (reuse_canvas) {
+        if (show_still_on_canvas(current_img_obj, file_path, &cache_hit) != 0) {
+            printf("图片加载失败: %s\n", file_path);
+        }
     } else {
-        // BMP使用canvas手动绘制
+        // BMP/JPEG/PNG使用canvas手动绘制
         memset(canvas_buf, 0, sizeof(canvas_buf));
         
         current_img_obj = lv_canvas_create(img_container);
@@ -278,173 +393,85 @@ void show_current_image(void) {
         lv_obj_align(current_img_obj, LV_ALIGN_CENTER, 0, 0);
         is_gif_obj = false;
         
-        // 为canvas分配缓冲区
-        lv_canvas_set_buffer(current_img_obj, canvas_buf, 680, 280, LV_IMG_CF_TRUE_COLOR_ALPHA);
-        lv_canvas_fill_bg(current_img_obj, lv_color_hex(0xFFFFFF), LV_OPA_COVER);
-        
-        // 加载BMP到canvas
-        if (load_bmp_to_canvas(current_img_obj, file_path) != 0) {
-            printf("BMP图片加载失败: %s\n", file_path);
-            lv_canvas_fill_bg(current_img_obj, lv_color_hex(0xFFFFFF), LV_OPA_COVER);
+        // 加载图片到canvas
+        if (show_still_on_canvas(current_img_obj, file_path, &cache_hit) != 0) {
+            printf("图片加载失败: %s\n", file_path);
         } else {
-            printf("BMP图片加载成功: %s\n", file_path);
+            printf("图片加载成功: %s\n", file_path);
         }
     }
     
-    // 更新信息标签
+    // 更新信息标签（有元数据时显示原图尺寸，GIF显示帧数）
     if (img_info_label) {
-        char info[200];
+        char info[240];
+        char detail[48] = "";
+        media_info_t meta;
+        if (media_catalog_lookup(file_path, &meta) == MEDIA_INFO_READY && meta.width > 0) {
+            if (meta.frames > 1) {
+                snprintf(detail, sizeof(detail), " %ux%u %u帧", meta.width, meta.height, meta.frames);
+            } else {
+                snprintf(detail, sizeof(detail), " %ux%u", meta.width, meta.height);
+            }
+        }
         if (image_names != NULL && image_names[current_img_index] != NULL) {
-            snprintf(info, sizeof(info), "%s (%d/%d)\n%s", 
+            snprintf(info, sizeof(info), "%s (%d/%d)%s\n%s", 
                      image_names[current_img_index], 
                      current_img_index + 1, 
                      image_count,
+                     detail,
                      file_path);
         } else {
-            snprintf(info, sizeof(info), "图片 %d/%d\n%s", 
+            snprintf(info, sizeof(info), "图片 %d/%d%s\n%s", 
                      current_img_index + 1, 
                      image_count,
+                     detail,
                      file_path);
         }
         lv_label_set_text(img_info_label, info);
     }
+    
+    // 预取相邻图片，下次翻页直接命中缓存
+    prefetch_neighbours(current_img_index);
+    
+    image_cache_stats_t stats;
+    image_cache_get_stats(&stats);
+    printf("[图片缓存] 切换耗时 %.2f ms (%s)，命中%u 等待%u 未命中%u 预取%u 淘汰%u\n",
+           viewer_now_ms() - start_ms, need_gif ? "GIF" : (cache_hit ? "命中" : "解码"),
+           stats.hits, stats.waits, stats.misses, stats.prefetched, stats.evictions);
 }
 
 /**
- * @brief 加载BMP图片到Canvas
+ * @brief 加载静态图片（BMP/JPEG/PNG）到Canvas
  */
 int load_bmp_to_canvas(lv_obj_t *canvas, const char *bmp_path) {
     if (canvas == NULL || bmp_path == NULL) {
         return -1;
     }
     
-    // 打开BMP文件
-    int bmp_fd = open(bmp_path, O_RDONLY);
-    if (bmp_fd == -1) {
-        printf("无法打开图片: %s\n", bmp_path);
-        perror("详细原因");
-        return -1;
-    }
-    
-    // 读取文件头
-    struct bmp_header header;
-    if (read(bmp_fd, &header, sizeof(header)) != sizeof(header)) {
-        printf("读取BMP头失败: %s\n", bmp_path);
-        perror("详细原因");
-        close(bmp_fd);
-        return -1;
-    }
-    
-    // 验证签名
-    if (header.signature != 0x4D42) {
-        printf("无效的BMP文件签名: 0x%X\n", header.signature);
-        close(bmp_fd);
-        return -1;
-    }
-    
-    // 读取信息头
-    struct bmp_info_header info_header;
-    if (read(bmp_fd, &info_header, sizeof(info_header)) != sizeof(info_header)) {
-        printf("读取BMP信息头失败\n");
-        close(bmp_fd);
-        return -1;
-    }
-    
-    // 格式验证
-    if (info_header.bpp != 24) {
-        printf("只支持24位BMP图片 (当前: %d bpp)\n", info_header.bpp);
-        close(bmp_fd);
-        return -1;
-    }
-    
-    if (info_header.compression != 0) {
-        printf("不支持压缩的BMP图片\n");
-        close(bmp_fd);
-        return -1;
-    }
-    
-    // 定位像素数据
-    lseek(bmp_fd, header.data_offset, SEEK_SET);
-    
-    int img_width = info_header.width;
-    int img_height = abs(info_header.height);
-    int row_size = ((img_width * 3 + 3) / 4) * 4;  // BMP行对齐到4字节
-    
-    printf("BMP信息: %dx%d, bpp=%d, row_size=%d\n", img_width, img_height, info_header.bpp, row_size);
-    
-    // 读取像素数据
-    unsigned char *bmp_buf = (unsigned char *)malloc(row_size * img_height);
-    if (!bmp_buf) {
-        printf("内存分配失败\n");
-        close(bmp_fd);
-        return -1;
-    }
-    
-    ssize_t bytes_read = read(bmp_fd, bmp_buf, row_size * img_height);
-    close(bmp_fd);
-    
-    if (bytes_read != (ssize_t)(row_size * img_height)) {
-        printf("图片读取不完整: %zd/%d 字节\n", bytes_read, row_size * img_height);
-        free(bmp_buf);
-        return -1;
-    }
-    
-    // 清空canvas
-    lv_canvas_fill_bg(canvas, lv_color_hex(0xFFFFFF), LV_OPA_COVER);
-    
-    // 获取canvas尺寸
     lv_img_dsc_t *canvas_dsc = lv_canvas_get_img(canvas);
     int canvas_width = canvas_dsc->header.w;
     int canvas_height = canvas_dsc->header.h;
-    
-    // 计算缩放和居中位置
-    float scale_x = (float)canvas_width / img_width;
-    float scale_y = (float)canvas_height / img_height;
-    float scale = (scale_x < scale_y) ? scale_x : scale_y;  // 保持宽高比
-    
-    int scaled_width = (int)(img_width * scale);
-    int scaled_height = (int)(img_height * scale);
-    int x_offset = (canvas_width - scaled_width) / 2;
-    int y_offset = (canvas_height - scaled_height) / 2;
-    
-    printf("缩放: %.2f, 显示尺寸: %dx%d, 偏移: (%d, %d)\n", 
-           (double)scale, scaled_width, scaled_height, x_offset, y_offset);
-    
-    // 转换并绘制像素
-    for (int y = 0; y < scaled_height; y++) {
-        for (int x = 0; x < scaled_width; x++) {
-            // 计算源图片坐标
-            int src_x = (int)(x / scale);
-            int src_y = (int)(y / scale);
-            
-            // BMP数据是从下往上存储的
-            int bmp_y = info_header.height > 0 ? (img_height - src_y - 1) : src_y;
-            int src_pos = bmp_y * row_size + src_x * 3;
-            
-            if (src_pos < 0 || src_pos >= row_size * img_height) {
-                continue;
-            }
-            
-            // 读取BGR数据（BMP格式是BGR）
-            uint8_t b = bmp_buf[src_pos];
-            uint8_t g = bmp_buf[src_pos + 1];
-            uint8_t r = bmp_buf[src_pos + 2];
-            
-            // 转换为LVGL颜色格式（ARGB8888）
-            lv_color_t color = lv_color_make(r, g, b);
-            
-            // 绘制到canvas
-            int canvas_x = x_offset + x;
-            int canvas_y = y_offset + y;
-            
-            if (canvas_x >= 0 && canvas_x < canvas_width && 
-                canvas_y >= 0 && canvas_y < canvas_height) {
-                lv_canvas_set_px_color(canvas, canvas_x, canvas_y, color);
+    lv_img_cf_t cf = canvas_dsc->header.cf;
+    int ret;
+    if (sizeof(lv_color_t) == 4 && (cf == LV_IMG_CF_TRUE_COLOR || cf == LV_IMG_CF_TRUE_COLOR_ALPHA)) {
+        // 32位色深下lv_color_t即0xAARRGGBB，按行缩放直接写入canvas缓冲区，整块写入后只刷新一次
+        ret = image_decode_fit(bmp_path, (uint32_t *)canvas_dsc->data, canvas_width, canvas_height,
+                               IMAGE_VIEWER_SCALE_MODE);
+    } else {
+        // 其他格式：缩放到临时缓冲区再逐像素转换
+        uint32_t *scaled = (uint32_t *)malloc((size_t)canvas_width * canvas_height * sizeof(uint32_t));
+        ret = scaled ? image_decode_fit(bmp_path, scaled, canvas_width, canvas_height,
+                                        IMAGE_VIEWER_SCALE_MODE) : -1;
+        for (int y = 0; ret == 0 && y < canvas_height; y++) {
+            for (int x = 0; x < canvas_width; x++) {
+                lv_img_buf_set_px_color(canvas_dsc, x, y, lv_color_hex(scaled[y * canvas_width + x]));
             }
         }
+        free(scaled);
+    }
+    if (ret != 0) {
+        return -1;
     }
-    
-    free(bmp_buf);
     
     // 刷新canvas显示
     lv_obj_invalidate(canvas);
@@ -486,6 +513,25 @@ static void next_image_cb(lv_event_t * e) {
     show_current_image();
 }
 
+/**
+ * @brief 网格中点击缩略图：显示该图片
+ */
+static void gallery_select_cb(int index) {
+    if (index < 0 || index >= image_count) return;
+    current_img_index = index;
+    printf("从缩略图打开图片，索引: %d\n", current_img_index);
+    show_current_image();
+}
+
+/**
+ * @brief 缩略图按钮回调
+ */
+static void gallery_btn_cb(lv_event_t * e) {
+    (void)e;
+    if (image_count == 0 || image_files == NULL) return;
+    gallery_view_show(image_screen, gallery_select_cb);
+}
+
 // Getter/Setter函数实现
 int get_current_image_index(void) {
     return current_img_index;
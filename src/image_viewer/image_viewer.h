@@ -20,9 +20,9 @@ void show_images(void);
 void show_current_image(void);
 
 /**
- * @brief 加载BMP图片到Canvas
+ * @brief 加载静态图片到Canvas（按扩展名选择BMP/JPEG/PNG解码器，按比例缩放居中）
  * @param canvas Canvas对象
- * @param bmp_path BMP文件路径
+ * @param bmp_path 图片文件路径
  * @return 成功返回0，失败返回-1
  */
 int load_bmp_to_canvas(lv_obj_t *canvas, const char *bmp_path);
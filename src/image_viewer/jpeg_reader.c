@@ -0,0 +1,189 @@
+/**
+ * @file jpeg_reader.c
+ * @brief JPEG流式读取实现
+ */
+
+#include "jpeg_reader.h"
+#include "image_decoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+// TJpgDec错误码说明（用于日志）
+static const char *jpeg_error_name(JRESULT rc) {
+    switch (rc) {
+    case JDR_INP:
+        return "文件不完整";
+    case JDR_MEM1:
+    case JDR_MEM2:
+        return "工作内存不足";
+    case JDR_FMT1:
+        return "数据损坏";
+    case JDR_FMT2:
+        return "不支持的格式";
+    case JDR_FMT3:
+        return "不支持的JPEG类型（渐进式、CMYK或特殊采样）";
+    default:
+        return "解码失败";
+    }
+}
+
+// TJpgDec输入函数：从映射中顺序读取，buf为NULL时跳过
+static size_t jpeg_input(JDEC *jd, uint8_t *buf, size_t n) {
+    jpeg_reader_t *reader = (jpeg_reader_t *)jd->device;
+    size_t left = reader->map_len - reader->pos;
+    if (n > left) {
+        n = left;
+    }
+    if (buf) {
+        memcpy(buf, reader->map + reader->pos, n);
+    }
+    reader->pos += n;
+    return n;
+}
+
+// TJpgDec输出函数：把一个MCU（RGB）写入当前MCU行缓冲区（BGR）
+static int jpeg_output(JDEC *jd, void *bitmap, JRECT *rect) {
+    jpeg_reader_t *reader = (jpeg_reader_t *)jd->device;
+    const uint8_t *p = (const uint8_t *)bitmap;
+    int w = rect->right - rect->left + 1;
+    for (int y = rect->top; y <= rect->bottom; y++) {
+        uint8_t *out = reader->band + ((size_t)(y - reader->band_top) * reader->width + rect->left) * 3;
+        for (int x = 0; x < w; x++, p += 3, out += 3) {
+            out[0] = p[2];
+            out[1] = p[1];
+            out[2] = p[0];
+        }
+    }
+    return 1;
+}
+
+// 解码下一个MCU行
+static void jpeg_next_band(jpeg_reader_t *reader) {
+    size_t row_bytes = (size_t)reader->width * 3;
+    memcpy(reader->prev_row, reader->band + (size_t)(reader->band_rows - 1) * row_bytes, row_bytes);
+    reader->band_top += reader->band_rows;
+    if (reader->failed) {
+        return;
+    }
+    JRESULT rc = jd_decomp_mcurow(&reader->jd, jpeg_output);
+    if (rc != JDR_OK) {
+        // 文件损坏：剩下的行显示为白色
+        printf("[JPEG] 第%d行解码失败: %s\n", reader->band_top, jpeg_error_name(rc));
+        memset(reader->band, 0xFF, row_bytes * reader->band_rows);
+        reader->failed = true;
+    }
+}
+
+// image_scale_row_fn适配：按需逐个MCU行解码
+static const uint8_t *jpeg_row_fn(void *ctx, int y, uint8_t *scratch) {
+    (void)scratch;
+    jpeg_reader_t *reader = (jpeg_reader_t *)ctx;
+    if (y < reader->band_top) {
+        return reader->prev_row;
+    }
+    while (y >= reader->band_top + reader->band_rows) {
+        jpeg_next_band(reader);
+    }
+    return reader->band + (size_t)(y - reader->band_top) * reader->width * 3;
+}
+
+// 选择解码缩小比例：解码后仍不小于按比例缩放到目标尺寸后的大小
+static int jpeg_pick_scale(int w, int h, int max_w, int max_h) {
+    if (max_w <= 0 || max_h <= 0) {
+        return 0;
+    }
+    int64_t fit_w = max_w;
+    int64_t fit_h = max_h;
+    if ((int64_t)w * max_h > (int64_t)h * max_w) {
+        fit_h = (int64_t)h * max_w / w;
+    } else {
+        fit_w = (int64_t)w * max_h / h;
+    }
+    int scale = 0;
+    while (scale < 3 && (w >> (scale + 1)) >= fit_w && (h >> (scale + 1)) >= fit_h) {
+        scale++;
+    }
+    return scale;
+}
+
+int jpeg_reader_open(jpeg_reader_t *reader, const char *path, int max_w, int max_h) {
+    memset(reader, 0, sizeof(*reader));
+    if (image_map_file(path, "[JPEG]", &reader->map, &reader->map_len) != 0) {
+        return -1;
+    }
+
+    JRESULT rc = jd_prepare(&reader->jd, jpeg_input, reader->pool, sizeof(reader->pool), reader);
+    if (rc != JDR_OK) {
+        printf("[JPEG] 无法解析文件头: %s (%s)\n", path, jpeg_error_name(rc));
+        jpeg_reader_close(reader);
+        return -1;
+    }
+    reader->src_width = reader->jd.width;
+    reader->src_height = reader->jd.height;
+    reader->scale = jpeg_pick_scale(reader->src_width, reader->src_height, max_w, max_h);
+    reader->width = reader->src_width >> reader->scale;
+    reader->height = reader->src_height >> reader->scale;
+    reader->band_rows = (reader->jd.msy * 8) >> reader->scale;
+    if (reader->width <= 0 || reader->height <= 0 || reader->band_rows <= 0) {
+        printf("[JPEG] 图片尺寸无效: %dx%d\n", reader->src_width, reader->src_height);
+        jpeg_reader_close(reader);
+        return -1;
+    }
+
+    size_t row_bytes = (size_t)reader->width * 3;
+    reader->band = (uint8_t *)malloc(row_bytes * (reader->band_rows + 1));
+    if (!reader->band) {
+        printf("[JPEG] 内存分配失败\n");
+        jpeg_reader_close(reader);
+        return -1;
+    }
+    reader->prev_row = reader->band + row_bytes * reader->band_rows;
+    memset(reader->band, 0xFF, row_bytes * (reader->band_rows + 1));
+    reader->band_top = -reader->band_rows;     // 第一次取行时解码第0个MCU行
+    jd_decomp_start(&reader->jd, (uint8_t)reader->scale);
+    return 0;
+}
+
+void jpeg_reader_scale_src(jpeg_reader_t *reader, image_scale_src_t *src) {
+    memset(src, 0, sizeof(*src));
+    src->width = reader->width;
+    src->height = reader->height;
+    src->row_fn = jpeg_row_fn;
+    src->row_ctx = reader;
+}
+
+int jpeg_decode_fit(const char *path, uint32_t *dst, int dst_w, int dst_h, image_scale_mode_t mode) {
+    jpeg_reader_t *jpeg = (jpeg_reader_t *)malloc(sizeof(jpeg_reader_t));
+    if (!jpeg) {
+        return -1;
+    }
+    if (jpeg_reader_open(jpeg, path, dst_w, dst_h) != 0) {
+        free(jpeg);
+        return -1;
+    }
+    printf("JPEG信息: %dx%d, 解码缩小1/%d -> %dx%d\n", jpeg->src_width, jpeg->src_height,
+           1 << jpeg->scale, jpeg->width, jpeg->height);
+
+    image_scale_src_t src;
+    jpeg_reader_scale_src(jpeg, &src);
+    int ret = image_scale_fit(&src, dst, dst_w, dst_h, mode);
+    if (ret != 0) {
+        printf("JPEG缩放失败（内存不足）\n");
+    }
+    jpeg_reader_close(jpeg);
+    free(jpeg);
+    return ret;
+}
+
+void jpeg_reader_close(jpeg_reader_t *reader) {
+    free(reader->band);
+    reader->band = NULL;
+    reader->prev_row = NULL;
+    if (reader->map) {
+        munmap((void *)reader->map, reader->map_len);
+    }
+    reader->map = NULL;
+    reader->map_len = 0;
+}
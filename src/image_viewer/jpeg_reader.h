@@ -0,0 +1,84 @@
+/**
+ * @file jpeg_reader.h
+ * @brief JPEG流式读取：TJpgDec按MCU行解码，解码时直接缩小1/2、1/4或1/8
+ *
+ * LVGL的sjpg解码器把整张JPEG解码到内存（lv_mem内存池），大照片放不下也很慢。
+ * 这里直接使用TJpgDec：
+ *   - 文件mmap映射为只读，解码器按顺序读取
+ *   - 打开时根据目标尺寸选择TJpgDec内置的缩小比例（1/1、1/2、1/4、1/8），
+ *     取不小于目标尺寸的最小解码尺寸，再交给image_scaler缩放到目标尺寸
+ *   - 只保存一个MCU行（解码后8或16行以内）和上一个MCU行的最后一行，
+ *     缩放按行号顺序取行时逐个MCU行解码
+ * 内存只和解码后的宽度有关（最多约48KB），不需要LVGL内存池，可以在后台线程中调用。
+ *
+ * 不支持渐进式、CMYK和4:1:1等特殊采样的JPEG（TJpgDec限制），打开时失败。
+ * 文件不完整或数据损坏时，已解码的部分正常显示，其余为白色。
+ */
+
+#ifndef JPEG_READER_H
+#define JPEG_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "image_scaler.h"
+#include "lvgl/src/extra/libs/sjpg/tjpgd.h"
+
+#define JPEG_POOL_SIZE 4096                     // TJpgDec工作内存（LVGL sjpg使用相同大小）
+
+// 一个打开的JPEG文件
+typedef struct {
+    const uint8_t *map;             // 文件映射
+    size_t map_len;
+    size_t pos;                     // 解码器读取位置
+    JDEC jd;
+    uint8_t pool[JPEG_POOL_SIZE];
+    int src_width;                  // 原图尺寸
+    int src_height;
+    int scale;                      // 解码缩小比例（1/2^scale）
+    int width;                      // 解码后的尺寸
+    int height;
+    int band_rows;                  // 一个MCU行解码后的像素行数
+    int band_top;                   // band第一行的行号
+    uint8_t *band;                  // 当前MCU行（24位BGR，width*band_rows*3字节）
+    uint8_t *prev_row;              // 上一个MCU行的最后一行（双线性跨MCU行时使用）
+    bool failed;                    // 解码中途出错（之后的行为白色）
+} jpeg_reader_t;
+
+/**
+ * @brief 打开JPEG文件，读取文件头并选择解码缩小比例
+ * @param reader 输出的读取器
+ * @param path 文件路径
+ * @param max_w 目标宽度（按比例缩放后不超过此尺寸，0表示按原尺寸解码）
+ * @param max_h 目标高度
+ * @return 成功返回0，失败返回-1（已打印原因）
+ */
+int jpeg_reader_open(jpeg_reader_t *reader, const char *path, int max_w, int max_h);
+
+/**
+ * @brief 填充缩放源描述（行号必须单调不减，最多回退一行）
+ * @param reader 读取器（缩放完成前不能关闭）
+ * @param src 输出的源描述
+ */
+void jpeg_reader_scale_src(jpeg_reader_t *reader, image_scale_src_t *src);
+
+/**
+ * @brief 把JPEG文件按比例缩放、居中写入一块32位缓冲区，图片以外的边框填白色
+ *
+ * 不依赖LVGL，可以在后台线程中调用。
+ * @param path 文件路径
+ * @param dst 目标缓冲区（0xAARRGGBB，dst_w*dst_h个像素，行间无填充）
+ * @param dst_w 目标宽度
+ * @param dst_h 目标高度
+ * @param mode 缩放方式
+ * @return 成功返回0，失败返回-1（dst内容未定义）
+ */
+int jpeg_decode_fit(const char *path, uint32_t *dst, int dst_w, int dst_h, image_scale_mode_t mode);
+
+/**
+ * @brief 关闭读取器（释放行缓冲区，解除映射）
+ * @param reader 读取器
+ */
+void jpeg_reader_close(jpeg_reader_t *reader);
+
+#endif /* JPEG_READER_H */
@@ -0,0 +1,726 @@
+/**
+ * @file png_reader.c
+ * @brief PNG流式读取实现
+ */
+
+#include "png_reader.h"
+#include "image_decoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define PNG_SIGNATURE_SIZE 8
+#define PNG_CHUNK_OVERHEAD 12                   // 长度、类型、CRC
+#define PNG_WINDOW_SIZE 32768                   // deflate窗口
+#define PNG_WINDOW_MASK (PNG_WINDOW_SIZE - 1)
+#define PNG_FAST_BITS 9                         // 哈夫曼快速查找表位数
+#define PNG_FAST_MASK ((1 << PNG_FAST_BITS) - 1)
+#define PNG_MAX_PAD 4                           // 数据结束后允许补0的字节数（预读）
+
+static const uint8_t png_signature[PNG_SIGNATURE_SIZE] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+// 长度码和距离码的基数、额外位数（RFC 1951）
+static const uint16_t length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+static const uint8_t length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+// 码长码的顺序
+static const uint8_t codelen_order[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15,
+};
+
+// 规范哈夫曼表：码长不超过PNG_FAST_BITS的直接查表，其余按码长逐级比较
+typedef struct {
+    uint16_t fast[1 << PNG_FAST_BITS];          // (码长<<9)|符号，0表示需要慢速查找
+    uint16_t first_code[16];
+    int max_code[17];                           // 左对齐到16位
+    uint16_t first_symbol[16];
+    uint8_t size[288];
+    uint16_t value[288];
+} png_huffman_t;
+
+typedef enum {
+    Z_BLOCK_HEADER = 0,                         // 读下一个块头
+    Z_STORED,                                   // 未压缩块
+    Z_HUFFMAN,                                  // 压缩块
+} z_state_t;
+
+struct png_inflate {
+    uint32_t bits;                              // 位缓冲（低位先出）
+    int bit_count;
+    int pad;                                    // 数据结束后补0的字节数
+    z_state_t state;
+    bool final;                                 // 当前块是最后一块
+    uint32_t stored_left;
+    int match_len;                              // 未复制完的匹配
+    int match_dist;
+    uint32_t out_total;                         // 已输出字节数（窗口写入位置）
+    png_huffman_t lit;
+    png_huffman_t dist;
+    uint8_t window[PNG_WINDOW_SIZE];
+};
+
+static uint32_t rd32be(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static int bit_reverse(int v, int bits) {
+    v = ((v & 0xAAAA) >> 1) | ((v & 0x5555) << 1);
+    v = ((v & 0xCCCC) >> 2) | ((v & 0x3333) << 2);
+    v = ((v & 0xF0F0) >> 4) | ((v & 0x0F0F) << 4);
+    v = ((v & 0xFF00) >> 8) | ((v & 0x00FF) << 8);
+    return v >> (16 - bits);
+}
+
+// 按码长表构造哈夫曼表，码长不合法返回-1
+static int huffman_build(png_huffman_t *h, const uint8_t *lengths, int count) {
+    int sizes[17] = { 0 };
+    int next_code[16];
+    memset(h->fast, 0, sizeof(h->fast));
+    for (int i = 0; i < count; i++) {
+        sizes[lengths[i]]++;
+    }
+    sizes[0] = 0;
+    int code = 0;
+    int k = 0;
+    for (int i = 1; i < 16; i++) {
+        if (sizes[i] > (1 << i)) {
+            return -1;
+        }
+        next_code[i] = code;
+        h->first_code[i] = (uint16_t)code;
+        h->first_symbol[i] = (uint16_t)k;
+        code += sizes[i];
+        if (sizes[i] && code - 1 >= (1 << i)) {
+            return -1;
+        }
+        h->max_code[i] = code << (16 - i);
+        code <<= 1;
+        k += sizes[i];
+    }
+    h->max_code[16] = 0x10000;
+    for (int i = 0; i < count; i++) {
+        int s = lengths[i];
+        if (!s) {
+            continue;
+        }
+        int c = next_code[s] - h->first_code[s] + h->first_symbol[s];
+        h->size[c] = (uint8_t)s;
+        h->value[c] = (uint16_t)i;
+        if (s <= PNG_FAST_BITS) {
+            uint16_t fast = (uint16_t)((s << 9) | i);
+            for (int j = bit_reverse(next_code[s], s); j < (1 << PNG_FAST_BITS); j += 1 << s) {
+                h->fast[j] = fast;
+            }
+        }
+        next_code[s]++;
+    }
+    return 0;
+}
+
+// 取IDAT数据的下一个字节，所有IDAT块读完后返回-1
+static int png_next_byte(png_reader_t *reader) {
+    while (reader->chunk_left == 0) {
+        // 跳过CRC，进入下一个块；IDAT块必须连续
+        size_t pos = reader->chunk_pos + 4;
+        if (pos + 8 > reader->map_len || memcmp(reader->map + pos + 4, "IDAT", 4) != 0) {
+            return -1;
+        }
+        uint32_t len = rd32be(reader->map + pos);
+        pos += 8;
+        if (len > reader->map_len - pos) {
+            len = (uint32_t)(reader->map_len - pos);
+        }
+        reader->chunk_pos = pos;
+        reader->chunk_left = len;
+    }
+    reader->chunk_left--;
+    return reader->map[reader->chunk_pos++];
+}
+
+static void fill_bits(png_reader_t *reader) {
+    struct png_inflate *z = reader->z;
+    while (z->bit_count <= 24) {
+        int c = png_next_byte(reader);
+        if (c < 0) {
+            c = 0;
+            z->pad++;
+        }
+        z->bits |= (uint32_t)c << z->bit_count;
+        z->bit_count += 8;
+    }
+}
+
+static uint32_t get_bits(png_reader_t *reader, int n) {
+    struct png_inflate *z = reader->z;
+    if (z->bit_count < n) {
+        fill_bits(reader);
+    }
+    uint32_t v = z->bits & ((1u << n) - 1);
+    z->bits >>= n;
+    z->bit_count -= n;
+    return v;
+}
+
+// 解码一个哈夫曼符号，数据错误返回-1
+static int huffman_decode(png_reader_t *reader, const png_huffman_t *h) {
+    struct png_inflate *z = reader->z;
+    if (z->bit_count < 16) {
+        fill_bits(reader);
+    }
+    int b = h->fast[z->bits & PNG_FAST_MASK];
+    int s;
+    if (b) {
+        s = b >> 9;
+        z->bits >>= s;
+        z->bit_count -= s;
+        return b & 511;
+    }
+    int k = bit_reverse((int)(z->bits & 0xFFFF), 16);
+    for (s = PNG_FAST_BITS + 1; k >= h->max_code[s]; s++) {
+    }
+    if (s >= 16) {
+        return -1;
+    }
+    b = (k >> (16 - s)) - h->first_code[s] + h->first_symbol[s];
+    if (b >= 288 || h->size[b] != s) {
+        return -1;
+    }
+    z->bits >>= s;
+    z->bit_count -= s;
+    return h->value[b];
+}
+
+static int build_fixed_tables(struct png_inflate *z) {
+    uint8_t lengths[288];
+    memset(lengths, 8, 144);
+    memset(lengths + 144, 9, 112);
+    memset(lengths + 256, 7, 24);
+    memset(lengths + 280, 8, 8);
+    if (huffman_build(&z->lit, lengths, 288) != 0) {
+        return -1;
+    }
+    memset(lengths, 5, 32);
+    return huffman_build(&z->dist, lengths, 32);
+}
+
+static int read_dynamic_tables(png_reader_t *reader) {
+    struct png_inflate *z = reader->z;
+    int hlit = (int)get_bits(reader, 5) + 257;
+    int hdist = (int)get_bits(reader, 5) + 1;
+    int hclen = (int)get_bits(reader, 4) + 4;
+    uint8_t lengths[286 + 32];
+    uint8_t codelen_lengths[19];
+    memset(codelen_lengths, 0, sizeof(codelen_lengths));
+    for (int i = 0; i < hclen; i++) {
+        codelen_lengths[codelen_order[i]] = (uint8_t)get_bits(reader, 3);
+    }
+    // 码长码表临时放在dist表中
+    if (hlit > 286 || huffman_build(&z->dist, codelen_lengths, 19) != 0) {
+        return -1;
+    }
+    int n = 0;
+    while (n < hlit + hdist) {
+        int c = huffman_decode(reader, &z->dist);
+        if (c < 0 || c > 18) {
+            return -1;
+        }
+        int rep = 1;
+        uint8_t fill = (uint8_t)c;
+        if (c == 16) {
+            if (n == 0) {
+                return -1;
+            }
+            rep = 3 + (int)get_bits(reader, 2);
+            fill = lengths[n - 1];
+        } else if (c == 17) {
+            rep = 3 + (int)get_bits(reader, 3);
+            fill = 0;
+        } else if (c == 18) {
+            rep = 11 + (int)get_bits(reader, 7);
+            fill = 0;
+        }
+        if (n + rep > hlit + hdist) {
+            return -1;
+        }
+        memset(lengths + n, fill, rep);
+        n += rep;
+    }
+    if (lengths[256] == 0 || huffman_build(&z->lit, lengths, hlit) != 0) {
+        return -1;
+    }
+    return huffman_build(&z->dist, lengths + hlit, hdist);
+}
+
+static int read_block_header(png_reader_t *reader) {
+    struct png_inflate *z = reader->z;
+    if (z->final) {
+        return -1;                              // 最后一块已结束，数据不够
+    }
+    z->final = get_bits(reader, 1) != 0;
+    switch (get_bits(reader, 2)) {
+    case 0: {
+        // 未压缩块：丢弃到字节边界，读长度
+        get_bits(reader, z->bit_count & 7);
+        uint32_t len = get_bits(reader, 16);
+        uint32_t nlen = get_bits(reader, 16);
+        if ((len ^ 0xFFFF) != nlen) {
+            return -1;
+        }
+        z->stored_left = len;
+        z->state = Z_STORED;
+        return 0;
+    }
+    case 1:
+        z->state = Z_HUFFMAN;
+        return build_fixed_tables(z);
+    case 2:
+        z->state = Z_HUFFMAN;
+        return read_dynamic_tables(reader);
+    default:
+        return -1;
+    }
+}
+
+static inline void put_byte(struct png_inflate *z, uint8_t **out, uint8_t c) {
+    z->window[z->out_total++ & PNG_WINDOW_MASK] = c;
+    *(*out)++ = c;
+}
+
+// 解压出正好n个字节，数据错误或提前结束返回-1
+static int inflate_read(png_reader_t *reader, uint8_t *out, size_t n) {
+    struct png_inflate *z = reader->z;
+    uint8_t *end = out + n;
+    while (out < end) {
+        if (z->match_len > 0) {
+            int len = z->match_len;
+            if (len > end - out) {
+                len = (int)(end - out);
+            }
+            z->match_len -= len;
+            for (int i = 0; i < len; i++) {
+                put_byte(z, &out, z->window[(z->out_total - z->match_dist) & PNG_WINDOW_MASK]);
+            }
+            continue;
+        }
+        if (z->state == Z_BLOCK_HEADER) {
+            if (read_block_header(reader) != 0) {
+                return -1;
+            }
+        } else if (z->state == Z_STORED) {
+            if (z->stored_left == 0) {
+                z->state = Z_BLOCK_HEADER;
+                continue;
+            }
+            put_byte(z, &out, (uint8_t)get_bits(reader, 8));
+            z->stored_left--;
+        } else {
+            int sym = huffman_decode(reader, &z->lit);
+            if (sym < 0) {
+                return -1;
+            }
+            if (sym < 256) {
+                put_byte(z, &out, (uint8_t)sym);
+                continue;
+            }
+            if (sym == 256) {
+                z->state = Z_BLOCK_HEADER;
+                continue;
+            }
+            sym -= 257;
+            if (sym >= 29) {
+                return -1;
+            }
+            int len = length_base[sym] + (int)get_bits(reader, length_extra[sym]);
+            int dsym = huffman_decode(reader, &z->dist);
+            if (dsym < 0 || dsym >= 30) {
+                return -1;
+            }
+            int dist = dist_base[dsym] + (int)get_bits(reader, dist_extra[dsym]);
+            if ((uint32_t)dist > z->out_total) {
+                return -1;
+            }
+            z->match_len = len;
+            z->match_dist = dist;
+        }
+        if (z->pad > PNG_MAX_PAD) {
+            return -1;                          // 已经读到数据结束以后
+        }
+    }
+    return 0;
+}
+
+static uint8_t paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return (uint8_t)a;
+    }
+    return (uint8_t)(pb <= pc ? b : c);
+}
+
+// 反滤波（cur和prev的第一个字节是滤波类型）
+static int unfilter(uint8_t *cur, const uint8_t *prev, size_t n, int bpp) {
+    uint8_t *x = cur + 1;
+    const uint8_t *up = prev + 1;
+    switch (cur[0]) {
+    case 0:
+        break;
+    case 1:
+        for (size_t i = bpp; i < n; i++) {
+            x[i] = (uint8_t)(x[i] + x[i - bpp]);
+        }
+        break;
+    case 2:
+        for (size_t i = 0; i < n; i++) {
+            x[i] = (uint8_t)(x[i] + up[i]);
+        }
+        break;
+    case 3:
+        for (size_t i = 0; i < (size_t)bpp && i < n; i++) {
+            x[i] = (uint8_t)(x[i] + (up[i] >> 1));
+        }
+        for (size_t i = bpp; i < n; i++) {
+            x[i] = (uint8_t)(x[i] + ((x[i - bpp] + up[i]) >> 1));
+        }
+        break;
+    case 4:
+        for (size_t i = 0; i < (size_t)bpp && i < n; i++) {
+            x[i] = (uint8_t)(x[i] + up[i]);
+        }
+        for (size_t i = bpp; i < n; i++) {
+            x[i] = (uint8_t)(x[i] + paeth(x[i - bpp], up[i], up[i - bpp]));
+        }
+        break;
+    default:
+        return -1;
+    }
+    return 0;
+}
+
+// 与白色背景混合
+static inline uint8_t blend_white(int c, int a) {
+    int t = c * a + 255 * (255 - a) + 128;
+    return (uint8_t)((t + (t >> 8)) >> 8);
+}
+
+// 取第x个样本（位深小于8时从字节中拆出，16位返回完整值）
+static inline int sample_at(const uint8_t *p, int x, int depth) {
+    switch (depth) {
+    case 16:
+        return (p[x * 2] << 8) | p[x * 2 + 1];
+    case 8:
+        return p[x];
+    default: {
+        int bit = x * depth;
+        return (p[bit >> 3] >> (8 - depth - (bit & 7))) & ((1 << depth) - 1);
+    }
+    }
+}
+
+// 把反滤波后的扫描线转换成24位BGR
+static void convert_row(const png_reader_t *reader, const uint8_t *p, uint8_t *out) {
+    int w = reader->width;
+    int d = reader->bit_depth;
+    int hi = d == 16 ? 2 : 1;                   // 16位只取高字节
+    switch (reader->color_type) {
+    case 0: {
+        int max = (1 << d) - 1;
+        for (int x = 0; x < w; x++, out += 3) {
+            int v = sample_at(p, x, d);
+            uint8_t g = d == 16 ? (uint8_t)(v >> 8) : (uint8_t)(v * 255 / max);
+            if (reader->has_key && v == reader->key[0]) {
+                g = 255;
+            }
+            out[0] = out[1] = out[2] = g;
+        }
+        break;
+    }
+    case 2:
+        for (int x = 0; x < w; x++, p += 3 * hi, out += 3) {
+            out[0] = p[2 * hi];
+            out[1] = p[hi];
+            out[2] = p[0];
+            if (reader->has_key && sample_at(p, 0, d) == reader->key[0] &&
+                sample_at(p, 1, d) == reader->key[1] && sample_at(p, 2, d) == reader->key[2]) {
+                out[0] = out[1] = out[2] = 255;
+            }
+        }
+        break;
+    case 3:
+        for (int x = 0; x < w; x++, out += 3) {
+            int i = sample_at(p, x, d);
+            if (i < reader->palette_size) {
+                memcpy(out, reader->palette[i], 3);
+            } else {
+                out[0] = out[1] = out[2] = 0;
+            }
+        }
+        break;
+    case 4:
+        for (int x = 0; x < w; x++, p += 2 * hi, out += 3) {
+            out[0] = out[1] = out[2] = blend_white(p[0], p[hi]);
+        }
+        break;
+    case 6:
+    default:
+        for (int x = 0; x < w; x++, p += 4 * hi, out += 3) {
+            int a = p[3 * hi];
+            out[0] = blend_white(p[2 * hi], a);
+            out[1] = blend_white(p[hi], a);
+            out[2] = blend_white(p[0], a);
+        }
+        break;
+    }
+}
+
+// 解压、反滤波下一行（结果在line[0]）
+static void png_next_line(png_reader_t *reader) {
+    uint8_t *tmp = reader->line[1];
+    reader->line[1] = reader->line[0];
+    reader->line[0] = tmp;
+    reader->next_y++;
+    if (reader->failed) {
+        return;
+    }
+    if (inflate_read(reader, reader->line[0], reader->row_bytes + 1) != 0 ||
+        unfilter(reader->line[0], reader->line[1], reader->row_bytes, reader->pixel_bytes) != 0) {
+        printf("[PNG] 第%d行解压失败（数据损坏或不完整）\n", reader->next_y - 1);
+        reader->failed = true;
+    }
+}
+
+// image_scale_row_fn适配：按需解压到第y行，只转换取到的行
+static const uint8_t *png_row_fn(void *ctx, int y, uint8_t *scratch) {
+    (void)scratch;
+    png_reader_t *reader = (png_reader_t *)ctx;
+    for (int k = 0; k < 2; k++) {
+        if (reader->bgr_y[k] == y) {
+            return reader->bgr[k];
+        }
+    }
+    // 覆盖两行中较早的一行；行号只会增加，y之前的行不会再被取到
+    int k = reader->bgr_y[0] < reader->bgr_y[1] ? 0 : 1;
+    if (y < reader->next_y) {
+        // 不应发生（回退超过一行），返回较近的一行
+        return reader->bgr[1 - k];
+    }
+    while (reader->next_y <= y) {
+        png_next_line(reader);
+    }
+    if (reader->failed) {
+        memset(reader->bgr[k], 0xFF, (size_t)reader->width * 3);
+    } else {
+        convert_row(reader, reader->line[0] + 1, reader->bgr[k]);
+    }
+    reader->bgr_y[k] = y;
+    return reader->bgr[k];
+}
+
+// 校验位深和颜色类型的组合
+static bool png_format_valid(int color_type, int depth) {
+    switch (color_type) {
+    case 0:
+        return depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16;
+    case 3:
+        return depth == 1 || depth == 2 || depth == 4 || depth == 8;
+    case 2:
+    case 4:
+    case 6:
+        return depth == 8 || depth == 16;
+    default:
+        return false;
+    }
+}
+
+// 解析IHDR、PLTE、tRNS，定位第一个IDAT块
+static int png_parse(png_reader_t *reader) {
+    static const int channels[7] = { 1, 0, 3, 1, 2, 0, 4 };
+    const uint8_t *m = reader->map;
+    size_t len = reader->map_len;
+    if (len < PNG_SIGNATURE_SIZE + PNG_CHUNK_OVERHEAD + 13 ||
+        memcmp(m, png_signature, PNG_SIGNATURE_SIZE) != 0 || memcmp(m + 12, "IHDR", 4) != 0) {
+        printf("[PNG] 无效的PNG文件\n");
+        return -1;
+    }
+    const uint8_t *ihdr = m + 16;
+    uint32_t w = rd32be(ihdr);
+    uint32_t h = rd32be(ihdr + 4);
+    reader->bit_depth = ihdr[8];
+    reader->color_type = ihdr[9];
+    if (w == 0 || h == 0 || w > PNG_MAX_WIDTH || h > 0x7FFFFFFFu) {
+        printf("[PNG] 不支持的尺寸: %ux%u\n", w, h);
+        return -1;
+    }
+    if (!png_format_valid(reader->color_type, reader->bit_depth) || ihdr[10] != 0 || ihdr[11] != 0) {
+        printf("[PNG] 不支持的格式: 颜色类型%d, 位深%d\n", reader->color_type, reader->bit_depth);
+        return -1;
+    }
+    if (ihdr[12] != 0) {
+        printf("[PNG] 不支持隔行扫描的PNG\n");
+        return -1;
+    }
+    reader->width = (int)w;
+    reader->height = (int)h;
+    int bits = channels[reader->color_type] * reader->bit_depth;
+    reader->pixel_bytes = bits < 8 ? 1 : bits / 8;
+    reader->row_bytes = ((size_t)w * bits + 7) / 8;
+
+    // 调色板默认黑色不透明
+    memset(reader->palette, 0, sizeof(reader->palette));
+    uint8_t alpha[256];
+    memset(alpha, 255, sizeof(alpha));
+    size_t pos = PNG_SIGNATURE_SIZE;
+    while (pos + PNG_CHUNK_OVERHEAD <= len) {
+        uint32_t clen = rd32be(m + pos);
+        const uint8_t *type = m + pos + 4;
+        const uint8_t *data = m + pos + 8;
+        if (clen > len - pos - PNG_CHUNK_OVERHEAD) {
+            break;
+        }
+        if (memcmp(type, "IDAT", 4) == 0) {
+            reader->chunk_pos = pos + 8;
+            reader->chunk_left = clen;
+            for (int i = 0; i < reader->palette_size; i++) {
+                uint8_t *c = reader->palette[i];
+                c[0] = blend_white(c[0], alpha[i]);
+                c[1] = blend_white(c[1], alpha[i]);
+                c[2] = blend_white(c[2], alpha[i]);
+            }
+            if (reader->color_type == 3 && reader->palette_size == 0) {
+                printf("[PNG] 缺少调色板\n");
+                return -1;
+            }
+            return 0;
+        }
+        if (memcmp(type, "PLTE", 4) == 0) {
+            reader->palette_size = (int)(clen / 3 > 256 ? 256 : clen / 3);
+            for (int i = 0; i < reader->palette_size; i++) {
+                reader->palette[i][0] = data[i * 3 + 2];
+                reader->palette[i][1] = data[i * 3 + 1];
+                reader->palette[i][2] = data[i * 3];
+            }
+        } else if (memcmp(type, "tRNS", 4) == 0) {
+            if (reader->color_type == 3) {
+                memcpy(alpha, data, clen > 256 ? 256 : clen);
+            } else if (reader->color_type == 0 && clen >= 2) {
+                reader->has_key = true;
+                reader->key[0] = (uint16_t)((data[0] << 8) | data[1]);
+            } else if (reader->color_type == 2 && clen >= 6) {
+                reader->has_key = true;
+                for (int c = 0; c < 3; c++) {
+                    reader->key[c] = (uint16_t)((data[c * 2] << 8) | data[c * 2 + 1]);
+                }
+            }
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            break;
+        }
+        pos += PNG_CHUNK_OVERHEAD + clen;
+    }
+    printf("[PNG] 没有图像数据\n");
+    return -1;
+}
+
+// 读取并校验zlib头
+static int png_zlib_header(png_reader_t *reader) {
+    uint32_t cmf = get_bits(reader, 8);
+    uint32_t flg = get_bits(reader, 8);
+    if ((cmf & 0x0F) != 8 || (cmf >> 4) > 7 || ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20)) {
+        printf("[PNG] 无效的zlib数据头\n");
+        return -1;
+    }
+    return 0;
+}
+
+int png_reader_open(png_reader_t *reader, const char *path) {
+    memset(reader, 0, sizeof(*reader));
+    if (image_map_file(path, "[PNG]", &reader->map, &reader->map_len) != 0) {
+        return -1;
+    }
+    if (png_parse(reader) != 0) {
+        png_reader_close(reader);
+        return -1;
+    }
+
+    size_t line_bytes = reader->row_bytes + 1;
+    size_t bgr_bytes = (size_t)reader->width * 3;
+    reader->z = (struct png_inflate *)calloc(1, sizeof(struct png_inflate));
+    uint8_t *buf = (uint8_t *)malloc(line_bytes * 2 + bgr_bytes * 2);
+    if (!reader->z || !buf) {
+        printf("[PNG] 内存分配失败\n");
+        free(buf);
+        png_reader_close(reader);
+        return -1;
+    }
+    reader->buf = buf;
+    reader->line[0] = buf;
+    reader->line[1] = buf + line_bytes;
+    reader->bgr[0] = buf + line_bytes * 2;
+    reader->bgr[1] = reader->bgr[0] + bgr_bytes;
+    reader->bgr_y[0] = reader->bgr_y[1] = -1;
+    memset(buf, 0, line_bytes * 2);             // 第一行之前的“上一行”为0
+    reader->next_y = 0;
+
+    if (png_zlib_header(reader) != 0) {
+        png_reader_close(reader);
+        return -1;
+    }
+    return 0;
+}
+
+void png_reader_scale_src(png_reader_t *reader, image_scale_src_t *src) {
+    memset(src, 0, sizeof(*src));
+    src->width = reader->width;
+    src->height = reader->height;
+    src->row_fn = png_row_fn;
+    src->row_ctx = reader;
+}
+
+int png_decode_fit(const char *path, uint32_t *dst, int dst_w, int dst_h, image_scale_mode_t mode) {
+    png_reader_t *png = (png_reader_t *)malloc(sizeof(png_reader_t));
+    if (!png) {
+        return -1;
+    }
+    if (png_reader_open(png, path) != 0) {
+        free(png);
+        return -1;
+    }
+    printf("PNG信息: %dx%d, 颜色类型%d, 位深%d\n", png->width, png->height, png->color_type, png->bit_depth);
+
+    image_scale_src_t src;
+    png_reader_scale_src(png, &src);
+    int ret = image_scale_fit(&src, dst, dst_w, dst_h, mode);
+    if (ret != 0) {
+        printf("PNG缩放失败（内存不足）\n");
+    }
+    png_reader_close(png);
+    free(png);
+    return ret;
+}
+
+void png_reader_close(png_reader_t *reader) {
+    free(reader->z);
+    reader->z = NULL;
+    free(reader->buf);
+    reader->buf = NULL;
+    reader->line[0] = reader->line[1] = NULL;
+    reader->bgr[0] = reader->bgr[1] = NULL;
+    if (reader->map) {
+        munmap((void *)reader->map, reader->map_len);
+    }
+    reader->map = NULL;
+    reader->map_len = 0;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file png_reader.h
+ * @brief PNG流式读取：边解压边反滤波，按行交给缩放，不保存整张图片
+ *
+ * lodepng（LVGL的PNG解码器）先把全部IDAT解压到一块内存，再反滤波、转换颜色到另一块内存，
+ * 而且使用LVGL内存池（4MB，非线程安全），稍大的PNG就放不下。这里：
+ *   - 文件mmap映射为只读，依次读取各IDAT块
+ *   - 内置的解压器（deflate，9位快速查找表）按需输出字节，只保留32KB窗口，
+ *     每次解压一行扫描线，用上一行反滤波后转换成24位BGR
+ *   - 缩放按行号顺序取行，跳过的行只解压、反滤波，不转换颜色
+ * 内存只有窗口、哈夫曼表和几行缓冲区，和图片高度无关，宽度最大PNG_MAX_WIDTH；
+ * 不使用LVGL内存池，可以在后台线程中调用。
+ *
+ * 支持全部颜色类型和位深（灰度、RGB、调色板、灰度+alpha、RGBA，1~16位）和tRNS；
+ * 透明像素与白色背景混合。不支持隔行扫描（Adam7需要整张图片的缓冲区），不校验CRC和Adler-32。
+ */
+
+#ifndef PNG_READER_H
+#define PNG_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "image_scaler.h"
+
+#define PNG_MAX_WIDTH 16384             // 宽度上限（决定行缓冲区大小）
+
+struct png_inflate;
+
+// 一个打开的PNG文件
+typedef struct {
+    const uint8_t *map;             // 文件映射
+    size_t map_len;
+    int width;
+    int height;
+    int bit_depth;                  // 1、2、4、8、16
+    int color_type;                 // 0灰度、2RGB、3调色板、4灰度+alpha、6RGBA
+    int pixel_bytes;                // 反滤波时左边像素的字节距离（至少1）
+    size_t row_bytes;               // 每行扫描线字节数（不含滤波类型字节）
+    size_t chunk_pos;               // 当前IDAT块中下一个字节的位置
+    size_t chunk_left;              // 当前IDAT块剩余字节数
+    struct png_inflate *z;          // 解压状态（窗口、哈夫曼表）
+    uint8_t *buf;                   // 行缓冲区（line和bgr都在这里）
+    uint8_t *line[2];               // 当前行和上一行扫描线（第一个字节是滤波类型）
+    int next_y;                     // 下一行要解压的行号
+    uint8_t *bgr[2];                // 最近转换的两行（24位BGR）
+    int bgr_y[2];                   // 这两行的行号
+    uint8_t palette[256][3];        // 调色板（BGR，已与白色背景混合）
+    int palette_size;
+    bool has_key;                   // 灰度/RGB的tRNS透明色
+    uint16_t key[3];
+    bool failed;                    // 解压中途出错（之后的行为白色）
+} png_reader_t;
+
+/**
+ * @brief 打开PNG文件并校验格式
+ * @param reader 输出的读取器
+ * @param path 文件路径
+ * @return 成功返回0，失败返回-1（已打印原因）
+ */
+int png_reader_open(png_reader_t *reader, const char *path);
+
+/**
+ * @brief 填充缩放源描述（行号必须单调不减，最多回退一行）
+ * @param reader 读取器（缩放完成前不能关闭）
+ * @param src 输出的源描述
+ */
+void png_reader_scale_src(png_reader_t *reader, image_scale_src_t *src);
+
+/**
+ * @brief 把PNG文件按比例缩放、居中写入一块32位缓冲区，图片以外的边框填白色
+ *
+ * 不依赖LVGL，可以在后台线程中调用。
+ * @param path 文件路径
+ * @param dst 目标缓冲区（0xAARRGGBB，dst_w*dst_h个像素，行间无填充）
+ * @param dst_w 目标宽度
+ * @param dst_h 目标高度
+ * @param mode 缩放方式
+ * @return 成功返回0，失败返回-1（dst内容未定义）
+ */
+int png_decode_fit(const char *path, uint32_t *dst, int dst_w, int dst_h, image_scale_mode_t mode);
+
+/**
+ * @brief 关闭读取器（释放缓冲区，解除映射）
+ * @param reader 读取器
+ */
+void png_reader_close(png_reader_t *reader);
+
+#endif /* PNG_READER_H */
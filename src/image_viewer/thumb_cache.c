@@ -0,0 +1,375 @@
+/**
+ * @file thumb_cache.c
+ * @brief 持久化缩略图缓存实现
+ */
+
+#include "thumb_cache.h"
+#include "image_decoder.h"
+#include "image_scaler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// 条目上限（哈希表大小，必须是2的幂）
+#ifndef THUMB_CACHE_CAPACITY
+    #define THUMB_CACHE_CAPACITY 1024
+#endif
+
+#define THUMB_CACHE_MAGIC 0x424D4854u          // "THMB"
+#define THUMB_CACHE_VERSION 1
+#define THUMB_PATH_MAX 232                     // 条目中保存的路径长度上限（含结尾0）
+#define THUMB_MAX_LOAD (THUMB_CACHE_CAPACITY * 3 / 4)  // 超过后替换旧条目，保证探测长度
+#define THUMB_GROW_SLOTS 16                    // 文件每次加长的像素槽数
+#define THUMB_MAX_REQUEST 64                   // 生成列表长度上限
+#define THUMB_BYTES ((size_t)THUMB_WIDTH * THUMB_HEIGHT * sizeof(uint32_t))
+
+// 文件头（占一页）
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t thumb_w;
+    uint32_t thumb_h;
+    uint32_t capacity;
+    uint32_t entries;                           // 已使用的条目数
+    uint32_t slots;                             // 已分配的像素槽数
+} thumb_file_header_t;
+
+// 索引条目（256字节）
+typedef struct {
+    uint32_t state;                             // thumb_state_t，0为空条目
+    uint32_t hash;
+    int64_t mtime;
+    int64_t size;
+    uint32_t slot;                              // 像素槽序号
+    uint32_t reserved;
+    char path[THUMB_PATH_MAX];
+} thumb_entry_t;
+
+#define THUMB_HEADER_SIZE 4096
+#define THUMB_INDEX_SIZE ((size_t)THUMB_CACHE_CAPACITY * sizeof(thumb_entry_t))
+#define THUMB_PIXELS_OFFSET (THUMB_HEADER_SIZE + THUMB_INDEX_SIZE)
+#define THUMB_MAP_SIZE (THUMB_PIXELS_OFFSET + (size_t)THUMB_CACHE_CAPACITY * THUMB_BYTES)
+
+static pthread_mutex_t thumb_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t thumb_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t thumb_thread;
+static bool thumb_running = false;
+
+static int thumb_fd = -1;
+static uint8_t *thumb_map = NULL;
+static thumb_file_header_t *thumb_header = NULL;
+static thumb_entry_t *thumb_index = NULL;
+static size_t thumb_file_size = 0;
+
+static char request_paths[THUMB_MAX_REQUEST][THUMB_PATH_MAX];
+static int request_count = 0;
+
+static _Atomic uint32_t thumb_gen = 0;
+static thumb_cache_stats_t thumb_stats;
+
+// FNV-1a
+static uint32_t path_hash(const char *path) {
+    uint32_t h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)path; *p; p++) {
+        h = (h ^ *p) * 16777619u;
+    }
+    return h;
+}
+
+static uint32_t *slot_pixels(uint32_t slot) {
+    return (uint32_t *)(thumb_map + THUMB_PIXELS_OFFSET + (size_t)slot * THUMB_BYTES);
+}
+
+// 按路径查找条目（持有锁时调用），找不到时返回NULL，*free_entry为第一个空条目
+static thumb_entry_t *find_entry(const char *path, uint32_t hash, thumb_entry_t **free_entry) {
+    *free_entry = NULL;
+    for (uint32_t i = 0; i < THUMB_CACHE_CAPACITY; i++) {
+        thumb_entry_t *e = &thumb_index[(hash + i) & (THUMB_CACHE_CAPACITY - 1)];
+        if (e->state == 0) {
+            *free_entry = e;
+            return NULL;
+        }
+        if (e->hash == hash && strcmp(e->path, path) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+// 分配一个像素槽，必要时加长文件（持有锁时调用）
+static int alloc_slot(uint32_t *slot) {
+    uint32_t n = thumb_header->slots;
+    if (n >= THUMB_CACHE_CAPACITY) {
+        return -1;
+    }
+    size_t need = THUMB_PIXELS_OFFSET + (size_t)(n + 1) * THUMB_BYTES;
+    if (thumb_fd >= 0 && need > thumb_file_size) {
+        uint32_t grow = n + THUMB_GROW_SLOTS < THUMB_CACHE_CAPACITY ? n + THUMB_GROW_SLOTS : THUMB_CACHE_CAPACITY;
+        size_t new_size = THUMB_PIXELS_OFFSET + (size_t)grow * THUMB_BYTES;
+        if (ftruncate(thumb_fd, (off_t)new_size) != 0) {
+            printf("[缩略图] 加长缓存文件失败\n");
+            return -1;
+        }
+        thumb_file_size = new_size;
+    }
+    thumb_header->slots = n + 1;
+    *slot = n;
+    return 0;
+}
+
+static bool stat_key(const char *path, int64_t *mtime, int64_t *size) {
+    struct stat st;
+    if (strlen(path) >= THUMB_PATH_MAX || stat(path, &st) != 0) {
+        return false;
+    }
+    *mtime = (int64_t)st.st_mtime;
+    *size = (int64_t)st.st_size;
+    return true;
+}
+
+thumb_state_t thumb_cache_lookup(const char *path, const uint32_t **pixels) {
+    int64_t mtime, size;
+    if (!thumb_map || !path || !stat_key(path, &mtime, &size)) {
+        return THUMB_MISSING;
+    }
+    uint32_t hash = path_hash(path);
+    thumb_state_t state = THUMB_MISSING;
+    pthread_mutex_lock(&thumb_mutex);
+    thumb_stats.lookups++;
+    thumb_entry_t *free_entry;
+    thumb_entry_t *e = find_entry(path, hash, &free_entry);
+    if (e && e->mtime == mtime && e->size == size) {
+        state = (thumb_state_t)e->state;
+        if (state == THUMB_READY && e->slot >= thumb_header->slots) {
+            // 槽号越过已分配的像素区（文件损坏或被截断），按未缓存处理，避免访问映射外触发SIGBUS
+            state = THUMB_MISSING;
+        } else if (state == THUMB_READY) {
+            thumb_stats.hits++;
+            if (pixels) {
+                *pixels = slot_pixels(e->slot);
+            }
+        }
+    }
+    pthread_mutex_unlock(&thumb_mutex);
+    return state;
+}
+
+int thumb_cache_put(const char *path, const uint32_t *pixels) {
+    int64_t mtime, size;
+    if (!thumb_map || !path || !stat_key(path, &mtime, &size)) {
+        return -1;
+    }
+    uint32_t hash = path_hash(path);
+    pthread_mutex_lock(&thumb_mutex);
+    thumb_entry_t *free_entry;
+    thumb_entry_t *e = find_entry(path, hash, &free_entry);
+    if (!e) {
+        if (free_entry && thumb_header->entries < THUMB_MAX_LOAD) {
+            e = free_entry;
+            e->slot = UINT32_MAX;
+            thumb_header->entries++;
+        } else {
+            // 表已满：替换该路径哈希起始位置的条目，复用其像素槽
+            e = &thumb_index[hash & (THUMB_CACHE_CAPACITY - 1)];
+            thumb_stats.evictions++;
+        }
+        e->hash = hash;
+        snprintf(e->path, sizeof(e->path), "%s", path);
+    }
+    if (e->slot != UINT32_MAX && e->slot >= thumb_header->slots) {
+        e->slot = UINT32_MAX;
+    }
+    if (pixels && e->slot == UINT32_MAX && alloc_slot(&e->slot) != 0) {
+        // 没有可用的像素槽，按失败记录（条目仍保留，下次原图修改后再试）
+        pixels = NULL;
+    }
+    // 像素写完后再置状态
+    e->state = THUMB_MISSING;
+    if (pixels) {
+        memcpy(slot_pixels(e->slot), pixels, THUMB_BYTES);
+    }
+    e->mtime = mtime;
+    e->size = size;
+    e->state = pixels ? THUMB_READY : THUMB_FAILED;
+    if (pixels) {
+        thumb_stats.generated++;
+    } else {
+        thumb_stats.failed++;
+    }
+    pthread_mutex_unlock(&thumb_mutex);
+    atomic_fetch_add(&thumb_gen, 1);
+    return 0;
+}
+
+static void *thumb_worker(void *arg) {
+    (void)arg;
+    uint32_t *buf = (uint32_t *)malloc(THUMB_BYTES);
+    if (!buf) {
+        printf("[缩略图] 内存分配失败\n");
+        return NULL;
+    }
+    pthread_mutex_lock(&thumb_mutex);
+    while (thumb_running) {
+        if (request_count == 0) {
+            pthread_cond_wait(&thumb_cond, &thumb_mutex);
+            continue;
+        }
+        char path[THUMB_PATH_MAX];
+        snprintf(path, sizeof(path), "%s", request_paths[0]);
+        memmove(request_paths[0], request_paths[1], (size_t)(request_count - 1) * THUMB_PATH_MAX);
+        request_count--;
+        pthread_mutex_unlock(&thumb_mutex);
+
+        // 只生成BMP/JPEG/PNG；已有缩略图（包括失败记录）的跳过
+        if (image_decode_supported(path) && thumb_cache_lookup(path, NULL) == THUMB_MISSING) {
+            int ret = image_decode_fit(path, buf, THUMB_WIDTH, THUMB_HEIGHT, IMAGE_SCALE_BOX);
+            thumb_cache_put(path, ret == 0 ? buf : NULL);
+        }
+
+        pthread_mutex_lock(&thumb_mutex);
+    }
+    pthread_mutex_unlock(&thumb_mutex);
+    free(buf);
+    return NULL;
+}
+
+// 映射缓存文件，文件头不匹配时清空重建
+static int map_cache_file(const char *cache_path) {
+    thumb_fd = open(cache_path, O_RDWR | O_CREAT, 0644);
+    if (thumb_fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    thumb_file_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    if (fstat(thumb_fd, &st) != 0) {
+        goto fail;
+    }
+    if ((size_t)st.st_size >= THUMB_PIXELS_OFFSET &&
+        pread(thumb_fd, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr) &&
+        hdr.magic == THUMB_CACHE_MAGIC && hdr.version == THUMB_CACHE_VERSION &&
+        hdr.thumb_w == THUMB_WIDTH && hdr.thumb_h == THUMB_HEIGHT && hdr.capacity == THUMB_CACHE_CAPACITY &&
+        (size_t)st.st_size >= THUMB_PIXELS_OFFSET + (size_t)hdr.slots * THUMB_BYTES) {
+        thumb_file_size = (size_t)st.st_size;
+    } else {
+        // 新文件或格式不兼容：清空后只保留文件头和索引表，像素槽按需加长
+        printf("[缩略图] 创建缓存文件: %s\n", cache_path);
+        if (ftruncate(thumb_fd, 0) != 0 || ftruncate(thumb_fd, (off_t)THUMB_PIXELS_OFFSET) != 0) {
+            goto fail;
+        }
+        thumb_file_size = THUMB_PIXELS_OFFSET;
+        hdr.magic = 0;
+    }
+    // 按最大容量映射，文件加长后新的像素槽直接可用，已返回的指针不会失效
+    void *map = mmap(NULL, THUMB_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, thumb_fd, 0);
+    if (map == MAP_FAILED) {
+        goto fail;
+    }
+    thumb_map = (uint8_t *)map;
+    thumb_header = (thumb_file_header_t *)thumb_map;
+    if (hdr.magic != THUMB_CACHE_MAGIC) {
+        thumb_header->magic = THUMB_CACHE_MAGIC;
+        thumb_header->version = THUMB_CACHE_VERSION;
+        thumb_header->thumb_w = THUMB_WIDTH;
+        thumb_header->thumb_h = THUMB_HEIGHT;
+        thumb_header->capacity = THUMB_CACHE_CAPACITY;
+        thumb_header->entries = 0;
+        thumb_header->slots = 0;
+    }
+    return 0;
+
+fail:
+    close(thumb_fd);
+    thumb_fd = -1;
+    return -1;
+}
+
+int thumb_cache_open(const char *cache_path) {
+    if (thumb_running) {
+        return 0;
+    }
+    memset(&thumb_stats, 0, sizeof(thumb_stats));
+    if (cache_path && map_cache_file(cache_path) == 0) {
+        thumb_stats.persistent = true;
+    } else {
+        // 缓存文件不可用：匿名映射，只在本次运行有效（匿名映射的页初始为0，即空表）
+        printf("[缩略图] 无法使用缓存文件 %s，缩略图不会保存\n", cache_path ? cache_path : "(null)");
+        void *map = mmap(NULL, THUMB_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED) {
+            printf("[缩略图] 映射失败\n");
+            return -1;
+        }
+        thumb_map = (uint8_t *)map;
+        thumb_header = (thumb_file_header_t *)thumb_map;
+        thumb_header->magic = THUMB_CACHE_MAGIC;
+    }
+    thumb_index = (thumb_entry_t *)(thumb_map + THUMB_HEADER_SIZE);
+    thumb_stats.capacity = THUMB_CACHE_CAPACITY;
+    request_count = 0;
+
+    thumb_running = true;
+    if (pthread_create(&thumb_thread, NULL, thumb_worker, NULL) != 0) {
+        printf("[缩略图] 创建生成线程失败\n");
+        thumb_running = false;
+        thumb_cache_close();
+        return -1;
+    }
+    printf("[缩略图] 缓存已打开: %u个缩略图\n", thumb_header->entries);
+    return 0;
+}
+
+void thumb_cache_close(void) {
+    if (thumb_running) {
+        pthread_mutex_lock(&thumb_mutex);
+        thumb_running = false;
+        request_count = 0;
+        pthread_cond_broadcast(&thumb_cond);
+        pthread_mutex_unlock(&thumb_mutex);
+        pthread_join(thumb_thread, NULL);
+    }
+    if (thumb_map) {
+        if (thumb_fd >= 0) {
+            msync(thumb_map, thumb_file_size, MS_ASYNC);
+        }
+        munmap(thumb_map, THUMB_MAP_SIZE);
+        thumb_map = NULL;
+        thumb_header = NULL;
+        thumb_index = NULL;
+    }
+    if (thumb_fd >= 0) {
+        close(thumb_fd);
+        thumb_fd = -1;
+    }
+}
+
+void thumb_cache_request(const char *const *paths, int count) {
+    if (!thumb_running) {
+        return;
+    }
+    pthread_mutex_lock(&thumb_mutex);
+    request_count = 0;
+    for (int i = 0; i < count && request_count < THUMB_MAX_REQUEST; i++) {
+        if (paths[i] && strlen(paths[i]) < THUMB_PATH_MAX) {
+            snprintf(request_paths[request_count++], THUMB_PATH_MAX, "%s", paths[i]);
+        }
+    }
+    pthread_cond_signal(&thumb_cond);
+    pthread_mutex_unlock(&thumb_mutex);
+}
+
+uint32_t thumb_cache_generation(void) {
+    return atomic_load(&thumb_gen);
+}
+
+void thumb_cache_get_stats(thumb_cache_stats_t *stats) {
+    pthread_mutex_lock(&thumb_mutex);
+    *stats = thumb_stats;
+    stats->entries = thumb_header ? thumb_header->entries : 0;
+    pthread_mutex_unlock(&thumb_mutex);
+}
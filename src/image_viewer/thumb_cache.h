@@ -0,0 +1,90 @@
+/**
+ * @file thumb_cache.h
+ * @brief 持久化缩略图缓存：单个mmap映射的缓存文件 + 后台生成线程
+ *
+ * 缩略图（THUMB_WIDTH x THUMB_HEIGHT，0xAARRGGBB，区域平均缩小，居中、边框白色）
+ * 保存在一个缓存文件中，程序再次启动时直接从映射读取，不需要重新解码原图：
+ *   - 文件头 + 索引表（开放寻址哈希表，键为路径，条目中记录修改时间和文件大小）+ 像素槽
+ *   - 整个文件一次映射到最大容量，像素槽按需分配、文件按需加长，已返回的指针一直有效
+ *   - 原图被修改（修改时间或大小变化）后缩略图失效，重新生成时复用原来的像素槽
+ *   - 后台线程按thumb_cache_request给出的顺序生成BMP/JPEG/PNG缩略图；GIF解码依赖LVGL的内存池，
+ *     由调用者在LVGL线程中生成后用thumb_cache_put写入
+ * 缓存文件不可写时退回匿名映射（仅本次运行有效）。
+ */
+
+#ifndef THUMB_CACHE_H
+#define THUMB_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define THUMB_WIDTH 96                          // 缩略图宽度
+#define THUMB_HEIGHT 72                         // 缩略图高度
+
+// 缩略图状态
+typedef enum {
+    THUMB_MISSING = 0,              // 还没有生成（或原图已修改）
+    THUMB_READY,                    // 可以显示
+    THUMB_FAILED,                   // 原图无法解码（不再重试，直到原图被修改）
+} thumb_state_t;
+
+// 统计信息
+typedef struct {
+    uint32_t lookups;               // 查询次数
+    uint32_t hits;                  // 查询命中
+    uint32_t generated;             // 本次运行生成的缩略图数
+    uint32_t failed;                // 生成失败数
+    uint32_t evictions;             // 表满时被替换的条目数
+    uint32_t entries;               // 缓存文件中的条目数
+    uint32_t capacity;              // 条目上限
+    bool persistent;                // 是否写入了缓存文件（否则为匿名映射）
+} thumb_cache_stats_t;
+
+/**
+ * @brief 打开（不存在时创建）缓存文件并启动后台生成线程（重复调用直接返回）
+ * @param cache_path 缓存文件路径
+ * @return 成功返回0（包括退回匿名映射），失败返回-1
+ */
+int thumb_cache_open(const char *cache_path);
+
+/**
+ * @brief 停止后台线程、同步并关闭缓存文件（之后不能再使用已返回的像素指针）
+ */
+void thumb_cache_close(void);
+
+/**
+ * @brief 查询缩略图
+ * @param path 原图路径
+ * @param pixels 输出像素（THUMB_WIDTH*THUMB_HEIGHT，状态为THUMB_READY时有效，可为NULL）
+ * @return 缩略图状态
+ */
+thumb_state_t thumb_cache_lookup(const char *path, const uint32_t **pixels);
+
+/**
+ * @brief 写入缩略图（可在任意线程调用）
+ * @param path 原图路径
+ * @param pixels 缩略图像素，NULL表示原图无法解码（记为THUMB_FAILED）
+ * @return 成功返回0，失败返回-1
+ */
+int thumb_cache_put(const char *path, const uint32_t *pixels);
+
+/**
+ * @brief 设置后台生成列表（替换之前的列表），按顺序生成尚未缓存的BMP/JPEG/PNG缩略图
+ * @param paths 原图路径，优先级从高到低（会被复制）
+ * @param count 路径数
+ */
+void thumb_cache_request(const char *const *paths, int count);
+
+/**
+ * @brief 缩略图变化计数，每写入一个缩略图加1（调用者据此判断是否需要刷新显示）
+ * @return 计数
+ */
+uint32_t thumb_cache_generation(void);
+
+/**
+ * @brief 获取统计信息
+ * @param stats 输出
+ */
+void thumb_cache_get_stats(thumb_cache_stats_t *stats);
+
+#endif /* THUMB_CACHE_H */
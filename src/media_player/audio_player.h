@@ -3,7 +3,7 @@
  * @brief 独立的音频播放器模块（仅处理音频文件）
  * 
  * 功能：
- * - 使用MPlayer播放音频文件
+ * - 使用常驻的MPlayer播放音频文件（media_engine，切换曲目不重启进程）
  * - 独立的播放状态管理
  * - 与视频播放器完全分离
  */
@@ -12,6 +12,7 @@
 #define AUDIO_PLAYER_H
 
 #include <stdbool.h>
+#include "media_engine.h"
 
 /**
  * @brief 初始化音频播放器
@@ -76,11 +77,19 @@ void audio_player_volume_down(void);
 int audio_player_get_pid(void);
 
 /**
- * @brief 检查MPlayer是否仍在运行
- * @return 是否仍在运行
+ * @brief 检查是否仍在播放（mplayer常驻，播放到结尾、停止或文件无法播放后返回false）
+ *
+ * 加载是异步的：握手完成前返回true，握手失败时通过状态回调显示"状态: 无法播放"。
+ * @return 是否仍在播放
  */
 bool audio_player_is_running(void);
 
+/**
+ * @brief 获取播放进度（无锁读取状态快照，不阻塞，用于界面定时器）
+ * @param status 输出的状态（位置、时长、是否暂停）
+ */
+void audio_player_get_status(media_engine_status_t *status);
+
 /**
  * @brief 设置状态更新回调函数
  * @param callback 回调函数指针
@@ -94,7 +103,7 @@ void audio_player_set_status_callback(void (*callback)(const char *));
 void audio_player_send_command(const char *cmd);
 
 /**
- * @brief 清理资源
+ * @brief 清理资源（退出常驻mplayer，程序退出时调用）
  */
 void audio_player_cleanup(void);
 
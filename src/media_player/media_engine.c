@@ -0,0 +1,698 @@
+/**
+ * @file media_engine.c
+ * @brief 常驻MPlayer播放引擎实现
+ */
+
+#include "media_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <strings.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+
+#ifndef MEDIA_ENGINE_LOAD_TIMEOUT_MS
+#define MEDIA_ENGINE_LOAD_TIMEOUT_MS 5000       // 加载握手的最长时间（包括首次启动mplayer），超时后重启mplayer
+#endif
+
+#ifndef MEDIA_ENGINE_STATUS_MS
+#define MEDIA_ENGINE_STATUS_MS 250              // 播放时查询位置和暂停状态的间隔
+#endif
+
+#ifndef MEDIA_ENGINE_STATUS_PAUSED_MS
+#define MEDIA_ENGINE_STATUS_PAUSED_MS 1000      // 暂停时的查询间隔（位置不变，只需发现恢复播放或结束）
+#endif
+
+#ifndef MEDIA_ENGINE_QUIT_TIMEOUT_MS
+#define MEDIA_ENGINE_QUIT_TIMEOUT_MS 1000       // quit后等待进程退出的时间，超时后SIGKILL
+#endif
+
+#define MEDIA_ENGINE_MAX_ARGS 32
+#define MEDIA_ENGINE_QUERY_RING 8                // 未回答查询的记录数（每批最多3个，握手1个）
+
+// 查询（pausing_keep_force：查询不改变暂停状态）
+typedef enum {
+    QUERY_TIME_POS = 0,
+    QUERY_PAUSE,
+    QUERY_LENGTH,
+} engine_query_t;
+
+static const char *const query_cmds[] = {
+    [QUERY_TIME_POS] = "pausing_keep_force get_property time_pos",
+    [QUERY_PAUSE] = "pausing_keep_force get_property pause",
+    [QUERY_LENGTH] = "pausing_keep_force get_property length",
+};
+
+// 一个引擎（一个mplayer进程）
+typedef struct {
+    const char *name;                   // 日志中的名称
+    const char *const *args;            // mplayer参数
+    bool framebuffer;                   // 是否输出到framebuffer
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;                // 进程退出时广播
+    pid_t pid;
+    int cmd_fd;                         // mplayer标准输入（写端，非阻塞）
+    int out_fd;                         // mplayer标准输出（读端，由读取线程使用）
+    pthread_t reader;
+    bool reader_started;
+    bool alive;                         // 进程在运行（读取线程看到输出结束后为false）
+    bool loaded;                        // 有文件正在播放
+    bool loading;                       // 已发送loadfile，握手查询还没有回答
+    bool load_failed;                   // 最近一次加载失败（无法播放、超时或mplayer退出）
+    bool paused;
+    bool length_failed;                 // 当前文件没有时长（不再查询）
+    int32_t position_ms;
+    int32_t duration_ms;
+    uint32_t track;
+    uint32_t queries;                   // 已发送的查询数（每个查询有且只有一个ANS_回答）
+    uint32_t answers;                   // 已收到的回答数
+    uint32_t stale_before;              // 序号小于它的回答属于加载、停止之前，不更新状态
+    uint32_t load_seq;                  // 握手查询的序号
+    uint64_t load_start_ms;
+    char load_path[1024];               // 正在加载的文件（日志用）
+    uint8_t query_kind[MEDIA_ENGINE_QUERY_RING];    // 未回答查询的类型（回答按发送顺序到达）
+    uint64_t last_status_ms;            // 上一批状态查询的时间
+    // 状态快照（seqlock）：持有mutex时写，任意线程无锁读
+    _Atomic uint32_t snap_seq;          // 奇数表示正在写
+    _Atomic uint32_t snap_flags;        // bit0: loaded, bit1: paused, bit2: loading, bit3: load_failed
+    _Atomic int32_t snap_position_ms;
+    _Atomic int32_t snap_duration_ms;
+    _Atomic uint32_t snap_track;
+} media_engine_t;
+
+static const char *const audio_args[] = {
+    "-slave", "-idle", "-quiet",
+    NULL
+};
+
+static const char *const video_args[] = {
+    "-slave", "-idle", "-quiet",
+    "-vo", "fbdev2",                    // 使用fbdev2
+    "-cache", "32768",                  // 缓存大小
+    "-lavdopts", "skipframe=nonref:skiploopfilter=all:fast:threads=8",  // 解码器优化选项
+    "-vf", "scale=800:480,format=bgr24",    // 缩放为800x480，格式为bgr24
+    "-framedrop",                       // 抽帧减少卡顿
+    "-nocorrect-pts",                   // 不校正时间戳
+    NULL
+};
+
+static media_engine_t engines[MEDIA_ENGINE_COUNT] = {
+    [MEDIA_ENGINE_AUDIO] = {
+        .name = "音频", .args = audio_args, .framebuffer = false,
+        .mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER,
+        .pid = -1, .cmd_fd = -1, .out_fd = -1,
+    },
+    [MEDIA_ENGINE_VIDEO] = {
+        .name = "视频", .args = video_args, .framebuffer = true,
+        .mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER,
+        .pid = -1, .cmd_fd = -1, .out_fd = -1,
+    },
+};
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+// pthread_cond_timedwait使用的绝对时间
+static void deadline_after(int ms, struct timespec *ts) {
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static media_engine_t *engine_get(media_engine_role_t role) {
+    if (role < 0 || role >= MEDIA_ENGINE_COUNT) {
+        return NULL;
+    }
+    return &engines[role];
+}
+
+/**
+ * @brief 把当前状态写入快照，调用时持有锁（写者由锁串行化）
+ */
+static void engine_publish_locked(media_engine_t *e) {
+    uint32_t seq = atomic_load_explicit(&e->snap_seq, memory_order_relaxed);
+    atomic_store_explicit(&e->snap_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&e->snap_flags, (e->loaded ? 1u : 0u) | (e->paused ? 2u : 0u) |
+                          (e->loading ? 4u : 0u) | (e->load_failed ? 8u : 0u), memory_order_relaxed);
+    atomic_store_explicit(&e->snap_position_ms, e->position_ms, memory_order_relaxed);
+    atomic_store_explicit(&e->snap_duration_ms, e->duration_ms, memory_order_relaxed);
+    atomic_store_explicit(&e->snap_track, e->track, memory_order_relaxed);
+    atomic_store_explicit(&e->snap_seq, seq + 2, memory_order_release);
+}
+
+// "ANS_xxx=值"中的秒数转毫秒
+static int32_t answer_ms(const char *value) {
+    double sec = strtod(value, NULL);
+    if (!(sec >= 0.0) || sec > 2000000.0) {
+        return -1;
+    }
+    return (int32_t)(sec * 1000.0 + 0.5);
+}
+
+static void engine_request_status_locked(media_engine_t *e);
+
+/**
+ * @brief 握手查询已回答（在读取线程中，持有锁）：ANS_time_pos表示开始播放，ANS_ERROR表示失败
+ */
+static void engine_finish_load_locked(media_engine_t *e) {
+    e->loading = false;
+    if (e->loaded) {
+        printf("[媒体引擎] %s 开始播放 (%llums): %s\n", e->name,
+               (unsigned long long)(now_ms() - e->load_start_ms), e->load_path);
+        engine_request_status_locked(e);    // 马上得到时长
+    } else {
+        e->load_failed = true;
+        printf("[媒体引擎] %s 无法播放: %s\n", e->name, e->load_path);
+    }
+}
+
+/**
+ * @brief 处理mplayer输出的一行：ANS_回答更新状态，其余原样打印
+ *
+ * get_property的回答为 ANS_time_pos= / ANS_length= / ANS_pause=，
+ * get_time_pos等命令的回答为 ANS_TIME_POSITION= / ANS_LENGTH= / ANS_PAUSE=，两种都接受。
+ */
+static void engine_handle_line(media_engine_t *e, const char *line) {
+    if (strncmp(line, "ANS_", 4) != 0) {
+        if (line[0] != '\0') {
+            printf("%s\n", line);
+        }
+        return;
+    }
+    const char *ans = line + 4;
+    pthread_mutex_lock(&e->mutex);
+    engine_query_t kind = (engine_query_t)e->query_kind[e->answers % MEDIA_ENGINE_QUERY_RING];
+    uint32_t seq = ++e->answers;
+    if ((int32_t)(seq - e->stale_before) < 0) {
+        // 上一个文件的回答，只计数
+    } else if (strncmp(ans, "ERROR", 5) == 0) {
+        if (kind == QUERY_TIME_POS) {
+            e->loaded = false;      // 没有文件在播放（加载失败或已播放结束）
+            e->paused = false;
+        } else if (kind == QUERY_LENGTH) {
+            e->length_failed = true;
+        }
+    } else if (strncasecmp(ans, "time_pos=", 9) == 0) {
+        e->loaded = true;
+        e->position_ms = answer_ms(ans + 9);
+    } else if (strncasecmp(ans, "TIME_POSITION=", 14) == 0) {
+        e->position_ms = answer_ms(ans + 14);
+    } else if (strncasecmp(ans, "length=", 7) == 0) {
+        e->duration_ms = answer_ms(ans + 7);
+        e->length_failed = e->duration_ms <= 0;
+    } else if (strncasecmp(ans, "pause=", 6) == 0) {
+        e->paused = strncasecmp(ans + 6, "yes", 3) == 0;
+    }
+    if (e->loading && seq == e->load_seq) {
+        engine_finish_load_locked(e);
+    }
+    engine_publish_locked(e);
+    pthread_mutex_unlock(&e->mutex);
+}
+
+/**
+ * @brief 发送一条命令，调用时持有锁
+ */
+static int engine_send_locked(media_engine_t *e, const char *cmd) {
+    if (!e->alive || e->cmd_fd == -1) {
+        return -1;
+    }
+    char line[1100];
+    int n = snprintf(line, sizeof(line), "%s\n", cmd);
+    if (n <= 0 || (size_t)n >= sizeof(line)) {
+        return -1;
+    }
+    // 不超过PIPE_BUF的写入是原子的：要么整条写入，要么管道已满返回EAGAIN
+    ssize_t w;
+    do {
+        w = write(e->cmd_fd, line, (size_t)n);
+    } while (w < 0 && errno == EINTR);
+    if (w != n) {
+        printf("[媒体引擎] %s 命令发送失败: %s (%s)\n", e->name, cmd, w < 0 ? strerror(errno) : "部分写入");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 发送查询并记录类型，返回这个查询的序号（等待answers达到该序号即收到回答），失败返回0
+ */
+static uint32_t engine_query_locked(media_engine_t *e, engine_query_t kind) {
+    if (engine_send_locked(e, query_cmds[kind]) != 0) {
+        return 0;
+    }
+    e->query_kind[e->queries % MEDIA_ENGINE_QUERY_RING] = (uint8_t)kind;
+    return ++e->queries;
+}
+
+/**
+ * @brief 发送一批状态查询（位置、暂停状态，时长未知时加上时长），调用时持有锁
+ *
+ * 上一批还没有全部回答时不发送：mplayer忙（如解码卡顿）时查询不会在管道中堆积。
+ * 播放结束时mplayer不输出任何内容，位置查询回答ANS_ERROR时清除loaded。
+ */
+static void engine_request_status_locked(media_engine_t *e) {
+    if (!e->alive || !e->loaded || e->queries != e->answers) {
+        return;
+    }
+    e->last_status_ms = now_ms();
+    if (engine_query_locked(e, QUERY_TIME_POS) == 0 || engine_query_locked(e, QUERY_PAUSE) == 0) {
+        return;
+    }
+    if (e->duration_ms <= 0 && !e->length_failed) {
+        engine_query_locked(e, QUERY_LENGTH);
+    }
+}
+
+// 距离下一批状态查询或加载超时的时间（poll超时），没有文件在播放时为-1（只等待输出）
+static int engine_status_timeout_locked(media_engine_t *e) {
+    if (e->alive && e->loading) {
+        uint64_t elapsed = now_ms() - e->load_start_ms;
+        if (elapsed < MEDIA_ENGINE_LOAD_TIMEOUT_MS) {
+            return (int)(MEDIA_ENGINE_LOAD_TIMEOUT_MS - elapsed);
+        }
+        // 没有回答：mplayer已无响应，结束进程组（读取线程随后读到输出结束），下一次加载重新启动
+        printf("[媒体引擎] %s 加载超时（%dms），重启mplayer: %s\n", e->name, MEDIA_ENGINE_LOAD_TIMEOUT_MS, e->load_path);
+        e->loading = false;
+        e->load_failed = true;
+        engine_publish_locked(e);
+        kill(-e->pid, SIGKILL);
+        return -1;
+    }
+    if (!e->alive || !e->loaded) {
+        return -1;
+    }
+    uint64_t interval = e->paused ? MEDIA_ENGINE_STATUS_PAUSED_MS : MEDIA_ENGINE_STATUS_MS;
+    uint64_t elapsed = now_ms() - e->last_status_ms;
+    if (elapsed >= interval) {
+        engine_request_status_locked(e);
+        return (int)interval;
+    }
+    return (int)(interval - elapsed);
+}
+
+/**
+ * @brief 读取线程：逐行读取mplayer标准输出，直到进程退出；有文件在播放时按间隔发送状态查询
+ */
+static void *engine_reader_thread(void *arg) {
+    media_engine_t *e = (media_engine_t *)arg;
+    char buf[1024];
+    size_t len = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&e->mutex);
+        int timeout = engine_status_timeout_locked(e);
+        pthread_mutex_unlock(&e->mutex);
+
+        struct pollfd pfd = { .fd = e->out_fd, .events = POLLIN };
+        int ready = poll(&pfd, 1, timeout);
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        if (ready <= 0) {
+            continue;       // 超时：回到循环开头发送查询
+        }
+
+        ssize_t n = read(e->out_fd, buf + len, sizeof(buf) - 1 - len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        len += (size_t)n;
+
+        char *start = buf;
+        char *nl;
+        while ((nl = memchr(start, '\n', (size_t)(buf + len - start))) != NULL) {
+            *nl = '\0';
+            if (nl > start && nl[-1] == '\r') {
+                nl[-1] = '\0';
+            }
+            engine_handle_line(e, start);
+            start = nl + 1;
+        }
+        len = (size_t)(buf + len - start);
+        memmove(buf, start, len);
+        if (len == sizeof(buf) - 1) {
+            // 超长的行直接处理
+            buf[len] = '\0';
+            engine_handle_line(e, buf);
+            len = 0;
+        }
+    }
+
+    close(e->out_fd);
+    waitpid(e->pid, NULL, 0);
+
+    pthread_mutex_lock(&e->mutex);
+    printf("[媒体引擎] %s mplayer已退出 (PID: %d)\n", e->name, e->pid);
+    if (e->loading) {
+        printf("[媒体引擎] %s mplayer在加载时退出: %s\n", e->name, e->load_path);
+        e->loading = false;
+        e->load_failed = true;
+    }
+    e->alive = false;
+    e->loaded = false;
+    e->paused = false;
+    engine_publish_locked(e);
+    pthread_cond_broadcast(&e->cond);
+    pthread_mutex_unlock(&e->mutex);
+    return NULL;
+}
+
+/**
+ * @brief 启动mplayer进程和读取线程（已运行时直接返回），调用时持有锁
+ */
+static int engine_spawn_locked(media_engine_t *e) {
+    if (e->alive) {
+        return 0;
+    }
+    // 上一个进程已退出：回收读取线程（它已不再使用锁）
+    if (e->reader_started) {
+        pthread_join(e->reader, NULL);
+        e->reader_started = false;
+    }
+    if (e->cmd_fd != -1) {
+        close(e->cmd_fd);
+        e->cmd_fd = -1;
+    }
+
+    int in_pipe[2];
+    int out_pipe[2];
+    if (pipe(in_pipe) == -1) {
+        perror("[媒体引擎] pipe");
+        return -1;
+    }
+    if (pipe(out_pipe) == -1) {
+        perror("[媒体引擎] pipe");
+        close(in_pipe[0]);
+        close(in_pipe[1]);
+        return -1;
+    }
+    // 管道不被其他子进程（另一个引擎的mplayer）继承，否则对方退出时读不到结束
+    for (int i = 0; i < 2; i++) {
+        fcntl(in_pipe[i], F_SETFD, FD_CLOEXEC);
+        fcntl(out_pipe[i], F_SETFD, FD_CLOEXEC);
+    }
+    // mplayer退出后写控制管道返回EPIPE，而不是终止程序
+    signal(SIGPIPE, SIG_IGN);
+
+    const char *argv[MEDIA_ENGINE_MAX_ARGS];
+    int argc = 0;
+    argv[argc++] = NULL;    // 程序路径，稍后设置
+    for (int i = 0; e->args[i] != NULL && argc < MEDIA_ENGINE_MAX_ARGS - 1; i++) {
+        argv[argc++] = e->args[i];
+    }
+    argv[argc] = NULL;
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("[媒体引擎] fork");
+        close(in_pipe[0]);
+        close(in_pipe[1]);
+        close(out_pipe[0]);
+        close(out_pipe[1]);
+        return -1;
+    }
+
+    if (pid == 0) {
+        // 子进程：标准输入为控制管道，标准输出为回答管道（dup2后的描述符不带FD_CLOEXEC）
+        dup2(in_pipe[0], STDIN_FILENO);
+        dup2(out_pipe[1], STDOUT_FILENO);
+        // 程序异常退出（包括_exit）时mplayer也退出
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        signal(SIGPIPE, SIG_DFL);
+        // 独立的进程组：强制终止时连同mplayer启动的子进程一起结束（它们也持有标准输出）
+        setpgid(0, 0);
+        if (e->framebuffer) {
+            putenv("SDL_VIDEODRIVER=fbcon");
+            putenv("SDL_FBDEV=/dev/fb0");
+        }
+
+        const char *env = getenv("MPLAYER_BIN");
+        if (env != NULL && env[0] != '\0') {
+            argv[0] = env;
+            execvp(argv[0], (char *const *)argv);
+        }
+        // 尝试多个可能的mplayer路径
+        const char *mplayer_paths[] = {
+            "/bin/mplayer",
+            "./mplayer",
+            "/usr/bin/mplayer",
+            "/system/bin/mplayer",
+            "mplayer",
+            NULL
+        };
+        for (int i = 0; mplayer_paths[i] != NULL; i++) {
+            argv[0] = mplayer_paths[i];
+            execvp(argv[0], (char *const *)argv);
+        }
+        fprintf(stderr, "[媒体引擎] 错误: 无法找到mplayer\n");
+        _exit(127);
+    }
+
+    close(in_pipe[0]);
+    close(out_pipe[1]);
+    fcntl(in_pipe[1], F_SETFL, O_NONBLOCK);
+
+    e->pid = pid;
+    e->cmd_fd = in_pipe[1];
+    e->out_fd = out_pipe[0];
+    e->alive = true;
+    e->loaded = false;
+    e->loading = false;
+    e->paused = false;
+    e->queries = 0;
+    e->answers = 0;
+    e->stale_before = 0;
+    engine_publish_locked(e);
+
+    if (pthread_create(&e->reader, NULL, engine_reader_thread, e) != 0) {
+        printf("[媒体引擎] 错误: 无法创建%s读取线程\n", e->name);
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+        close(e->cmd_fd);
+        close(e->out_fd);
+        e->cmd_fd = -1;
+        e->out_fd = -1;
+        e->pid = -1;
+        e->alive = false;
+        return -1;
+    }
+    e->reader_started = true;
+
+    printf("[媒体引擎] %s mplayer已启动（常驻，PID: %d）\n", e->name, pid);
+    return 0;
+}
+
+int media_engine_start(media_engine_role_t role) {
+    media_engine_t *e = engine_get(role);
+    if (e == NULL) {
+        return -1;
+    }
+    pthread_mutex_lock(&e->mutex);
+    int ret = engine_spawn_locked(e);
+    pthread_mutex_unlock(&e->mutex);
+    return ret;
+}
+
+int media_engine_load(media_engine_role_t role, const char *path) {
+    media_engine_t *e = engine_get(role);
+    if (e == NULL || path == NULL || path[0] == '\0') {
+        return -1;
+    }
+    // 路径放在引号中传给loadfile：不能含有换行，也不能同时含有两种引号
+    char quote = strchr(path, '"') == NULL ? '"' : '\'';
+    if (strpbrk(path, "\r\n") != NULL || (quote == '\'' && strchr(path, '\'') != NULL)) {
+        printf("[媒体引擎] 错误: 无法传给mplayer的文件名 [%s]\n", path);
+        return -1;
+    }
+    char cmd[1024];
+    if ((size_t)snprintf(cmd, sizeof(cmd), "loadfile %c%s%c", quote, path, quote) >= sizeof(cmd)) {
+        printf("[媒体引擎] 错误: 路径过长 [%s]\n", path);
+        return -1;
+    }
+
+    pthread_mutex_lock(&e->mutex);
+    if (engine_spawn_locked(e) != 0) {
+        e->load_failed = true;
+        engine_publish_locked(e);
+        pthread_mutex_unlock(&e->mutex);
+        return -1;
+    }
+
+    // 握手：loadfile之后的查询在文件打开后才会被处理，由读取线程根据回答完成加载，这里不等待
+    uint32_t seq = 0;
+    if (engine_send_locked(e, cmd) == 0) {
+        seq = engine_query_locked(e, QUERY_TIME_POS);
+    }
+    if (seq == 0) {
+        e->load_failed = true;
+        engine_publish_locked(e);
+        pthread_mutex_unlock(&e->mutex);
+        return -1;
+    }
+    // 新的曲目：之前发出的查询回答的是上一个文件
+    e->stale_before = seq;
+    e->load_seq = seq;
+    e->load_start_ms = now_ms();
+    snprintf(e->load_path, sizeof(e->load_path), "%s", path);
+    e->loading = true;
+    e->load_failed = false;
+    e->loaded = false;
+    e->paused = false;
+    e->length_failed = false;
+    e->position_ms = 0;
+    e->duration_ms = -1;
+    e->track++;
+    engine_publish_locked(e);
+    pthread_mutex_unlock(&e->mutex);
+    return 0;
+}
+
+void media_engine_stop(media_engine_role_t role) {
+    media_engine_t *e = engine_get(role);
+    if (e == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&e->mutex);
+    if (e->alive && e->loaded) {
+        engine_send_locked(e, "stop");
+    }
+    e->stale_before = e->queries + 1;
+    e->loaded = false;
+    e->loading = false;
+    e->paused = false;
+    engine_publish_locked(e);
+    pthread_mutex_unlock(&e->mutex);
+}
+
+int media_engine_command(media_engine_role_t role, const char *cmd) {
+    media_engine_t *e = engine_get(role);
+    if (e == NULL || cmd == NULL) {
+        return -1;
+    }
+    pthread_mutex_lock(&e->mutex);
+    int ret = engine_send_locked(e, cmd);
+    if (ret == 0) {
+        // 暂停、跳转、变速后马上更新状态，不等下一个间隔
+        engine_request_status_locked(e);
+    }
+    pthread_mutex_unlock(&e->mutex);
+    return ret;
+}
+
+void media_engine_get_status(media_engine_role_t role, media_engine_status_t *status) {
+    media_engine_t *e = engine_get(role);
+    memset(status, 0, sizeof(*status));
+    status->position_ms = -1;
+    status->duration_ms = -1;
+    if (e == NULL) {
+        return;
+    }
+    // seqlock：读到的序号为奇数或前后不一致时说明正在写，重读
+    for (;;) {
+        uint32_t seq = atomic_load_explicit(&e->snap_seq, memory_order_acquire);
+        if (seq & 1u) {
+            sched_yield();
+            continue;
+        }
+        uint32_t flags = atomic_load_explicit(&e->snap_flags, memory_order_relaxed);
+        int32_t position = atomic_load_explicit(&e->snap_position_ms, memory_order_relaxed);
+        int32_t duration = atomic_load_explicit(&e->snap_duration_ms, memory_order_relaxed);
+        uint32_t track = atomic_load_explicit(&e->snap_track, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&e->snap_seq, memory_order_relaxed) != seq) {
+            continue;
+        }
+        status->loaded = (flags & 1u) != 0;
+        status->paused = (flags & 2u) != 0;
+        status->loading = (flags & 4u) != 0;
+        status->failed = (flags & 8u) != 0;
+        status->position_ms = status->loaded ? position : -1;
+        status->duration_ms = status->loaded ? duration : -1;
+        status->track = track;
+        return;
+    }
+}
+
+void media_engine_format_time(char *buf, size_t size, int32_t ms) {
+    if (ms < 0) {
+        snprintf(buf, size, "--:--");
+        return;
+    }
+    int32_t sec = ms / 1000;
+    snprintf(buf, size, "%d:%02d", (int)(sec / 60), (int)(sec % 60));
+}
+
+bool media_engine_is_loaded(media_engine_role_t role) {
+    media_engine_status_t status;
+    media_engine_get_status(role, &status);
+    return status.loaded || status.loading;
+}
+
+int media_engine_get_pid(media_engine_role_t role) {
+    media_engine_t *e = engine_get(role);
+    if (e == NULL) {
+        return -1;
+    }
+    pthread_mutex_lock(&e->mutex);
+    int pid = e->alive ? (int)e->pid : -1;
+    pthread_mutex_unlock(&e->mutex);
+    return pid;
+}
+
+void media_engine_close(media_engine_role_t role) {
+    media_engine_t *e = engine_get(role);
+    if (e == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&e->mutex);
+    if (e->alive) {
+        engine_send_locked(e, "quit");
+
+        struct timespec deadline;
+        deadline_after(MEDIA_ENGINE_QUIT_TIMEOUT_MS, &deadline);
+        while (e->alive) {
+            if (pthread_cond_timedwait(&e->cond, &e->mutex, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+        if (e->alive) {
+            printf("[媒体引擎] 警告: %s mplayer未正常退出，强制终止\n", e->name);
+            kill(-e->pid, SIGKILL);
+            while (e->alive) {
+                pthread_cond_wait(&e->cond, &e->mutex);
+            }
+        }
+    }
+    if (e->reader_started) {
+        pthread_join(e->reader, NULL);
+        e->reader_started = false;
+    }
+    if (e->cmd_fd != -1) {
+        close(e->cmd_fd);
+        e->cmd_fd = -1;
+    }
+    e->pid = -1;
+    pthread_mutex_unlock(&e->mutex);
+}
@@ -0,0 +1,119 @@
+/**
+ * @file media_engine.h
+ * @brief 常驻MPlayer播放引擎：每种用途（音频、视频）一个长期运行的 mplayer -idle -slave 进程
+ *
+ * 以前每次播放都fork一个新的mplayer，再固定等待（视频1.5秒）后才打开控制管道，
+ * 切换曲目需要先quit/kill旧进程。播放引擎改为：
+ *   - 每种用途只启动一次mplayer（-idle：播放结束后不退出，等待下一条命令）
+ *   - 标准输入为常驻控制管道，曲目通过 loadfile 命令加载
+ *   - 标准输出由读取线程逐行解析，加载后发送一个查询，收到回答（ANS_）即表示加载完成（握手），
+ *     不再固定等待；加载只发送命令、不等待回答，握手结果由读取线程写入状态快照
+ *     （loading变为false，loaded或failed），文件无法播放时mplayer回答ANS_ERROR
+ *   - 握手超时时读取线程结束无响应的mplayer，下一次加载重新启动
+ *   - mplayer意外退出时下一次加载自动重新启动
+ *   - 有文件在播放时读取线程按间隔查询位置、暂停状态和时长，回答写入状态快照，
+ *     界面定时器用media_engine_get_status()无锁读取，不会等待管道
+ * 环境变量 MPLAYER_BIN 可以指定mplayer路径（如测试用的模拟脚本）。
+ * 所有函数都可以在任意线程调用。
+ */
+
+#ifndef MEDIA_ENGINE_H
+#define MEDIA_ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// 引擎用途
+typedef enum {
+    MEDIA_ENGINE_AUDIO = 0,         // 音频（无视频输出）
+    MEDIA_ENGINE_VIDEO,             // 视频（fbdev2全屏输出）
+    MEDIA_ENGINE_COUNT,
+} media_engine_role_t;
+
+// 播放状态快照
+typedef struct {
+    bool loaded;                    // 有文件正在播放（包括暂停）
+    bool paused;
+    bool loading;                   // 已发出加载，正在等待握手
+    bool failed;                    // 最近一次加载失败（无法播放、超时或mplayer退出）
+    int32_t position_ms;            // 播放位置，未知为-1
+    int32_t duration_ms;            // 总时长，未知（如网络流）为-1
+    uint32_t track;                 // 每次加载加1，用于发现曲目已切换
+} media_engine_status_t;
+
+/**
+ * @brief 启动引擎的mplayer进程（已运行时直接返回），不等待就绪
+ *
+ * 在程序启动时调用，第一次播放就不需要等待mplayer启动。
+ * @param role 引擎用途
+ * @return 成功返回0，失败返回-1
+ */
+int media_engine_start(media_engine_role_t role);
+
+/**
+ * @brief 加载并播放文件（替换正在播放的文件），不等待握手
+ *
+ * 发送loadfile和握手查询后立即返回（mplayer需要重新启动时包括fork），可以在LVGL线程调用。
+ * 状态快照的loading在握手完成前为true；之后loaded表示开始播放，failed表示文件无法播放、
+ * 超时（MEDIA_ENGINE_LOAD_TIMEOUT_MS）或mplayer退出。
+ * @param role 引擎用途
+ * @param path 文件路径
+ * @return 已发出加载返回0；路径无效、mplayer无法启动或管道已满返回-1
+ */
+int media_engine_load(media_engine_role_t role, const char *path);
+
+/**
+ * @brief 停止播放（mplayer回到空闲状态，进程保留）
+ * @param role 引擎用途
+ */
+void media_engine_stop(media_engine_role_t role);
+
+/**
+ * @brief 发送slave命令（如 "pause"、"volume +10"、"speed_set 1.5"）
+ * @param role 引擎用途
+ * @param cmd 命令（不含换行）
+ * @return 成功返回0，mplayer未运行或管道已满返回-1
+ */
+int media_engine_command(media_engine_role_t role, const char *cmd);
+
+/**
+ * @brief 是否有文件正在播放或正在加载（播放到结尾、加载失败或被停止后为false）
+ *
+ * 不阻塞：返回状态快照中的loaded或loading，播放结束最多在一个查询间隔后发现。
+ * @param role 引擎用途
+ * @return 是否正在播放
+ */
+bool media_engine_is_loaded(media_engine_role_t role);
+
+/**
+ * @brief 读取播放状态快照（无锁，不阻塞，可以在LVGL定时器中频繁调用）
+ *
+ * 播放时每250ms更新一次，暂停时每1秒；发送命令（暂停、跳转等）后立即更新。
+ * @param role 引擎用途
+ * @param status 输出的状态
+ */
+void media_engine_get_status(media_engine_role_t role, media_engine_status_t *status);
+
+/**
+ * @brief 把状态中的毫秒数（位置、时长）格式化为"m:ss"，未知（负数）时为"--:--"
+ * @param buf 输出缓冲区
+ * @param size 缓冲区大小
+ * @param ms 毫秒数
+ */
+void media_engine_format_time(char *buf, size_t size, int32_t ms);
+
+/**
+ * @brief 获取mplayer进程ID
+ * @param role 引擎用途
+ * @return 进程ID，未运行返回-1
+ */
+int media_engine_get_pid(media_engine_role_t role);
+
+/**
+ * @brief 退出mplayer进程并停止读取线程（程序退出时调用）
+ * @param role 引擎用途
+ */
+void media_engine_close(media_engine_role_t role);
+
+#endif /* MEDIA_ENGINE_H */
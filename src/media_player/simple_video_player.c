@@ -2,32 +2,27 @@
  * @file simple_video_player.c
  * @brief 简单的MPlayer全屏视频播放器实现
  * 
- * 实现方案（参考video.c，但添加FIFO控制和性能优化）：
- * 1. 使用MPlayer全屏播放视频（-vo fbdev2）
- * 2. 使用fork+execlp启动（参考video.c）
- * 3. 使用FIFO多线程控制（恢复FIFO，用于控制功能）
- * 4. 添加性能优化参数（-framedrop等）
+ * 实现方案：
+ * 1. 使用MPlayer全屏播放视频（-vo fbdev2），启动参数见media_engine.c
+ * 2. 使用常驻的视频播放引擎（media_engine）：mplayer只启动一次（-idle -slave），
+ *    播放和切换视频通过控制管道发送loadfile，等待mplayer回答后返回（不再固定等待1.5秒）
+ * 3. 播放和控制使用不同线程（触屏控制线程调用上一个/下一个等），由player_mutex保护状态
+ * 4. 性能优化参数（-framedrop等）
  */
 
 #include "simple_video_player.h"
+#include "media_engine.h"
 #include "../file_scanner/file_scanner.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <stdbool.h>
-#include <unistd.h>
-#include <fcntl.h>
-#include <sys/wait.h>
-#include <sys/stat.h>
-#include <signal.h>
 #include <pthread.h>
-#include <errno.h>
 
 // 播放器状态
 static bool is_playing = false;
 static bool is_paused = false;  // 暂停状态
-static pid_t mplayer_pid = -1;
-static int mplayer_control_pipe = -1;
 static pthread_mutex_t player_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 // 当前播放文件索引（使用全局变量）
@@ -55,148 +50,38 @@ static bool is_video_file(const char *file_path) {
  * @brief 发送MPlayer控制命令
  */
 static void send_mplayer_command(const char *cmd) {
-    if (cmd != NULL && mplayer_control_pipe != -1) {
-        char full_cmd[256];
-        snprintf(full_cmd, sizeof(full_cmd), "%s\n", cmd);
-        (void)write(mplayer_control_pipe, full_cmd, strlen(full_cmd));
-        fsync(mplayer_control_pipe);
+    if (cmd != NULL) {
+        media_engine_command(MEDIA_ENGINE_VIDEO, cmd);
     }
 }
 
 /**
- * @brief 启动MPlayer进程（参考video.c，但添加FIFO控制和性能优化参数）
+ * @brief 在常驻mplayer中加载视频（替换正在播放的视频），不等待握手
+ *
+ * 文件无法播放时握手失败，由check_mplayer_running()发现（与播放结束相同）。
  */
 static bool start_mplayer(const char *file_path) {
-    // 先停止之前的MPlayer进程（如果有，参考video.c的video_stop）
-    if (mplayer_pid != -1) {
-        kill(mplayer_pid, SIGTERM);
-        waitpid(mplayer_pid, NULL, 0);
-        mplayer_pid = -1;
-    }
-    
-    // 创建FIFO管道（用于多线程控制）
-    (void)system("rm -f /tmp/mplayer_fifo");
-    if (mkfifo("/tmp/mplayer_fifo", 0666) == -1 && errno != EEXIST) {
-        perror("mkfifo");
-        return false;
-    }
-    
-    // 使用fork+execlp方式启动MPlayer（参考video.c，但添加-slave和性能优化参数）
-    mplayer_pid = fork();
-    if (mplayer_pid == 0) {
-        // 子进程：执行MPlayer（参考video.c，但添加-slave和性能优化）
-        // 设置framebuffer环境（参考video.c）
-        putenv("SDL_VIDEODRIVER=fbcon");
-        putenv("SDL_FBDEV=/dev/fb0");
-        
-        execlp("mplayer", "mplayer",
-              "-vo", "fbdev2",        // 使用fbdev2
-              "-cache", "32768",     // 缓存大小
-              "-lavdopts", "skipframe=nonref:skiploopfilter=all:fast:threads=8",  // 解码器优化选项
-              "-vf", "scale=800:480,format=bgr24",  // 视频滤镜：缩放为800x480，格式为bgr24
-              "-framedrop",          // 抽帧减少卡顿
-              "-nocorrect-pts",      // 不校正时间戳
-              "-slave",              // 保留slave模式用于FIFO控制（触控功能需要）
-              "-input", "file=/tmp/mplayer_fifo",  // FIFO控制（触控功能需要）
-              file_path,
-              NULL);
-              
-        // 如果所有方案都失败，直接退出
-        perror("Failed to play video with mplayer (all methods failed)");
-        exit(1);
-    } else if (mplayer_pid < 0) {
-        // fork失败
-        perror("fork");
-        return false;
-    }
-    
-    // 父进程：等待MPlayer启动
-    usleep(1500000);  // 1.5秒，等待MPlayer启动
-    
-    // 验证进程是否还在运行
-    int status;
-    pid_t result = waitpid(mplayer_pid, &status, WNOHANG);
-    if (result == mplayer_pid) {
-        // 进程已退出
-        printf("错误: MPlayer启动后立即退出\n");
-        mplayer_pid = -1;
-        return false;
-    } else if (result == -1) {
-        // 错误
-        perror("waitpid");
-        mplayer_pid = -1;
+    if (media_engine_load(MEDIA_ENGINE_VIDEO, file_path) != 0) {
+        printf("错误: MPlayer无法播放 %s\n", file_path);
         return false;
     }
-    
-    // 打开FIFO用于发送控制命令
-    mplayer_control_pipe = open("/tmp/mplayer_fifo", O_WRONLY | O_NONBLOCK);
-    if (mplayer_control_pipe == -1) {
-        printf("警告: 无法打开MPlayer控制FIFO\n");
-        // 尝试再次打开
-        usleep(500000);  // 500ms
-        mplayer_control_pipe = open("/tmp/mplayer_fifo", O_WRONLY | O_NONBLOCK);
-        if (mplayer_control_pipe == -1) {
-            printf("错误: 无法打开MPlayer控制FIFO\n");
-            // 即使FIFO打开失败，如果进程在运行，也认为启动成功
-        }
+    // mplayer常驻，播放速度在文件之间保持：新视频从正常速度开始
+    if (playback_speed != 1.0f) {
+        send_mplayer_command("speed_set 1.0");
     }
-    
-    printf("[视频播放] MPlayer已启动，PID: %d\n", mplayer_pid);
+    printf("[视频播放] 正在播放: %s (PID: %d)\n", file_path, media_engine_get_pid(MEDIA_ENGINE_VIDEO));
     return true;
 }
 
 /**
- * @brief 停止MPlayer进程（参考video.c，但先尝试FIFO命令）
- */
-static void stop_mplayer(void) {
-    if (mplayer_pid != -1) {
-        // 先尝试通过FIFO发送quit命令
-        if (mplayer_control_pipe != -1) {
-            send_mplayer_command("quit");
-            close(mplayer_control_pipe);
-            mplayer_control_pipe = -1;
-            usleep(300000);  // 等待300ms
-        }
-        
-        // 使用SIGTERM终止进程（参考video.c）
-        kill(mplayer_pid, SIGTERM);
-        // 等待进程退出（参考video.c的waitpid）
-        waitpid(mplayer_pid, NULL, 0);
-        mplayer_pid = -1;
-    }
-    
-    // 清理FIFO
-    (void)system("rm -f /tmp/mplayer_fifo");
-}
-
-/**
- * @brief 检查MPlayer进程是否还在运行
+ * @brief 检查是否还有视频在播放（播放到结尾后更新状态）
  */
 static bool check_mplayer_running(void) {
-    if (mplayer_pid == -1) {
-        return false;
-    }
-    // 使用WNOHANG非阻塞检查
-    int status;
-    pid_t result = waitpid(mplayer_pid, &status, WNOHANG);
-    if (result > 0) {
-        // 进程已结束
-        printf("[视频播放] 检测到MPlayer进程已退出\n");
-        mplayer_pid = -1;
-        if (mplayer_control_pipe != -1) {
-            close(mplayer_control_pipe);
-            mplayer_control_pipe = -1;
-        }
-        is_playing = false;
-        is_paused = false;
-        return false;
-    } else if (result == -1) {
-        // 错误（可能是进程不存在）
-        perror("[视频播放] waitpid检查失败");
-        mplayer_pid = -1;
-        if (mplayer_control_pipe != -1) {
-            close(mplayer_control_pipe);
-            mplayer_control_pipe = -1;
+    media_engine_status_t status;
+    media_engine_get_status(MEDIA_ENGINE_VIDEO, &status);
+    if (!status.loaded && !status.loading) {
+        if (is_playing) {
+            printf(status.failed ? "错误: MPlayer无法播放当前视频\n" : "[视频播放] 检测到视频已结束\n");
         }
         is_playing = false;
         is_paused = false;
@@ -206,46 +91,19 @@ static bool check_mplayer_running(void) {
 }
 
 /**
- * @brief 强制停止MPlayer进程（参考video.c，但先尝试FIFO命令）
+ * @brief 强制停止播放（不等待，mplayer回到空闲状态）
  */
 static void force_stop_mplayer(void) {
     printf("[视频播放] 开始强制停止MPlayer\n");
     
-    // 先检查进程是否还在运行
+    // 先检查是否还在播放
     if (!check_mplayer_running()) {
-        printf("[视频播放] MPlayer进程已退出，无需停止\n");
-        // 清理FIFO
-        (void)system("rm -f /tmp/mplayer_fifo");
+        printf("[视频播放] 视频已结束，无需停止\n");
         return;
     }
     
-    // 先尝试通过FIFO发送quit命令
-    if (mplayer_control_pipe != -1) {
-        send_mplayer_command("quit");
-        close(mplayer_control_pipe);
-        mplayer_control_pipe = -1;
-        usleep(200000);  // 等待200ms
-    }
-    
-    // 再次检查进程是否还在运行（可能已经通过quit命令退出）
-    if (!check_mplayer_running()) {
-        printf("[视频播放] MPlayer已通过quit命令退出\n");
-        // 清理FIFO
-        (void)system("rm -f /tmp/mplayer_fifo");
-        return;
-    }
-    
-    // 使用SIGTERM终止进程（参考video.c）
-    if (mplayer_pid != -1) {
-        kill(mplayer_pid, SIGTERM);
-        waitpid(mplayer_pid, NULL, 0);
-        mplayer_pid = -1;
-    }
-    
-    // 清理FIFO
-    (void)system("rm -f /tmp/mplayer_fifo");
-    
-    printf("[视频播放] MPlayer已完全停止\n");
+    media_engine_stop(MEDIA_ENGINE_VIDEO);
+    printf("[视频播放] MPlayer已停止播放\n");
 }
 
 /**
@@ -254,9 +112,10 @@ static void force_stop_mplayer(void) {
 void simple_video_init(void) {
     is_playing = false;
     is_paused = false;
-    mplayer_pid = -1;
-    mplayer_control_pipe = -1;
     playback_speed = 1.0f;
+    
+    // 启动常驻mplayer（不等待），第一次播放时已就绪
+    media_engine_start(MEDIA_ENGINE_VIDEO);
 }
 
 /**
@@ -267,21 +126,12 @@ void simple_video_init(void) {
 bool simple_video_play(const char *file_path) {
     pthread_mutex_lock(&player_mutex);
     
-    // 如果正在播放，先停止并等待完全退出
-    if (is_playing) {
-        stop_mplayer();
-        is_playing = false;
-        is_paused = false;
-        // 等待MPlayer完全退出和framebuffer恢复
-        usleep(500000);  // 500ms
-    }
-    
     if (file_path == NULL || !is_video_file(file_path)) {
         pthread_mutex_unlock(&player_mutex);
         return false;
     }
     
-    // 启动MPlayer
+    // 加载新视频（正在播放的视频由loadfile直接替换）
     if (start_mplayer(file_path)) {
         is_playing = true;
         is_paused = false;
@@ -290,35 +140,20 @@ bool simple_video_play(const char *file_path) {
         return true;
     }
     
+    is_playing = false;
+    is_paused = false;
     pthread_mutex_unlock(&player_mutex);
     return false;
 }
 
 /**
- * @brief 停止播放（参考video.c，但先尝试FIFO命令）
+ * @brief 停止播放（mplayer回到空闲状态，不退出）
  */
 void simple_video_stop(void) {
     pthread_mutex_lock(&player_mutex);
     
     if (is_playing) {
-        // 先尝试通过FIFO发送quit命令
-        if (mplayer_control_pipe != -1) {
-            send_mplayer_command("quit");
-            close(mplayer_control_pipe);
-            mplayer_control_pipe = -1;
-            usleep(200000);  // 等待200ms
-        }
-        
-        // 使用SIGTERM终止进程（参考video.c）
-        if (mplayer_pid != -1) {
-            kill(mplayer_pid, SIGTERM);
-            waitpid(mplayer_pid, NULL, 0);
-            mplayer_pid = -1;
-        }
-        
-        // 清理FIFO
-        (void)system("rm -f /tmp/mplayer_fifo");
-        
+        media_engine_stop(MEDIA_ENGINE_VIDEO);
         is_playing = false;
         is_paused = false;
     }
@@ -344,7 +179,7 @@ void simple_video_force_stop(void) {
 void simple_video_toggle_pause(void) {
     pthread_mutex_lock(&player_mutex);
     
-    if (is_playing && mplayer_control_pipe != -1) {
+    if (is_playing) {
         send_mplayer_command("pause");
         is_paused = !is_paused;  // 切换暂停状态
         printf("视频%s\n", is_paused ? "已暂停" : "已恢复播放");
@@ -354,80 +189,46 @@ void simple_video_toggle_pause(void) {
 }
 
 /**
- * @brief 上一首
+ * @brief 从当前视频开始按step方向查找另一个视频文件并复制路径
+ *
+ * 视频列表可能被媒体索引在主线程中更新，查找和复制期间加锁。
+ * @return 找到的索引，没有其他视频返回-1
  */
-void simple_video_prev(void) {
-    pthread_mutex_lock(&player_mutex);
+static int find_adjacent_video(int step, char *path, size_t size) {
+    int found = -1;
     
-    if (!is_playing) {
-        pthread_mutex_unlock(&player_mutex);
-        return;
-    }
+    media_index_lock();
     
-    // 查找上一个视频文件
     extern char **video_files;
     extern int video_count;
     
-    if (video_files == NULL || video_count == 0) {
-        pthread_mutex_unlock(&player_mutex);
-        return;
-    }
-    
-    extern int current_video_index;
-    int start_index = (current_video_index >= 0) ? current_video_index : 0;
-    int index = start_index;
-    
-    do {
-        index--;
-        if (index < 0) {
-            index = video_count - 1;
-        }
-        
-        if (index == start_index) {
-            // 已经循环一圈，没有找到其他视频
-            pthread_mutex_unlock(&player_mutex);
-            return;
-        }
+    if (video_files != NULL && video_count > 0) {
+        int start_index = (current_video_index >= 0 && current_video_index < video_count) ? current_video_index : 0;
+        int index = start_index;
         
-        const char *prev_file = video_files[index];
-        if (prev_file != NULL && is_video_file(prev_file)) {
-            // 停止当前播放
-            if (mplayer_control_pipe != -1) {
-                send_mplayer_command("quit");
-                close(mplayer_control_pipe);
-                mplayer_control_pipe = -1;
-            }
-            
-            if (mplayer_pid != -1) {
-                kill(mplayer_pid, SIGTERM);
-                waitpid(mplayer_pid, NULL, 0);
-                mplayer_pid = -1;
+        while (1) {
+            index = (index + step + video_count) % video_count;
+            if (index == start_index) {
+                // 已经循环一圈，没有找到其他视频
+                break;
             }
-            
-            (void)system("rm -f /tmp/mplayer_fifo");
-            usleep(300000);
-            
-            // 播放新视频
-            printf("切换到视频: %s\n", prev_file);
-            current_video_index = index;
-            if (start_mplayer(prev_file)) {
-                is_playing = true;
-                is_paused = false;
-            } else {
-                is_playing = false;
-                is_paused = false;
+            if (video_files[index] != NULL && is_video_file(video_files[index])) {
+                snprintf(path, size, "%s", video_files[index]);
+                found = index;
+                break;
             }
-            break;
         }
-    } while (index != start_index);
+    }
     
-    pthread_mutex_unlock(&player_mutex);
+    media_index_unlock();
+    return found;
 }
 
 /**
- * @brief 下一首
+ * @brief 停止当前视频并切换到列表中的另一个视频
+ * @param step -1为上一个，1为下一个
  */
-void simple_video_next(void) {
+static void switch_video(int step) {
     pthread_mutex_lock(&player_mutex);
     
     if (!is_playing) {
@@ -435,73 +236,49 @@ void simple_video_next(void) {
         return;
     }
     
-    // 查找下一个视频文件
-    extern char **video_files;
-    extern int video_count;
-    
-    if (video_files == NULL || video_count == 0) {
+    char file_path[512];
+    int index = find_adjacent_video(step, file_path, sizeof(file_path));
+    if (index < 0) {
         pthread_mutex_unlock(&player_mutex);
         return;
     }
     
-    extern int current_video_index;
-    int start_index = (current_video_index >= 0) ? current_video_index : 0;
-    int index = start_index;
-    
-    do {
-        index++;
-        if (index >= video_count) {
-            index = 0;
-        }
-        
-        if (index == start_index) {
-            // 已经循环一圈，没有找到其他视频
-            pthread_mutex_unlock(&player_mutex);
-            return;
-        }
-        
-        const char *next_file = video_files[index];
-        if (next_file != NULL && is_video_file(next_file)) {
-            // 停止当前播放
-            if (mplayer_control_pipe != -1) {
-                send_mplayer_command("quit");
-                close(mplayer_control_pipe);
-                mplayer_control_pipe = -1;
-            }
-            
-            if (mplayer_pid != -1) {
-                kill(mplayer_pid, SIGTERM);
-                waitpid(mplayer_pid, NULL, 0);
-                mplayer_pid = -1;
-            }
-            
-            (void)system("rm -f /tmp/mplayer_fifo");
-            usleep(300000);
-            
-            // 播放新视频
-            printf("切换到视频: %s\n", next_file);
-            current_video_index = index;
-            if (start_mplayer(next_file)) {
-                is_playing = true;
-                is_paused = false;
-            } else {
-                is_playing = false;
-                is_paused = false;
-            }
-            break;
-        }
-    } while (index != start_index);
+    // 播放新视频（loadfile直接替换当前视频，不重启mplayer）
+    printf("切换到视频: %s\n", file_path);
+    current_video_index = index;
+    if (start_mplayer(file_path)) {
+        is_playing = true;
+        is_paused = false;
+        playback_speed = 1.0f;
+    } else {
+        is_playing = false;
+        is_paused = false;
+    }
     
     pthread_mutex_unlock(&player_mutex);
 }
 
+/**
+ * @brief 上一首
+ */
+void simple_video_prev(void) {
+    switch_video(-1);
+}
+
+/**
+ * @brief 下一首
+ */
+void simple_video_next(void) {
+    switch_video(1);
+}
+
 /**
  * @brief 加速播放
  */
 void simple_video_speed_up(void) {
     pthread_mutex_lock(&player_mutex);
     
-    if (is_playing && mplayer_control_pipe != -1) {
+    if (is_playing) {
         playback_speed += 0.1f;
         if (playback_speed > 2.0f) {
             playback_speed = 2.0f;
@@ -522,7 +299,7 @@ void simple_video_speed_up(void) {
 void simple_video_speed_down(void) {
     pthread_mutex_lock(&player_mutex);
     
-    if (is_playing && mplayer_control_pipe != -1) {
+    if (is_playing) {
         playback_speed -= 0.1f;
         if (playback_speed < 0.5f) {
             playback_speed = 0.5f;
@@ -543,7 +320,7 @@ void simple_video_speed_down(void) {
 void simple_video_volume_up(void) {
     pthread_mutex_lock(&player_mutex);
     
-    if (is_playing && mplayer_control_pipe != -1) {
+    if (is_playing) {
         send_mplayer_command("volume +10");
     }
     
@@ -556,7 +333,7 @@ void simple_video_volume_up(void) {
 void simple_video_volume_down(void) {
     pthread_mutex_lock(&player_mutex);
     
-    if (is_playing && mplayer_control_pipe != -1) {
+    if (is_playing) {
         send_mplayer_command("volume -10");
     }
     
@@ -571,38 +348,9 @@ bool simple_video_is_playing(void) {
     bool result;
     pthread_mutex_lock(&player_mutex);
     
-    // 如果状态显示正在播放，检查进程是否还在运行
+    // 如果状态显示正在播放，检查视频是否已播放到结尾
     if (is_playing) {
-        // 检查进程是否还在运行，如果已退出则更新状态
-        if (mplayer_pid != -1) {
-            int status;
-            pid_t wait_result = waitpid(mplayer_pid, &status, WNOHANG);
-            if (wait_result > 0) {
-                // 进程已结束
-                printf("[视频播放] 检测到MPlayer进程已退出，更新播放状态\n");
-                mplayer_pid = -1;
-                if (mplayer_control_pipe != -1) {
-                    close(mplayer_control_pipe);
-                    mplayer_control_pipe = -1;
-                }
-                is_playing = false;
-                is_paused = false;
-            } else if (wait_result == -1) {
-                // 错误（可能是进程不存在）
-                printf("[视频播放] 检查MPlayer进程状态失败，更新播放状态\n");
-                mplayer_pid = -1;
-                if (mplayer_control_pipe != -1) {
-                    close(mplayer_control_pipe);
-                    mplayer_control_pipe = -1;
-                }
-                is_playing = false;
-                is_paused = false;
-            }
-        } else {
-            // PID无效，认为已停止
-            is_playing = false;
-            is_paused = false;
-        }
+        check_mplayer_running();
     }
     
     result = is_playing;
@@ -611,8 +359,16 @@ bool simple_video_is_playing(void) {
 }
 
 /**
- * @brief 清理资源
+ * @brief 获取播放进度
+ */
+void simple_video_get_status(media_engine_status_t *status) {
+    media_engine_get_status(MEDIA_ENGINE_VIDEO, status);
+}
+
+/**
+ * @brief 清理资源（退出常驻mplayer）
  */
 void simple_video_cleanup(void) {
     simple_video_force_stop();
+    media_engine_close(MEDIA_ENGINE_VIDEO);
 }
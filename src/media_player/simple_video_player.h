@@ -3,7 +3,7 @@
  * @brief 简单的MPlayer全屏视频播放器
  * 
  * 功能：
- * - 使用MPlayer全屏播放视频
+ * - 使用常驻的MPlayer全屏播放视频（media_engine，切换视频不重启进程）
  * - 触屏手势控制（左上返回、左下上一首、右下下一首、右上暂停、滑动控制）
  * - 播放和控制使用不同线程
  */
@@ -12,6 +12,7 @@
 #define SIMPLE_VIDEO_PLAYER_H
 
 #include <stdbool.h>
+#include "media_engine.h"
 
 /**
  * @brief 初始化视频播放器
@@ -31,7 +32,7 @@ bool simple_video_play(const char *file_path);
 void simple_video_stop(void);
 
 /**
- * @brief 强制停止播放（立即使用SIGKILL终止mplayer进程）
+ * @brief 强制停止播放（不加锁、不等待，常驻mplayer回到空闲状态）
  */
 void simple_video_force_stop(void);
 
@@ -77,7 +78,13 @@ void simple_video_volume_down(void);
 bool simple_video_is_playing(void);
 
 /**
- * @brief 清理资源
+ * @brief 获取播放进度（无锁读取状态快照，不阻塞，用于界面定时器）
+ * @param status 输出的状态（位置、时长、是否暂停）
+ */
+void simple_video_get_status(media_engine_status_t *status);
+
+/**
+ * @brief 清理资源（退出常驻mplayer，程序退出时调用）
  */
 void simple_video_cleanup(void);
 
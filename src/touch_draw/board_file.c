@@ -0,0 +1,252 @@
+/**
+ * @file board_file.c
+ * @brief 画板保存/载入实现
+ */
+
+#include "board_file.h"
+#include "../collaborative_draw/draw_protocol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const uint8_t g_board_magic[4] = { 'T', 'D', 'B', '1' };
+
+static uint64_t board_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// 一带是否整体为背景色
+static bool band_is_background(const uint32_t *src, int w, int rows, int stride, uint32_t background) {
+    for (int r = 0; r < rows; r++, src += stride) {
+        for (int c = 0; c < w; c++) {
+            if (src[c] != background) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int board_file_save(const char *path, const stroke_surface_t *surface, int x, int y, int w, int h,
+                    uint32_t background, board_file_info_t *info) {
+    uint64_t start_us = board_now_us();
+    if (!path || !surface || !surface->pixels || x < 0 || y < 0 || w <= 0 || h <= 0 ||
+        w > 0xFFFF || h > 0xFFFF || x + w > surface->width || y + h > surface->height) {
+        return -1;
+    }
+
+    int band_count = (h + BOARD_FILE_BAND_ROWS - 1) / BOARD_FILE_BAND_ROWS;
+    // 最坏情况每个像素一个游程：1字节游程 + 4字节颜色字面量
+    size_t enc_cap = (size_t)w * BOARD_FILE_BAND_ROWS * 5 + 16;
+    uint8_t *enc = malloc(enc_cap);
+    uint8_t *table = calloc(band_count, 4);
+    if (!enc || !table) {
+        free(enc);
+        free(table);
+        return -1;
+    }
+
+    char tmp_path[512];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *fp = fopen(tmp_path, "wb");
+    if (!fp) {
+        free(enc);
+        free(table);
+        return -1;
+    }
+
+    // 先写占位的文件头和长度表，数据写完后回填
+    uint8_t header[BOARD_FILE_HEADER_SIZE] = {0};
+    bool ok = fwrite(header, 1, sizeof(header), fp) == sizeof(header) &&
+              fwrite(table, 4, band_count, fp) == (size_t)band_count;
+
+    uint32_t total = 0;
+    for (int b = 0; ok && b < band_count; b++) {
+        int row0 = b * BOARD_FILE_BAND_ROWS;
+        int rows = h - row0 < BOARD_FILE_BAND_ROWS ? h - row0 : BOARD_FILE_BAND_ROWS;
+        const uint32_t *src = surface->pixels + (size_t)(y + row0) * surface->stride + x;
+        if (band_is_background(src, w, rows, surface->stride, background)) {
+            continue;
+        }
+        int n = draw_tile_encode(src, w, rows, surface->stride, enc, enc_cap);
+        if (n <= 0 || fwrite(enc, 1, n, fp) != (size_t)n) {
+            ok = false;
+            break;
+        }
+        put_u32(table + b * 4, (uint32_t)n);
+        total += (uint32_t)n;
+    }
+
+    if (ok) {
+        memcpy(header, g_board_magic, 4);
+        put_u16(header + 4, BOARD_FILE_VERSION);
+        put_u16(header + 6, BOARD_FILE_BAND_ROWS);
+        put_u16(header + 8, (uint16_t)w);
+        put_u16(header + 10, (uint16_t)h);
+        put_u32(header + 12, background);
+        put_u32(header + 16, (uint32_t)band_count);
+        put_u32(header + 20, total);
+        ok = fseek(fp, 0, SEEK_SET) == 0 &&
+             fwrite(header, 1, sizeof(header), fp) == sizeof(header) &&
+             fwrite(table, 4, band_count, fp) == (size_t)band_count;
+    }
+    free(enc);
+    free(table);
+
+    if (fclose(fp) != 0 || !ok || rename(tmp_path, path) != 0) {
+        remove(tmp_path);
+        return -1;
+    }
+
+    if (info) {
+        info->width = w;
+        info->height = h;
+        info->background = background;
+        info->file_bytes = BOARD_FILE_HEADER_SIZE + (size_t)band_count * 4 + total;
+        info->elapsed_us = (uint32_t)(board_now_us() - start_us);
+    }
+    return 0;
+}
+
+int board_file_decode(const uint8_t *data, size_t len, const stroke_surface_t *surface, int x, int y,
+                      board_file_info_t *info) {
+    uint64_t start_us = board_now_us();
+    if (!data || !surface || !surface->pixels || len < BOARD_FILE_HEADER_SIZE ||
+        memcmp(data, g_board_magic, 4) != 0 || get_u16(data + 4) != BOARD_FILE_VERSION) {
+        return -1;
+    }
+
+    int band_rows = get_u16(data + 6);
+    int w = get_u16(data + 8);
+    int h = get_u16(data + 10);
+    uint32_t background = get_u32(data + 12);
+    uint32_t band_count = get_u32(data + 16);
+    uint32_t total = get_u32(data + 20);
+    // 用减法核对长度，32位size_t下头部+长度表+数据相加可能回绕
+    if (band_rows <= 0 || w <= 0 || h <= 0 ||
+        band_count != (uint32_t)((h + band_rows - 1) / band_rows) ||
+        band_count > (len - BOARD_FILE_HEADER_SIZE) / 4 ||
+        total > len - BOARD_FILE_HEADER_SIZE - (size_t)band_count * 4) {
+        return -1;
+    }
+    if (x < 0 || y < 0 || x + w > surface->width || y + h > surface->height) {
+        printf("[画板文件] 画板尺寸%dx%d超出目标区域\n", w, h);
+        return -1;
+    }
+
+    // 全部分块先解码到临时图像，都成功后才写入framebuffer：损坏的文件不会改写画板
+    uint32_t *image = malloc((size_t)w * h * sizeof(uint32_t));
+    if (!image) {
+        return -1;
+    }
+
+    // 长度表之和必须等于数据长度，否则不是完整的文件
+    const uint8_t *table = data + BOARD_FILE_HEADER_SIZE;
+    uint64_t sum = 0;
+    for (uint32_t b = 0; b < band_count; b++) {
+        sum += get_u32(table + b * 4);
+    }
+    if (sum != total) {
+        free(image);
+        return -1;
+    }
+
+    const uint8_t *p = table + (size_t)band_count * 4;
+    const uint8_t *end = p + total;
+    int ret = 0;
+    for (uint32_t b = 0; b < band_count; b++) {
+        int row0 = (int)b * band_rows;
+        int rows = h - row0 < band_rows ? h - row0 : band_rows;
+        uint32_t n = get_u32(table + b * 4);
+        uint32_t *band = image + (size_t)row0 * w;
+
+        if (n == 0) {
+            for (size_t i = 0; i < (size_t)w * rows; i++) {
+                band[i] = background;
+            }
+            continue;
+        }
+        if (n > (size_t)(end - p) || draw_tile_decode(p, n, band, w * rows) != 0) {
+            ret = -1;
+            break;
+        }
+        p += n;
+    }
+    if (ret == 0) {
+        uint32_t *dst = surface->pixels + (size_t)y * surface->stride + x;
+        for (int r = 0; r < h; r++, dst += surface->stride) {
+            memcpy(dst, image + (size_t)r * w, w * sizeof(uint32_t));
+        }
+    }
+    free(image);
+
+    if (ret == 0 && info) {
+        info->width = w;
+        info->height = h;
+        info->background = background;
+        info->file_bytes = len;
+        info->elapsed_us = (uint32_t)(board_now_us() - start_us);
+    }
+    return ret;
+}
+
+int board_file_load(const char *path, const stroke_surface_t *surface, int x, int y,
+                    board_file_info_t *info) {
+    uint64_t start_us = board_now_us();
+    if (!path) {
+        return -1;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < BOARD_FILE_HEADER_SIZE) {
+        close(fd);
+        return -1;
+    }
+    size_t len = (size_t)st.st_size;
+    void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+    madvise(map, len, MADV_SEQUENTIAL);
+
+    int ret = board_file_decode((const uint8_t *)map, len, surface, x, y, info);
+    munmap(map, len);
+
+    if (ret == 0 && info) {
+        info->elapsed_us = (uint32_t)(board_now_us() - start_us);
+    }
+    return ret;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file board_file.h
+ * @brief 画板保存/载入（按行带RLE压缩的文件格式）
+ *
+ * 画板区域按BOARD_FILE_BAND_ROWS行一带，每带用画布快照相同的RLE编码
+ * （draw_tile_encode，最近使用颜色表 + 游程），整带为背景色时不存数据。
+ * 保存时直接从framebuffer逐带编码写出，不拷贝整屏；
+ * 载入时mmap文件，逐带解码到一带大小的缓冲区再写入framebuffer。
+ *
+ * 文件格式（小端）：
+ *   文件头 24字节：[魔数"TDB1"] [版本 u16] [每带行数 u16] [宽 u16] [高 u16] [背景色 u32] [带数 u32] [数据总长 u32]
+ *   带长度表：带数 * u32（0表示整带为背景色）
+ *   各带RLE数据依次存放
+ *
+ * 本模块不加锁，调用者在保存、载入时持有对应framebuffer的锁。
+ */
+
+#ifndef BOARD_FILE_H
+#define BOARD_FILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "stroke_raster.h"
+
+#define BOARD_FILE_VERSION 1
+#define BOARD_FILE_BAND_ROWS 16                // 每带行数
+#define BOARD_FILE_HEADER_SIZE 24
+
+// 保存/载入结果
+typedef struct {
+    int width;                      // 画板宽度
+    int height;                     // 画板高度
+    uint32_t background;            // 背景色
+    size_t file_bytes;              // 文件大小
+    uint32_t elapsed_us;            // 耗时（微秒）
+} board_file_info_t;
+
+/**
+ * @brief 把画板区域保存到文件（先写临时文件再rename）
+ * @param path 文件路径
+ * @param surface 画板所在的framebuffer
+ * @param x 区域左上角X
+ * @param y 区域左上角Y
+ * @param w 区域宽度
+ * @param h 区域高度
+ * @param background 背景色（整带为背景色时不存数据）
+ * @param info 输出结果（可为NULL）
+ * @return 成功返回0，失败返回-1
+ */
+int board_file_save(const char *path, const stroke_surface_t *surface, int x, int y, int w, int h,
+                    uint32_t background, board_file_info_t *info);
+
+/**
+ * @brief 从文件载入画板（mmap读取），写到framebuffer的(x, y)处
+ * @param path 文件路径
+ * @param surface 目标framebuffer
+ * @param x 写入位置X
+ * @param y 写入位置Y
+ * @param info 输出结果（可为NULL）
+ * @return 成功返回0，文件不存在、格式错误或超出framebuffer范围返回-1（此时framebuffer不变）
+ */
+int board_file_load(const char *path, const stroke_surface_t *surface, int x, int y,
+                    board_file_info_t *info);
+
+/**
+ * @brief 从内存中的画板数据解码（格式与文件相同，用于网络传输等场景）
+ * @param data 数据
+ * @param len 数据长度
+ * @param surface 目标framebuffer
+ * @param x 写入位置X
+ * @param y 写入位置Y
+ * @param info 输出结果（可为NULL）
+ * @return 成功返回0，失败返回-1
+ */
+int board_file_decode(const uint8_t *data, size_t len, const stroke_surface_t *surface, int x, int y,
+                      board_file_info_t *info);
+
+#endif /* BOARD_FILE_H */
@@ -0,0 +1,258 @@
+/**
+ * @file ink_filter.c
+ * @brief 笔迹输入滤波实现
+ */
+
+#include "ink_filter.h"
+#include <math.h>
+#include <string.h>
+
+#define INK_PI 3.14159265f
+#define INK_MIN_DT 0.001f                      // 时间差下限（秒），同一时刻的采样按1ms计
+#define INK_MAX_DT 0.1f                        // 时间差上限（秒），停顿后不把速度算得过小
+#define INK_PREDICT_MIN_SPEED 20.0f            // 低于该速度（像素/秒）不预测，避免笔尖静止时抖动
+
+void ink_filter_default_config(ink_filter_config_t *config) {
+    config->min_distance = 1.5f;
+    config->min_cutoff = 3.0f;
+    config->beta = 0.05f;
+    config->d_cutoff = 10.0f;
+    config->flatness_px = 0.5f;
+    config->predict_us = 16000;
+    config->max_predict_px = 20.0f;
+}
+
+void ink_filter_init(ink_filter_t *filter, const ink_filter_config_t *config) {
+    memset(filter, 0, sizeof(*filter));
+    if (config) {
+        filter->config = *config;
+    } else {
+        ink_filter_default_config(&filter->config);
+    }
+}
+
+// 一阶低通的平滑系数
+static float ink_alpha(float cutoff, float dt) {
+    float tau = 1.0f / (2.0f * INK_PI * cutoff);
+    return 1.0f / (1.0f + tau / dt);
+}
+
+static int ink_round(float v) {
+    return (int)lroundf(v);
+}
+
+// 追加一个输出点（与上一个输出点相同时跳过）
+static int ink_emit(ink_filter_t *filter, int x, int y, ink_point_t *out, int n, int max_out) {
+    if (n >= max_out || (x == filter->last_out.x && y == filter->last_out.y)) {
+        return n;
+    }
+    out[n].x = x;
+    out[n].y = y;
+    filter->last_out = out[n];
+    filter->stats.emitted++;
+    return n + 1;
+}
+
+int ink_filter_down(ink_filter_t *filter, int x, int y, uint64_t t_us, ink_point_t *out, int max_out) {
+    filter->active = true;
+    filter->last_us = t_us;
+    filter->last_raw_us = t_us;
+    filter->acc_x = filter->raw_x = filter->fx = (float)x;
+    filter->acc_y = filter->raw_y = filter->fy = (float)y;
+    filter->vx = 0.0f;
+    filter->vy = 0.0f;
+    filter->px[2] = (float)x;
+    filter->py[2] = (float)y;
+    filter->count = 1;
+    filter->stats.raw_samples++;
+    if (max_out < 1) {
+        return 0;
+    }
+    out[0].x = x;
+    out[0].y = y;
+    filter->last_out = out[0];
+    filter->stats.emitted++;
+    return 1;
+}
+
+int ink_filter_move(ink_filter_t *filter, int x, int y, uint64_t t_us, ink_point_t *out, int max_out) {
+    if (!filter->active) {
+        return ink_filter_down(filter, x, y, t_us, out, max_out);
+    }
+    const ink_filter_config_t *cfg = &filter->config;
+    filter->stats.raw_samples++;
+    filter->raw_x = (float)x;
+    filter->raw_y = (float)y;
+    float raw_dt = t_us > filter->last_raw_us ? (float)(t_us - filter->last_raw_us) / 1000000.0f : INK_MIN_DT;
+    if (raw_dt > INK_MAX_DT) raw_dt = INK_MAX_DT;
+    filter->last_raw_us = t_us;
+
+    // 合并：离上一个有效采样太近的采样只更新最新位置（抬起时补上），
+    // 速度向自上一个有效采样以来的平均速度收敛，笔尖停住时预测段随之缩短消失
+    float mx = (float)x - filter->acc_x;
+    float my = (float)y - filter->acc_y;
+    if (mx * mx + my * my < cfg->min_distance * cfg->min_distance) {
+        float since = t_us > filter->last_us ? (float)(t_us - filter->last_us) / 1000000.0f : INK_MIN_DT;
+        if (since < INK_MIN_DT) since = INK_MIN_DT;
+        float a_d = ink_alpha(cfg->d_cutoff, raw_dt < INK_MIN_DT ? INK_MIN_DT : raw_dt);
+        filter->vx += a_d * (mx / since - filter->vx);
+        filter->vy += a_d * (my / since - filter->vy);
+        filter->stats.coalesced++;
+        return 0;
+    }
+    filter->acc_x = (float)x;
+    filter->acc_y = (float)y;
+
+    float dt = t_us > filter->last_us ? (float)(t_us - filter->last_us) / 1000000.0f : INK_MIN_DT;
+    if (dt < INK_MIN_DT) dt = INK_MIN_DT;
+    if (dt > INK_MAX_DT) dt = INK_MAX_DT;
+    filter->last_us = t_us;
+
+    // 一欧元滤波：速度先低通，截止频率按速度大小升高（两轴共用，避免斜线方向上滤波不一致）
+    float a_d = ink_alpha(cfg->d_cutoff, dt);
+    filter->vx += a_d * (((float)x - filter->fx) / dt - filter->vx);
+    filter->vy += a_d * (((float)y - filter->fy) / dt - filter->vy);
+    float speed = sqrtf(filter->vx * filter->vx + filter->vy * filter->vy);
+    float a = ink_alpha(cfg->min_cutoff + cfg->beta * speed, dt);
+    filter->fx += a * ((float)x - filter->fx);
+    filter->fy += a * ((float)y - filter->fy);
+
+    // 滤波点入队：P0、P1、P2（P2为最新）
+    filter->px[0] = filter->px[1];
+    filter->py[0] = filter->py[1];
+    filter->px[1] = filter->px[2];
+    filter->py[1] = filter->py[2];
+    filter->px[2] = filter->fx;
+    filter->py[2] = filter->fy;
+    if (filter->count < 3) {
+        filter->count++;
+    }
+    float p0x = filter->count >= 3 ? filter->px[0] : filter->px[1];
+    float p0y = filter->count >= 3 ? filter->py[0] : filter->py[1];
+    float p1x = filter->px[1], p1y = filter->py[1];
+    float p2x = filter->px[2], p2y = filter->py[2];
+
+    // P1到P2的Hermite曲线：起点切线取Catmull-Rom的(P2-P0)/2；终点还没有下一个点，
+    // 把起点切线按弦方向镜像作为终点切线（按曲率不变外推，圆弧上正好是终点切线）
+    float m1x = (p2x - p0x) * 0.5f, m1y = (p2y - p0y) * 0.5f;
+    float dx = p2x - p1x, dy = p2y - p1y;
+    float d2 = dx * dx + dy * dy;
+    float m2x = dx, m2y = dy;
+    if (d2 > 0.0f) {
+        float k = 2.0f * (m1x * dx + m1y * dy) / d2;
+        m2x = k * dx - m1x;
+        m2y = k * dy - m1y;
+    }
+    // 曲线偏离弦最多约(4/27)*(|m1 - 弦| + |m2 - 弦|)，分成n段后偏离按n^2减小；
+    // 直线部分只输出一段，避免多余的圆头重叠
+    float bulge = 0.15f * (sqrtf((m1x - dx) * (m1x - dx) + (m1y - dy) * (m1y - dy)) +
+                           sqrtf((m2x - dx) * (m2x - dx) + (m2y - dy) * (m2y - dy)));
+    int pieces = bulge > cfg->flatness_px ? (int)ceilf(sqrtf(bulge / cfg->flatness_px)) : 1;
+    int limit = max_out < INK_FILTER_MAX_POINTS ? max_out : INK_FILTER_MAX_POINTS;
+    if (pieces < 1) pieces = 1;
+    if (pieces > limit) pieces = limit;
+
+    int n = 0;
+    for (int i = 1; i <= pieces; i++) {
+        float t = (float)i / (float)pieces;
+        float t2 = t * t;
+        float t3 = t2 * t;
+        float h00 = 2.0f * t3 - 3.0f * t2 + 1.0f;
+        float h10 = t3 - 2.0f * t2 + t;
+        float h01 = -2.0f * t3 + 3.0f * t2;
+        float h11 = t3 - t2;
+        float cx = h00 * p1x + h10 * m1x + h01 * p2x + h11 * m2x;
+        float cy = h00 * p1y + h10 * m1y + h01 * p2y + h11 * m2y;
+        n = ink_emit(filter, ink_round(cx), ink_round(cy), out, n, max_out);
+    }
+    return n;
+}
+
+int ink_filter_up(ink_filter_t *filter, ink_point_t *out, int max_out) {
+    if (!filter->active) {
+        return 0;
+    }
+    filter->active = false;
+    // 滤波有少量滞后，抬起时直接补到最后一个真实采样
+    return ink_emit(filter, ink_round(filter->raw_x), ink_round(filter->raw_y), out, 0, max_out);
+}
+
+bool ink_filter_predict(const ink_filter_t *filter, ink_point_t *pt) {
+    const ink_filter_config_t *cfg = &filter->config;
+    if (!filter->active || cfg->predict_us == 0) {
+        return false;
+    }
+    float speed = sqrtf(filter->vx * filter->vx + filter->vy * filter->vy);
+    if (speed < INK_PREDICT_MIN_SPEED) {
+        return false;
+    }
+
+    // 从最新真实采样沿速度方向外推，预测段从最近输出的点画起（同时补上滤波滞后）
+    float t = (float)cfg->predict_us / 1000000.0f;
+    float dx = filter->raw_x + filter->vx * t - (float)filter->last_out.x;
+    float dy = filter->raw_y + filter->vy * t - (float)filter->last_out.y;
+    float len = sqrtf(dx * dx + dy * dy);
+    if (len > cfg->max_predict_px) {
+        dx *= cfg->max_predict_px / len;
+        dy *= cfg->max_predict_px / len;
+    }
+    pt->x = filter->last_out.x + ink_round(dx);
+    pt->y = filter->last_out.y + ink_round(dy);
+    return pt->x != filter->last_out.x || pt->y != filter->last_out.y;
+}
+
+int ink_backup_save(ink_backup_t *backup, const stroke_surface_t *surface,
+                    int x0, int y0, int x1, int y1, int radius) {
+    // 抗锯齿边缘比半径多一个像素
+    int reach = radius + 1;
+    stroke_rect_t r;
+    r.x0 = (x0 < x1 ? x0 : x1) - reach;
+    r.y0 = (y0 < y1 ? y0 : y1) - reach;
+    r.x1 = (x0 > x1 ? x0 : x1) + reach + 1;
+    r.y1 = (y0 > y1 ? y0 : y1) + reach + 1;
+    if (r.x0 < 0) r.x0 = 0;
+    if (r.y0 < 0) r.y0 = 0;
+    if (r.x1 > surface->width) r.x1 = surface->width;
+    if (r.y1 > surface->height) r.y1 = surface->height;
+
+    backup->valid = false;
+    int w = r.x1 - r.x0;
+    int h = r.y1 - r.y0;
+    if (w <= 0 || h <= 0 || w > INK_BACKUP_MAX || h > INK_BACKUP_MAX) {
+        return -1;
+    }
+    for (int row = 0; row < h; row++) {
+        memcpy(backup->pixels + row * w, surface->pixels + (size_t)(r.y0 + row) * surface->stride + r.x0,
+               w * sizeof(uint32_t));
+    }
+    backup->from.x = x0;
+    backup->from.y = y0;
+    backup->to.x = x1;
+    backup->to.y = y1;
+    backup->rect = r;
+    backup->valid = true;
+    return 0;
+}
+
+void ink_backup_restore(ink_backup_t *backup, const stroke_surface_t *surface, stroke_rect_t *dirty) {
+    if (!backup->valid) {
+        if (dirty) {
+            stroke_rect_reset(dirty);
+        }
+        return;
+    }
+    const stroke_rect_t *r = &backup->rect;
+    int w = r->x1 - r->x0;
+    for (int row = r->y0; row < r->y1; row++) {
+        memcpy(surface->pixels + (size_t)row * surface->stride + r->x0,
+               backup->pixels + (row - r->y0) * w, w * sizeof(uint32_t));
+    }
+    if (dirty) {
+        *dirty = *r;
+    }
+    backup->valid = false;
+}
+
+void ink_backup_discard(ink_backup_t *backup) {
+    backup->valid = false;
+}
@@ -0,0 +1,167 @@
+/**
+ * @file ink_filter.h
+ * @brief 笔迹输入滤波：采样合并、平滑、曲线细分与落点预测
+ *
+ * 原来触摸/鼠标采样直接连成直线：帧间隔大时画出长的直线弦，采样密时
+ * 同一批像素被反复绘制。本模块在采样和光栅化之间加一级处理：
+ *   1. 合并：与上一个有效采样距离小于min_distance的采样不立即输出
+ *   2. 平滑：每轴一欧元滤波（one-euro），慢速时去抖，快速时截止频率升高、几乎不滞后
+ *   3. 细分：最新两点之间按Catmull-Rom（Hermite形式，终点切线按曲率外推，不等待下一个采样）
+ *      插值出若干短线段代替一条直线弦，段数按弯曲程度决定（直线只输出一段）
+ *   4. 预测：按滤波后的速度从最新采样向前外推一小段，调用者先画出预测段，
+ *      下一批真实采样到来时用ink_backup_restore擦除后再画真实线段
+ *
+ * 预测段只用于显示，调用者不要把它记入撤销历史或发送给协作端。
+ * 本模块不加锁；ink_backup_*由调用者在持有对应framebuffer的锁时调用。
+ */
+
+#ifndef INK_FILTER_H
+#define INK_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stroke_raster.h"
+
+#define INK_FILTER_MAX_POINTS 8                // 每次采样最多输出的点数（细分段数上限）
+#define INK_BACKUP_MAX 64                      // 预测段备份区域最大边长（像素）
+
+// 点（framebuffer坐标）
+typedef struct {
+    int x;
+    int y;
+} ink_point_t;
+
+// 滤波参数
+typedef struct {
+    float min_distance;             // 合并距离（像素），小于该距离的采样不立即输出
+    float min_cutoff;               // 一欧元滤波最小截止频率（Hz），越小慢速时越平滑
+    float beta;                     // 截止频率随速度（像素/秒）增加的系数，越大快速时越跟手
+    float d_cutoff;                 // 速度估计的截止频率（Hz）
+    float flatness_px;              // 曲线细分时每段允许偏离曲线的距离（像素），越小段数越多
+    uint32_t predict_us;            // 预测时长（微秒），0为不预测
+    float max_predict_px;           // 预测段最大长度（像素）
+} ink_filter_config_t;
+
+// 统计信息
+typedef struct {
+    uint32_t raw_samples;           // 输入的采样数
+    uint32_t coalesced;             // 被合并（未立即输出）的采样数
+    uint32_t emitted;               // 输出的点数
+} ink_filter_stats_t;
+
+// 滤波状态（每个输入源一个，直接嵌入调用者的结构或作为静态变量）
+typedef struct {
+    ink_filter_config_t config;
+    bool active;                    // 是否在一笔之中
+    uint64_t last_us;               // 上一个有效采样的时间
+    uint64_t last_raw_us;           // 最新采样的时间
+    float acc_x;                    // 上一个有效（未被合并的）采样
+    float acc_y;
+    float raw_x;                    // 最新采样（未滤波，包括被合并的采样）
+    float raw_y;
+    float fx;                       // 滤波后的位置
+    float fy;
+    float vx;                       // 滤波后的速度（像素/秒）
+    float vy;
+    float px[3];                    // 最近三个滤波点（[2]为最新），用于Catmull-Rom
+    float py[3];
+    int count;                      // px/py中有效点数
+    ink_point_t last_out;           // 最近输出的点
+    ink_filter_stats_t stats;
+} ink_filter_t;
+
+// 预测段覆盖像素的备份
+typedef struct {
+    bool valid;
+    ink_point_t from;               // 备份对应的线段（调用者据此判断预测段是否变化）
+    ink_point_t to;
+    stroke_rect_t rect;             // 备份的区域（framebuffer坐标）
+    uint32_t pixels[INK_BACKUP_MAX * INK_BACKUP_MAX];
+} ink_backup_t;
+
+/**
+ * @brief 获取默认参数（按约100Hz的触摸采样、800x480屏幕调整）
+ * @param config 输出参数
+ */
+void ink_filter_default_config(ink_filter_config_t *config);
+
+/**
+ * @brief 初始化滤波状态
+ * @param filter 滤波状态
+ * @param config 参数（NULL使用默认参数）
+ */
+void ink_filter_init(ink_filter_t *filter, const ink_filter_config_t *config);
+
+/**
+ * @brief 开始一笔（按下）
+ * @param filter 滤波状态
+ * @param x 采样X
+ * @param y 采样Y
+ * @param t_us 采样时间（单调时钟，微秒）
+ * @param out 输出点（第一个点，调用者画一个圆点）
+ * @param max_out out容量（至少1）
+ * @return 输出的点数
+ */
+int ink_filter_down(ink_filter_t *filter, int x, int y, uint64_t t_us, ink_point_t *out, int max_out);
+
+/**
+ * @brief 一笔中的移动采样
+ *
+ * 输出的点依次与上一个输出点相连（第一个点接上一次调用的最后一个点）。
+ * @param filter 滤波状态
+ * @param x 采样X
+ * @param y 采样Y
+ * @param t_us 采样时间（单调时钟，微秒）
+ * @param out 输出点
+ * @param max_out out容量（建议INK_FILTER_MAX_POINTS）
+ * @return 输出的点数（采样被合并时为0）
+ */
+int ink_filter_move(ink_filter_t *filter, int x, int y, uint64_t t_us, ink_point_t *out, int max_out);
+
+/**
+ * @brief 结束一笔（抬起），把笔迹补到最后一个真实采样
+ * @param filter 滤波状态
+ * @param out 输出点
+ * @param max_out out容量
+ * @return 输出的点数
+ */
+int ink_filter_up(ink_filter_t *filter, ink_point_t *out, int max_out);
+
+/**
+ * @brief 计算预测点（从最近输出的点画到预测点即为预测段）
+ * @param filter 滤波状态
+ * @param pt 输出预测点
+ * @return 有预测段返回true（未按下、未开启预测或速度很小时返回false；
+ *         笔尖停住后被合并的采样会让速度逐渐衰减，预测段随之消失）
+ */
+bool ink_filter_predict(const ink_filter_t *filter, ink_point_t *pt);
+
+/**
+ * @brief 保存一段线段将要覆盖的像素（在绘制预测段之前调用）
+ * @param backup 备份
+ * @param surface 绘制目标
+ * @param x0 起点X
+ * @param y0 起点Y
+ * @param x1 终点X
+ * @param y1 终点Y
+ * @param radius 线段半径
+ * @return 成功返回0，区域超过INK_BACKUP_MAX返回-1（此时不要绘制预测段）
+ */
+int ink_backup_save(ink_backup_t *backup, const stroke_surface_t *surface,
+                    int x0, int y0, int x1, int y1, int radius);
+
+/**
+ * @brief 恢复备份的像素（擦除预测段）并使备份失效，没有备份时什么都不做
+ * @param backup 备份
+ * @param surface 绘制目标
+ * @param dirty 输出被恢复的区域（可为NULL，没有备份时为空矩形）
+ */
+void ink_backup_restore(ink_backup_t *backup, const stroke_surface_t *surface, stroke_rect_t *dirty);
+
+/**
+ * @brief 丢弃备份（画板已被整体改写，如清屏）
+ * @param backup 备份
+ */
+void ink_backup_discard(ink_backup_t *backup);
+
+#endif /* INK_FILTER_H */
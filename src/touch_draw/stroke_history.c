@@ -0,0 +1,607 @@
+/**
+ * @file stroke_history.c
+ * @brief 画板撤销/重做实现
+ *
+ * 记录用绝对序号（seq）编号，日志是容量固定的环形数组，保存[first_seq, end_seq)。
+ * 检查点k表示"第seq条记录之前"的画板状态，最早的检查点总是位于first_seq，
+ * 因此日志中任意一条记录都能通过"最近的检查点 + 重放"还原。
+ * dirty记录自最新检查点以来被改写过的块，保存下一个检查点时只复制这些块。
+ */
+
+#include "stroke_history.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HISTORY_DEFAULT_LOG         4096
+#define HISTORY_DEFAULT_INTERVAL    128
+#define HISTORY_MAX_CHECKPOINTS     64
+#define HISTORY_MAX_OWNERS          16
+#define HISTORY_TILE_PIXELS         (STROKE_HISTORY_TILE * STROKE_HISTORY_TILE)
+
+// 记录标志
+#define ENTRY_F_START   0x01        // 一笔的第一段
+#define ENTRY_F_CLEAR   0x02        // 清屏
+#define ENTRY_F_UNDONE  0x04        // 已撤销（重放时跳过）
+#define ENTRY_F_AA      0x08        // 抗锯齿绘制
+
+// 日志记录（坐标相对画板区域）
+typedef struct {
+    int16_t x0, y0, x1, y1;
+    uint32_t color;
+    uint32_t owner;
+    uint8_t radius;
+    uint8_t flags;
+    uint16_t reserved;
+} history_entry_t;
+
+_Static_assert(sizeof(history_entry_t) == 20, "history_entry_t should stay compact");
+
+// 分块像素（多个检查点共享时引用计数）
+typedef struct {
+    uint32_t refs;
+    uint32_t pixels[HISTORY_TILE_PIXELS];
+} history_tile_t;
+
+typedef struct {
+    uint32_t seq;
+    history_tile_t **tiles;         // tile_count个，指向tile_slots中的一段
+} history_checkpoint_t;
+
+// 每个用户最后一段的终点（判断新的一段是否与上一段相连）
+typedef struct {
+    uint32_t owner;
+    int16_t x;
+    int16_t y;
+    bool valid;
+    uint32_t used;
+} history_owner_t;
+
+typedef struct {
+    stroke_history_config_t config;
+    int cols;
+    int rows;
+    int tile_count;
+
+    history_entry_t *log;
+    uint32_t first_seq;
+    uint32_t end_seq;
+
+    history_checkpoint_t cps[HISTORY_MAX_CHECKPOINTS];
+    int cp_first;
+    int cp_count;
+    history_tile_t **tile_slots;
+
+    uint8_t *dirty;                 // 每块一个字节：自最新检查点以来是否被改写
+    uint8_t *mask;                  // 撤销时的临时块集合
+    size_t fixed_bytes;             // 日志和检查点表（创建时一次分配）
+    size_t tile_bytes;              // 已分配的分块像素
+    uint32_t tiles;
+
+    history_owner_t owners[HISTORY_MAX_OWNERS];
+    uint32_t owner_clock;
+
+    stroke_history_stats_t stats;
+} stroke_history_t;
+
+static uint64_t history_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static history_entry_t *entry_at(stroke_history_t *h, uint32_t seq) {
+    return &h->log[seq % h->config.log_capacity];
+}
+
+static history_checkpoint_t *checkpoint_at(stroke_history_t *h, int index) {
+    return &h->cps[(h->cp_first + index) % HISTORY_MAX_CHECKPOINTS];
+}
+
+// 画板区域对应的绘制目标（坐标原点在画板左上角）
+static stroke_surface_t area_surface(const stroke_history_t *h, const stroke_surface_t *surface) {
+    stroke_surface_t area;
+    area.pixels = surface->pixels + (size_t)h->config.area_y * surface->stride + h->config.area_x;
+    area.stride = surface->stride;
+    area.width = h->config.area_w;
+    area.height = h->config.area_h;
+    return area;
+}
+
+// 第index块在画板中的位置和尺寸
+static void tile_rect(const stroke_history_t *h, int index, int *x, int *y, int *w, int *h_out) {
+    *x = (index % h->cols) * STROKE_HISTORY_TILE;
+    *y = (index / h->cols) * STROKE_HISTORY_TILE;
+    *w = h->config.area_w - *x < STROKE_HISTORY_TILE ? h->config.area_w - *x : STROKE_HISTORY_TILE;
+    *h_out = h->config.area_h - *y < STROKE_HISTORY_TILE ? h->config.area_h - *y : STROKE_HISTORY_TILE;
+}
+
+static history_tile_t *tile_capture(stroke_history_t *h, const stroke_surface_t *area, int index) {
+    history_tile_t *tile = malloc(sizeof(history_tile_t));
+    if (!tile) {
+        return NULL;
+    }
+    tile->refs = 1;
+    h->tile_bytes += sizeof(history_tile_t);
+    h->tiles++;
+
+    int x, y, w, th;
+    tile_rect(h, index, &x, &y, &w, &th);
+    for (int row = 0; row < th; row++) {
+        memcpy(tile->pixels + row * STROKE_HISTORY_TILE,
+               area->pixels + (size_t)(y + row) * area->stride + x, w * sizeof(uint32_t));
+    }
+    return tile;
+}
+
+static void tile_restore(const stroke_history_t *h, const stroke_surface_t *area, int index,
+                         const history_tile_t *tile) {
+    int x, y, w, th;
+    tile_rect(h, index, &x, &y, &w, &th);
+    for (int row = 0; row < th; row++) {
+        memcpy(area->pixels + (size_t)(y + row) * area->stride + x,
+               tile->pixels + row * STROKE_HISTORY_TILE, w * sizeof(uint32_t));
+    }
+}
+
+static void tile_release(stroke_history_t *h, history_tile_t *tile) {
+    if (tile && --tile->refs == 0) {
+        free(tile);
+        h->tile_bytes -= sizeof(history_tile_t);
+        h->tiles--;
+    }
+}
+
+static void checkpoint_release(stroke_history_t *h, history_checkpoint_t *cp) {
+    for (int i = 0; i < h->tile_count; i++) {
+        tile_release(h, cp->tiles[i]);
+        cp->tiles[i] = NULL;
+    }
+}
+
+// 丢弃最早的检查点及其之前的记录（至少保留一个检查点）
+static void drop_oldest_checkpoint(stroke_history_t *h) {
+    if (h->cp_count < 2) {
+        return;
+    }
+    checkpoint_release(h, checkpoint_at(h, 0));
+    h->cp_first = (h->cp_first + 1) % HISTORY_MAX_CHECKPOINTS;
+    h->cp_count--;
+    uint32_t new_first = checkpoint_at(h, 0)->seq;
+    h->stats.evicted_entries += new_first - h->first_seq;
+    h->first_seq = new_first;
+}
+
+// 丢弃第keep个之后的检查点（它们包含了被撤销/重做改变的记录）
+static void drop_checkpoints_after(stroke_history_t *h, int keep) {
+    while (h->cp_count > keep + 1) {
+        checkpoint_release(h, checkpoint_at(h, h->cp_count - 1));
+        h->cp_count--;
+    }
+}
+
+// 在end_seq处保存检查点：变化过的块复制，其余与上一个检查点共享
+static int checkpoint_create(stroke_history_t *h, const stroke_surface_t *surface) {
+    history_checkpoint_t *last = h->cp_count ? checkpoint_at(h, h->cp_count - 1) : NULL;
+    if (last && last->seq == h->end_seq) {
+        return 0;
+    }
+
+    int needed = 0;
+    for (int i = 0; i < h->tile_count; i++) {
+        needed += (!last || h->dirty[i]) ? 1 : 0;
+    }
+    size_t tile_budget = h->config.budget_bytes - h->fixed_bytes;
+    while (h->cp_count >= 2 &&
+           (h->cp_count >= HISTORY_MAX_CHECKPOINTS ||
+            h->tile_bytes + (size_t)needed * sizeof(history_tile_t) > tile_budget)) {
+        drop_oldest_checkpoint(h);
+    }
+    last = h->cp_count ? checkpoint_at(h, h->cp_count - 1) : NULL;
+
+    history_checkpoint_t *cp = &h->cps[(h->cp_first + h->cp_count) % HISTORY_MAX_CHECKPOINTS];
+    stroke_surface_t area = area_surface(h, surface);
+    for (int i = 0; i < h->tile_count; i++) {
+        if (!last || h->dirty[i]) {
+            cp->tiles[i] = tile_capture(h, &area, i);
+            if (!cp->tiles[i]) {
+                checkpoint_release(h, cp);
+                printf("[撤销历史] 警告：分块内存分配失败，检查点未保存\n");
+                return -1;
+            }
+        } else {
+            cp->tiles[i] = last->tiles[i];
+            cp->tiles[i]->refs++;
+        }
+    }
+    cp->seq = h->end_seq;
+    h->cp_count++;
+    memset(h->dirty, 0, h->tile_count);
+    return 0;
+}
+
+// 把记录影响的块加入集合（清屏影响全部块）
+static void mark_entry_tiles(const stroke_history_t *h, const history_entry_t *e, uint8_t *set) {
+    if (e->flags & ENTRY_F_CLEAR) {
+        memset(set, 1, h->tile_count);
+        return;
+    }
+    int reach = e->radius + 1;
+    int x0 = (e->x0 < e->x1 ? e->x0 : e->x1) - reach;
+    int x1 = (e->x0 > e->x1 ? e->x0 : e->x1) + reach;
+    int y0 = (e->y0 < e->y1 ? e->y0 : e->y1) - reach;
+    int y1 = (e->y0 > e->y1 ? e->y0 : e->y1) + reach;
+    if (x1 < 0 || y1 < 0 || x0 >= h->config.area_w || y0 >= h->config.area_h) {
+        return;
+    }
+    int tx0 = x0 < 0 ? 0 : x0 / STROKE_HISTORY_TILE;
+    int ty0 = y0 < 0 ? 0 : y0 / STROKE_HISTORY_TILE;
+    int tx1 = (x1 >= h->config.area_w ? h->config.area_w - 1 : x1) / STROKE_HISTORY_TILE;
+    int ty1 = (y1 >= h->config.area_h ? h->config.area_h - 1 : y1) / STROKE_HISTORY_TILE;
+    for (int ty = ty0; ty <= ty1; ty++) {
+        memset(set + ty * h->cols + tx0, 1, tx1 - tx0 + 1);
+    }
+}
+
+static void entry_draw(const stroke_history_t *h, const stroke_surface_t *area, const history_entry_t *e) {
+    if (e->flags & ENTRY_F_CLEAR) {
+        for (int y = 0; y < area->height; y++) {
+            uint32_t *row = area->pixels + (size_t)y * area->stride;
+            for (int x = 0; x < area->width; x++) {
+                row[x] = h->config.background;
+            }
+        }
+        return;
+    }
+    stroke_raster_segment(area, e->x0, e->y0, e->x1, e->y1, e->radius, e->color,
+                          (e->flags & ENTRY_F_AA) != 0, NULL);
+}
+
+static history_owner_t *owner_slot(stroke_history_t *h, uint32_t owner) {
+    history_owner_t *lru = &h->owners[0];
+    for (int i = 0; i < HISTORY_MAX_OWNERS; i++) {
+        if (h->owners[i].used && h->owners[i].owner == owner) {
+            h->owners[i].used = ++h->owner_clock;
+            return &h->owners[i];
+        }
+        if (h->owners[i].used < lru->used) {
+            lru = &h->owners[i];
+        }
+    }
+    memset(lru, 0, sizeof(*lru));
+    lru->owner = owner;
+    lru->used = ++h->owner_clock;
+    return lru;
+}
+
+// 追加一条记录；日志满时先保存检查点再丢弃最早的一段
+static void append_entry(stroke_history_t *h, const stroke_surface_t *surface, const history_entry_t *e) {
+    if (h->cp_count == 0) {
+        return;  // 尚未reset或reset失败
+    }
+    if (h->end_seq - h->first_seq >= h->config.log_capacity) {
+        if (h->cp_count < 2 || checkpoint_at(h, 1)->seq == h->first_seq) {
+            checkpoint_create(h, surface);
+        }
+        drop_oldest_checkpoint(h);
+        if (h->end_seq - h->first_seq >= h->config.log_capacity) {
+            return;  // 无法腾出空间（检查点保存失败），放弃记录
+        }
+    }
+
+    *entry_at(h, h->end_seq) = *e;
+    h->end_seq++;
+    mark_entry_tiles(h, e, h->dirty);
+
+    if (h->end_seq - checkpoint_at(h, h->cp_count - 1)->seq >= h->config.checkpoint_interval) {
+        checkpoint_create(h, surface);
+    }
+}
+
+// 从changed_seq之前最近的检查点恢复受影响的块并重放之后仍有效的记录
+static void rebuild_from(stroke_history_t *h, const stroke_surface_t *surface, uint32_t changed_seq,
+                         stroke_rect_t *dirty) {
+    uint64_t start_us = history_now_us();
+
+    int k = h->cp_count - 1;
+    while (k > 0 && checkpoint_at(h, k)->seq > changed_seq) {
+        k--;
+    }
+    drop_checkpoints_after(h, k);
+    history_checkpoint_t *cp = checkpoint_at(h, k);
+
+    // 检查点之后被改写过的块（包括已撤销的记录曾经画过的位置）
+    memcpy(h->mask, h->dirty, h->tile_count);
+    for (uint32_t seq = cp->seq; seq != h->end_seq; seq++) {
+        mark_entry_tiles(h, entry_at(h, seq), h->mask);
+    }
+
+    stroke_surface_t area = area_surface(h, surface);
+    uint32_t restored = 0;
+    int tx0 = h->cols, ty0 = h->rows, tx1 = -1, ty1 = -1;
+    for (int i = 0; i < h->tile_count; i++) {
+        if (!h->mask[i]) {
+            continue;
+        }
+        tile_restore(h, &area, i, cp->tiles[i]);
+        restored++;
+        int tx = i % h->cols, ty = i / h->cols;
+        if (tx < tx0) tx0 = tx;
+        if (tx > tx1) tx1 = tx;
+        if (ty < ty0) ty0 = ty;
+        if (ty > ty1) ty1 = ty;
+    }
+
+    uint32_t replayed = 0;
+    for (uint32_t seq = cp->seq; seq != h->end_seq; seq++) {
+        const history_entry_t *e = entry_at(h, seq);
+        if (!(e->flags & ENTRY_F_UNDONE)) {
+            entry_draw(h, &area, e);
+            replayed++;
+        }
+    }
+
+    // 画板现在与检查点相比的差异就是恢复过的这些块
+    memcpy(h->dirty, h->mask, h->tile_count);
+
+    if (dirty) {
+        stroke_rect_reset(dirty);
+        if (tx1 >= 0) {
+            dirty->x0 = h->config.area_x + tx0 * STROKE_HISTORY_TILE;
+            dirty->y0 = h->config.area_y + ty0 * STROKE_HISTORY_TILE;
+            int x1 = (tx1 + 1) * STROKE_HISTORY_TILE;
+            int y1 = (ty1 + 1) * STROKE_HISTORY_TILE;
+            dirty->x1 = h->config.area_x + (x1 < h->config.area_w ? x1 : h->config.area_w);
+            dirty->y1 = h->config.area_y + (y1 < h->config.area_h ? y1 : h->config.area_h);
+        }
+    }
+
+    // 重放较长时补一个检查点，保证下一次撤销的重放量有上限
+    if (h->end_seq - cp->seq >= h->config.checkpoint_interval) {
+        checkpoint_create(h, surface);
+    }
+
+    h->stats.last_replayed = replayed;
+    h->stats.last_restored_tiles = restored;
+    h->stats.last_undo_us = (uint32_t)(history_now_us() - start_us);
+}
+
+// 该用户最近一条有效记录，返回是否找到
+static bool find_latest_live(stroke_history_t *h, uint32_t owner, uint32_t *out) {
+    for (uint32_t seq = h->end_seq; seq != h->first_seq; seq--) {
+        const history_entry_t *e = entry_at(h, seq - 1);
+        if (e->owner == owner && !(e->flags & ENTRY_F_UNDONE)) {
+            *out = seq - 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 设置或清除从start开始的一笔（该用户下一个START之前的记录）的撤销标志
+static void mark_stroke(stroke_history_t *h, uint32_t owner, uint32_t start, bool undone) {
+    for (uint32_t seq = start; seq != h->end_seq; seq++) {
+        history_entry_t *e = entry_at(h, seq);
+        if (e->owner != owner) {
+            continue;
+        }
+        if (seq != start && (e->flags & ENTRY_F_START)) {
+            break;
+        }
+        if (undone) {
+            e->flags |= ENTRY_F_UNDONE;
+        } else {
+            e->flags &= (uint8_t)~ENTRY_F_UNDONE;
+        }
+    }
+}
+
+stroke_history_handle_t stroke_history_create(const stroke_history_config_t *config) {
+    if (!config || config->area_w <= 0 || config->area_h <= 0) {
+        return NULL;
+    }
+
+    stroke_history_t *h = calloc(1, sizeof(stroke_history_t));
+    if (!h) {
+        return NULL;
+    }
+    h->config = *config;
+    if (h->config.log_capacity == 0) {
+        h->config.log_capacity = HISTORY_DEFAULT_LOG;
+    }
+    if (h->config.checkpoint_interval == 0) {
+        h->config.checkpoint_interval = HISTORY_DEFAULT_INTERVAL;
+    }
+    h->cols = (config->area_w + STROKE_HISTORY_TILE - 1) / STROKE_HISTORY_TILE;
+    h->rows = (config->area_h + STROKE_HISTORY_TILE - 1) / STROKE_HISTORY_TILE;
+    h->tile_count = h->cols * h->rows;
+
+    h->log = calloc(h->config.log_capacity, sizeof(history_entry_t));
+    h->tile_slots = calloc((size_t)HISTORY_MAX_CHECKPOINTS * h->tile_count, sizeof(history_tile_t *));
+    h->dirty = calloc(h->tile_count, 1);
+    h->mask = calloc(h->tile_count, 1);
+    if (!h->log || !h->tile_slots || !h->dirty || !h->mask) {
+        stroke_history_destroy(h);
+        return NULL;
+    }
+    for (int i = 0; i < HISTORY_MAX_CHECKPOINTS; i++) {
+        h->cps[i].tiles = h->tile_slots + (size_t)i * h->tile_count;
+    }
+
+    // 预算至少能容纳两整屏分块（保存新检查点后才能丢弃旧的）
+    h->fixed_bytes = sizeof(stroke_history_t) + h->config.log_capacity * sizeof(history_entry_t) +
+                     (size_t)HISTORY_MAX_CHECKPOINTS * h->tile_count * sizeof(history_tile_t *) +
+                     2 * (size_t)h->tile_count;
+    size_t min_budget = h->fixed_bytes + 2 * (size_t)h->tile_count * sizeof(history_tile_t);
+    if (h->config.budget_bytes < min_budget) {
+        printf("[撤销历史] 内存预算%zu字节不足，调整为%zu字节\n", h->config.budget_bytes, min_budget);
+        h->config.budget_bytes = min_budget;
+    }
+    return h;
+}
+
+void stroke_history_destroy(stroke_history_handle_t handle) {
+    stroke_history_t *h = (stroke_history_t *)handle;
+    if (!h) {
+        return;
+    }
+    if (h->tile_slots) {
+        for (int i = 0; i < h->cp_count; i++) {
+            checkpoint_release(h, checkpoint_at(h, i));
+        }
+    }
+    free(h->log);
+    free(h->tile_slots);
+    free(h->dirty);
+    free(h->mask);
+    free(h);
+}
+
+int stroke_history_reset(stroke_history_handle_t handle, const stroke_surface_t *surface) {
+    stroke_history_t *h = (stroke_history_t *)handle;
+    if (!h || !surface || !surface->pixels ||
+        h->config.area_x + h->config.area_w > surface->width ||
+        h->config.area_y + h->config.area_h > surface->height) {
+        return -1;
+    }
+
+    drop_checkpoints_after(h, 0);
+    if (h->cp_count) {
+        checkpoint_release(h, checkpoint_at(h, 0));
+        h->cp_count = 0;
+    }
+    h->first_seq = h->end_seq;
+    memset(h->owners, 0, sizeof(h->owners));
+    memset(h->dirty, 1, h->tile_count);
+    return checkpoint_create(h, surface);
+}
+
+void stroke_history_record_segment(stroke_history_handle_t handle, const stroke_surface_t *surface,
+                                   uint32_t owner, int x0, int y0, int x1, int y1,
+                                   int radius, uint32_t color, bool antialias) {
+    stroke_history_t *h = (stroke_history_t *)handle;
+    if (!h || !surface) {
+        return;
+    }
+
+    history_entry_t e;
+    memset(&e, 0, sizeof(e));
+    e.x0 = (int16_t)(x0 - h->config.area_x);
+    e.y0 = (int16_t)(y0 - h->config.area_y);
+    e.x1 = (int16_t)(x1 - h->config.area_x);
+    e.y1 = (int16_t)(y1 - h->config.area_y);
+    e.color = color;
+    e.owner = owner;
+    e.radius = (uint8_t)(radius > 255 ? 255 : radius);
+    e.flags = antialias ? ENTRY_F_AA : 0;
+
+    // 圆点（落笔）或与上一段不相连时开始新的一笔
+    history_owner_t *o = owner_slot(h, owner);
+    if ((x0 == x1 && y0 == y1) || !o->valid || o->x != e.x0 || o->y != e.y0) {
+        e.flags |= ENTRY_F_START;
+    }
+    o->x = e.x1;
+    o->y = e.y1;
+    o->valid = true;
+
+    append_entry(h, surface, &e);
+}
+
+void stroke_history_record_clear(stroke_history_handle_t handle, const stroke_surface_t *surface,
+                                 uint32_t owner) {
+    stroke_history_t *h = (stroke_history_t *)handle;
+    if (!h || !surface) {
+        return;
+    }
+
+    history_entry_t e;
+    memset(&e, 0, sizeof(e));
+    e.owner = owner;
+    e.flags = ENTRY_F_START | ENTRY_F_CLEAR;
+    owner_slot(h, owner)->valid = false;
+    append_entry(h, surface, &e);
+}
+
+int stroke_history_undo(stroke_history_handle_t handle, const stroke_surface_t *surface,
+                        uint32_t owner, stroke_rect_t *dirty) {
+    stroke_history_t *h = (stroke_history_t *)handle;
+    if (dirty) {
+        stroke_rect_reset(dirty);
+    }
+    if (!h || !surface || h->cp_count == 0) {
+        return -1;
+    }
+
+    uint32_t latest;
+    if (!find_latest_live(h, owner, &latest)) {
+        return -1;
+    }
+
+    // 向前找这一笔的第一段；第一段已被丢弃时从日志中最早的一段开始撤销
+    uint32_t start = latest;
+    for (uint32_t seq = latest + 1; seq != h->first_seq; seq--) {
+        const history_entry_t *e = entry_at(h, seq - 1);
+        if (e->owner != owner) {
+            continue;
+        }
+        start = seq - 1;
+        if (e->flags & ENTRY_F_START) {
+            break;
+        }
+    }
+
+    mark_stroke(h, owner, start, true);
+    owner_slot(h, owner)->valid = false;
+    rebuild_from(h, surface, start, dirty);
+    return 0;
+}
+
+int stroke_history_redo(stroke_history_handle_t handle, const stroke_surface_t *surface,
+                        uint32_t owner, stroke_rect_t *dirty) {
+    stroke_history_t *h = (stroke_history_t *)handle;
+    if (dirty) {
+        stroke_rect_reset(dirty);
+    }
+    if (!h || !surface || h->cp_count == 0) {
+        return -1;
+    }
+
+    // 最近一次撤销的是该用户最后一条有效记录之后最早的一笔已撤销的操作
+    uint32_t seq = h->first_seq;
+    uint32_t latest;
+    if (find_latest_live(h, owner, &latest)) {
+        seq = latest + 1;
+    }
+    for (; seq != h->end_seq; seq++) {
+        const history_entry_t *e = entry_at(h, seq);
+        if (e->owner == owner && (e->flags & ENTRY_F_UNDONE) && (e->flags & ENTRY_F_START)) {
+            break;
+        }
+    }
+    if (seq == h->end_seq) {
+        return -1;
+    }
+
+    mark_stroke(h, owner, seq, false);
+    owner_slot(h, owner)->valid = false;
+    rebuild_from(h, surface, seq, dirty);
+    return 0;
+}
+
+void stroke_history_get_stats(stroke_history_handle_t handle, stroke_history_stats_t *stats) {
+    stroke_history_t *h = (stroke_history_t *)handle;
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (!h) {
+        return;
+    }
+    *stats = h->stats;
+    stats->entries = h->end_seq - h->first_seq;
+    stats->checkpoints = (uint32_t)h->cp_count;
+    stats->tiles = h->tiles;
+    stats->bytes_used = h->fixed_bytes + h->tile_bytes;
+    stats->budget_bytes = h->config.budget_bytes;
+}
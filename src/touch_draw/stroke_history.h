@@ -0,0 +1,134 @@
+/**
+ * @file stroke_history.h
+ * @brief 画板撤销/重做：笔画日志 + 分块写时复制检查点
+ *
+ * 每一段落到画板上的线段（本地或远程）以20字节记录追加到环形笔画日志，
+ * 清屏也是一条记录。每隔一定数量的记录保存一个检查点：画板按64x64分块，
+ * 自上一个检查点以来没有变化的块与上一个检查点共享同一份像素（引用计数），
+ * 只复制变化过的块。
+ *
+ * 撤销某个用户最近的一笔：把该笔的记录标记为已撤销，从它之前最近的检查点
+ * 恢复受影响的块，再重放检查点之后仍有效的记录。重做同理。
+ * 日志和分块像素的总内存不超过创建时给定的预算，超出时丢弃最早的检查点和记录。
+ *
+ * 本模块不加锁，调用者在记录、撤销、重做时持有对应framebuffer的锁。
+ */
+
+#ifndef STROKE_HISTORY_H
+#define STROKE_HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "stroke_raster.h"
+
+#define STROKE_HISTORY_TILE 64                 // 检查点分块边长（像素）
+#define STROKE_HISTORY_OWNER_LOCAL 0           // 本地用户的owner（远程用户使用其用户ID）
+
+// 撤销历史配置
+typedef struct {
+    int area_x;                     // 画板区域（framebuffer坐标）
+    int area_y;
+    int area_w;
+    int area_h;
+    uint32_t background;            // 清屏颜色
+    size_t budget_bytes;            // 内存预算（日志 + 分块像素，不足两整屏分块时自动放大）
+    uint32_t log_capacity;          // 日志记录数（0=默认4096）
+    uint32_t checkpoint_interval;   // 每隔多少条记录保存检查点（0=默认128，决定撤销时最多重放的记录数）
+} stroke_history_config_t;
+
+// 撤销历史统计
+typedef struct {
+    uint32_t entries;               // 日志中的记录数
+    uint32_t checkpoints;           // 检查点数
+    uint32_t tiles;                 // 已分配的分块数（共享的只算一次）
+    size_t bytes_used;              // 已用内存（日志 + 分块）
+    size_t budget_bytes;            // 内存预算
+    uint32_t evicted_entries;       // 因预算或日志容量丢弃的记录数
+    uint32_t last_replayed;         // 最近一次撤销/重做重放的记录数
+    uint32_t last_restored_tiles;   // 最近一次撤销/重做恢复的分块数
+    uint32_t last_undo_us;          // 最近一次撤销/重做耗时（微秒）
+} stroke_history_stats_t;
+
+// 撤销历史句柄
+typedef void* stroke_history_handle_t;
+
+/**
+ * @brief 创建撤销历史（日志按容量一次分配）
+ * @param config 配置参数
+ * @return 句柄，失败返回NULL
+ */
+stroke_history_handle_t stroke_history_create(const stroke_history_config_t *config);
+
+/**
+ * @brief 释放撤销历史
+ * @param handle 句柄
+ */
+void stroke_history_destroy(stroke_history_handle_t handle);
+
+/**
+ * @brief 清空历史，以当前画板内容作为新的起点（画板被历史之外的途径整体改写后调用，如快照同步）
+ * @param handle 句柄
+ * @param surface 画板所在的framebuffer
+ * @return 成功返回0，失败（内存不足）返回-1
+ */
+int stroke_history_reset(stroke_history_handle_t handle, const stroke_surface_t *surface);
+
+/**
+ * @brief 记录一段已经绘制到画板上的线段（x0,y0与x1,y1相同为一个圆点）
+ *
+ * 圆点或与该用户上一段不相连的线段视为新的一笔。
+ * @param handle 句柄
+ * @param surface 画板所在的framebuffer（保存检查点时读取）
+ * @param owner 用户（本地为STROKE_HISTORY_OWNER_LOCAL）
+ * @param x0 起点X（framebuffer坐标）
+ * @param y0 起点Y
+ * @param x1 终点X
+ * @param y1 终点Y
+ * @param radius 半径
+ * @param color 颜色
+ * @param antialias 绘制时是否抗锯齿
+ */
+void stroke_history_record_segment(stroke_history_handle_t handle, const stroke_surface_t *surface,
+                                   uint32_t owner, int x0, int y0, int x1, int y1,
+                                   int radius, uint32_t color, bool antialias);
+
+/**
+ * @brief 记录一次已经完成的清屏（画板区域填充为背景色，可被撤销）
+ * @param handle 句柄
+ * @param surface 画板所在的framebuffer
+ * @param owner 用户
+ */
+void stroke_history_record_clear(stroke_history_handle_t handle, const stroke_surface_t *surface,
+                                 uint32_t owner);
+
+/**
+ * @brief 撤销某个用户最近的一笔（或一次清屏），直接改写画板
+ * @param handle 句柄
+ * @param surface 画板所在的framebuffer
+ * @param owner 用户
+ * @param dirty 输出被改写的区域（framebuffer坐标，可为NULL）
+ * @return 成功返回0，没有可撤销的操作返回-1
+ */
+int stroke_history_undo(stroke_history_handle_t handle, const stroke_surface_t *surface,
+                        uint32_t owner, stroke_rect_t *dirty);
+
+/**
+ * @brief 重做某个用户最近撤销的一笔（该用户画了新的一笔后不能再重做）
+ * @param handle 句柄
+ * @param surface 画板所在的framebuffer
+ * @param owner 用户
+ * @param dirty 输出被改写的区域（framebuffer坐标，可为NULL）
+ * @return 成功返回0，没有可重做的操作返回-1
+ */
+int stroke_history_redo(stroke_history_handle_t handle, const stroke_surface_t *surface,
+                        uint32_t owner, stroke_rect_t *dirty);
+
+/**
+ * @brief 获取统计信息
+ * @param handle 句柄
+ * @param stats 输出统计信息
+ */
+void stroke_history_get_stats(stroke_history_handle_t handle, stroke_history_stats_t *stats);
+
+#endif /* STROKE_HISTORY_H */
@@ -0,0 +1,263 @@
+/**
+ * @file stroke_raster.c
+ * @brief 圆头粗线段光栅化实现
+ *
+ * 胶囊形是凸集，任意一行与它的交集是一个区间，等于该行与
+ * 两端圆、中间带状矩形三部分交集的并（取最小左端、最大右端）。
+ * 每行只做几次乘除和两次开方，填充用64位宽写入。
+ */
+
+#include "stroke_raster.h"
+#include <math.h>
+#include <stddef.h>
+
+#define STROKE_EPS 1e-4f
+
+// 允许以64位访问32位像素数组
+typedef uint64_t __attribute__((may_alias)) stroke_u64_t;
+
+typedef struct {
+    float x0, y0;                   // 起点
+    float x1, y1;                   // 终点
+    float dx, dy;                   // 方向向量
+    float len2;                     // 长度平方
+    float len;
+} stroke_seg_t;
+
+void stroke_rect_reset(stroke_rect_t *rect) {
+    rect->x0 = rect->y0 = 0;
+    rect->x1 = rect->y1 = 0;
+}
+
+bool stroke_rect_empty(const stroke_rect_t *rect) {
+    return rect->x0 >= rect->x1 || rect->y0 >= rect->y1;
+}
+
+void stroke_rect_union(stroke_rect_t *dst, const stroke_rect_t *src) {
+    if (stroke_rect_empty(src)) {
+        return;
+    }
+    if (stroke_rect_empty(dst)) {
+        *dst = *src;
+        return;
+    }
+    if (src->x0 < dst->x0) dst->x0 = src->x0;
+    if (src->y0 < dst->y0) dst->y0 = src->y0;
+    if (src->x1 > dst->x1) dst->x1 = src->x1;
+    if (src->y1 > dst->y1) dst->y1 = src->y1;
+}
+
+// 区间并入[*left, *right]（取包围）
+static void span_merge(float l, float r, float *left, float *right, bool *any) {
+    if (l > r) {
+        return;
+    }
+    if (!*any) {
+        *left = l;
+        *right = r;
+        *any = true;
+        return;
+    }
+    if (l < *left) *left = l;
+    if (r > *right) *right = r;
+}
+
+// 圆(cx,cy,R)与第yc行的交集
+static void disc_row(float cx, float cy, float yc, float R, float *left, float *right, bool *any) {
+    float v = yc - cy;
+    float h2 = R * R - v * v;
+    if (h2 < 0.0f) {
+        return;
+    }
+    float h = sqrtf(h2);
+    span_merge(cx - h, cx + h, left, right, any);
+}
+
+// 线性约束 lo <= a*u + b <= hi 对u的解区间，a为0时退化为全体或空集
+static bool linear_range(float a, float b, float lo, float hi, float *u0, float *u1) {
+    if (a == 0.0f) {
+        if (b < lo || b > hi) {
+            return false;
+        }
+        *u0 = -INFINITY;
+        *u1 = INFINITY;
+        return true;
+    }
+    float p = (lo - b) / a;
+    float q = (hi - b) / a;
+    *u0 = p < q ? p : q;
+    *u1 = p < q ? q : p;
+    return true;
+}
+
+// 胶囊（线段加半径R）与第yc行的交集，返回是否非空
+static bool capsule_row(const stroke_seg_t *s, float yc, float R, float *left, float *right) {
+    bool any = false;
+    disc_row(s->x0, s->y0, yc, R, left, right, &any);
+    if (s->len2 == 0.0f) {
+        return any;
+    }
+    disc_row(s->x1, s->y1, yc, R, left, right, &any);
+
+    // 中间带：到直线距离不超过R，且投影落在线段内；u = px - x0, v = yc - y0
+    float v = yc - s->y0;
+    float a0, a1, b0, b1;
+    if (linear_range(-s->dy, s->dx * v, -R * s->len, R * s->len, &a0, &a1) &&
+        linear_range(s->dx, s->dy * v, 0.0f, s->len2, &b0, &b1)) {
+        float u0 = a0 > b0 ? a0 : b0;
+        float u1 = a1 < b1 ? a1 : b1;
+        span_merge(s->x0 + u0, s->x0 + u1, left, right, &any);
+    }
+    return any;
+}
+
+// 点到线段的距离
+static float seg_distance(const stroke_seg_t *s, float px, float py) {
+    float ux = px - s->x0;
+    float uy = py - s->y0;
+    float t = 0.0f;
+    if (s->len2 > 0.0f) {
+        t = (ux * s->dx + uy * s->dy) / s->len2;
+        t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+    }
+    float ex = ux - t * s->dx;
+    float ey = uy - t * s->dy;
+    return sqrtf(ex * ex + ey * ey);
+}
+
+// 填充一段连续像素：先对齐到8字节，再每次写两个像素
+static void fill_span(uint32_t *p, int n, uint32_t color) {
+    if (n > 0 && ((uintptr_t)p & 7)) {
+        *p++ = color;
+        n--;
+    }
+    stroke_u64_t pair = ((uint64_t)color << 32) | color;
+    stroke_u64_t *q = (stroke_u64_t *)p;
+    int pairs = n >> 1;
+    int i = 0;
+    for (; i + 4 <= pairs; i += 4) {
+        q[i] = pair;
+        q[i + 1] = pair;
+        q[i + 2] = pair;
+        q[i + 3] = pair;
+    }
+    for (; i < pairs; i++) {
+        q[i] = pair;
+    }
+    if (n & 1) {
+        p[n - 1] = color;
+    }
+}
+
+// 逐字节混合，alpha范围0~256
+static inline uint32_t blend_pixel(uint32_t dst, uint32_t src, uint32_t alpha) {
+    uint32_t inv = 256 - alpha;
+    uint32_t rb = ((src & 0x00FF00FF) * alpha + (dst & 0x00FF00FF) * inv) >> 8;
+    uint32_t ag = ((src >> 8) & 0x00FF00FF) * alpha + ((dst >> 8) & 0x00FF00FF) * inv;
+    return (rb & 0x00FF00FF) | (ag & 0xFF00FF00);
+}
+
+static inline int clamp_int(int v, int lo, int hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// 抗锯齿行：内区间直接填充，外区间剩余的边缘像素按覆盖率混合
+static int aa_row(const stroke_surface_t *surface, const stroke_seg_t *s, int y, float radius,
+                  uint32_t color, int *min_x, int *max_x) {
+    float lo, ro;
+    if (!capsule_row(s, (float)y, radius + 0.5f, &lo, &ro)) {
+        return 0;
+    }
+    int xo0 = clamp_int((int)ceilf(lo), 0, surface->width);
+    int xo1 = clamp_int((int)floorf(ro), -1, surface->width - 1);
+    if (xo0 > xo1) {
+        return 0;
+    }
+
+    // 内区间：到线段距离不超过radius-0.5的像素覆盖率为1
+    int xi0 = xo1 + 1, xi1 = xo1;
+    float li, ri;
+    if (radius >= 0.5f && capsule_row(s, (float)y, radius - 0.5f, &li, &ri)) {
+        xi0 = clamp_int((int)ceilf(li - STROKE_EPS), xo0, xo1 + 1);
+        xi1 = clamp_int((int)floorf(ri + STROKE_EPS), xi0 - 1, xo1);
+    }
+
+    uint32_t *row = surface->pixels + (size_t)y * surface->stride;
+    for (int x = xo0; x <= xo1; x++) {
+        if (x == xi0 && xi1 >= xi0) {
+            fill_span(row + xi0, xi1 - xi0 + 1, color);
+            x = xi1;
+            continue;
+        }
+        float cover = radius + 0.5f - seg_distance(s, (float)x, (float)y);
+        if (cover <= 0.0f) {
+            continue;
+        }
+        uint32_t alpha = cover >= 1.0f ? 256 : (uint32_t)(cover * 256.0f);
+        row[x] = blend_pixel(row[x], color, alpha);
+    }
+    if (xo0 < *min_x) *min_x = xo0;
+    if (xo1 > *max_x) *max_x = xo1;
+    return xo1 - xo0 + 1;
+}
+
+int stroke_raster_segment(const stroke_surface_t *surface, int x0, int y0, int x1, int y1,
+                          int radius, uint32_t color, bool antialias, stroke_rect_t *dirty) {
+    if (dirty) {
+        stroke_rect_reset(dirty);
+    }
+    if (!surface || !surface->pixels || surface->width <= 0 || surface->height <= 0 || radius < 0) {
+        return 0;
+    }
+
+    stroke_seg_t s;
+    s.x0 = (float)x0;
+    s.y0 = (float)y0;
+    s.x1 = (float)x1;
+    s.y1 = (float)y1;
+    s.dx = s.x1 - s.x0;
+    s.dy = s.y1 - s.y0;
+    s.len2 = s.dx * s.dx + s.dy * s.dy;
+    s.len = sqrtf(s.len2);
+
+    float r = (float)radius;
+    int reach = radius + (antialias ? 1 : 0);
+    int ya = clamp_int((y0 < y1 ? y0 : y1) - reach, 0, surface->height);
+    int yb = clamp_int((y0 > y1 ? y0 : y1) + reach, -1, surface->height - 1);
+
+    int written = 0;
+    int min_x = surface->width, max_x = -1, min_y = -1, max_y = -1;
+    for (int y = ya; y <= yb; y++) {
+        int n;
+        if (antialias) {
+            n = aa_row(surface, &s, y, r, color, &min_x, &max_x);
+        } else {
+            // 整数端点时圆的区间端点也是精确值，加一个小量避免浮点误差漏掉边界像素
+            float left, right;
+            if (!capsule_row(&s, (float)y, r + STROKE_EPS, &left, &right)) {
+                continue;
+            }
+            int xa = clamp_int((int)ceilf(left), 0, surface->width);
+            int xb = clamp_int((int)floorf(right), -1, surface->width - 1);
+            n = xb - xa + 1;
+            if (n > 0) {
+                fill_span(surface->pixels + (size_t)y * surface->stride + xa, n, color);
+                if (xa < min_x) min_x = xa;
+                if (xb > max_x) max_x = xb;
+            }
+        }
+        if (n > 0) {
+            written += n;
+            if (min_y < 0) min_y = y;
+            max_y = y;
+        }
+    }
+
+    if (dirty && written > 0) {
+        dirty->x0 = min_x;
+        dirty->y0 = min_y;
+        dirty->x1 = max_x + 1;
+        dirty->y1 = max_y + 1;
+    }
+    return written;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file stroke_raster.h
+ * @brief 圆头粗线段光栅化（按水平扫描段填充）
+ *
+ * 把一段笔画（两端圆头、宽度为2r+1的胶囊形）逐行求出覆盖的水平区间，
+ * 每行一次宽写入填充，代替沿线逐点盖圆、逐像素加锁的做法。
+ * 可选抗锯齿：区间内部直接填充，只有边缘像素按到线段的距离计算覆盖率后混合。
+ *
+ * 本模块不加锁，调用者在一次绘制前后持有对应framebuffer的锁。
+ */
+
+#ifndef STROKE_RASTER_H
+#define STROKE_RASTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 32位像素绘制目标（framebuffer或SDL虚拟framebuffer）
+typedef struct {
+    uint32_t *pixels;               // 左上角像素
+    int stride;                     // 每行像素数（不是字节数）
+    int width;
+    int height;
+} stroke_surface_t;
+
+// 脏矩形（包含x0/y0，不包含x1/y1），空矩形x0 >= x1
+typedef struct {
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+} stroke_rect_t;
+
+/**
+ * @brief 把矩形置为空
+ * @param rect 矩形
+ */
+void stroke_rect_reset(stroke_rect_t *rect);
+
+/**
+ * @brief 判断矩形是否为空
+ * @param rect 矩形
+ * @return 空返回true
+ */
+bool stroke_rect_empty(const stroke_rect_t *rect);
+
+/**
+ * @brief 把src合并到dst（取包围盒）
+ * @param dst 目标矩形
+ * @param src 要合并的矩形
+ */
+void stroke_rect_union(stroke_rect_t *dst, const stroke_rect_t *src);
+
+/**
+ * @brief 绘制一段圆头粗线段（x0,y0与x1,y1相同时为一个圆点）
+ *
+ * 非抗锯齿时覆盖到线段距离不超过radius的所有像素中心，
+ * 与原来的逐点盖圆（dx*dx + dy*dy <= r*r）结果一致但没有缝隙。
+ * 抗锯齿时边缘像素按覆盖率与原像素逐字节混合（与像素通道顺序无关）。
+ * @param surface 绘制目标
+ * @param x0 起点X
+ * @param y0 起点Y
+ * @param x1 终点X
+ * @param y1 终点Y
+ * @param radius 半径（像素，0为单像素宽）
+ * @param color 颜色（按目标的像素格式）
+ * @param antialias 是否抗锯齿
+ * @param dirty 输出本次写入的包围盒（可为NULL）
+ * @return 写入的像素数
+ */
+int stroke_raster_segment(const stroke_surface_t *surface, int x0, int y0, int x1, int y1,
+                          int radius, uint32_t color, bool antialias, stroke_rect_t *dirty);
+
+#endif /* STROKE_RASTER_H */
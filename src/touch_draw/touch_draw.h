@@ -7,6 +7,7 @@
 #define TOUCH_DRAW_H
 
 #include "lvgl/lvgl.h"
+#include "../collaborative_draw/remote_op_queue.h"
 
 /**
  * @brief 显示触摸绘图窗口
@@ -46,4 +47,10 @@ void touch_draw_set_collaborative_mode(bool enabled);
  */
 bool touch_draw_get_collaborative_mode(void);
 
+/**
+ * @brief 获取远程绘图队列统计信息（入队/出队、溢出丢弃、背压次数、最大占用）
+ * @param stats 输出统计信息
+ */
+void touch_draw_get_remote_queue_stats(remote_op_queue_stats_t *stats);
+
 #endif /* TOUCH_DRAW_H */
@@ -10,7 +10,81 @@
 #include <strings.h>
 #include "lvgl/lvgl.h"
 
+#ifndef MUSIC_PROGRESS_MS
+#define MUSIC_PROGRESS_MS 250       // 进度条刷新间隔（与播放引擎的查询间隔相同）
+#endif
+
+extern const lv_font_t SourceHanSansSC_VF;
+
 static lv_obj_t *music_win = NULL;
+static lv_obj_t *progress_bar = NULL;       // 播放进度（0~1000）
+static lv_obj_t *progress_label = NULL;     // "1:23 / 4:56"
+static lv_timer_t *progress_timer = NULL;
+
+/**
+ * @brief 进度定时器：读取音频播放器的状态快照更新进度条（不访问mplayer管道，不阻塞界面）
+ */
+static void progress_timer_cb(lv_timer_t *timer) {
+    (void)timer;
+    extern lv_obj_t *player_screen;
+    if (!progress_bar || lv_scr_act() != player_screen) {
+        return;
+    }
+
+    media_engine_status_t status;
+    audio_player_get_status(&status);
+
+    int32_t value = 0;
+    char text[64];
+    if (status.loading) {
+        snprintf(text, sizeof(text), "加载中");
+    } else if (!status.loaded) {
+        // 加载是异步的，无法播放在握手完成后才知道
+        snprintf(text, sizeof(text), "%s", status.failed ? "无法播放" : "未播放");
+    } else {
+        char pos[16];
+        char len[16];
+        media_engine_format_time(pos, sizeof(pos), status.position_ms);
+        media_engine_format_time(len, sizeof(len), status.duration_ms);
+        snprintf(text, sizeof(text), "%s / %s%s", pos, len, status.paused ? "  已暂停" : "");
+        if (status.duration_ms > 0 && status.position_ms > 0) {
+            value = (int32_t)((int64_t)status.position_ms * 1000 / status.duration_ms);
+            value = value > 1000 ? 1000 : value;
+        }
+    }
+
+    // 只在变化时更新，避免每次都重绘
+    if (lv_bar_get_value(progress_bar) != value) {
+        lv_bar_set_value(progress_bar, value, LV_ANIM_OFF);
+    }
+    if (strcmp(lv_label_get_text(progress_label), text) != 0) {
+        lv_label_set_text(progress_label, text);
+    }
+}
+
+/**
+ * @brief 在播放器屏幕上创建进度条和时间（第一次显示音乐播放器时）
+ */
+static void create_progress(lv_obj_t *screen) {
+    if (progress_bar) {
+        return;
+    }
+    progress_label = lv_label_create(screen);
+    lv_label_set_text(progress_label, "未播放");
+    lv_obj_set_style_text_font(progress_label, &SourceHanSansSC_VF, 0);
+    lv_obj_set_style_text_color(progress_label, lv_color_hex(0x1a1a1a), 0);
+    lv_obj_align(progress_label, LV_ALIGN_TOP_RIGHT, -20, 180);
+
+    progress_bar = lv_bar_create(screen);
+    lv_obj_set_size(progress_bar, 500, 12);
+    lv_obj_align(progress_bar, LV_ALIGN_TOP_RIGHT, -20, 215);
+    lv_bar_set_range(progress_bar, 0, 1000);
+    lv_bar_set_value(progress_bar, 0, LV_ANIM_OFF);
+    lv_obj_set_style_bg_color(progress_bar, lv_color_hex(0xe0e0e0), 0);
+    lv_obj_set_style_bg_color(progress_bar, lv_color_hex(0x2196F3), LV_PART_INDICATOR);
+
+    progress_timer = lv_timer_create(progress_timer_cb, MUSIC_PROGRESS_MS, NULL);
+}
 
 static void update_music_label() {
     if (!music_win) return;
@@ -44,6 +118,16 @@ static void music_control_handler(lv_event_t *e) {
     extern char **audio_files;
     extern int audio_count;
     
+    if (audio_count == 0 || audio_files == NULL) {
+        return;
+    }
+    // 媒体索引可能已删除文件、缩短了列表，先把索引限制在现有范围内再移动
+    if (current_audio_index < 0) {
+        current_audio_index = 0;
+    } else if (current_audio_index >= audio_count) {
+        current_audio_index = audio_count - 1;
+    }
+    
     // 判断是上一首还是下一首按钮
     lv_obj_t *prev_btn = lv_obj_get_child(music_win, 2);
     
@@ -104,6 +188,7 @@ void music_win_show(void) {
     // 确保player_screen显示
     if (player_screen) {
         lv_obj_clear_flag(player_screen, LV_OBJ_FLAG_HIDDEN);
+        create_progress(player_screen);
     }
     
     // 确保主屏幕隐藏
@@ -153,8 +238,6 @@ void music_win_event_handler(lv_event_t *e) {
     if(lv_event_get_code(e) == LV_EVENT_CLICKED) {
         if (audio_player_is_playing()) {
             audio_player_stop();
-            // 等待音频播放器完全停止
-            usleep(100000);  // 100ms
         }
         
         if (music_win) {
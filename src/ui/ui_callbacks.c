@@ -368,14 +368,14 @@ void prev_media_cb(lv_event_t * e) {
         return;
     }
     
-    // 停止当前音频播放
-    if (audio_player_is_playing()) {
-        audio_player_stop();
-    }
-    
-    // 等待一小段时间，确保资源已释放
-    usleep(100000);  // 100ms
+    // 不需要先停止：常驻mplayer用loadfile直接替换当前曲目
     
+    // 媒体索引可能已删除文件、缩短了列表，先把索引限制在现有范围内再移动
+    if (current_audio_index < 0) {
+        current_audio_index = 0;
+    } else if (current_audio_index >= audio_count) {
+        current_audio_index = audio_count - 1;
+    }
     current_audio_index--;
     if (current_audio_index < 0) {
         current_audio_index = audio_count - 1;  // 循环到最后一首
@@ -418,14 +418,14 @@ void next_media_cb(lv_event_t * e) {
         return;
     }
     
-    // 停止当前音频播放
-    if (audio_player_is_playing()) {
-        audio_player_stop();
-    }
-    
-    // 等待一小段时间，确保资源已释放
-    usleep(100000);  // 100ms
+    // 不需要先停止：常驻mplayer用loadfile直接替换当前曲目
     
+    // 媒体索引可能已删除文件、缩短了列表，先把索引限制在现有范围内再移动
+    if (current_audio_index < 0) {
+        current_audio_index = 0;
+    } else if (current_audio_index >= audio_count) {
+        current_audio_index = audio_count - 1;
+    }
     current_audio_index++;
     if (current_audio_index >= audio_count) {
         current_audio_index = 0;  // 循环到第一首
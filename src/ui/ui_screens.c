@@ -13,9 +13,12 @@
 #include "timer_win.h"
 #include "../common/common.h"
 #include "../image_viewer/image_viewer.h"
+#include "../image_viewer/gallery_view.h"
 #include "../media_player/audio_player.h"
 #include "../media_player/simple_video_player.h"
 #include "../file_scanner/file_scanner.h"
+#include "../file_scanner/media_catalog.h"
+#include "../file_scanner/media_search.h"
 #include "../touch_draw/touch_draw.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -541,6 +544,53 @@ void create_image_screen(void) {
     /* show_images(); */
 }
 
+/* 播放列表搜索：输入框过滤，排序按钮在名称、日期、大小之间切换 */
+static media_query_t playlist_query;
+static bool playlist_query_ready = false;
+static lv_obj_t *playlist_search_ta = NULL;
+static lv_obj_t *playlist_keyboard = NULL;
+static lv_obj_t *playlist_sort_label = NULL;
+static const char *playlist_sort_names[MEDIA_SORT_COUNT] = {"名称", "日期", "大小"};
+
+/**
+ * @brief 搜索框事件：获得焦点时弹出键盘，输入变化时过滤播放列表
+ */
+static void playlist_search_event_cb(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code == LV_EVENT_FOCUSED) {
+        lv_keyboard_set_textarea(playlist_keyboard, playlist_search_ta);
+        lv_obj_clear_flag(playlist_keyboard, LV_OBJ_FLAG_HIDDEN);
+    } else if (code == LV_EVENT_DEFOCUSED) {
+        lv_obj_add_flag(playlist_keyboard, LV_OBJ_FLAG_HIDDEN);
+    } else if (code == LV_EVENT_VALUE_CHANGED && playlist_query_ready) {
+        media_query_set_text(&playlist_query, lv_textarea_get_text(playlist_search_ta));
+        update_playlist();
+    }
+}
+
+/**
+ * @brief 键盘确定或取消时收起键盘
+ */
+static void playlist_keyboard_event_cb(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code == LV_EVENT_READY || code == LV_EVENT_CANCEL) {
+        lv_obj_clear_state(playlist_search_ta, LV_STATE_FOCUSED);
+        lv_obj_add_flag(playlist_keyboard, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+/**
+ * @brief 排序按钮：名称 -> 日期 -> 大小
+ */
+static void playlist_sort_cb(lv_event_t *e) {
+    if (lv_event_get_code(e) != LV_EVENT_CLICKED || !playlist_query_ready) {
+        return;
+    }
+    media_query_set_sort(&playlist_query, (media_sort_t)((playlist_query.sort + 1) % MEDIA_SORT_COUNT));
+    lv_label_set_text(playlist_sort_label, playlist_sort_names[playlist_query.sort]);
+    update_playlist();
+}
+
 /**
  * @brief 创建播放器屏幕
  */
@@ -556,6 +606,27 @@ void create_player_screen(void) {
     lv_obj_align(playlist_title, LV_ALIGN_TOP_LEFT, 10, 10);  // 固定在左上方
     lv_obj_move_foreground(playlist_title);  // 确保标题在最上层
     
+    // 搜索框和排序按钮（标题和播放列表之间），可输入文件名或拼音首字母
+    playlist_search_ta = lv_textarea_create(player_screen);
+    lv_textarea_set_one_line(playlist_search_ta, true);
+    lv_textarea_set_max_length(playlist_search_ta, MEDIA_QUERY_TEXT_MAX - 1);
+    lv_textarea_set_placeholder_text(playlist_search_ta, "搜索(如zjl)");
+    lv_obj_set_size(playlist_search_ta, 170, 32);
+    lv_obj_align(playlist_search_ta, LV_ALIGN_TOP_LEFT, 10, 36);
+    lv_obj_set_style_text_font(playlist_search_ta, &SourceHanSansSC_VF, 0);
+    lv_obj_set_style_pad_ver(playlist_search_ta, 2, 0);
+    lv_obj_add_event_cb(playlist_search_ta, playlist_search_event_cb, LV_EVENT_ALL, NULL);
+    
+    lv_obj_t *sort_btn = lv_btn_create(player_screen);
+    lv_obj_set_size(sort_btn, 75, 32);
+    lv_obj_align(sort_btn, LV_ALIGN_TOP_LEFT, 185, 36);
+    lv_obj_set_style_bg_color(sort_btn, lv_color_hex(0x9E9E9E), 0);
+    playlist_sort_label = lv_label_create(sort_btn);
+    lv_label_set_text(playlist_sort_label, playlist_sort_names[MEDIA_SORT_NAME]);
+    lv_obj_set_style_text_font(playlist_sort_label, &SourceHanSansSC_VF, 0);
+    lv_obj_center(playlist_sort_label);
+    lv_obj_add_event_cb(sort_btn, playlist_sort_cb, LV_EVENT_CLICKED, NULL);
+    
     /* 创建播放列表容器（左侧，标题下方间隔60px） */
     extern lv_obj_t *playlist_container;
     playlist_container = lv_obj_create(player_screen);
@@ -763,6 +834,12 @@ void create_player_screen(void) {
     lv_obj_set_style_text_font(speed_label, &SourceHanSansSC_VF, 0);
     lv_obj_set_style_text_color(speed_label, lv_color_hex(0x1a1a1a), 0);
     
+    // 搜索键盘（屏幕底部，搜索框获得焦点时显示）
+    playlist_keyboard = lv_keyboard_create(player_screen);
+    lv_obj_set_size(playlist_keyboard, LV_PCT(100), LV_PCT(45));
+    lv_obj_add_flag(playlist_keyboard, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_add_event_cb(playlist_keyboard, playlist_keyboard_event_cb, LV_EVENT_ALL, NULL);
+    
     // 初始化播放列表（在音乐播放时更新）
     update_playlist();
     
@@ -798,10 +875,10 @@ static void playlist_item_clicked(lv_event_t *e) {
     }
     
     lv_obj_t *btn = lv_event_get_target(e);
-    int *index = (int *)lv_obj_get_user_data(btn);
-    if (index) {
+    intptr_t index = (intptr_t)lv_obj_get_user_data(btn);  // 列表下标+1
+    if (index > 0) {
         extern void play_audio_by_index(int);
-        play_audio_by_index(*index);
+        play_audio_by_index((int)index - 1);
     }
 }
 
@@ -817,12 +894,21 @@ void update_playlist(void) {
         return;
     }
     
+    // 列表或元数据变化后重新查询（没有变化时直接返回）
+    if (!playlist_query_ready) {
+        media_query_init(&playlist_query, MEDIA_LIST_AUDIO, MEDIA_SORT_NAME);
+        playlist_query_ready = true;
+    } else {
+        media_query_refresh(&playlist_query);
+    }
+    
     // 清空现有列表项
     lv_obj_clean(playlist_list);
     
-    // 添加音频文件到列表
-    for (int i = 0; i < audio_count && i < 20; i++) {  // 最多显示20项
-        if (!audio_files[i]) {
+    // 按排序添加搜索结果
+    for (int n = 0; n < playlist_query.count && n < 20; n++) {  // 最多显示20项
+        int i = playlist_query.items[n];
+        if (i >= audio_count || !audio_files[i]) {
             break;
         }
         
@@ -830,6 +916,21 @@ void update_playlist(void) {
         const char *filename = strrchr(audio_files[i], '/');
         filename = filename ? filename + 1 : audio_files[i];
         
+        // 媒体目录中有元数据时显示ID3标题和时长（不打开文件）
+        char item_text[128];
+        media_info_t meta;
+        if (media_catalog_lookup(audio_files[i], &meta) == MEDIA_INFO_READY) {
+            const char *title = meta.title[0] != '\0' ? meta.title : filename;
+            if (meta.duration_ms > 0) {
+                unsigned sec = meta.duration_ms / 1000;
+                snprintf(item_text, sizeof(item_text), "%s  %u:%02u", title, sec / 60, sec % 60);
+            } else {
+                snprintf(item_text, sizeof(item_text), "%s", title);
+            }
+        } else {
+            snprintf(item_text, sizeof(item_text), "%s", filename);
+        }
+        
         // 创建列表项按钮
         lv_obj_t *list_btn = lv_btn_create(playlist_list);
         lv_obj_set_size(list_btn, LV_PCT(100), 35);
@@ -841,7 +942,7 @@ void update_playlist(void) {
         
         // 创建标签
         lv_obj_t *list_label = lv_label_create(list_btn);
-        lv_label_set_text(list_label, filename);
+        lv_label_set_text(list_label, item_text);
         lv_obj_set_style_text_font(list_label, &SourceHanSansSC_VF, 0);
         lv_obj_set_style_text_color(list_label, 
             (i == current_audio_index) ? lv_color_hex(0xffffff) : lv_color_hex(0x1a1a1a), 0);
@@ -849,10 +950,8 @@ void update_playlist(void) {
         lv_label_set_long_mode(list_label, LV_LABEL_LONG_SCROLL_CIRCULAR);
         lv_obj_set_width(list_label, LV_PCT(90));
         
-        // 存储索引到用户数据
-        int *index_ptr = (int *)malloc(sizeof(int));
-        *index_ptr = i;
-        lv_obj_set_user_data(list_btn, index_ptr);
+        // 存储索引到用户数据（直接存下标+1，每次输入都会重建列表，不再为每项分配内存）
+        lv_obj_set_user_data(list_btn, (void *)(intptr_t)(i + 1));
         
         // 添加点击事件
         lv_obj_add_event_cb(list_btn, playlist_item_clicked, LV_EVENT_CLICKED, NULL);
@@ -866,21 +965,13 @@ void play_audio_by_index(int index) {
     extern char **audio_files;
     extern int audio_count;
     extern int current_audio_index;
-    extern bool audio_player_is_playing(void);
-    extern void audio_player_stop(void);
     extern bool audio_player_play(const char *);
     
     if (index < 0 || index >= audio_count || !audio_files[index]) {
         return;
     }
     
-    // 停止当前播放
-    if (audio_player_is_playing()) {
-        audio_player_stop();
-        usleep(100000);
-    }
-    
-    // 更新索引并播放
+    // 更新索引并播放（常驻mplayer用loadfile直接替换当前曲目，不需要先停止）
     current_audio_index = index;
     audio_player_play(audio_files[index]);
     
@@ -932,6 +1023,7 @@ void back_to_main_cb(lv_event_t * e) {
         lv_obj_add_flag(player_screen, LV_OBJ_FLAG_HIDDEN);
     }
     if (image_screen) {
+        gallery_view_close();  // 关闭缩略图网格，停止后台生成
         lv_obj_add_flag(image_screen, LV_OBJ_FLAG_HIDDEN);
     }
     if (video_screen) {
@@ -15,8 +15,99 @@
 #include <unistd.h>  // For access()
 #include "lvgl/lvgl.h"
 
+#ifndef VIDEO_PROGRESS_MS
+#define VIDEO_PROGRESS_MS 250       // 进度检查间隔
+#endif
+
+extern const lv_font_t SourceHanSansSC_VF;
+
 lv_obj_t *video_screen = NULL;  // 视频播放独立屏幕（全局变量，供其他模块访问）
 static lv_obj_t *touch_overlay = NULL;  // 全屏透明层用于捕获触屏事件
+static lv_obj_t *progress_panel = NULL;     // 底部进度面板（暂停时显示）
+static lv_obj_t *progress_bar = NULL;
+static lv_obj_t *progress_label = NULL;
+static lv_timer_t *progress_timer = NULL;
+static bool progress_drawn = false;         // 本次暂停已绘制过面板
+
+/**
+ * @brief 进度定时器：读取视频播放器的状态快照，暂停时在画面底部显示进度
+ *
+ * 播放时mplayer直接写framebuffer，LVGL不重绘进度面板（mplayer的下一帧会覆盖它），
+ * 暂停时画面不再变化，此时绘制一次，之后只在内容变化时重绘。
+ */
+static void progress_timer_cb(lv_timer_t *timer) {
+    (void)timer;
+    if (!progress_panel || lv_scr_act() != video_screen) {
+        return;
+    }
+
+    media_engine_status_t status;
+    simple_video_get_status(&status);
+    if (!status.loaded || !status.paused) {
+        progress_drawn = false;
+        return;
+    }
+
+    char pos[16];
+    char len[16];
+    char text[64];
+    media_engine_format_time(pos, sizeof(pos), status.position_ms);
+    media_engine_format_time(len, sizeof(len), status.duration_ms);
+    snprintf(text, sizeof(text), "%s / %s  已暂停", pos, len);
+    int32_t value = 0;
+    if (status.duration_ms > 0 && status.position_ms > 0) {
+        value = (int32_t)((int64_t)status.position_ms * 1000 / status.duration_ms);
+        value = value > 1000 ? 1000 : value;
+    }
+
+    bool changed = lv_bar_get_value(progress_bar) != value ||
+                   strcmp(lv_label_get_text(progress_label), text) != 0;
+    if (progress_drawn && !changed) {
+        return;
+    }
+    lv_bar_set_value(progress_bar, value, LV_ANIM_OFF);
+    lv_label_set_text(progress_label, text);
+    lv_obj_clear_flag(progress_panel, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_invalidate(progress_panel);      // 整个面板重绘在暂停的画面上
+    progress_drawn = true;
+}
+
+/**
+ * @brief 创建底部进度面板（隐藏，暂停时由定时器显示）
+ */
+static void create_progress(lv_obj_t *screen) {
+    if (progress_panel) {
+        lv_obj_add_flag(progress_panel, LV_OBJ_FLAG_HIDDEN);
+        progress_drawn = false;
+        return;
+    }
+    progress_panel = lv_obj_create(screen);
+    lv_obj_set_size(progress_panel, LV_HOR_RES - 40, 56);
+    lv_obj_align(progress_panel, LV_ALIGN_BOTTOM_MID, 0, -10);
+    lv_obj_set_style_bg_color(progress_panel, lv_color_hex(0x202020), 0);
+    lv_obj_set_style_bg_opa(progress_panel, LV_OPA_COVER, 0);
+    lv_obj_set_style_border_width(progress_panel, 0, 0);
+    lv_obj_set_style_pad_all(progress_panel, 6, 0);
+    lv_obj_clear_flag(progress_panel, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_clear_flag(progress_panel, LV_OBJ_FLAG_CLICKABLE);   // 触屏事件交给透明层
+    lv_obj_add_flag(progress_panel, LV_OBJ_FLAG_HIDDEN);
+
+    progress_label = lv_label_create(progress_panel);
+    lv_label_set_text(progress_label, "");
+    lv_obj_set_style_text_font(progress_label, &SourceHanSansSC_VF, 0);
+    lv_obj_set_style_text_color(progress_label, lv_color_white(), 0);
+    lv_obj_align(progress_label, LV_ALIGN_TOP_LEFT, 0, -4);
+
+    progress_bar = lv_bar_create(progress_panel);
+    lv_obj_set_size(progress_bar, LV_PCT(100), 10);
+    lv_obj_align(progress_bar, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_bar_set_range(progress_bar, 0, 1000);
+    lv_bar_set_value(progress_bar, 0, LV_ANIM_OFF);
+    lv_obj_set_style_bg_color(progress_bar, lv_color_hex(0x606060), 0);
+    lv_obj_set_style_bg_color(progress_bar, lv_color_hex(0x2196F3), LV_PART_INDICATOR);
+
+    progress_timer = lv_timer_create(progress_timer_cb, VIDEO_PROGRESS_MS, NULL);
+}
 
 /**
  * @brief 触屏事件处理回调
@@ -92,6 +183,7 @@ void video_win_show_with_file(const char *file_path) {
         lv_obj_set_style_bg_color(video_screen, lv_color_white(), 0);
         lv_obj_set_style_bg_opa(video_screen, LV_OPA_COVER, 0);
     }
+    create_progress(video_screen);
     
     // 隐藏主屏幕
     extern lv_obj_t *main_screen;
@@ -241,7 +333,6 @@ void video_win_event_handler(lv_event_t *e) {
         lv_obj_move_foreground(loading_screen);  // 确保在最上层
         
         // 创建加载提示文字
-        extern lv_font_t SourceHanSansSC_VF;
         lv_obj_t *loading_label = lv_label_create(loading_screen);
         lv_label_set_text(loading_label, "正在返回主页...");
         lv_obj_set_style_text_font(loading_label, &SourceHanSansSC_VF, 0);
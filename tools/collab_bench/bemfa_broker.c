@@ -0,0 +1,528 @@
+/**
+ * @file bemfa_broker.c
+ * @brief 本地巴法云TCP协议兼容服务器（协作绘图性能测试用）
+ *
+ * 实现 bemfa_tcp_client.c 使用的行协议子集，监听本机8344端口：
+ *   cmd=1&uid=xxx&topic=a,b\r\n          订阅，回复 cmd=1&res=1
+ *   cmd=2&uid=xxx&topic=a/set&msg=xxx\r\n 推送给a的订阅者（发送者除外），回复 cmd=2&res=1
+ *   cmd=2&uid=xxx&topic=a&msg=xxx\r\n     推送给a的所有订阅者
+ *   cmd=2&uid=xxx&topic=a/up&msg=xxx\r\n  只回复，不推送
+ *   ping\r\n 或 cmd=0&...\r\n             心跳，回复 cmd=0&res=1
+ * 推送给订阅者的格式与巴法云一致：cmd=2&uid=xxx&topic=a&msg=xxx\r\n
+ *
+ * 单线程epoll，非阻塞socket；每个连接有接收重组缓冲区和发送缓冲区，
+ * 发送缓冲区超过上限的慢客户端丢弃推送并计数。
+ */
+
+#define _GNU_SOURCE  // accept4
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define BROKER_DEFAULT_PORT     8344
+#define BROKER_MAX_CLIENTS      256
+#define BROKER_MAX_TOPICS       8
+#define BROKER_TOPIC_LEN        128
+#define BROKER_RX_BUFFER_SIZE   8192               // 单行最大长度（与客户端一致）
+#define BROKER_TX_BUFFER_LIMIT  (1024 * 1024)      // 单连接待发送数据上限
+#define BROKER_LISTEN_TAG       UINT32_MAX         // epoll中监听socket的标记
+
+// 客户端连接
+typedef struct {
+    bool in_use;
+    int fd;
+    char rx[BROKER_RX_BUFFER_SIZE];
+    size_t rx_len;
+    bool rx_discarding;                            // 正在丢弃超长行
+    char *tx;                                      // 待发送数据
+    size_t tx_len;
+    size_t tx_off;                                 // 已发送的前缀长度
+    size_t tx_cap;
+    bool want_write;                               // 已注册EPOLLOUT
+    char topics[BROKER_MAX_TOPICS][BROKER_TOPIC_LEN];
+    int topic_count;
+    uint64_t dropped;                              // 因发送缓冲区满丢弃的推送
+} broker_client_t;
+
+// 服务器统计
+typedef struct {
+    uint64_t connections;                          // 累计连接数
+    uint64_t publishes;                            // 收到的发布命令
+    uint64_t deliveries;                           // 推送给订阅者的消息数（扇出）
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    uint64_t dropped;                              // 慢客户端丢弃的推送
+    uint64_t bad_lines;                            // 无法解析的行
+} broker_stats_t;
+
+static struct {
+    int listen_fd;
+    int epoll_fd;
+    broker_client_t clients[BROKER_MAX_CLIENTS];
+    int active;
+    broker_stats_t stats;
+    broker_stats_t last_report;
+    volatile sig_atomic_t stop;
+} g_broker;
+
+static void signal_handler(int sig) {
+    (void)sig;
+    g_broker.stop = 1;
+}
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void client_close(broker_client_t *c) {
+    if (!c->in_use) {
+        return;
+    }
+    epoll_ctl(g_broker.epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    free(c->tx);
+    memset(c, 0, sizeof(*c));
+    c->fd = -1;
+    g_broker.active--;
+}
+
+static void client_update_events(broker_client_t *c, bool want_write) {
+    if (c->want_write == want_write) {
+        return;
+    }
+    struct epoll_event ev = {0};
+    ev.events = EPOLLIN | EPOLLRDHUP | (want_write ? EPOLLOUT : 0);
+    ev.data.u32 = (uint32_t)(c - g_broker.clients);
+    epoll_ctl(g_broker.epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+    c->want_write = want_write;
+}
+
+// 尽量发出发送缓冲区中的数据，出错返回-1
+static int client_flush(broker_client_t *c) {
+    while (c->tx_off < c->tx_len) {
+        ssize_t n = send(c->fd, c->tx + c->tx_off, c->tx_len - c->tx_off, MSG_NOSIGNAL);
+        if (n > 0) {
+            c->tx_off += n;
+            g_broker.stats.bytes_out += n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return -1;
+        }
+    }
+
+    if (c->tx_off == c->tx_len) {
+        c->tx_off = 0;
+        c->tx_len = 0;
+    }
+    client_update_events(c, c->tx_len > 0);
+    return 0;
+}
+
+// 追加一行到发送缓冲区，超过上限返回false（调用者计入丢弃）
+static bool client_enqueue(broker_client_t *c, const char *data, size_t len) {
+    size_t pending = c->tx_len - c->tx_off;
+    if (pending + len > BROKER_TX_BUFFER_LIMIT) {
+        return false;
+    }
+
+    // 先把已发送的前缀挪走，再按需扩容
+    if (c->tx_off > 0 && c->tx_len + len > c->tx_cap) {
+        memmove(c->tx, c->tx + c->tx_off, pending);
+        c->tx_len = pending;
+        c->tx_off = 0;
+    }
+    if (c->tx_len + len > c->tx_cap) {
+        size_t cap = c->tx_cap ? c->tx_cap : 4096;
+        while (cap < c->tx_len + len) {
+            cap *= 2;
+        }
+        char *tx = (char *)realloc(c->tx, cap);
+        if (!tx) {
+            return false;
+        }
+        c->tx = tx;
+        c->tx_cap = cap;
+    }
+    memcpy(c->tx + c->tx_len, data, len);
+    c->tx_len += len;
+    return true;
+}
+
+static void client_reply(broker_client_t *c, const char *reply) {
+    client_enqueue(c, reply, strlen(reply));
+}
+
+// 取出形如 "&key=value" 的字段（value到下一个'&'或行尾），未找到返回NULL
+static const char *find_field(const char *line, const char *key, size_t *value_len) {
+    const char *p = strstr(line, key);
+    if (!p) {
+        return NULL;
+    }
+    p += strlen(key);
+    const char *end = strchr(p, '&');
+    *value_len = end ? (size_t)(end - p) : strlen(p);
+    return p;
+}
+
+static bool client_subscribed(const broker_client_t *c, const char *topic, size_t topic_len) {
+    for (int i = 0; i < c->topic_count; i++) {
+        if (strlen(c->topics[i]) == topic_len && memcmp(c->topics[i], topic, topic_len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 订阅：topic可以是逗号分隔的多个主题
+static void handle_subscribe(broker_client_t *c, const char *line) {
+    size_t topic_len = 0;
+    const char *topic = find_field(line, "&topic=", &topic_len);
+    size_t uid_len = 0;
+    const char *uid = find_field(line, "&uid=", &uid_len);
+    if (!topic || topic_len == 0 || !uid || uid_len == 0) {
+        client_reply(c, "cmd=1&res=0\r\n");
+        return;
+    }
+
+    while (topic_len > 0) {
+        const char *comma = memchr(topic, ',', topic_len);
+        size_t len = comma ? (size_t)(comma - topic) : topic_len;
+        if (len > 0 && len < BROKER_TOPIC_LEN && !client_subscribed(c, topic, len) &&
+            c->topic_count < BROKER_MAX_TOPICS) {
+            memcpy(c->topics[c->topic_count], topic, len);
+            c->topics[c->topic_count][len] = '\0';
+            c->topic_count++;
+        }
+        if (!comma) {
+            break;
+        }
+        topic_len -= len + 1;
+        topic = comma + 1;
+    }
+    client_reply(c, "cmd=1&res=1\r\n");
+}
+
+// 发布：按主题后缀决定推送范围，推送行只组装一次
+static void handle_publish(broker_client_t *c, const char *line) {
+    size_t uid_len = 0, topic_len = 0;
+    const char *uid = find_field(line, "&uid=", &uid_len);
+    const char *topic = find_field(line, "&topic=", &topic_len);
+    const char *msg = strstr(line, "&msg=");
+    if (!uid || !topic || topic_len == 0 || !msg) {
+        client_reply(c, "cmd=2&res=0\r\n");
+        return;
+    }
+    msg += 5;
+
+    g_broker.stats.publishes++;
+
+    bool exclude_sender = false;
+    if (topic_len > 4 && memcmp(topic + topic_len - 4, "/set", 4) == 0) {
+        topic_len -= 4;
+        exclude_sender = true;
+    } else if (topic_len > 3 && memcmp(topic + topic_len - 3, "/up", 3) == 0) {
+        client_reply(c, "cmd=2&res=1\r\n");
+        return;
+    }
+
+    size_t msg_len = strlen(msg);
+    size_t push_len = 24 + uid_len + topic_len + msg_len;
+    char *push = (char *)malloc(push_len + 1);
+    if (!push) {
+        client_reply(c, "cmd=2&res=0\r\n");
+        return;
+    }
+    int n = snprintf(push, push_len + 1, "cmd=2&uid=%.*s&topic=%.*s&msg=%s\r\n",
+                     (int)uid_len, uid, (int)topic_len, topic, msg);
+
+    for (int i = 0; i < BROKER_MAX_CLIENTS; i++) {
+        broker_client_t *sub = &g_broker.clients[i];
+        if (!sub->in_use || (exclude_sender && sub == c) || !client_subscribed(sub, topic, topic_len)) {
+            continue;
+        }
+        if (client_enqueue(sub, push, n)) {
+            g_broker.stats.deliveries++;
+        } else {
+            sub->dropped++;
+            g_broker.stats.dropped++;
+        }
+    }
+    free(push);
+
+    client_reply(c, "cmd=2&res=1\r\n");
+}
+
+static void handle_line(broker_client_t *c, const char *line) {
+    if (strncmp(line, "cmd=1&", 6) == 0) {
+        handle_subscribe(c, line);
+    } else if (strncmp(line, "cmd=2&", 6) == 0) {
+        handle_publish(c, line);
+    } else if (strncmp(line, "cmd=0", 5) == 0 || strcmp(line, "ping") == 0) {
+        client_reply(c, "cmd=0&res=1\r\n");
+    } else {
+        g_broker.stats.bad_lines++;
+    }
+}
+
+// 读取并按行处理；连接关闭或出错返回-1
+static int client_read(broker_client_t *c) {
+    for (;;) {
+        size_t space = sizeof(c->rx) - 1 - c->rx_len;
+        ssize_t n = recv(c->fd, c->rx + c->rx_len, space, 0);
+        if (n == 0) {
+            return -1;
+        }
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        g_broker.stats.bytes_in += n;
+
+        size_t scan_from = c->rx_len;
+        c->rx_len += n;
+        size_t start = 0;
+        char *nl;
+        while ((nl = memchr(c->rx + scan_from, '\n', c->rx_len - scan_from)) != NULL) {
+            size_t end = nl - c->rx;
+            size_t len = end - start;
+            if (len > 0 && c->rx[start + len - 1] == '\r') {
+                len--;
+            }
+            c->rx[start + len] = '\0';
+            if (c->rx_discarding) {
+                c->rx_discarding = false;
+            } else if (len > 0) {
+                handle_line(c, c->rx + start);
+            }
+            start = end + 1;
+            scan_from = start;
+        }
+
+        if (start > 0) {
+            memmove(c->rx, c->rx + start, c->rx_len - start);
+            c->rx_len -= start;
+        }
+        if (c->rx_len >= sizeof(c->rx) - 1) {
+            c->rx_len = 0;
+            c->rx_discarding = true;
+            g_broker.stats.bad_lines++;
+        }
+    }
+}
+
+static void accept_clients(void) {
+    for (;;) {
+        int fd = accept4(g_broker.listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                printf("[本地服务器] accept失败: %s\n", strerror(errno));
+            }
+            return;
+        }
+
+        int slot = -1;
+        for (int i = 0; i < BROKER_MAX_CLIENTS; i++) {
+            if (!g_broker.clients[i].in_use) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot < 0) {
+            printf("[本地服务器] 连接数已满（%d），拒绝新连接\n", BROKER_MAX_CLIENTS);
+            close(fd);
+            continue;
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        broker_client_t *c = &g_broker.clients[slot];
+        memset(c, 0, sizeof(*c));
+        c->in_use = true;
+        c->fd = fd;
+
+        struct epoll_event ev = {0};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.u32 = (uint32_t)slot;
+        if (epoll_ctl(g_broker.epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            c->in_use = false;
+            continue;
+        }
+        g_broker.active++;
+        g_broker.stats.connections++;
+    }
+}
+
+// 输出统计（interval_ms为0时输出累计值）
+static void report_stats(uint64_t interval_ms) {
+    broker_stats_t *s = &g_broker.stats;
+    if (interval_ms == 0) {
+        printf("[本地服务器] 累计：连接%llu，发布%llu，推送%llu，丢弃%llu，入%llu字节，出%llu字节，错误行%llu\n",
+               (unsigned long long)s->connections, (unsigned long long)s->publishes,
+               (unsigned long long)s->deliveries, (unsigned long long)s->dropped,
+               (unsigned long long)s->bytes_in, (unsigned long long)s->bytes_out,
+               (unsigned long long)s->bad_lines);
+        return;
+    }
+
+    broker_stats_t *l = &g_broker.last_report;
+    printf("[本地服务器] 在线%d，发布%llu/s，推送(扇出)%llu/s，出%llu KB/s，丢弃%llu\n",
+           g_broker.active,
+           (unsigned long long)((s->publishes - l->publishes) * 1000 / interval_ms),
+           (unsigned long long)((s->deliveries - l->deliveries) * 1000 / interval_ms),
+           (unsigned long long)((s->bytes_out - l->bytes_out) * 1000 / interval_ms / 1024),
+           (unsigned long long)(s->dropped - l->dropped));
+    *l = *s;
+}
+
+static int broker_listen(const char *bind_addr, uint16_t port) {
+    g_broker.listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (g_broker.listen_fd < 0) {
+        printf("[本地服务器] 创建socket失败: %s\n", strerror(errno));
+        return -1;
+    }
+
+    int one = 1;
+    setsockopt(g_broker.listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, bind_addr, &addr.sin_addr) != 1) {
+        printf("[本地服务器] 无效的监听地址: %s\n", bind_addr);
+        return -1;
+    }
+    if (bind(g_broker.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(g_broker.listen_fd, 128) != 0) {
+        printf("[本地服务器] 监听%s:%u失败: %s\n", bind_addr, port, strerror(errno));
+        return -1;
+    }
+
+    g_broker.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (g_broker.epoll_fd < 0) {
+        printf("[本地服务器] 创建epoll失败: %s\n", strerror(errno));
+        return -1;
+    }
+    struct epoll_event ev = {0};
+    ev.events = EPOLLIN;
+    ev.data.u32 = BROKER_LISTEN_TAG;
+    return epoll_ctl(g_broker.epoll_fd, EPOLL_CTL_ADD, g_broker.listen_fd, &ev);
+}
+
+static void usage(const char *prog) {
+    printf("用法: %s [-b 监听地址] [-p 端口] [-i 统计间隔秒(0=关闭)]\n", prog);
+    printf("默认: -b 127.0.0.1 -p %d -i 5\n", BROKER_DEFAULT_PORT);
+}
+
+int main(int argc, char **argv) {
+    const char *bind_addr = "127.0.0.1";
+    uint16_t port = BROKER_DEFAULT_PORT;
+    int report_interval_s = 5;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "b:p:i:h")) != -1) {
+        switch (opt) {
+        case 'b': bind_addr = optarg; break;
+        case 'p': port = (uint16_t)atoi(optarg); break;
+        case 'i': report_interval_s = atoi(optarg); break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+    signal(SIGPIPE, SIG_IGN);
+
+    for (int i = 0; i < BROKER_MAX_CLIENTS; i++) {
+        g_broker.clients[i].fd = -1;
+    }
+    if (broker_listen(bind_addr, port) != 0) {
+        return 1;
+    }
+    printf("[本地服务器] 监听 %s:%u（巴法云TCP协议兼容）\n", bind_addr, port);
+
+    struct epoll_event events[64];
+    uint64_t last_report_ms = monotonic_ms();
+    while (!g_broker.stop) {
+        int timeout_ms = -1;
+        if (report_interval_s > 0) {
+            uint64_t next = last_report_ms + (uint64_t)report_interval_s * 1000;
+            uint64_t now = monotonic_ms();
+            timeout_ms = next > now ? (int)(next - now) : 0;
+        }
+
+        int n = epoll_wait(g_broker.epoll_fd, events, 64, timeout_ms);
+        if (n < 0 && errno != EINTR) {
+            printf("[本地服务器] epoll_wait失败: %s\n", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.u32 == BROKER_LISTEN_TAG) {
+                accept_clients();
+                continue;
+            }
+
+            broker_client_t *c = &g_broker.clients[events[i].data.u32];
+            if (!c->in_use) {
+                continue;
+            }
+            if ((events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) && client_read(c) != 0) {
+                client_close(c);
+                continue;
+            }
+            if ((events[i].events & EPOLLOUT) && client_flush(c) != 0) {
+                client_close(c);
+            }
+        }
+
+        // 本轮产生的回复和推送统一尝试发送（未发完的注册EPOLLOUT）
+        for (int i = 0; i < BROKER_MAX_CLIENTS; i++) {
+            broker_client_t *c = &g_broker.clients[i];
+            if (c->in_use && c->tx_len > c->tx_off && !c->want_write && client_flush(c) != 0) {
+                client_close(c);
+            }
+        }
+
+        if (report_interval_s > 0) {
+            uint64_t now = monotonic_ms();
+            if (now - last_report_ms >= (uint64_t)report_interval_s * 1000) {
+                report_stats(now - last_report_ms);
+                last_report_ms = now;
+            }
+        }
+    }
+
+    report_stats(0);
+    for (int i = 0; i < BROKER_MAX_CLIENTS; i++) {
+        client_close(&g_broker.clients[i]);
+    }
+    close(g_broker.epoll_fd);
+    close(g_broker.listen_fd);
+    return 0;
+}
@@ -0,0 +1,325 @@
+/**
+ * @file bemfa_rx_fuzz.c
+ * @brief bemfa_tcp_client 接收重组测试（任意分段 + 吞吐）
+ *
+ * 在本地回环上建立一个TCP连接，客户端一侧是真实的 bemfa_tcp_client（bemfa_tcp_connect/
+ * bemfa_tcp_loop），服务器一侧把预先生成的行流按随机字节边界切开逐段写入：
+ *   - 推送消息 cmd=2&uid=..&topic=..&msg=..（msg为随机长度的base64url文本，\r\n或\n结尾）
+ *   - 发布确认 cmd=2&res=1（不回调）
+ *   - 每隔一段插入一条超过接收缓冲区的超长行（应被丢弃，后续行不受影响）
+ * 每写一段就调用 bemfa_tcp_loop 直到socket中没有数据，使每次recv尽量只拿到这一段。
+ * 1~8字节分段只写入前1/20的消息（每段一次系统调用，全量太慢）。
+ * 检查：
+ *   - 回调次数、顺序、topic和msg内容与直接生成的期望完全一致
+ *   - 写入流的过程中没有malloc/calloc/realloc（链接时用 --wrap 计数）
+ * 输出每种分段方式的消息吞吐。
+ */
+
+#include "collaborative_draw/bemfa_tcp_client.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define FUZZ_TOPIC          "fuzz"
+#define FUZZ_MSG_MAX        342                    // DRAW_WIRE_TEXT_LEN(256)
+#define FUZZ_OVERSIZE_LEN   (BEMFA_TCP_RX_BUFFER_SIZE + 800)
+#define FUZZ_OVERSIZE_EVERY 5000                   // 每隔N条消息插入一条超长行
+#define FUZZ_TINY_DIVISOR   20                     // 1~8字节分段很慢，只写入前1/20的消息
+
+// 期望的一条回调（msg在流中的偏移）
+typedef struct {
+    size_t msg_off;
+    size_t msg_len;
+    size_t line_end;                               // 这一行（及其后的确认行、超长行）结束的偏移
+} fuzz_expect_t;
+
+static struct {
+    char *stream;
+    size_t stream_len;
+    fuzz_expect_t *expect;
+    size_t expect_count;
+    size_t case_count;                             // 本轮写入的消息数（前缀）
+    size_t next;                                   // 下一条期望的回调
+    size_t mismatches;
+} g_fuzz;
+
+/* ---------------- 分配计数（-Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc） ---------------- */
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t size);
+void *__wrap_malloc(size_t size);
+void *__wrap_calloc(size_t n, size_t size);
+void *__wrap_realloc(void *p, size_t size);
+
+static volatile unsigned long alloc_count = 0;
+
+void *__wrap_malloc(size_t size) {
+    alloc_count++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    alloc_count++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *p, size_t size) {
+    alloc_count++;
+    return __real_realloc(p, size);
+}
+
+/* ---------------- 生成行流 ---------------- */
+
+static uint32_t rng_state = 1;
+
+static uint32_t rng_next(void) {
+    // xorshift32
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng_state = x;
+    return x;
+}
+
+static void stream_append(size_t *cap, const char *data, size_t len) {
+    if (g_fuzz.stream_len + len > *cap) {
+        size_t new_cap = *cap ? *cap * 2 : 1 << 20;
+        while (new_cap < g_fuzz.stream_len + len) {
+            new_cap *= 2;
+        }
+        g_fuzz.stream = (char *)realloc(g_fuzz.stream, new_cap);
+        if (!g_fuzz.stream) {
+            printf("[接收测试] 内存不足\n");
+            exit(1);
+        }
+        *cap = new_cap;
+    }
+    memcpy(g_fuzz.stream + g_fuzz.stream_len, data, len);
+    g_fuzz.stream_len += len;
+}
+
+static void build_stream(size_t messages, uint32_t seed) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    static char oversize[FUZZ_OVERSIZE_LEN];
+    size_t cap = 0;
+    rng_state = seed ? seed : 1;
+    g_fuzz.expect = (fuzz_expect_t *)malloc(messages * sizeof(fuzz_expect_t));
+    if (!g_fuzz.expect) {
+        printf("[接收测试] 内存不足\n");
+        exit(1);
+    }
+
+    for (size_t i = 0; i < messages; i++) {
+        char msg[FUZZ_MSG_MAX];
+        size_t msg_len = 1 + rng_next() % FUZZ_MSG_MAX;
+        for (size_t k = 0; k < msg_len; k++) {
+            msg[k] = alphabet[rng_next() % 64];
+        }
+        char head[64];
+        int head_len = snprintf(head, sizeof(head), "cmd=2&uid=u%u&topic=%s&msg=",
+                                (unsigned)(rng_next() % 1000), FUZZ_TOPIC);
+        stream_append(&cap, head, (size_t)head_len);
+        g_fuzz.expect[i].msg_off = g_fuzz.stream_len;
+        g_fuzz.expect[i].msg_len = msg_len;
+        stream_append(&cap, msg, msg_len);
+        if (rng_next() % 8 == 0) {
+            stream_append(&cap, "\n", 1);       // 少数行只有\n
+        } else {
+            stream_append(&cap, "\r\n", 2);
+        }
+
+        if (rng_next() % 4 == 0) {
+            stream_append(&cap, "cmd=2&res=1\r\n", 13);
+        }
+        if (i % FUZZ_OVERSIZE_EVERY == FUZZ_OVERSIZE_EVERY - 1) {
+            memset(oversize, 'A', sizeof(oversize));
+            memcpy(oversize, "cmd=2&uid=big&topic=" FUZZ_TOPIC "&msg=", 29);
+            stream_append(&cap, oversize, sizeof(oversize));
+            stream_append(&cap, "\r\n", 2);
+        }
+        g_fuzz.expect[i].line_end = g_fuzz.stream_len;
+    }
+    g_fuzz.expect_count = messages;
+}
+
+/* ---------------- 回调 ---------------- */
+
+static void on_message(const char *topic, const char *msg, size_t msg_len, void *user_data) {
+    (void)user_data;
+    if (g_fuzz.next >= g_fuzz.case_count) {
+        g_fuzz.mismatches++;
+        return;
+    }
+    const fuzz_expect_t *e = &g_fuzz.expect[g_fuzz.next++];
+    if (strcmp(topic, FUZZ_TOPIC) != 0 || msg_len != e->msg_len ||
+        memcmp(msg, g_fuzz.stream + e->msg_off, msg_len) != 0 || msg[msg_len] != '\0') {
+        if (g_fuzz.mismatches++ < 5) {
+            printf("[接收测试] 第%zu条消息不一致（长度%zu，期望%zu）\n", g_fuzz.next, msg_len, e->msg_len);
+        }
+    }
+}
+
+/* ---------------- 驱动 ---------------- */
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// 处理客户端socket中的所有数据
+static int drain(bemfa_tcp_handle_t client) {
+    int fd = bemfa_tcp_get_fd(client);
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    if (poll(&pfd, 1, 1000) <= 0) {
+        return -1;
+    }
+    int pending = 0;
+    do {
+        if (bemfa_tcp_loop(client) != 0) {
+            return -1;
+        }
+        if (ioctl(fd, FIONREAD, &pending) != 0) {
+            return -1;
+        }
+    } while (pending > 0);
+    return 0;
+}
+
+/**
+ * @brief 按分段方式写入行流的前messages条消息并检查回调
+ * @param min_frag / max_frag 每段长度范围（字节）
+ * @return 0通过，-1失败
+ */
+static int run_case(const char *name, size_t messages, size_t min_frag, size_t max_frag, uint32_t seed) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (listen_fd < 0 || bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(listen_fd, 1) != 0 || getsockname(listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+        printf("[接收测试] 创建监听socket失败: %s\n", strerror(errno));
+        return -1;
+    }
+
+    bemfa_tcp_config_t config;
+    memset(&config, 0, sizeof(config));
+    snprintf(config.server_host, sizeof(config.server_host), "127.0.0.1");
+    config.server_port = ntohs(addr.sin_port);
+    snprintf(config.topic, sizeof(config.topic), FUZZ_TOPIC);
+    bemfa_tcp_handle_t client = bemfa_tcp_init(&config);
+    if (!client || bemfa_tcp_connect(client) != 0) {
+        printf("[接收测试] 连接失败\n");
+        return -1;
+    }
+    bemfa_tcp_set_message_callback(client, on_message, NULL);
+    int server_fd = accept(listen_fd, NULL, NULL);
+    int one = 1;
+    setsockopt(server_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    close(listen_fd);
+
+    size_t stream_len = g_fuzz.expect[messages - 1].line_end;
+    g_fuzz.case_count = messages;
+    g_fuzz.next = 0;
+    g_fuzz.mismatches = 0;
+    rng_state = seed;
+    unsigned long allocs_before = alloc_count;
+    uint64_t t0 = monotonic_ns();
+    size_t pos = 0;
+    size_t writes = 0;
+    int ret = 0;
+    while (pos < stream_len) {
+        size_t frag = min_frag + (max_frag > min_frag ? rng_next() % (max_frag - min_frag + 1) : 0);
+        if (frag > stream_len - pos) {
+            frag = stream_len - pos;
+        }
+        if (write_all(server_fd, g_fuzz.stream + pos, frag) != 0 || drain(client) != 0) {
+            printf("[接收测试] 写入或接收失败（偏移%zu）\n", pos);
+            ret = -1;
+            break;
+        }
+        pos += frag;
+        writes++;
+    }
+    double elapsed = (double)(monotonic_ns() - t0) / 1e9;
+    unsigned long allocs = alloc_count - allocs_before;
+
+    bool ok = ret == 0 && g_fuzz.next == messages && g_fuzz.mismatches == 0 && allocs == 0;
+    printf("%-14s 写入%8zu次  回调%8zu/%zu  不一致%zu  分配%lu  %9.0f 消息/s  %s\n",
+           name, writes, g_fuzz.next, messages, g_fuzz.mismatches, allocs,
+           (double)g_fuzz.next / elapsed, ok ? "通过" : "失败");
+
+    close(server_fd);
+    bemfa_tcp_cleanup(client);
+    return ok ? 0 : -1;
+}
+
+static void usage(const char *prog) {
+    printf("用法: %s [-n 消息数] [-s 随机种子]\n", prog);
+    printf("默认: -n 200000 -s 1\n");
+}
+
+int main(int argc, char **argv) {
+    size_t messages = 200000;
+    uint32_t seed = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1) {
+        switch (opt) {
+        case 'n': messages = (size_t)atol(optarg); break;
+        case 's': seed = (uint32_t)atoi(optarg); break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (messages == 0) {
+        printf("[接收测试] 参数无效（消息数须大于0）\n");
+        return 1;
+    }
+
+    build_stream(messages, seed);
+    printf("========== bemfa接收重组测试 ==========\n");
+    printf("行流: %zu条消息，%zu字节（含%zu条超长行）\n", messages, g_fuzz.stream_len,
+           messages / FUZZ_OVERSIZE_EVERY);
+
+    int failed = 0;
+    size_t tiny = messages / FUZZ_TINY_DIVISOR ? messages / FUZZ_TINY_DIVISOR : 1;
+    failed += run_case("随机1~300字节", messages, 1, 300, seed) != 0;
+    failed += run_case("随机1~8字节", tiny, 1, 8, seed + 1) != 0;
+    failed += run_case("随机1~16KB", messages, 1, 16384, seed + 2) != 0;
+    failed += run_case("整块64KB", messages, 65536, 65536, seed + 3) != 0;
+    printf("==========================================\n");
+
+    free(g_fuzz.stream);
+    free(g_fuzz.expect);
+    return failed ? 1 : 0;
+}
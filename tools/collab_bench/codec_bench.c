@@ -0,0 +1,350 @@
+/**
+ * @file codec_bench.c
+ * @brief 绘图协议编解码吞吐测试
+ *
+ * 把笔画序列按 collaborative_draw 的批量规则编码成帧并转为base64url文本，
+ * 再还原并逐条解码，统计：
+ *   - 每点字节数（二进制帧、线上文本），与旧格式（结构体memcpy后十六进制，56字节/点）对比
+ *   - 编码吞吐（帧编码 + base64url）、解码吞吐（base64url还原 + 帧解码），单位为点/s
+ * 解码结果与原始笔画逐点比较，不一致时报错退出。
+ *
+ * 笔画文件格式与 collab_loadgen 相同（COLLAB_STROKE_RECORD 录制）：
+ * 每行 "x y"，空行分隔笔画，'#'开头为注释。未指定文件时生成随机笔画。
+ */
+
+#include "collaborative_draw/draw_protocol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#define CODEC_BENCH_FRAME_MAX   256
+#define CODEC_BENCH_BATCH_BYTES 200                // 与collaborative_draw默认值一致
+#define CODEC_BENCH_LEGACY_TEXT 56                 // 旧格式：28字节结构体的十六进制文本
+#define CODEC_BENCH_USER_ID     1000
+
+// 笔画中的一个点（stroke_start表示新笔画起点）
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    bool stroke_start;
+} bench_point_t;
+
+// 编码结果：所有帧的文本依次存放，offsets[i]为第i帧的起点
+typedef struct {
+    char *text;
+    size_t text_len;
+    size_t text_cap;
+    size_t *offsets;
+    size_t frames;
+    size_t frames_cap;
+    size_t bin_bytes;
+} bench_wire_t;
+
+static bench_point_t *points = NULL;
+static size_t point_count = 0;
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static bool points_push(size_t *cap, uint16_t x, uint16_t y, bool stroke_start) {
+    if (point_count == *cap) {
+        size_t new_cap = *cap ? *cap * 2 : 1024;
+        bench_point_t *p = (bench_point_t *)realloc(points, new_cap * sizeof(*p));
+        if (!p) {
+            return false;
+        }
+        points = p;
+        *cap = new_cap;
+    }
+    points[point_count].x = x;
+    points[point_count].y = y;
+    points[point_count].stroke_start = stroke_start;
+    point_count++;
+    return true;
+}
+
+// 读取录制的笔画文件
+static int load_strokes(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        printf("[编解码测试] 打开笔画文件失败: %s (%s)\n", path, strerror(errno));
+        return -1;
+    }
+
+    size_t cap = 0;
+    bool stroke_start = true;
+    char line[128];
+    while (fgets(line, sizeof(line), fp)) {
+        unsigned x, y;
+        if (line[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, "%u %u", &x, &y) != 2) {
+            stroke_start = true;
+            continue;
+        }
+        if (!points_push(&cap, (uint16_t)x, (uint16_t)y, stroke_start)) {
+            fclose(fp);
+            return -1;
+        }
+        stroke_start = false;
+    }
+    fclose(fp);
+
+    if (point_count == 0) {
+        printf("[编解码测试] 笔画文件为空: %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// 生成随机笔画（绘图区域720x340，y从60开始，与触摸绘图一致）
+static int generate_strokes(unsigned seed, int strokes) {
+    size_t cap = 0;
+    srand(seed);
+    for (int s = 0; s < strokes; s++) {
+        int x = rand() % 720;
+        int y = 60 + rand() % 340;
+        int len = 20 + rand() % 100;
+        for (int i = 0; i < len; i++) {
+            if (!points_push(&cap, (uint16_t)x, (uint16_t)y, i == 0)) {
+                return -1;
+            }
+            x += rand() % 9 - 4;
+            y += rand() % 9 - 4;
+            x = x < 0 ? 0 : (x > 719 ? 719 : x);
+            y = y < 60 ? 60 : (y > 399 ? 399 : y);
+        }
+    }
+    return 0;
+}
+
+static int wire_push(bench_wire_t *w, const uint8_t *frame, int frame_len) {
+    size_t need = DRAW_WIRE_TEXT_LEN((size_t)frame_len) + 1;
+    if (w->text_len + need > w->text_cap) {
+        size_t cap = w->text_cap ? w->text_cap * 2 : 65536;
+        while (cap < w->text_len + need) {
+            cap *= 2;
+        }
+        char *p = (char *)realloc(w->text, cap);
+        if (!p) {
+            return -1;
+        }
+        w->text = p;
+        w->text_cap = cap;
+    }
+    if (w->frames + 1 >= w->frames_cap) {
+        size_t cap = w->frames_cap ? w->frames_cap * 2 : 1024;
+        size_t *p = (size_t *)realloc(w->offsets, cap * sizeof(size_t));
+        if (!p) {
+            return -1;
+        }
+        w->offsets = p;
+        w->frames_cap = cap;
+    }
+    int n = draw_wire_to_text(frame, (size_t)frame_len, w->text + w->text_len, w->text_cap - w->text_len);
+    if (n < 0) {
+        return -1;
+    }
+    w->offsets[w->frames++] = w->text_len;
+    w->text_len += (size_t)n;
+    w->offsets[w->frames] = w->text_len;
+    w->bin_bytes += (size_t)frame_len;
+    return 0;
+}
+
+/**
+ * @brief 编码整个笔画序列（批量规则与collaborative_draw_send_operation一致）
+ * @param w 输出（NULL时只编码不保存，用于计时）
+ * @return 0成功，-1失败
+ */
+static int encode_stream(bench_wire_t *w, int batch_points) {
+    draw_codec_state_t codec;
+    uint8_t frame[CODEC_BENCH_FRAME_MAX];
+    char text[DRAW_WIRE_TEXT_LEN(CODEC_BENCH_FRAME_MAX) + 1];
+    int frame_len = 0;
+    int frame_points = 0;
+    draw_codec_reset(&codec);
+
+    for (size_t i = 1; i <= point_count; i++) {
+        bool flush = i == point_count;
+        if (!flush) {
+            const bench_point_t *pt = &points[i];
+            if (pt->stroke_start) {
+                continue;   // 笔画起点只作为下一段的prev
+            }
+            const bench_point_t *prev = &points[i - 1];
+            draw_operation_t op = {0};
+            op.user_id = CODEC_BENCH_USER_ID;
+            op.msg_type = MSG_TYPE_DRAW_LINE;
+            op.x = pt->x;
+            op.y = pt->y;
+            op.prev_x = prev->x;
+            op.prev_y = prev->y;
+            op.pen_size = 2;
+            op.color = 0xFF000000;
+
+            bool appended = false;
+            for (int attempt = 0; attempt < 2 && !appended; attempt++) {
+                if (frame_len > 0 && (attempt > 0 || op.prev_x != codec.last_x || op.prev_y != codec.last_y)) {
+                    if (w ? wire_push(w, frame, frame_len) != 0
+                          : draw_wire_to_text(frame, (size_t)frame_len, text, sizeof(text)) < 0) {
+                        return -1;
+                    }
+                    frame_len = 0;
+                    frame_points = 0;
+                }
+                if (frame_len == 0) {
+                    frame_len = draw_frame_begin(frame, sizeof(frame), CODEC_BENCH_USER_ID, 1);
+                }
+                int rec = draw_frame_append(&codec, &op, frame + frame_len,
+                                            (size_t)(CODEC_BENCH_BATCH_BYTES - frame_len));
+                if (rec > 0) {
+                    frame_len += rec;
+                    frame_points++;
+                    appended = true;
+                }
+            }
+            if (!appended) {
+                return -1;
+            }
+            flush = frame_points >= batch_points || frame_len + DRAW_RECORD_MAX > CODEC_BENCH_BATCH_BYTES;
+        }
+        if (flush && frame_len > 0) {
+            if (w ? wire_push(w, frame, frame_len) != 0
+                  : draw_wire_to_text(frame, (size_t)frame_len, text, sizeof(text)) < 0) {
+                return -1;
+            }
+            frame_len = 0;
+            frame_points = 0;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 解码所有帧，verify为true时与原始笔画逐点比较
+ * @return 解码的点数，出错返回-1
+ */
+static long decode_stream(const bench_wire_t *w, bool verify) {
+    draw_codec_state_t codec;
+    uint8_t frame[CODEC_BENCH_FRAME_MAX];
+    draw_codec_reset(&codec);
+    long decoded = 0;
+    size_t next = 1;
+
+    for (size_t f = 0; f < w->frames; f++) {
+        int len = draw_wire_from_text(w->text + w->offsets[f], w->offsets[f + 1] - w->offsets[f],
+                                      frame, sizeof(frame));
+        draw_frame_reader_t reader;
+        if (len <= 0 || draw_frame_reader_init(&reader, frame, (size_t)len) != 0) {
+            return -1;
+        }
+        reader.state = &codec;
+        draw_operation_t op;
+        int ret;
+        while ((ret = draw_frame_reader_next(&reader, &op)) == 1) {
+            decoded++;
+            if (verify) {
+                while (next < point_count && points[next].stroke_start) {
+                    next++;
+                }
+                if (next >= point_count || op.x != points[next].x || op.y != points[next].y ||
+                    op.prev_x != points[next - 1].x || op.prev_y != points[next - 1].y) {
+                    printf("[编解码测试] 第%ld个点解码不一致\n", decoded);
+                    return -1;
+                }
+                next++;
+            }
+        }
+        if (ret < 0 || reader.skipped) {
+            return -1;
+        }
+    }
+    return decoded;
+}
+
+static void usage(const char *prog) {
+    printf("用法: %s [-f 笔画文件] [-s 随机种子] [-b 批量点数] [-n 重复次数]\n", prog);
+    printf("默认: -s 1 -b 32 -n 200\n");
+}
+
+int main(int argc, char **argv) {
+    const char *stroke_file = NULL;
+    unsigned seed = 1;
+    int batch_points = 32;
+    int repeat = 200;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:s:b:n:h")) != -1) {
+        switch (opt) {
+        case 'f': stroke_file = optarg; break;
+        case 's': seed = (unsigned)atoi(optarg); break;
+        case 'b': batch_points = atoi(optarg); break;
+        case 'n': repeat = atoi(optarg); break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (batch_points <= 0 || repeat <= 0) {
+        printf("[编解码测试] 参数无效（批量点数、重复次数须大于0）\n");
+        return 1;
+    }
+    if (stroke_file ? load_strokes(stroke_file) != 0 : generate_strokes(seed, 200) != 0) {
+        return 1;
+    }
+
+    printf("========== 绘图协议编解码测试 ==========\n");
+    printf("笔画点数: %zu（%s）\n", point_count, stroke_file ? stroke_file : "随机生成");
+    printf("%-10s %8s %10s %10s %8s %14s %14s\n",
+           "批量", "帧数", "二进制B/点", "文本B/点", "压缩比", "编码(点/s)", "解码(点/s)");
+
+    int batches[2] = { 1, batch_points };
+    for (int b = 0; b < (batch_points == 1 ? 1 : 2); b++) {
+        bench_wire_t wire;
+        memset(&wire, 0, sizeof(wire));
+        if (encode_stream(&wire, batches[b]) != 0) {
+            printf("[编解码测试] 编码失败\n");
+            return 1;
+        }
+        long segments = decode_stream(&wire, true);
+        if (segments <= 0) {
+            printf("[编解码测试] 解码失败\n");
+            return 1;
+        }
+
+        uint64_t t0 = monotonic_ns();
+        for (int r = 0; r < repeat; r++) {
+            if (encode_stream(NULL, batches[b]) != 0) {
+                return 1;
+            }
+        }
+        uint64_t t1 = monotonic_ns();
+        for (int r = 0; r < repeat; r++) {
+            if (decode_stream(&wire, false) != segments) {
+                return 1;
+            }
+        }
+        uint64_t t2 = monotonic_ns();
+
+        double total = (double)segments * repeat;
+        double text_per_point = (double)wire.text_len / (double)segments;
+        printf("%-8d %8zu %10.2f %10.2f %7.1fx %14.0f %14.0f\n",
+               batches[b], wire.frames, (double)wire.bin_bytes / (double)segments, text_per_point,
+               CODEC_BENCH_LEGACY_TEXT / text_per_point,
+               total / ((double)(t1 - t0) / 1e9), total / ((double)(t2 - t1) / 1e9));
+        free(wire.text);
+        free(wire.offsets);
+    }
+    printf("旧格式: %d 文本字节/点（结构体memcpy + 十六进制）\n", CODEC_BENCH_LEGACY_TEXT);
+    printf("==========================================\n");
+    free(points);
+    return 0;
+}
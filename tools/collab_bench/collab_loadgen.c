@@ -0,0 +1,617 @@
+/**
+ * @file collab_loadgen.c
+ * @brief 协作绘图负载生成器
+ *
+ * 启动N个模拟绘图客户端（每个一个线程），各自通过 bemfa_tcp_client 连接
+ * 服务器（默认本地 bemfa_broker），订阅同一主题，按固定采样率回放笔画，
+ * 用与 collaborative_draw 相同的差分编码和批量规则打包成帧后发布到 主题/set。
+ * 每个客户端解码收到的帧，统计：
+ *   - 点到接收延迟：帧中第一个点产生时刻到对端解码完成（帧头时间戳为单调时钟微秒，
+ *     所有客户端在同一进程内，无需时间同步）
+ *   - 丢失数：sum(每个客户端发布数) * (N-1) - 总接收数
+ *   - 扇出吞吐：所有客户端每秒收到的消息数/点数
+ *
+ * -L 改用局域网UDP组播（lan_transport）直连，不经过服务器；-x 在接收端随机丢包以验证
+ * NACK重传。多进程测试时各进程用 -o 指定客户端编号偏移、-g 指定所有进程的客户端总数，
+ * 此时丢失数以局域网层统计（重试后放弃的包）为准。
+ *
+ * 笔画文件格式（与 COLLAB_STROKE_RECORD 录制的格式相同）：
+ * 每行 "x y"，空行分隔笔画，'#'开头为注释。未指定文件时生成随机笔画。
+ */
+
+#include "collaborative_draw/draw_protocol.h"
+#include "collaborative_draw/bemfa_tcp_client.h"
+#include "collaborative_draw/lan_transport.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+
+#define LOADGEN_MAX_CLIENTS     64
+#define LOADGEN_FRAME_MAX       256
+#define LOADGEN_BATCH_BYTES     200                // 与collaborative_draw默认值一致
+#define LOADGEN_DRAIN_MS        1000               // 停止发送后继续接收的时间
+#define LOADGEN_SUBSCRIBE_WAIT_MS 300              // 全部订阅后等待服务器处理
+#define LOADGEN_USER_ID_BASE    1000
+
+// 笔画中的一个点（stroke_start表示新笔画起点）
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    bool stroke_start;
+} loadgen_point_t;
+
+// 每个模拟客户端
+typedef struct {
+    int index;
+    uint32_t user_id;
+    pthread_t thread;
+    bemfa_tcp_handle_t tcp;
+    lan_transport_handle_t lan;                    // 局域网模式句柄（非NULL时不使用tcp）
+    lan_transport_stats_t lan_stats;               // 关闭前保存的局域网层统计
+    draw_codec_state_t send_codec;
+    draw_codec_state_t peer_codecs[LOADGEN_MAX_CLIENTS];
+    uint8_t frame[LOADGEN_FRAME_MAX];
+    int frame_len;
+    int frame_points;
+    uint64_t frame_first_us;
+    // 发送统计
+    uint64_t msgs_sent;
+    uint64_t points_sent;
+    uint64_t publish_errors;
+    // 接收统计
+    uint64_t msgs_received;
+    uint64_t points_received;
+    uint64_t decode_errors;
+    uint64_t skipped;
+    uint32_t *latency_us;                          // 每条接收消息的延迟样本
+    size_t latency_count;
+    size_t latency_cap;
+} loadgen_client_t;
+
+static struct {
+    char host[256];
+    uint16_t port;
+    char topic[128];
+    int clients;
+    int duration_s;
+    int rate;                                      // 每客户端每秒产生的点数
+    int batch_points;
+    int batch_delay_ms;
+    bool lan;                                      // 局域网组播模式
+    char lan_iface[32];
+    int lan_drop_permille;
+    int index_offset;                              // 多进程：本进程第一个客户端的编号
+    int total_clients;                             // 多进程：所有进程的客户端总数
+    loadgen_point_t *points;
+    size_t point_count;
+    loadgen_client_t client[LOADGEN_MAX_CLIENTS];
+    pthread_barrier_t ready;
+    volatile sig_atomic_t stop;
+} g_loadgen;
+
+static void signal_handler(int sig) {
+    (void)sig;
+    g_loadgen.stop = 1;
+}
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// 帧头时间戳：截断为32位的单调时钟微秒（约71分钟回绕，差值计算不受影响）
+static uint32_t timestamp_us(uint64_t us) {
+    uint32_t ts = (uint32_t)us;
+    return ts ? ts : 1;  // 0表示"无时间戳"
+}
+
+static bool points_push(size_t *cap, uint16_t x, uint16_t y, bool stroke_start) {
+    if (g_loadgen.point_count == *cap) {
+        size_t new_cap = *cap ? *cap * 2 : 1024;
+        loadgen_point_t *p = (loadgen_point_t *)realloc(g_loadgen.points, new_cap * sizeof(*p));
+        if (!p) {
+            return false;
+        }
+        g_loadgen.points = p;
+        *cap = new_cap;
+    }
+    loadgen_point_t *pt = &g_loadgen.points[g_loadgen.point_count++];
+    pt->x = x;
+    pt->y = y;
+    pt->stroke_start = stroke_start;
+    return true;
+}
+
+// 读取录制的笔画文件
+static int load_strokes(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        printf("[负载生成] 打开笔画文件失败: %s (%s)\n", path, strerror(errno));
+        return -1;
+    }
+
+    size_t cap = 0;
+    bool stroke_start = true;
+    char line[128];
+    while (fgets(line, sizeof(line), fp)) {
+        unsigned x, y;
+        if (line[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, "%u %u", &x, &y) != 2) {
+            stroke_start = true;
+            continue;
+        }
+        if (!points_push(&cap, (uint16_t)x, (uint16_t)y, stroke_start)) {
+            fclose(fp);
+            return -1;
+        }
+        stroke_start = false;
+    }
+    fclose(fp);
+
+    if (g_loadgen.point_count == 0) {
+        printf("[负载生成] 笔画文件为空: %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// 生成随机笔画（绘图区域720x340，y从60开始，与触摸绘图一致）
+static int generate_strokes(unsigned seed, int strokes) {
+    size_t cap = 0;
+    srand(seed);
+    for (int s = 0; s < strokes; s++) {
+        int x = rand() % 720;
+        int y = 60 + rand() % 340;
+        int len = 20 + rand() % 100;
+        for (int i = 0; i < len; i++) {
+            if (!points_push(&cap, (uint16_t)x, (uint16_t)y, i == 0)) {
+                return -1;
+            }
+            x += rand() % 9 - 4;
+            y += rand() % 9 - 4;
+            x = x < 0 ? 0 : (x > 719 ? 719 : x);
+            y = y < 60 ? 60 : (y > 399 ? 399 : y);
+        }
+    }
+    return 0;
+}
+
+static void record_latency(loadgen_client_t *c, uint32_t latency) {
+    if (c->latency_count == c->latency_cap) {
+        size_t cap = c->latency_cap ? c->latency_cap * 2 : 4096;
+        uint32_t *p = (uint32_t *)realloc(c->latency_us, cap * sizeof(uint32_t));
+        if (!p) {
+            return;
+        }
+        c->latency_us = p;
+        c->latency_cap = cap;
+    }
+    c->latency_us[c->latency_count++] = latency;
+}
+
+// 解码整帧，记录延迟和点数
+static void handle_frame(loadgen_client_t *c, const uint8_t *frame, int len, uint64_t now) {
+    draw_frame_reader_t reader;
+    if (len <= 0 || draw_frame_reader_init(&reader, frame, len) != 0) {
+        c->decode_errors++;
+        return;
+    }
+
+    uint32_t peer = reader.user_id - LOADGEN_USER_ID_BASE;
+    if (peer >= (uint32_t)g_loadgen.total_clients) {
+        c->decode_errors++;
+        return;
+    }
+    reader.state = &c->peer_codecs[peer];
+
+    draw_operation_t op;
+    int ret;
+    while ((ret = draw_frame_reader_next(&reader, &op)) == 1) {
+        c->points_received++;
+    }
+    if (ret < 0) {
+        c->decode_errors++;
+    }
+    c->skipped += reader.skipped;
+    c->msgs_received++;
+    if (reader.timestamp) {
+        record_latency(c, timestamp_us(now) - reader.timestamp);
+    }
+}
+
+// 巴法云接收回调
+static void on_message(const char *topic, const char *msg, size_t msg_len, void *user_data) {
+    (void)topic;
+    loadgen_client_t *c = (loadgen_client_t *)user_data;
+    uint64_t now = monotonic_us();
+
+    uint8_t frame[LOADGEN_FRAME_MAX];
+    int len = draw_wire_from_text(msg, msg_len, frame, sizeof(frame));
+    handle_frame(c, frame, len, now);
+}
+
+// 局域网接收回调（缺口被放弃后重置该发送者的差分状态）
+static void on_lan_frame(uint32_t sender, const uint8_t *frame, size_t len, bool after_gap, void *user_data) {
+    loadgen_client_t *c = (loadgen_client_t *)user_data;
+    uint32_t peer = sender - LOADGEN_USER_ID_BASE;
+    if (after_gap && peer < (uint32_t)g_loadgen.total_clients) {
+        draw_codec_reset(&c->peer_codecs[peer]);
+    }
+    handle_frame(c, frame, (int)len, monotonic_us());
+}
+
+static void flush_frame(loadgen_client_t *c) {
+    if (c->frame_points == 0) {
+        return;
+    }
+
+    int ret;
+    if (c->lan) {
+        ret = lan_transport_send(c->lan, c->frame, c->frame_len);
+    } else {
+        char text[DRAW_WIRE_TEXT_LEN(LOADGEN_FRAME_MAX) + 1];
+        char topic_set[160];
+        snprintf(topic_set, sizeof(topic_set), "%s/set", g_loadgen.topic);
+        ret = draw_wire_to_text(c->frame, c->frame_len, text, sizeof(text)) > 0 ?
+              bemfa_tcp_publish(c->tcp, topic_set, text) : -1;
+    }
+    if (ret == 0) {
+        c->msgs_sent++;
+        c->points_sent += c->frame_points;
+    } else {
+        c->publish_errors++;
+        draw_codec_reset(&c->send_codec);
+    }
+    c->frame_len = 0;
+    c->frame_points = 0;
+}
+
+// 追加一段线条到批量帧（规则与collaborative_draw_send_operation一致）
+static void append_segment(loadgen_client_t *c, const loadgen_point_t *prev, const loadgen_point_t *pt) {
+    draw_operation_t op = {0};
+    op.user_id = c->user_id;
+    op.msg_type = MSG_TYPE_DRAW_LINE;
+    op.x = pt->x;
+    op.y = pt->y;
+    op.prev_x = prev->x;
+    op.prev_y = prev->y;
+    op.pen_size = 2;
+    op.color = 0xFF000000;
+
+    if (c->frame_len > 0 && (op.prev_x != c->send_codec.last_x || op.prev_y != c->send_codec.last_y)) {
+        flush_frame(c);
+    }
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (c->frame_len == 0) {
+            c->frame_first_us = monotonic_us();
+            c->frame_len = draw_frame_begin(c->frame, sizeof(c->frame), c->user_id,
+                                            timestamp_us(c->frame_first_us));
+        }
+        int rec = draw_frame_append(&c->send_codec, &op, c->frame + c->frame_len,
+                                    LOADGEN_BATCH_BYTES - c->frame_len);
+        if (rec > 0) {
+            c->frame_len += rec;
+            c->frame_points++;
+            break;
+        }
+        flush_frame(c);
+    }
+
+    if (c->frame_points >= g_loadgen.batch_points ||
+        c->frame_len + DRAW_RECORD_MAX > LOADGEN_BATCH_BYTES) {
+        flush_frame(c);
+    }
+}
+
+// 等待socket可读并处理，最多等待timeout_ms（局域网模式同时处理HELLO/NACK定时任务）
+static void poll_receive(loadgen_client_t *c, int timeout_ms) {
+    if (timeout_ms < 0) {
+        timeout_ms = 0;
+    }
+    if (c->lan) {
+        int tick_ms = lan_transport_tick(c->lan);
+        if (tick_ms < timeout_ms) {
+            timeout_ms = tick_ms;
+        }
+    }
+
+    struct pollfd pfd = {c->lan ? lan_transport_get_fd(c->lan) : bemfa_tcp_get_fd(c->tcp), POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) > 0) {
+        if (c->lan) {
+            lan_transport_poll(c->lan);
+        } else {
+            bemfa_tcp_loop(c->tcp);
+        }
+    }
+}
+
+// 加入组播（局域网模式）或连接服务器并订阅
+static bool client_connect(loadgen_client_t *c) {
+    if (g_loadgen.lan) {
+        lan_transport_config_t cfg = {0};
+        snprintf(cfg.iface, sizeof(cfg.iface), "%s", g_loadgen.lan_iface);
+        snprintf(cfg.room, sizeof(cfg.room), "%s", g_loadgen.topic);
+        cfg.user_id = c->user_id;
+        cfg.rx_drop_permille = (uint16_t)g_loadgen.lan_drop_permille;
+        c->lan = lan_transport_open(&cfg);
+        if (c->lan) {
+            lan_transport_set_frame_callback(c->lan, on_lan_frame, c);
+        }
+        return c->lan != NULL;
+    }
+
+    bemfa_tcp_config_t cfg = {0};
+    snprintf(cfg.server_host, sizeof(cfg.server_host), "%s", g_loadgen.host);
+    cfg.server_port = g_loadgen.port;
+    snprintf(cfg.uid, sizeof(cfg.uid), "loadgen%d", c->index);
+    snprintf(cfg.topic, sizeof(cfg.topic), "%s", g_loadgen.topic);
+
+    c->tcp = bemfa_tcp_init(&cfg);
+    if (!c->tcp) {
+        return false;
+    }
+    bemfa_tcp_set_message_callback(c->tcp, on_message, c);
+    return bemfa_tcp_connect(c->tcp) == 0 && bemfa_tcp_subscribe(c->tcp, g_loadgen.topic) == 0;
+}
+
+static void *client_thread(void *arg) {
+    loadgen_client_t *c = (loadgen_client_t *)arg;
+    bool connected = client_connect(c);
+    if (!connected) {
+        printf("[负载生成] 客户端%d连接失败\n", c->index);
+    }
+
+    // 所有客户端订阅后再开始发送，避免早期消息没有接收者
+    pthread_barrier_wait(&g_loadgen.ready);
+    uint64_t wait_end = monotonic_us() + LOADGEN_SUBSCRIBE_WAIT_MS * 1000ULL;
+    while (connected && monotonic_us() < wait_end) {
+        poll_receive(c, (int)((wait_end - monotonic_us()) / 1000));
+    }
+
+    // 各客户端从不同位置开始回放，交错分布
+    size_t pos = (g_loadgen.point_count / (size_t)g_loadgen.total_clients) * (c->user_id - LOADGEN_USER_ID_BASE);
+    uint64_t interval_us = 1000000ULL / g_loadgen.rate;
+    uint64_t start = monotonic_us();
+    uint64_t end = start + (uint64_t)g_loadgen.duration_s * 1000000;
+    uint64_t next_point = start + interval_us * c->index / g_loadgen.clients;
+    loadgen_point_t prev = g_loadgen.points[pos];
+
+    while (connected && !g_loadgen.stop) {
+        uint64_t now = monotonic_us();
+        if (now >= end) {
+            break;
+        }
+
+        if (now >= next_point) {
+            const loadgen_point_t *pt = &g_loadgen.points[pos];
+            if (pt->stroke_start) {
+                prev = *pt;
+            }
+            append_segment(c, &prev, pt);
+            prev = *pt;
+            pos = (pos + 1) % g_loadgen.point_count;
+            next_point += interval_us;
+            continue;
+        }
+
+        uint64_t wake = next_point;
+        if (c->frame_points > 0) {
+            uint64_t deadline = c->frame_first_us + g_loadgen.batch_delay_ms * 1000ULL;
+            if (now >= deadline) {
+                flush_frame(c);
+                continue;
+            }
+            if (deadline < wake) {
+                wake = deadline;
+            }
+        }
+        poll_receive(c, (int)((wake - now + 999) / 1000));
+    }
+
+    if (connected) {
+        flush_frame(c);
+        uint64_t drain_end = monotonic_us() + LOADGEN_DRAIN_MS * 1000ULL;
+        while (monotonic_us() < drain_end) {
+            poll_receive(c, (int)((drain_end - monotonic_us()) / 1000) + 1);
+        }
+        if (c->tcp) {
+            bemfa_tcp_disconnect(c->tcp);
+        }
+    }
+    if (c->lan) {
+        lan_transport_get_stats(c->lan, &c->lan_stats);
+        lan_transport_close(c->lan);
+        c->lan = NULL;
+    }
+    if (c->tcp) {
+        bemfa_tcp_cleanup(c->tcp);
+        c->tcp = NULL;
+    }
+    return NULL;
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static uint32_t percentile(const uint32_t *sorted, size_t n, double p) {
+    if (n == 0) {
+        return 0;
+    }
+    size_t idx = (size_t)(p * (double)(n - 1) + 0.5);
+    return sorted[idx];
+}
+
+static void report(double elapsed_s) {
+    uint64_t sent = 0, points_sent = 0, publish_errors = 0;
+    uint64_t received = 0, points_received = 0, decode_errors = 0, skipped = 0;
+    uint64_t expected = 0;
+    size_t samples = 0;
+    lan_transport_stats_t lan = {0};
+
+    for (int i = 0; i < g_loadgen.clients; i++) {
+        loadgen_client_t *c = &g_loadgen.client[i];
+        sent += c->msgs_sent;
+        points_sent += c->points_sent;
+        publish_errors += c->publish_errors;
+        received += c->msgs_received;
+        points_received += c->points_received;
+        decode_errors += c->decode_errors;
+        skipped += c->skipped;
+        samples += c->latency_count;
+        expected += c->msgs_sent * (uint64_t)(g_loadgen.clients - 1);
+        lan.nacks_sent += c->lan_stats.nacks_sent;
+        lan.retransmits += c->lan_stats.retransmits;
+        lan.duplicates += c->lan_stats.duplicates;
+        lan.reordered += c->lan_stats.reordered;
+        lan.lost += c->lan_stats.lost;
+    }
+
+    uint32_t *all = (uint32_t *)malloc((samples ? samples : 1) * sizeof(uint32_t));
+    size_t n = 0;
+    for (int i = 0; all && i < g_loadgen.clients; i++) {
+        memcpy(all + n, g_loadgen.client[i].latency_us, g_loadgen.client[i].latency_count * sizeof(uint32_t));
+        n += g_loadgen.client[i].latency_count;
+    }
+    if (all) {
+        qsort(all, n, sizeof(uint32_t), compare_u32);
+    }
+
+    uint64_t lost = expected > received ? expected - received : 0;
+    printf("\n========== 协作绘图负载测试结果 ==========\n");
+    printf("客户端: %d，时长: %.1fs，每客户端 %d 点/s，批量 %d点/%dms，传输: %s\n",
+           g_loadgen.clients, elapsed_s, g_loadgen.rate, g_loadgen.batch_points, g_loadgen.batch_delay_ms,
+           g_loadgen.lan ? "局域网组播" : "TCP服务器");
+    printf("发送: %llu 条消息，%llu 个点（%.0f 消息/s），发布失败 %llu\n",
+           (unsigned long long)sent, (unsigned long long)points_sent, sent / elapsed_s,
+           (unsigned long long)publish_errors);
+    printf("接收: %llu / 应收 %llu 条，丢失 %llu（%.3f%%），解码错误 %llu，缺关键帧跳过 %llu\n",
+           (unsigned long long)received, (unsigned long long)expected, (unsigned long long)lost,
+           expected ? lost * 100.0 / expected : 0.0,
+           (unsigned long long)decode_errors, (unsigned long long)skipped);
+    if (g_loadgen.total_clients != g_loadgen.clients) {
+        printf("多进程模式（本进程%d/%d个客户端）：应收数不含其他进程，以局域网层丢失为准\n",
+               g_loadgen.clients, g_loadgen.total_clients);
+    }
+    if (g_loadgen.lan) {
+        printf("局域网层: NACK %u，重传 %u，乱序暂存 %u，重复 %u，重试后丢失 %u（接收端随机丢包 %d‰）\n",
+               lan.nacks_sent, lan.retransmits, lan.reordered, lan.duplicates, lan.lost,
+               g_loadgen.lan_drop_permille);
+    }
+    printf("扇出吞吐: %.0f 消息/s，%.0f 点/s\n", received / elapsed_s, points_received / elapsed_s);
+    if (all && n > 0) {
+        printf("点到接收延迟(us): p50=%u p90=%u p99=%u p99.9=%u max=%u（%zu个样本）\n",
+               percentile(all, n, 0.50), percentile(all, n, 0.90), percentile(all, n, 0.99),
+               percentile(all, n, 0.999), all[n - 1], n);
+    }
+    printf("==========================================\n");
+    free(all);
+}
+
+static void usage(const char *prog) {
+    printf("用法: %s [-H 服务器] [-p 端口] [-n 客户端数] [-d 秒] [-r 点/秒]\n"
+           "          [-b 批量点数] [-w 批量等待ms] [-t 主题] [-f 笔画文件] [-s 随机种子]\n"
+           "          [-L] [-I 网卡地址] [-x 丢包千分比] [-o 编号偏移] [-g 总客户端数]\n", prog);
+    printf("默认: -H 127.0.0.1 -p 8344 -n 8 -d 10 -r 120 -b 32 -w 8 -t loadgen\n");
+    printf("局域网模式(-L)默认: -I 127.0.0.1 -x 0\n");
+}
+
+int main(int argc, char **argv) {
+    strcpy(g_loadgen.host, "127.0.0.1");
+    strcpy(g_loadgen.topic, "loadgen");
+    g_loadgen.port = 8344;
+    g_loadgen.clients = 8;
+    g_loadgen.duration_s = 10;
+    g_loadgen.rate = 120;
+    g_loadgen.batch_points = 32;
+    g_loadgen.batch_delay_ms = 8;
+    strcpy(g_loadgen.lan_iface, "127.0.0.1");
+    g_loadgen.total_clients = 0;
+    const char *stroke_file = NULL;
+    unsigned seed = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "H:p:n:d:r:b:w:t:f:s:LI:x:o:g:h")) != -1) {
+        switch (opt) {
+        case 'H': strncpy(g_loadgen.host, optarg, sizeof(g_loadgen.host) - 1); break;
+        case 'p': g_loadgen.port = (uint16_t)atoi(optarg); break;
+        case 'n': g_loadgen.clients = atoi(optarg); break;
+        case 'd': g_loadgen.duration_s = atoi(optarg); break;
+        case 'r': g_loadgen.rate = atoi(optarg); break;
+        case 'b': g_loadgen.batch_points = atoi(optarg); break;
+        case 'w': g_loadgen.batch_delay_ms = atoi(optarg); break;
+        case 't': strncpy(g_loadgen.topic, optarg, sizeof(g_loadgen.topic) - 1); break;
+        case 'f': stroke_file = optarg; break;
+        case 's': seed = (unsigned)atoi(optarg); break;
+        case 'L': g_loadgen.lan = true; break;
+        case 'I': snprintf(g_loadgen.lan_iface, sizeof(g_loadgen.lan_iface), "%s", optarg); break;
+        case 'x': g_loadgen.lan_drop_permille = atoi(optarg); break;
+        case 'o': g_loadgen.index_offset = atoi(optarg); break;
+        case 'g': g_loadgen.total_clients = atoi(optarg); break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (g_loadgen.total_clients == 0) {
+        g_loadgen.total_clients = g_loadgen.clients;
+    }
+    if (g_loadgen.clients < 1 || g_loadgen.total_clients < 2 || g_loadgen.total_clients > LOADGEN_MAX_CLIENTS ||
+        g_loadgen.index_offset < 0 || g_loadgen.index_offset + g_loadgen.clients > g_loadgen.total_clients ||
+        g_loadgen.rate <= 0 || g_loadgen.duration_s <= 0 || g_loadgen.batch_points <= 0 ||
+        g_loadgen.lan_drop_permille < 0 || g_loadgen.lan_drop_permille > 1000) {
+        printf("[负载生成] 参数无效（总客户端数2~%d，编号偏移+客户端数不超过总数，速率/时长/批量须大于0）\n",
+               LOADGEN_MAX_CLIENTS);
+        return 1;
+    }
+
+    if (stroke_file ? load_strokes(stroke_file) != 0 : generate_strokes(seed, 200) != 0) {
+        return 1;
+    }
+    printf("[负载生成] 笔画点数: %zu（%s）\n", g_loadgen.point_count, stroke_file ? stroke_file : "随机生成");
+
+    signal(SIGINT, signal_handler);
+    signal(SIGPIPE, SIG_IGN);
+    pthread_barrier_init(&g_loadgen.ready, NULL, g_loadgen.clients);
+
+    uint64_t start = monotonic_us();
+    int started = 0;
+    for (int i = 0; i < g_loadgen.clients; i++) {
+        loadgen_client_t *c = &g_loadgen.client[i];
+        c->index = i;
+        c->user_id = LOADGEN_USER_ID_BASE + g_loadgen.index_offset + i;
+        if (pthread_create(&c->thread, NULL, client_thread, c) != 0) {
+            printf("[负载生成] 创建客户端线程失败\n");
+            g_loadgen.stop = 1;
+            break;
+        }
+        started++;
+    }
+    if (started < g_loadgen.clients) {
+        // 屏障永远凑不齐：不等待已启动的线程，直接退出
+        return 1;
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(g_loadgen.client[i].thread, NULL);
+    }
+    double elapsed = (monotonic_us() - start) / 1e6 - (LOADGEN_DRAIN_MS + LOADGEN_SUBSCRIBE_WAIT_MS) / 1000.0;
+
+    report(elapsed > 0 ? elapsed : 1.0);
+
+    for (int i = 0; i < g_loadgen.clients; i++) {
+        free(g_loadgen.client[i].latency_us);
+    }
+    free(g_loadgen.points);
+    pthread_barrier_destroy(&g_loadgen.ready);
+    return 0;
+}
@@ -0,0 +1,256 @@
+/**
+ * @file scaler_bench.c
+ * @brief 图片缩放方式对比测试：最近邻 / 双线性 / 区域平均
+ *
+ * 用 image_viewer 的 bmp_reader.c 映射BMP文件，按 image_scale_fit 的规则算出
+ * 保持宽高比的目标矩形（默认680x280画布），对每种缩放方式统计：
+ *   - 每次缩放耗时（多轮取最小值），以及相对原逐像素浮点缩放的倍数
+ *   - 与浮点参考图的PSNR：缩小时参考为精确的区域平均，放大时为浮点双线性
+ * 原逐像素缩放按改动前 load_bmp_to_canvas 的算法（每像素浮点除法、最近邻）直接写32位缓冲区，
+ * 不含 lv_canvas_set_px_color 的格式分派和重绘，实际设备上旧路径更慢。
+ *
+ * 不依赖LVGL，在开发机上运行。未指定文件时测试 bin/ 目录下的全部BMP。
+ */
+
+#include "image_viewer/bmp_reader.h"
+#include "image_viewer/image_scaler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <glob.h>
+#include <math.h>
+#include <time.h>
+
+#define SCALER_BENCH_CANVAS_W   680                // 与image_viewer的画布尺寸一致
+#define SCALER_BENCH_CANVAS_H   280
+#define SCALER_BENCH_ITERS      20                 // 每轮缩放次数
+#define SCALER_BENCH_ROUNDS     5                  // 取最快一轮
+#define SCALER_BENCH_MODES      3
+
+static int canvas_w = SCALER_BENCH_CANVAS_W;
+static int canvas_h = SCALER_BENCH_CANVAS_H;
+static int iters = SCALER_BENCH_ITERS;
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t pack_rgb(double r, double g, double b) {
+    return 0xFF000000u | ((uint32_t)lround(r) << 16) | ((uint32_t)lround(g) << 8) | (uint32_t)lround(b);
+}
+
+// 取显示顺序第y行的24位BGR像素（非24位时转换到scratch）
+static const uint8_t *src_row(const bmp_reader_t *reader, int y, uint8_t *scratch) {
+    return bmp_reader_row_bgr24(reader, y, scratch);
+}
+
+// 浮点参考图：缩小时为精确区域平均（按覆盖面积加权），放大时为浮点双线性
+static int render_reference(const bmp_reader_t *reader, uint32_t *ref, int dw, int dh) {
+    int w = reader->width, h = reader->height;
+    double fx = (double)w / dw, fy = (double)h / dh;
+    uint8_t *scratch0 = (uint8_t *)malloc((size_t)w * 3);
+    uint8_t *scratch1 = (uint8_t *)malloc((size_t)w * 3);
+    if (!scratch0 || !scratch1) {
+        free(scratch0);
+        free(scratch1);
+        return -1;
+    }
+    for (int y = 0; y < dh; y++) {
+        for (int x = 0; x < dw; x++) {
+            double acc[3] = {0, 0, 0};
+            double wsum = 0;
+            if (fx < 1.0 || fy < 1.0) {
+                double cx = (x + 0.5) * fx - 0.5, cy = (y + 0.5) * fy - 0.5;
+                if (cx < 0) cx = 0;
+                if (cy < 0) cy = 0;
+                int ix = (int)cx, iy = (int)cy;
+                double ax = cx - ix, ay = cy - iy;
+                int ix1 = ix + 1 < w ? ix + 1 : ix;
+                int iy1 = iy + 1 < h ? iy + 1 : iy;
+                const uint8_t *r0 = src_row(reader, iy, scratch0);
+                const uint8_t *r1 = src_row(reader, iy1, scratch1);
+                for (int c = 0; c < 3; c++) {
+                    acc[c] = (r0[ix * 3 + c] * (1 - ax) + r0[ix1 * 3 + c] * ax) * (1 - ay) +
+                             (r1[ix * 3 + c] * (1 - ax) + r1[ix1 * 3 + c] * ax) * ay;
+                }
+                wsum = 1;
+            } else {
+                double x0 = x * fx, x1 = (x + 1) * fx, y0 = y * fy, y1 = (y + 1) * fy;
+                for (int yy = (int)y0; yy < (int)ceil(y1) && yy < h; yy++) {
+                    double wy = fmin(y1, yy + 1) - fmax(y0, yy);
+                    const uint8_t *r = src_row(reader, yy, scratch0);
+                    for (int xx = (int)x0; xx < (int)ceil(x1) && xx < w; xx++) {
+                        double ww = (fmin(x1, xx + 1) - fmax(x0, xx)) * wy;
+                        for (int c = 0; c < 3; c++) {
+                            acc[c] += r[xx * 3 + c] * ww;
+                        }
+                        wsum += ww;
+                    }
+                }
+            }
+            ref[(size_t)y * dw + x] = pack_rgb(acc[2] / wsum, acc[1] / wsum, acc[0] / wsum);
+        }
+    }
+    free(scratch0);
+    free(scratch1);
+    return 0;
+}
+
+// 原逐像素缩放：每个目标像素做浮点除法取最近的源像素
+static void legacy_scale(const bmp_reader_t *reader, uint32_t *dst, int dst_stride, int dw, int dh, float scale,
+                         uint8_t *scratch) {
+    for (int y = 0; y < dh; y++) {
+        for (int x = 0; x < dw; x++) {
+            int src_x = (int)(x / scale);
+            int src_y = (int)(y / scale);
+            if (src_x >= reader->width || src_y >= reader->height) {
+                continue;
+            }
+            const uint8_t *p = src_row(reader, src_y, scratch) + src_x * 3;
+            dst[(size_t)y * dst_stride + x] = 0xFF000000u | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | p[0];
+        }
+    }
+}
+
+// 目标矩形（dst_stride为画布宽度）与参考图的PSNR，只比较RGB
+static double rect_psnr(const uint32_t *dst, int dst_stride, const uint32_t *ref, int dw, int dh) {
+    double se = 0;
+    for (int y = 0; y < dh; y++) {
+        for (int x = 0; x < dw; x++) {
+            uint32_t a = dst[(size_t)y * dst_stride + x], b = ref[(size_t)y * dw + x];
+            for (int shift = 0; shift < 24; shift += 8) {
+                double d = (double)((a >> shift) & 0xFF) - (double)((b >> shift) & 0xFF);
+                se += d * d;
+            }
+        }
+    }
+    se /= (double)dw * dh * 3;
+    return se == 0 ? 99.0 : 10.0 * log10(255.0 * 255.0 / se);
+}
+
+// 执行iters次缩放，多轮取最快一轮的平均耗时（毫秒）；mode<0为原逐像素缩放
+static double time_scale(const bmp_reader_t *reader, const image_scale_src_t *src, uint32_t *dst, int dw, int dh,
+                         float scale, int mode, uint8_t *scratch) {
+    double best = 1e30;
+    for (int round = 0; round < SCALER_BENCH_ROUNDS; round++) {
+        uint64_t start = monotonic_ns();
+        for (int i = 0; i < iters; i++) {
+            if (mode < 0) {
+                legacy_scale(reader, dst, canvas_w, dw, dh, scale, scratch);
+            } else if (image_scale_bgr24(src, dst, canvas_w, dw, dh, (image_scale_mode_t)mode) != 0) {
+                return -1;
+            }
+        }
+        double ms = (double)(monotonic_ns() - start) / 1e6 / iters;
+        if (ms < best) {
+            best = ms;
+        }
+    }
+    return best;
+}
+
+static int bench_file(const char *path) {
+    bmp_reader_t reader;
+    if (bmp_reader_open(&reader, path) != 0) {
+        return -1;
+    }
+    image_scale_src_t src;
+    bmp_reader_scale_src(&reader, &src);
+
+    // 与image_scale_fit相同的目标矩形
+    float scale_x = (float)canvas_w / reader.width;
+    float scale_y = (float)canvas_h / reader.height;
+    float scale = (scale_x < scale_y) ? scale_x : scale_y;
+    int dw = (int)(reader.width * scale);
+    int dh = (int)(reader.height * scale);
+    if (dw > canvas_w) dw = canvas_w;
+    if (dh > canvas_h) dh = canvas_h;
+    if (dw <= 0) dw = 1;
+    if (dh <= 0) dh = 1;
+
+    uint32_t *canvas = (uint32_t *)calloc((size_t)canvas_w * canvas_h, sizeof(uint32_t));
+    uint32_t *ref = (uint32_t *)malloc((size_t)dw * dh * sizeof(uint32_t));
+    uint8_t *scratch = (uint8_t *)malloc((size_t)reader.width * 3);
+    int ret = -1;
+    if (!canvas || !ref || !scratch || render_reference(&reader, ref, dw, dh) != 0) {
+        printf("[缩放测试] 内存不足: %s\n", path);
+        goto out;
+    }
+
+    printf("\n%s  %dx%d %d位 -> %dx%d（%s）\n", path, reader.width, reader.height, reader.bpp, dw, dh,
+           (dw < reader.width) ? "缩小" : "放大");
+    double legacy_ms = time_scale(&reader, &src, canvas, dw, dh, scale, -1, scratch);
+    printf("  %-10s %8.3f ms          PSNR %5.1f dB\n", "逐像素浮点", legacy_ms,
+           rect_psnr(canvas, canvas_w, ref, dw, dh));
+    for (int mode = 0; mode < SCALER_BENCH_MODES; mode++) {
+        double ms = time_scale(&reader, &src, canvas, dw, dh, scale, mode, scratch);
+        if (ms < 0) {
+            printf("[缩放测试] 缩放失败: %s\n", image_scale_mode_name((image_scale_mode_t)mode));
+            goto out;
+        }
+        printf("  %-10s %8.3f ms %6.1fx  PSNR %5.1f dB\n", image_scale_mode_name((image_scale_mode_t)mode), ms,
+               legacy_ms / ms, rect_psnr(canvas, canvas_w, ref, dw, dh));
+    }
+    ret = 0;
+out:
+    free(canvas);
+    free(ref);
+    free(scratch);
+    bmp_reader_close(&reader);
+    return ret;
+}
+
+static void usage(const char *prog) {
+    printf("用法: %s [-W 宽] [-H 高] [-n 次数] [BMP文件...]\n", prog);
+    printf("  -W  画布宽度（默认%d）\n", SCALER_BENCH_CANVAS_W);
+    printf("  -H  画布高度（默认%d）\n", SCALER_BENCH_CANVAS_H);
+    printf("  -n  每轮缩放次数（默认%d，共%d轮取最快）\n", SCALER_BENCH_ITERS, SCALER_BENCH_ROUNDS);
+    printf("  未指定文件时测试 bin/*.bmp\n");
+}
+
+int main(int argc, char **argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "W:H:n:h")) != -1) {
+        switch (opt) {
+        case 'W':
+            canvas_w = atoi(optarg);
+            break;
+        case 'H':
+            canvas_h = atoi(optarg);
+            break;
+        case 'n':
+            iters = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (canvas_w <= 0 || canvas_h <= 0 || iters <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    printf("[缩放测试] 画布%dx%d，每轮%d次，%d轮取最快\n", canvas_w, canvas_h, iters, SCALER_BENCH_ROUNDS);
+    int failed = 0;
+    if (optind < argc) {
+        for (int i = optind; i < argc; i++) {
+            failed |= bench_file(argv[i]) != 0;
+        }
+    } else {
+        glob_t files;
+        if (glob("bin/*.bmp", 0, NULL, &files) != 0) {
+            printf("[缩放测试] bin/ 下没有BMP文件，请在仓库根目录运行或指定文件\n");
+            return 1;
+        }
+        for (size_t i = 0; i < files.gl_pathc; i++) {
+            failed |= bench_file(files.gl_pathv[i]) != 0;
+        }
+        globfree(&files);
+    }
+    return failed ? 1 : 0;
+}
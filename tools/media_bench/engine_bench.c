@@ -0,0 +1,307 @@
+/**
+ * @file engine_bench.c
+ * @brief 常驻MPlayer播放引擎（media_engine.c）测试：握手、切换、超时重启、崩溃重启、播放状态
+ *
+ * MPLAYER_BIN 指向同目录的 fake_mplayer.sh（模拟 -idle -slave 的回答），
+ * 在临时目录中创建空的媒体文件，依次检查：
+ *   - media_engine_load() 调用本身的耗时（不等待握手，LVGL线程中调用）
+ *   - 首次加载（进程已预先启动）和连续切换的握手耗时（状态快照中loading变为false）
+ *   - 文件名含空格和双引号时的加载；不存在的文件回答ANS_ERROR时快照为failed
+ *   - 播放到结尾（位置查询回答ANS_ERROR）后 media_engine_is_loaded() 变为false
+ *   - 暂停/恢复在状态快照中可见的延迟，media_engine_get_status() 每次调用的耗时
+ *   - mplayer被SIGKILL后下一次加载自动重启
+ *   - mplayer不再读取命令（hang）时加载超时（failed），结束进程后下一次加载重启成功
+ *   - 找不到mplayer时加载失败（exec失败，子进程退出后快照为failed）
+ * 任一检查不符合预期时退出码为1。
+ */
+
+#include "media_player/media_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+
+#define ENGINE_BENCH_STUB       "tools/media_bench/fake_mplayer.sh"
+#define ENGINE_BENCH_LEN_MS     1500               // 模拟的每个文件播放时长
+#define ENGINE_BENCH_SWITCHES   10
+#define ENGINE_BENCH_WAIT_MS    3000               // 等待状态变化的上限
+
+// 与media_engine.c使用同一个加载超时（Makefile中用-D缩短），等待超时失败的上限
+#ifndef MEDIA_ENGINE_LOAD_TIMEOUT_MS
+#define MEDIA_ENGINE_LOAD_TIMEOUT_MS 5000
+#endif
+
+static char media_dir[] = "/tmp/engine_bench.XXXXXX";
+static char path_a[256];
+static char path_b[256];
+static char path_quoted[256];
+static char path_missing[256];
+static int failures = 0;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static void check(bool ok, const char *what) {
+    if (!ok) {
+        printf("[引擎测试] 失败: %s\n", what);
+        failures++;
+    }
+}
+
+static int create_file(char *path, size_t size, const char *name) {
+    snprintf(path, size, "%s/%s", media_dir, name);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("[引擎测试] 创建文件失败: %s\n", path);
+        return -1;
+    }
+    close(fd);
+    return 0;
+}
+
+static void remove_files(void) {
+    unlink(path_a);
+    unlink(path_b);
+    unlink(path_quoted);
+    rmdir(media_dir);
+}
+
+// 等待状态快照满足条件，返回等待的毫秒数，超时返回-1
+static double wait_status_role(media_engine_role_t role, bool (*cond)(const media_engine_status_t *)) {
+    media_engine_status_t s;
+    double start = now_ms();
+    do {
+        media_engine_get_status(role, &s);
+        if (cond(&s)) {
+            return now_ms() - start;
+        }
+        usleep(1000);
+    } while (now_ms() - start < ENGINE_BENCH_WAIT_MS);
+    return -1;
+}
+
+static double wait_status(bool (*cond)(const media_engine_status_t *)) {
+    return wait_status_role(MEDIA_ENGINE_AUDIO, cond);
+}
+
+static bool status_paused(const media_engine_status_t *s) {
+    return s->paused;
+}
+
+static bool status_playing(const media_engine_status_t *s) {
+    return !s->paused;
+}
+
+static bool status_has_length(const media_engine_status_t *s) {
+    return s->duration_ms >= 0;
+}
+
+static bool status_load_done(const media_engine_status_t *s) {
+    return !s->loading;
+}
+
+/**
+ * @brief 发出加载并等待握手完成
+ * @param call_ms 输出media_engine_load()调用本身的耗时
+ * @param total_ms 输出到握手完成的耗时
+ * @return 开始播放返回0，加载返回失败、握手失败或等待超时返回-1
+ */
+static int load_and_wait(const char *path, double *call_ms, double *total_ms) {
+    double t = now_ms();
+    int ret = media_engine_load(MEDIA_ENGINE_AUDIO, path);
+    *call_ms = now_ms() - t;
+    if (ret != 0) {
+        *total_ms = *call_ms;
+        return -1;
+    }
+    double wait = wait_status(status_load_done);
+    *total_ms = now_ms() - t;
+    media_engine_status_t s;
+    media_engine_get_status(MEDIA_ENGINE_AUDIO, &s);
+    return (wait >= 0 && s.loaded && !s.failed) ? 0 : -1;
+}
+
+static void bench_load(void) {
+    double call, total;
+    int ret = load_and_wait(path_a, &call, &total);
+    printf("[引擎测试] 首次加载: %d, 调用%.2fms, 握手%.1fms\n", ret, call, total);
+    check(ret == 0, "首次加载");
+
+    double worst = 0, sum = 0, worst_call = 0;
+    for (int i = 0; i < ENGINE_BENCH_SWITCHES; i++) {
+        ret = load_and_wait((i % 2) ? path_a : path_b, &call, &total);
+        check(ret == 0, "切换文件");
+        sum += total;
+        if (total > worst) {
+            worst = total;
+        }
+        if (call > worst_call) {
+            worst_call = call;
+        }
+    }
+    printf("[引擎测试] 切换%d次: 握手平均%.1fms, 最长%.1fms; 调用最长%.2fms\n", ENGINE_BENCH_SWITCHES,
+           sum / ENGINE_BENCH_SWITCHES, worst, worst_call);
+
+    ret = load_and_wait(path_quoted, &call, &total);
+    printf("[引擎测试] 文件名含空格和引号: %d, %.1fms\n", ret, total);
+    check(ret == 0, "文件名含空格和引号");
+
+    ret = load_and_wait(path_missing, &call, &total);
+    media_engine_status_t s;
+    media_engine_get_status(MEDIA_ENGINE_AUDIO, &s);
+    printf("[引擎测试] 不存在的文件: %d, 调用%.2fms, 失败可见%.1fms\n", ret, call, total);
+    check(ret != 0 && s.failed && !media_engine_is_loaded(MEDIA_ENGINE_AUDIO), "不存在的文件应握手失败");
+}
+
+static void bench_status(void) {
+    double call, total;
+    check(load_and_wait(path_a, &call, &total) == 0, "加载");
+    double ms = wait_status(status_has_length);
+    printf("[引擎测试] 时长可见: %.1fms\n", ms);
+    check(ms >= 0, "加载后得到时长");
+
+    media_engine_command(MEDIA_ENGINE_AUDIO, "pause");
+    ms = wait_status(status_paused);
+    printf("[引擎测试] 暂停可见: %.1fms\n", ms);
+    check(ms >= 0, "暂停状态");
+    media_engine_command(MEDIA_ENGINE_AUDIO, "pause");
+    ms = wait_status(status_playing);
+    printf("[引擎测试] 恢复可见: %.1fms\n", ms);
+    check(ms >= 0, "恢复播放状态");
+
+    media_engine_status_t s;
+    int n = 1000000;
+    double t = now_ms();
+    for (int i = 0; i < n; i++) {
+        media_engine_get_status(MEDIA_ENGINE_AUDIO, &s);
+    }
+    printf("[引擎测试] media_engine_get_status: %.1fns/次\n", (now_ms() - t) * 1e6 / n);
+
+    // 播放结束：模拟脚本在FAKE_LEN_MS之后对查询回答ANS_ERROR
+    t = now_ms();
+    while (media_engine_is_loaded(MEDIA_ENGINE_AUDIO) && now_ms() - t < ENGINE_BENCH_LEN_MS + ENGINE_BENCH_WAIT_MS) {
+        usleep(10000);
+    }
+    bool ended = !media_engine_is_loaded(MEDIA_ENGINE_AUDIO);
+    printf("[引擎测试] 播放结束检测: %.0fms（时长%dms）\n", now_ms() - t, ENGINE_BENCH_LEN_MS);
+    check(ended, "播放结束后应为未加载");
+}
+
+static void bench_recovery(void) {
+    // 崩溃：下一次加载自动重启
+    int pid = media_engine_get_pid(MEDIA_ENGINE_AUDIO);
+    check(pid > 0, "mplayer进程");
+    if (pid > 0) {
+        kill(pid, SIGKILL);
+    }
+    double t = now_ms();
+    while (media_engine_get_pid(MEDIA_ENGINE_AUDIO) > 0 && now_ms() - t < ENGINE_BENCH_WAIT_MS) {
+        usleep(1000);
+    }
+    double call, total;
+    int ret = load_and_wait(path_a, &call, &total);
+    printf("[引擎测试] 进程被杀死后加载（重启）: %d, 调用%.1fms, 握手%.1fms\n", ret, call, total);
+    check(ret == 0 && media_engine_get_pid(MEDIA_ENGINE_AUDIO) != pid, "崩溃后重启");
+
+    // 无响应：加载立即返回，握手超时后读取线程结束进程，下一次加载重启
+    media_engine_command(MEDIA_ENGINE_AUDIO, "hang");
+    t = now_ms();
+    ret = media_engine_load(MEDIA_ENGINE_AUDIO, path_b);
+    call = now_ms() - t;
+    media_engine_status_t s;
+    while (now_ms() - t < MEDIA_ENGINE_LOAD_TIMEOUT_MS + ENGINE_BENCH_WAIT_MS) {
+        media_engine_get_status(MEDIA_ENGINE_AUDIO, &s);
+        if (!s.loading) {
+            break;
+        }
+        usleep(1000);
+    }
+    printf("[引擎测试] 无响应时加载: %d, 调用%.2fms, 超时失败可见%.1fms\n", ret, call, now_ms() - t);
+    check(ret == 0 && !s.loading && s.failed, "无响应时加载应超时失败");
+    t = now_ms();
+    while (media_engine_get_pid(MEDIA_ENGINE_AUDIO) > 0 && now_ms() - t < ENGINE_BENCH_WAIT_MS) {
+        usleep(1000);
+    }
+    ret = load_and_wait(path_b, &call, &total);
+    printf("[引擎测试] 超时后加载（重启）: %d, 调用%.1fms, 握手%.1fms\n", ret, call, total);
+    check(ret == 0, "超时后重启");
+
+    t = now_ms();
+    media_engine_close(MEDIA_ENGINE_AUDIO);
+    printf("[引擎测试] 关闭: %.1fms\n", now_ms() - t);
+    check(media_engine_get_pid(MEDIA_ENGINE_AUDIO) < 0, "关闭后进程已退出");
+
+    // 找不到mplayer
+    setenv("MPLAYER_BIN", "/nonexistent/mplayer", 1);
+    setenv("PATH", "/nonexistent", 1);
+    // fork成功、exec在子进程中失败：加载先返回0，子进程退出后快照为failed
+    t = now_ms();
+    ret = media_engine_load(MEDIA_ENGINE_VIDEO, path_a);
+    call = now_ms() - t;
+    double ms = wait_status_role(MEDIA_ENGINE_VIDEO, status_load_done);
+    media_engine_get_status(MEDIA_ENGINE_VIDEO, &s);
+    printf("[引擎测试] 找不到mplayer时加载: %d, 调用%.1fms, 失败可见%.1fms\n", ret, call, now_ms() - t);
+    check(ret != 0 || (ms >= 0 && s.failed), "找不到mplayer时加载应失败");
+    media_engine_close(MEDIA_ENGINE_VIDEO);
+}
+
+static void usage(const char *prog) {
+    printf("用法: %s [-m 模拟脚本]\n", prog);
+    printf("  -m  模拟mplayer的脚本（默认%s，在仓库根目录运行）\n", ENGINE_BENCH_STUB);
+}
+
+int main(int argc, char **argv) {
+    const char *stub = ENGINE_BENCH_STUB;
+    int opt;
+    // 输出到管道时也按行刷新，避免fork时未输出的内容被复制到mplayer子进程
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    while ((opt = getopt(argc, argv, "m:h")) != -1) {
+        switch (opt) {
+        case 'm':
+            stub = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (access(stub, X_OK) != 0) {
+        printf("[引擎测试] 模拟脚本不可执行: %s\n", stub);
+        return 1;
+    }
+    char len[16];
+    snprintf(len, sizeof(len), "%d", ENGINE_BENCH_LEN_MS);
+    setenv("MPLAYER_BIN", stub, 1);
+    setenv("FAKE_LEN_MS", len, 1);
+
+    if (mkdtemp(media_dir) == NULL) {
+        printf("[引擎测试] 创建临时目录失败\n");
+        return 1;
+    }
+    snprintf(path_missing, sizeof(path_missing), "%s/missing.mp3", media_dir);
+    if (create_file(path_a, sizeof(path_a), "a.mp3") != 0 || create_file(path_b, sizeof(path_b), "b.mp3") != 0 ||
+        create_file(path_quoted, sizeof(path_quoted), "c d \"q\".mp3") != 0) {
+        remove_files();
+        return 1;
+    }
+
+    // 与设备上一样预先启动，首次加载不包含进程启动时间
+    media_engine_start(MEDIA_ENGINE_AUDIO);
+    usleep(500000);
+
+    bench_load();
+    bench_status();
+    bench_recovery();
+
+    remove_files();
+    printf("[引擎测试] %s\n", failures ? "未通过" : "全部通过");
+    return failures ? 1 : 0;
+}
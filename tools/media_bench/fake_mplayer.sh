@@ -0,0 +1,102 @@
+#!/bin/bash
+# 模拟 mplayer -idle -slave，供 media_engine 在开发机上测试（MPLAYER_BIN 指向本脚本）
+#
+# 从标准输入逐行读取slave命令（忽略命令行参数），回答写到标准输出：
+#   loadfile "路径"       等待FAKE_LOAD秒；文件存在时输出 "Playing ..."，否则 "File not found"
+#   get_property time_pos / length / pause
+#                         回答 ANS_time_pos= / ANS_length= / ANS_pause=；没有文件在播放、
+#                         或已播放超过FAKE_LEN_MS时回答 ANS_ERROR=PROPERTY_UNAVAILABLE，
+#                         未知属性回答 ANS_ERROR=PROPERTY_UNKNOWN
+#   pause                 切换暂停（暂停时位置不变）
+#   stop                  回到空闲状态
+#   quit                  退出
+#   hang                  100秒内不再读取命令（测试加载超时后的重启）
+# 命令前的 pausing_keep_force 前缀被忽略，其他命令不回答。
+#
+# 环境变量：
+#   FAKE_START   启动耗时（秒，默认0.3）
+#   FAKE_LOAD    打开文件耗时（秒，默认0.02）
+#   FAKE_LEN_MS  每个文件的播放时长（毫秒，默认1000000）
+#   FAKE_LOG     把收到的命令追加到该文件（默认不记录）
+
+sleep "${FAKE_START:-0.3}"
+
+len_ms=${FAKE_LEN_MS:-1000000}
+loaded=0
+paused=0
+start_ms=0
+paused_at=0
+
+now_ms() {
+    local us=${EPOCHREALTIME/./}
+    echo $((us / 1000))
+}
+
+# 秒数保留一位小数，与mplayer的输出格式一致
+print_seconds() {
+    echo "$1=$(($2 / 1000)).$((($2 % 1000) / 100))"
+}
+
+while IFS= read -r line; do
+    [ -n "$FAKE_LOG" ] && echo "$line" >> "$FAKE_LOG"
+    cmd=${line#pausing_keep_force }
+    set -- $cmd
+    case "$1" in
+    loadfile)
+        # 去掉两端的引号（media_engine使用双引号，路径含双引号时用单引号）
+        file=${cmd#loadfile }
+        file=${file:1:${#file}-2}
+        sleep "${FAKE_LOAD:-0.02}"
+        paused=0
+        if [ -f "$file" ]; then
+            loaded=1
+            start_ms=$(now_ms)
+            echo "Playing $file."
+            echo "Starting playback..."
+        else
+            loaded=0
+            echo "File not found: '$file'"
+        fi
+        ;;
+    pause)
+        if [ $loaded = 1 ]; then
+            if [ $paused = 0 ]; then
+                paused=1
+                paused_at=$(now_ms)
+            else
+                paused=0
+                start_ms=$((start_ms + $(now_ms) - paused_at))
+            fi
+        fi
+        ;;
+    get_property)
+        if [ $loaded = 1 ]; then
+            ref=$(now_ms)
+            [ $paused = 1 ] && ref=$paused_at
+            pos=$((ref - start_ms))
+            # 播放结束：-idle模式下不输出任何内容，之后的查询回答ANS_ERROR
+            [ $pos -gt "$len_ms" ] && loaded=0
+        fi
+        if [ $loaded = 0 ]; then
+            echo "ANS_ERROR=PROPERTY_UNAVAILABLE"
+        else
+            case "$2" in
+            time_pos) print_seconds ANS_time_pos "$pos" ;;
+            length) print_seconds ANS_length "$len_ms" ;;
+            pause) [ $paused = 1 ] && echo "ANS_pause=yes" || echo "ANS_pause=no" ;;
+            *) echo "ANS_ERROR=PROPERTY_UNKNOWN" ;;
+            esac
+        fi
+        ;;
+    stop)
+        loaded=0
+        paused=0
+        ;;
+    quit)
+        exit 0
+        ;;
+    hang)
+        sleep 100
+        ;;
+    esac
+done
@@ -0,0 +1,337 @@
+/**
+ * @file search_bench.c
+ * @brief 媒体列表搜索（media_search.c）耗时和正确性测试
+ *
+ * 生成中英文混合的音乐文件名（"歌手 - 歌名 编号.mp3"），代替媒体索引和媒体目录
+ * （列表、版本号和元数据由本文件提供），统计：
+ *   - 建立索引（排序、前缀数组、trigram倒排表）的耗时
+ *   - 1~2字节前缀查询、3字节以上子串查询（拉丁字母、拼音首字母、汉字）的平均耗时
+ *   - 逐字输入"zjldx"（在上一次结果中过滤）的总耗时
+ *   - 第一次按时间排序（读取元数据）、已有元数据时按大小排序、按字母跳转的耗时
+ * 每个查询的结果都与逐个文件比较的结果（同样的排序）逐项核对，另外检查空列表，
+ * 不一致时退出码为1。
+ *
+ * 不依赖LVGL，在开发机上运行。
+ */
+
+#include "file_scanner/media_search.h"
+#include "file_scanner/media_catalog.h"
+#include "file_scanner/pinyin_initials.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#define SEARCH_BENCH_FILES      10000              // 默认文件数
+#define SEARCH_BENCH_ITERS      200                // 每个查询的重复次数
+#define SEARCH_BENCH_NAME_MAX   256
+
+static char **files = NULL;
+static int file_count = 0;
+static uint32_t index_gen = 1;
+static uint32_t catalog_gen = 1;
+static int failures = 0;
+
+static const char *artists[] = { "周杰伦", "Beyond", "王菲", "Taylor Swift", "陈奕迅", "Adele", "林俊杰", "Coldplay" };
+static const char *titles_cn[] = { "稻香", "晴天", "七里香", "夜曲", "告白气球", "青花瓷", "月亮", "爱情",
+                                   "时间", "朋友", "海阔天空", "光辉岁月", "红豆", "传奇", "后来" };
+static const char *words_en[] = { "love", "song", "night", "star", "rain", "dream", "heart", "blue",
+                                  "summer", "light", "road", "fire", "moon", "home", "sky" };
+static const char *queries[] = { "z", "zj", "zjl", "zjldx", "周", "周杰伦", "稻香", "dx", "love", "lov",
+                                 "ight", "ado", "A", "1", "xyzq" };
+
+#define ARRAY_LEN(a) (sizeof(a) / sizeof((a)[0]))
+
+/* ---------------- 代替媒体索引和媒体目录 ---------------- */
+
+char **get_image_files(void) { return NULL; }
+int get_image_count(void) { return 0; }
+char **get_video_files(void) { return NULL; }
+int get_video_count(void) { return 0; }
+char **get_audio_files(void) { return files; }
+int get_audio_count(void) { return file_count; }
+uint32_t media_index_generation(void) { return index_gen; }
+uint32_t media_catalog_generation(void) { return catalog_gen; }
+
+// 大小和修改时间由路径的哈希值得到（固定，便于比较）
+media_info_state_t media_catalog_lookup(const char *path, media_info_t *info) {
+    uint32_t h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)path; *p; p++) {
+        h = (h ^ *p) * 16777619u;
+    }
+    if (info) {
+        memset(info, 0, sizeof(*info));
+        info->size = h % 10000000;
+        info->mtime = h % 100000;
+    }
+    return MEDIA_INFO_READY;
+}
+
+/* ---------------- 逐个文件比较（参考结果） ---------------- */
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static void check(bool ok, const char *what) {
+    if (!ok) {
+        printf("[搜索测试] 失败: %s\n", what);
+        failures++;
+    }
+}
+
+// 名称（去掉扩展名，ASCII转小写）和拼音首字母串，规则与media_search.c相同
+static void make_name(const char *path, char *name, char *abbr) {
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    const char *ext = strrchr(base, '.');
+    size_t len = (ext && ext != base) ? (size_t)(ext - base) : strlen(base);
+    if (len > SEARCH_BENCH_NAME_MAX - 1) {
+        len = SEARCH_BENCH_NAME_MAX - 1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        char ch = base[i];
+        name[i] = (ch >= 'A' && ch <= 'Z') ? (char)(ch - 'A' + 'a') : ch;
+    }
+    name[len] = '\0';
+
+    size_t n = 0;
+    const unsigned char *p = (const unsigned char *)name;
+    while (*p) {
+        uint32_t c = *p;
+        int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+        if (extra) {
+            c &= 0x3Fu >> extra;
+            for (int i = 1; i <= extra && p[i]; i++) {
+                c = (c << 6) | (p[i] & 0x3F);
+            }
+        }
+        p += extra + 1;
+        if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+            abbr[n++] = (char)c;
+        } else if (c >= 0x80 && pinyin_initial(c)) {
+            abbr[n++] = pinyin_initial(c);
+        }
+    }
+    abbr[n] = '\0';
+}
+
+static bool ref_matches(const char *path, const char *text) {
+    char name[SEARCH_BENCH_NAME_MAX];
+    char abbr[SEARCH_BENCH_NAME_MAX];
+    make_name(path, name, abbr);
+    size_t len = strlen(text);
+    if (len >= 3) {
+        return strstr(name, text) != NULL || strstr(abbr, text) != NULL;
+    }
+    return strncmp(name, text, len) == 0 || strncmp(abbr, text, len) == 0;
+}
+
+// 查询结果应为完整列表（同样的排序）中匹配的文件，顺序不变
+static bool verify(const media_query_t *q, const int *all, int all_count, const char *text) {
+    char folded[MEDIA_QUERY_TEXT_MAX];
+    size_t n = 0;
+    for (; text[n] && n + 1 < sizeof(folded); n++) {
+        folded[n] = (text[n] >= 'A' && text[n] <= 'Z') ? (char)(text[n] - 'A' + 'a') : text[n];
+    }
+    folded[n] = '\0';
+    int k = 0;
+    for (int i = 0; i < all_count; i++) {
+        if (folded[0] == '\0' || ref_matches(files[all[i]], folded)) {
+            if (k >= q->count || q->items[k] != all[i]) {
+                return false;
+            }
+            k++;
+        }
+    }
+    return k == q->count;
+}
+
+/* ---------------- 测试 ---------------- */
+
+static int generate_files(int count) {
+    files = calloc((size_t)count + 1, sizeof(char *));
+    if (!files) {
+        return -1;
+    }
+    srand(1);
+    for (int i = 0; i < count; i++) {
+        char buf[SEARCH_BENCH_NAME_MAX];
+        const char *artist = artists[rand() % ARRAY_LEN(artists)];
+        if (i % 2) {
+            snprintf(buf, sizeof(buf), "/mdata/music/%s - %s %d.mp3", artist,
+                     titles_cn[rand() % ARRAY_LEN(titles_cn)], i);
+        } else {
+            const char *w0 = words_en[rand() % ARRAY_LEN(words_en)];
+            const char *w1 = words_en[rand() % ARRAY_LEN(words_en)];
+            snprintf(buf, sizeof(buf), "/mdata/music/%s - %s %s %d.mp3", artist, w0, w1, i);
+        }
+        files[i] = strdup(buf);
+        if (!files[i]) {
+            return -1;
+        }
+        file_count = i + 1;
+    }
+    return 0;
+}
+
+// 完整列表在该排序下的顺序
+static int *snapshot_order(media_query_t *q) {
+    media_query_set_text(q, "");
+    int *all = malloc((size_t)(q->count > 0 ? q->count : 1) * sizeof(int));
+    if (all && q->count > 0) {
+        memcpy(all, q->items, (size_t)q->count * sizeof(int));
+    }
+    return all;
+}
+
+static void bench_queries(media_query_t *q, int iters) {
+    int *all = snapshot_order(q);
+    if (!all) {
+        check(false, "内存不足");
+        return;
+    }
+    int all_count = q->count;
+    double worst = 0;
+    for (size_t k = 0; k < ARRAY_LEN(queries); k++) {
+        double total = 0;
+        int results = 0;
+        for (int i = 0; i < iters; i++) {
+            media_query_set_text(q, "");
+            double t = now_ms();
+            results = media_query_set_text(q, queries[k]);
+            total += now_ms() - t;
+        }
+        double ms = total / iters;
+        if (ms > worst) {
+            worst = ms;
+        }
+        bool ok = verify(q, all, all_count, queries[k]);
+        printf("[搜索测试] %-12s %5d个结果  %.3fms%s\n", queries[k], results, ms, ok ? "" : "  与逐个比较不一致");
+        check(ok, queries[k]);
+    }
+    printf("[搜索测试] 完整查询最长: %.3fms\n", worst);
+
+    // 逐字输入：后面的输入在上一次结果中过滤
+    const char *typing = "zjldx";
+    char buf[8];
+    media_query_set_text(q, "");
+    double t = now_ms();
+    for (size_t i = 1; i <= strlen(typing); i++) {
+        memcpy(buf, typing, i);
+        buf[i] = '\0';
+        media_query_set_text(q, buf);
+    }
+    printf("[搜索测试] 逐字输入\"%s\"（%zu次查询）: %.3fms，%d个结果\n", typing, strlen(typing), now_ms() - t, q->count);
+    check(verify(q, all, all_count, typing), "逐字输入的结果");
+    free(all);
+}
+
+static void bench_sort_and_jump(media_query_t *q, int iters) {
+    media_query_set_text(q, "");
+    catalog_gen++;                          // 元数据变化：按时间排序时重新读取
+    double t = now_ms();
+    media_query_set_sort(q, MEDIA_SORT_DATE);
+    printf("[搜索测试] 按时间排序（读取元数据）: %.2fms\n", now_ms() - t);
+
+    t = now_ms();
+    for (int i = 0; i < iters; i++) {
+        media_query_set_sort(q, MEDIA_SORT_SIZE);
+    }
+    printf("[搜索测试] 按大小排序（已有元数据）: %.3fms\n", (now_ms() - t) / iters);
+
+    // 按大小排序时的查询也要保持排序
+    int *all = snapshot_order(q);
+    if (all) {
+        int all_count = q->count;
+        media_query_set_text(q, "love");
+        check(verify(q, all, all_count, "love"), "按大小排序时查询");
+        media_query_set_text(q, "zj");
+        check(verify(q, all, all_count, "zj"), "按大小排序时前缀查询");
+        free(all);
+    }
+
+    media_query_set_text(q, "");
+    media_query_set_sort(q, MEDIA_SORT_NAME);
+    int pos = -1;
+    t = now_ms();
+    for (int i = 0; i < iters; i++) {
+        pos = media_query_jump(q, "w");
+    }
+    double ms = (now_ms() - t) / iters;
+    printf("[搜索测试] 跳转到w: 第%d项 %s，%.4fms\n", pos, pos >= 0 ? files[q->items[pos]] : "-", ms);
+    check(pos >= 0 && ref_matches(files[q->items[pos]], "w") &&
+          (pos == 0 || !ref_matches(files[q->items[pos - 1]], "w")), "跳转位置");
+}
+
+static void bench_empty(void) {
+    int saved = file_count;
+    file_count = 0;
+    index_gen++;
+    media_query_t q;
+    media_query_init(&q, MEDIA_LIST_AUDIO, MEDIA_SORT_NAME);
+    check(q.count == 0, "空列表");
+    check(media_query_set_text(&q, "") == 0 && media_query_set_text(&q, "zj") == 0, "空列表查询");
+    check(media_query_jump(&q, "a") == -1, "空列表跳转");
+    media_query_free(&q);
+    file_count = saved;
+    index_gen++;
+}
+
+static void usage(const char *prog) {
+    printf("用法: %s [-n 文件数] [-i 次数]\n", prog);
+    printf("  -n  生成的文件数（默认%d）\n", SEARCH_BENCH_FILES);
+    printf("  -i  每个查询的重复次数（默认%d）\n", SEARCH_BENCH_ITERS);
+}
+
+int main(int argc, char **argv) {
+    int count = SEARCH_BENCH_FILES;
+    int iters = SEARCH_BENCH_ITERS;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:i:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            count = atoi(optarg);
+            break;
+        case 'i':
+            iters = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (count <= 0 || iters <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (generate_files(count) != 0) {
+        printf("[搜索测试] 内存不足\n");
+        return 1;
+    }
+
+    bench_empty();
+
+    media_query_t q;
+    double t = now_ms();
+    media_query_init(&q, MEDIA_LIST_AUDIO, MEDIA_SORT_NAME);
+    printf("[搜索测试] %d个文件，建立索引: %.2fms\n", file_count, now_ms() - t);
+    check(q.count == file_count, "完整列表");
+
+    bench_queries(&q, iters);
+    bench_sort_and_jump(&q, iters);
+
+    media_query_free(&q);
+    media_search_free();
+    for (int i = 0; i < file_count; i++) {
+        free(files[i]);
+    }
+    free(files);
+    printf("[搜索测试] %s\n", failures ? "未通过" : "全部通过");
+    return failures ? 1 : 0;
+}